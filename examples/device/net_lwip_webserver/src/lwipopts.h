@@ -59,6 +59,23 @@
 
 #define LWIP_SINGLE_NETIF               1
 
+/* PBUF_POOL_SIZE is too small to hold fragments for reassembly */
+#define IP_REASSEMBLY                   0
+
+/* IP, UDP and TCP checksums are verified/filled by tud_network_csum_*() while copying frames.
+ * These only handle IPv4, lwIP keeps doing it when IPv6 is enabled. TCP/UDP checksum of a fragment
+ * can only be checked after reassembly, lwIP keeps doing it if reassembly is enabled. */
+#if !LWIP_IPV6
+#define CHECKSUM_GEN_IP                 0
+#define CHECKSUM_GEN_UDP                0
+#define CHECKSUM_GEN_TCP                0
+#define CHECKSUM_CHECK_IP               0
+#if !IP_REASSEMBLY
+#define CHECKSUM_CHECK_UDP              0
+#define CHECKSUM_CHECK_TCP              0
+#endif
+#endif
+
 #define PBUF_POOL_SIZE                  2
 
 #define HTTPD_USE_CUSTOM_FSDATA         0
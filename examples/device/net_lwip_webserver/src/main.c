@@ -60,6 +60,7 @@ static struct netif netif_data;
 
 /* shared between tud_network_recv_cb() and service_traffic() */
 static struct pbuf *received_frame;
+static bool received_csum_ok;
 
 /* this is used by this code, ./class/net/net_driver.c, and usb_descriptors.c */
 /* ideally speaking, this should be generated from the hardware's unique ID (if available) */
@@ -181,7 +182,14 @@ bool tud_network_recv_cb(const uint8_t *src, uint16_t size)
     if (p)
     {
       /* pbuf_alloc() has already initialized struct; all we need to do is copy the data */
+#if !LWIP_IPV6
+      /* checksum is summed up while copying, lwIP is configured to not check it again */
+      uint16_t csum = tud_network_csum_copy(p->payload, src, size);
+      received_csum_ok = tud_network_csum_verify(p->payload, size, csum);
+#else
       memcpy(p->payload, src, size);
+      received_csum_ok = true;
+#endif
 
       /* store away the pointer for service_traffic() to later handle */
       received_frame = p;
@@ -197,7 +205,28 @@ uint16_t tud_network_xmit_cb(uint8_t *dst, void *ref, uint16_t arg)
 
   (void)arg; /* unused for this example */
 
+#if LWIP_IPV6
+  /* lwIP fills checksums itself */
   return pbuf_copy_partial(p, dst, p->tot_len, 0);
+#else
+  uint16_t csum;
+
+  if (p->next == NULL)
+  {
+    csum = tud_network_csum_copy(dst, p->payload, p->len);
+  }
+  else
+  {
+    /* chained pbuf: sum up in place after copying */
+    pbuf_copy_partial(p, dst, p->tot_len, 0);
+    csum = tud_network_csum_copy(dst, dst, p->tot_len);
+  }
+
+  /* lwIP is configured to leave checksums to us */
+  tud_network_csum_fill(dst, p->tot_len, csum);
+
+  return p->tot_len;
+#endif
 }
 
 static void service_traffic(void)
@@ -205,7 +234,8 @@ static void service_traffic(void)
   /* handle any packet received by tud_network_recv_cb() */
   if (received_frame)
   {
-    ethernet_input(received_frame, &netif_data);
+    /* frames with bad checksum are dropped here */
+    if (received_csum_ok) ethernet_input(received_frame, &netif_data);
     pbuf_free(received_frame);
     received_frame = NULL;
     tud_network_recv_renew();
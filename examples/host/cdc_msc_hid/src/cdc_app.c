@@ -57,18 +57,14 @@ void cdc_app_task(void)
   uint32_t count = get_console_inputs(buf, bufsize);
   buf[count] = 0;
 
-  // loop over all mounted interfaces
-  for(uint8_t idx=0; idx<CFG_TUH_CDC; idx++)
+  if (count == 0) return;
+
+  // console --> cdc interfaces, only those mounted with TX FIFO space
+  uint32_t mask = tuh_cdc_ready_mask(TUH_CDC_READY_TX);
+  for(uint8_t idx = tuh_cdc_ready_next(&mask); idx != TUSB_INDEX_INVALID_8; idx = tuh_cdc_ready_next(&mask))
   {
-    if ( tuh_cdc_mounted(idx) )
-    {
-      // console --> cdc interfaces
-      if (count)
-      {
-        tuh_cdc_write(idx, buf, count);
-        tuh_cdc_write_flush(idx);
-      }
-    }
+    tuh_cdc_write(idx, buf, count);
+    tuh_cdc_write_flush(idx);
   }
 }
 
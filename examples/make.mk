@@ -112,6 +112,13 @@ SRC_C += $(subst $(TOP)/,,$(wildcard $(TOP)/$(BOARD_PATH)/*.c))
 
 SRC_C += $(TINYUSB_SRC_C)
 
+# MAX3421E SPI host controller instead of MCU built-in one, board provides tuh_max3421_*_api()
+ifeq ($(MAX3421_HOST),1)
+  SRC_C += src/portable/analog/max3421/hcd_max3421.c
+  CFLAGS += -DCFG_TUH_MAX3421=1
+  CMAKE_DEFSYM += -DMAX3421_HOST=1
+endif
+
 INC += \
   $(TOP)/$(FAMILY_PATH) \
   $(TOP)/src \
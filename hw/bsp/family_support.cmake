@@ -245,9 +245,18 @@ function(family_add_tinyusb TARGET OPT_MCU RTOS)
     target_compile_definitions(${TARGET}-tinyusb_config INTERFACE CFG_TUSB_OS=OPT_OS_FREERTOS)
   endif ()
 
+  # MAX3421E SPI host controller instead of MCU built-in one, board provides tuh_max3421_*_api()
+  if (MAX3421_HOST STREQUAL "1")
+    target_compile_definitions(${TARGET}-tinyusb_config INTERFACE CFG_TUH_MAX3421=1)
+  endif ()
+
   # tinyusb's CMakeList.txt
   add_subdirectory(${TOP}/src ${CMAKE_CURRENT_BINARY_DIR}/tinyusb)
 
+  if (MAX3421_HOST STREQUAL "1")
+    target_sources(${TARGET}-tinyusb PRIVATE ${TOP}/src/portable/analog/max3421/hcd_max3421.c)
+  endif ()
+
   if (RTOS STREQUAL "freertos")
     # link tinyusb with freeRTOS kernel
     target_link_libraries(${TARGET}-tinyusb PUBLIC freertos_kernel)
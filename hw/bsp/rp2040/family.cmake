@@ -31,6 +31,8 @@ add_library(tinyusb_common_base INTERFACE)
 target_sources(tinyusb_common_base INTERFACE
 		${TOP}/src/tusb.c
 		${TOP}/src/common/tusb_fifo.c
+		${TOP}/src/class/vendor/vendor_mux.c
+		${TOP}/src/class/bridge/bridge.c
 		)
 
 target_include_directories(tinyusb_common_base INTERFACE
@@ -75,10 +77,13 @@ target_sources(tinyusb_device_base INTERFACE
 		${TOP}/src/class/hid/hid_device.c
 		${TOP}/src/class/midi/midi_device.c
 		${TOP}/src/class/msc/msc_device.c
+		${TOP}/src/class/msc/msc_image.c
 		${TOP}/src/class/net/ecm_rndis_device.c
 		${TOP}/src/class/net/ncm_device.c
+		${TOP}/src/class/net/net_csum.c
 		${TOP}/src/class/usbtmc/usbtmc_device.c
 		${TOP}/src/class/vendor/vendor_device.c
+		${TOP}/src/class/zero/zero_device.c
 		${TOP}/src/class/video/video_device.c
 		)
 
@@ -95,6 +100,8 @@ target_sources(tinyusb_host_base INTERFACE
 		${TOP}/src/class/hid/hid_host.c
 		${TOP}/src/class/msc/msc_host.c
 		${TOP}/src/class/vendor/vendor_host.c
+		${TOP}/src/class/vendor/vendor_mux_host.c
+		${TOP}/src/class/zero/zero_host.c
 		)
 
 # Sometimes have to do host specific actions in mostly common functions
@@ -113,21 +113,21 @@
 // EP IN software buffers and mutexes
 #if CFG_TUD_AUDIO_ENABLE_EP_IN && !CFG_TUD_AUDIO_ENABLE_ENCODING
   #if CFG_TUD_AUDIO_FUNC_1_EP_IN_SW_BUF_SZ > 0
-    CFG_TUD_MEM_SECTION CFG_TUSB_MEM_ALIGN uint8_t audio_ep_in_sw_buf_1[CFG_TUD_AUDIO_FUNC_1_EP_IN_SW_BUF_SZ];
+    CFG_TUD_MEM_SECTION CFG_TUD_MEM_ALIGN uint8_t audio_ep_in_sw_buf_1[TUD_EPBUF_SIZE(CFG_TUD_AUDIO_FUNC_1_EP_IN_SW_BUF_SZ)];
     #if CFG_FIFO_MUTEX
     osal_mutex_def_t ep_in_ff_mutex_wr_1; // No need for read mutex as only USB driver reads from FIFO
     #endif
   #endif // CFG_TUD_AUDIO_FUNC_1_EP_IN_SW_BUF_SZ > 0
 
   #if CFG_TUD_AUDIO > 1 && CFG_TUD_AUDIO_FUNC_2_EP_IN_SW_BUF_SZ > 0
-    CFG_TUD_MEM_SECTION CFG_TUSB_MEM_ALIGN uint8_t audio_ep_in_sw_buf_2[CFG_TUD_AUDIO_FUNC_2_EP_IN_SW_BUF_SZ];
+    CFG_TUD_MEM_SECTION CFG_TUD_MEM_ALIGN uint8_t audio_ep_in_sw_buf_2[TUD_EPBUF_SIZE(CFG_TUD_AUDIO_FUNC_2_EP_IN_SW_BUF_SZ)];
     #if CFG_FIFO_MUTEX
     osal_mutex_def_t ep_in_ff_mutex_wr_2; // No need for read mutex as only USB driver reads from FIFO
     #endif
   #endif // CFG_TUD_AUDIO > 1 && CFG_TUD_AUDIO_FUNC_2_EP_IN_SW_BUF_SZ > 0
 
   #if CFG_TUD_AUDIO > 2 && CFG_TUD_AUDIO_FUNC_3_EP_IN_SW_BUF_SZ > 0
-    CFG_TUD_MEM_SECTION CFG_TUSB_MEM_ALIGN uint8_t audio_ep_in_sw_buf_3[CFG_TUD_AUDIO_FUNC_3_EP_IN_SW_BUF_SZ];
+    CFG_TUD_MEM_SECTION CFG_TUD_MEM_ALIGN uint8_t audio_ep_in_sw_buf_3[TUD_EPBUF_SIZE(CFG_TUD_AUDIO_FUNC_3_EP_IN_SW_BUF_SZ)];
     #if CFG_FIFO_MUTEX
     osal_mutex_def_t ep_in_ff_mutex_wr_3; // No need for read mutex as only USB driver reads from FIFO
     #endif
@@ -139,36 +139,36 @@
 // - the software encoding is used - in this case the linear buffers serve as a target memory where logical channels are encoded into
 #if CFG_TUD_AUDIO_ENABLE_EP_IN && (USE_LINEAR_BUFFER || CFG_TUD_AUDIO_ENABLE_ENCODING)
   #if CFG_TUD_AUDIO_FUNC_1_EP_IN_SZ_MAX > 0
-    CFG_TUD_MEM_SECTION CFG_TUSB_MEM_ALIGN uint8_t lin_buf_in_1[CFG_TUD_AUDIO_FUNC_1_EP_IN_SZ_MAX];
+    CFG_TUD_MEM_SECTION CFG_TUD_MEM_ALIGN uint8_t lin_buf_in_1[TUD_EPBUF_SIZE(CFG_TUD_AUDIO_FUNC_1_EP_IN_SZ_MAX)];
   #endif
 
   #if CFG_TUD_AUDIO > 1 && CFG_TUD_AUDIO_FUNC_2_EP_IN_SZ_MAX > 0
-    CFG_TUD_MEM_SECTION CFG_TUSB_MEM_ALIGN uint8_t lin_buf_in_2[CFG_TUD_AUDIO_FUNC_2_EP_IN_SZ_MAX];
+    CFG_TUD_MEM_SECTION CFG_TUD_MEM_ALIGN uint8_t lin_buf_in_2[TUD_EPBUF_SIZE(CFG_TUD_AUDIO_FUNC_2_EP_IN_SZ_MAX)];
   #endif
 
   #if CFG_TUD_AUDIO > 2 && CFG_TUD_AUDIO_FUNC_3_EP_IN_SZ_MAX > 0
-    CFG_TUD_MEM_SECTION CFG_TUSB_MEM_ALIGN uint8_t lin_buf_in_3[CFG_TUD_AUDIO_FUNC_3_EP_IN_SZ_MAX];
+    CFG_TUD_MEM_SECTION CFG_TUD_MEM_ALIGN uint8_t lin_buf_in_3[TUD_EPBUF_SIZE(CFG_TUD_AUDIO_FUNC_3_EP_IN_SZ_MAX)];
   #endif
 #endif // CFG_TUD_AUDIO_ENABLE_EP_IN && (USE_LINEAR_BUFFER || CFG_TUD_AUDIO_ENABLE_DECODING)
 
 // EP OUT software buffers and mutexes
 #if CFG_TUD_AUDIO_ENABLE_EP_OUT && !CFG_TUD_AUDIO_ENABLE_DECODING
   #if CFG_TUD_AUDIO_FUNC_1_EP_OUT_SW_BUF_SZ > 0
-    CFG_TUD_MEM_SECTION CFG_TUSB_MEM_ALIGN uint8_t audio_ep_out_sw_buf_1[CFG_TUD_AUDIO_FUNC_1_EP_OUT_SW_BUF_SZ];
+    CFG_TUD_MEM_SECTION CFG_TUD_MEM_ALIGN uint8_t audio_ep_out_sw_buf_1[TUD_EPBUF_SIZE(CFG_TUD_AUDIO_FUNC_1_EP_OUT_SW_BUF_SZ)];
     #if CFG_FIFO_MUTEX
     osal_mutex_def_t ep_out_ff_mutex_rd_1; // No need for write mutex as only USB driver writes into FIFO
     #endif
   #endif // CFG_TUD_AUDIO_FUNC_1_EP_OUT_SW_BUF_SZ > 0
 
   #if CFG_TUD_AUDIO > 1 && CFG_TUD_AUDIO_FUNC_2_EP_OUT_SW_BUF_SZ > 0
-    CFG_TUD_MEM_SECTION CFG_TUSB_MEM_ALIGN uint8_t audio_ep_out_sw_buf_2[CFG_TUD_AUDIO_FUNC_2_EP_OUT_SW_BUF_SZ];
+    CFG_TUD_MEM_SECTION CFG_TUD_MEM_ALIGN uint8_t audio_ep_out_sw_buf_2[TUD_EPBUF_SIZE(CFG_TUD_AUDIO_FUNC_2_EP_OUT_SW_BUF_SZ)];
     #if CFG_FIFO_MUTEX
     osal_mutex_def_t ep_out_ff_mutex_rd_2; // No need for write mutex as only USB driver writes into FIFO
     #endif
   #endif // CFG_TUD_AUDIO > 1 && CFG_TUD_AUDIO_FUNC_2_EP_OUT_SW_BUF_SZ > 0
 
   #if CFG_TUD_AUDIO > 2 && CFG_TUD_AUDIO_FUNC_3_EP_OUT_SW_BUF_SZ > 0
-    CFG_TUD_MEM_SECTION CFG_TUSB_MEM_ALIGN uint8_t audio_ep_out_sw_buf_3[CFG_TUD_AUDIO_FUNC_3_EP_OUT_SW_BUF_SZ];
+    CFG_TUD_MEM_SECTION CFG_TUD_MEM_ALIGN uint8_t audio_ep_out_sw_buf_3[TUD_EPBUF_SIZE(CFG_TUD_AUDIO_FUNC_3_EP_OUT_SW_BUF_SZ)];
     #if CFG_FIFO_MUTEX
     osal_mutex_def_t ep_out_ff_mutex_rd_3; // No need for write mutex as only USB driver writes into FIFO
     #endif
@@ -180,15 +180,15 @@
 // - the software encoding is used - in this case the linear buffers serve as a target memory where logical channels are encoded into
 #if CFG_TUD_AUDIO_ENABLE_EP_OUT && (USE_LINEAR_BUFFER || CFG_TUD_AUDIO_ENABLE_DECODING)
   #if CFG_TUD_AUDIO_FUNC_1_EP_OUT_SZ_MAX > 0
-    CFG_TUD_MEM_SECTION CFG_TUSB_MEM_ALIGN uint8_t lin_buf_out_1[CFG_TUD_AUDIO_FUNC_1_EP_OUT_SZ_MAX];
+    CFG_TUD_MEM_SECTION CFG_TUD_MEM_ALIGN uint8_t lin_buf_out_1[TUD_EPBUF_SIZE(CFG_TUD_AUDIO_FUNC_1_EP_OUT_SZ_MAX)];
   #endif
 
   #if CFG_TUD_AUDIO > 1 && CFG_TUD_AUDIO_FUNC_2_EP_OUT_SZ_MAX > 0
-    CFG_TUD_MEM_SECTION CFG_TUSB_MEM_ALIGN uint8_t lin_buf_out_2[CFG_TUD_AUDIO_FUNC_2_EP_OUT_SZ_MAX];
+    CFG_TUD_MEM_SECTION CFG_TUD_MEM_ALIGN uint8_t lin_buf_out_2[TUD_EPBUF_SIZE(CFG_TUD_AUDIO_FUNC_2_EP_OUT_SZ_MAX)];
   #endif
 
   #if CFG_TUD_AUDIO > 2 && CFG_TUD_AUDIO_FUNC_3_EP_OUT_SZ_MAX > 0
-    CFG_TUD_MEM_SECTION CFG_TUSB_MEM_ALIGN uint8_t lin_buf_out_3[CFG_TUD_AUDIO_FUNC_3_EP_OUT_SZ_MAX];
+    CFG_TUD_MEM_SECTION CFG_TUD_MEM_ALIGN uint8_t lin_buf_out_3[TUD_EPBUF_SIZE(CFG_TUD_AUDIO_FUNC_3_EP_OUT_SZ_MAX)];
   #endif
 #endif // CFG_TUD_AUDIO_ENABLE_EP_OUT && (USE_LINEAR_BUFFER || CFG_TUD_AUDIO_ENABLE_DECODING)
 
@@ -267,6 +267,28 @@ uint8_t alt_setting_3[CFG_TUD_AUDIO_FUNC_3_N_AS_INT];
   #endif
 #endif
 
+// Gain stage applied within decoding/encoding copy
+#define AUDIOD_GAIN_RX    (CFG_TUD_AUDIO_ENABLE_GAIN && CFG_TUD_AUDIO_ENABLE_EP_OUT && CFG_TUD_AUDIO_ENABLE_DECODING)
+#define AUDIOD_GAIN_TX    (CFG_TUD_AUDIO_ENABLE_GAIN && CFG_TUD_AUDIO_ENABLE_EP_IN && CFG_TUD_AUDIO_ENABLE_ENCODING)
+
+#if AUDIOD_GAIN_RX || AUDIOD_GAIN_TX
+typedef struct
+{
+  uint16_t target;    // Gain set by application in Q1.15
+  uint16_t current;   // Gain applied to the last sample, ramps towards target (or zero if muted)
+  bool mute;
+} audiod_gain_t;
+#endif
+
+// Size of the AS interface lookup table, the largest number of AS interfaces of all audio functions
+#if CFG_TUD_AUDIO > 2
+  #define AUDIOD_N_AS_INT_MAX   TU_MAX(TU_MAX(CFG_TUD_AUDIO_FUNC_1_N_AS_INT, CFG_TUD_AUDIO_FUNC_2_N_AS_INT), TU_MAX(CFG_TUD_AUDIO_FUNC_3_N_AS_INT, 1))
+#elif CFG_TUD_AUDIO > 1
+  #define AUDIOD_N_AS_INT_MAX   TU_MAX(TU_MAX(CFG_TUD_AUDIO_FUNC_1_N_AS_INT, CFG_TUD_AUDIO_FUNC_2_N_AS_INT), 1)
+#else
+  #define AUDIOD_N_AS_INT_MAX   TU_MAX(CFG_TUD_AUDIO_FUNC_1_N_AS_INT, 1)
+#endif
+
 typedef struct
 {
   uint8_t rhport;
@@ -293,6 +315,21 @@ typedef struct
   uint8_t ep_int_ctr;           // Audio control interrupt EP.
 #endif
 
+  // Lookup tables built on open, so that class requests don't need to walk the descriptors
+  uint32_t entity_bitmap[8];                      // Entity IDs defined within the class specific AC descriptors
+  uint16_t as_itf_offset[AUDIOD_N_AS_INT_MAX];    // Offset of std. AS interface (alternate setting zero) from p_desc
+  uint8_t  as_itf_num[AUDIOD_N_AS_INT_MAX];       // Interface number of std. AS interface
+  uint8_t  n_as_itf;                              // Number of AS interfaces
+
+#if CFG_TUD_XFER_TIMESTAMP
+#if CFG_TUD_AUDIO_ENABLE_EP_IN
+  usbd_stream_ts_t ts_in;       // Application write until transmitted
+#endif
+#if CFG_TUD_AUDIO_ENABLE_EP_OUT
+  usbd_stream_ts_t ts_out;      // Reception until read by application
+#endif
+#endif
+
   /*------------- From this point, data is not cleared by bus reset -------------*/
 
   uint16_t desc_length;         // Length of audio function descriptor
@@ -304,6 +341,16 @@ typedef struct
   // Current active alternate settings
   uint8_t * alt_setting;   // We need to save the current alternate setting this way, because it is possible that there are AS interfaces which do not have an EP!
 
+#if CFG_TUD_AUDIO_ENABLE_EP_IN && CFG_TUD_AUDIO_ENABLE_IMPLICIT_FEEDBACK
+  // IN packet pacing for implicit feedback
+  struct {
+    uint32_t rate;          // Samples per (micro)frame in 16.16 set by application, 0 = not paced
+    uint32_t phase;         // Fraction of a sample carried over to the next packet in 16.16
+    uint16_t frame_sz;      // Bytes per audio frame (one sample of every channel) of active alternate setting, 0 = not paced
+    uint8_t interval_shift; // bInterval-1 of IN data EP
+  } implicit_fb;
+#endif
+
   // EP Transfer buffers and FIFOs
 #if CFG_TUD_AUDIO_ENABLE_EP_OUT
 #if !CFG_TUD_AUDIO_ENABLE_DECODING
@@ -347,7 +394,7 @@ typedef struct
 
   // Audio control interrupt buffer - no FIFO - 6 Bytes according to UAC 2 specification (p. 74)
 #if CFG_TUD_AUDIO_INT_CTR_EPSIZE_IN
-  CFG_TUSB_MEM_ALIGN uint8_t ep_int_ctr_buf[CFG_TUD_AUDIO_INT_CTR_EP_IN_SW_BUFFER_SIZE];
+  TUD_EPBUF_DEF(ep_int_ctr_buf, CFG_TUD_AUDIO_INT_CTR_EP_IN_SW_BUFFER_SIZE);
 #endif
 
   // Decoding parameters - parameters are set when alternate AS interface is set by host
@@ -362,6 +409,10 @@ typedef struct
   uint8_t n_channels_per_ff_rx;
   uint8_t n_ff_used_rx;
 #endif
+
+#if AUDIOD_GAIN_RX
+  audiod_gain_t gain_rx;
+#endif
 #endif
 
   // Encoding parameters - parameters are set when alternate AS interface is set by host
@@ -375,6 +426,10 @@ typedef struct
   uint8_t n_channels_per_ff_tx;
   uint8_t n_ff_used_tx;
 #endif
+
+#if AUDIOD_GAIN_TX
+  audiod_gain_t gain_tx;
+#endif
 #endif
 
   // Support FIFOs for software encoding and decoding
@@ -430,6 +485,15 @@ static bool audiod_decode_type_I_pcm(uint8_t rhport, audiod_function_t* audio, u
 static bool audiod_tx_done_cb(uint8_t rhport, audiod_function_t* audio);
 #endif
 
+#if CFG_TUD_AUDIO_ENABLE_EP_IN && CFG_TUD_AUDIO_ENABLE_IMPLICIT_FEEDBACK
+static uint16_t audiod_implicit_fb_n_frames(audiod_function_t* audio, uint16_t n_frames_available);
+static uint16_t audiod_implicit_fb_frame_size(uint8_t const * p_desc, uint8_t const * p_desc_end);
+#endif
+
+#if AUDIOD_GAIN_RX || AUDIOD_GAIN_TX
+static void audiod_gain_copy(uint8_t const n_bytes, uint8_t * dst, uint16_t const dst_step, uint8_t const * src, uint16_t const src_step, uint16_t n_samples, audiod_gain_t * gain);
+#endif
+
 #if CFG_TUD_AUDIO_ENABLE_ENCODING && CFG_TUD_AUDIO_ENABLE_EP_IN
 static uint16_t audiod_encode_type_I_pcm(uint8_t rhport, audiod_function_t* audio);
 #endif
@@ -442,16 +506,17 @@ static bool audiod_get_AS_interface_index(uint8_t itf, audiod_function_t * audio
 static bool audiod_verify_entity_exists(uint8_t itf, uint8_t entityID, uint8_t *func_id);
 static bool audiod_verify_itf_exists(uint8_t itf, uint8_t *func_id);
 static bool audiod_verify_ep_exists(uint8_t ep, uint8_t *func_id);
+static void audiod_build_lookup(audiod_function_t *audio);
 static uint8_t audiod_get_audio_fct_idx(audiod_function_t * audio);
 
 #if CFG_TUD_AUDIO_ENABLE_ENCODING || CFG_TUD_AUDIO_ENABLE_DECODING
 static void audiod_parse_for_AS_params(audiod_function_t* audio, uint8_t const * p_desc, uint8_t const * p_desc_end, uint8_t const as_itf);
+#endif
 
 static inline uint8_t tu_desc_subtype(void const* desc)
 {
   return ((uint8_t const*) desc)[2];
 }
-#endif
 
 #if CFG_TUD_AUDIO_ENABLE_EP_OUT && CFG_TUD_AUDIO_ENABLE_FEEDBACK_EP
 static bool set_fb_params_freq(audiod_function_t* audio, uint32_t sample_freq, uint32_t mclk_freq);
@@ -496,12 +561,19 @@ uint16_t tud_audio_n_available(uint8_t func_id)
 uint16_t tud_audio_n_read(uint8_t func_id, void* buffer, uint16_t bufsize)
 {
   TU_VERIFY(func_id < CFG_TUD_AUDIO && _audiod_fct[func_id].p_desc != NULL);
-  return tu_fifo_read_n(&_audiod_fct[func_id].ep_out_ff, buffer, bufsize);
+  uint16_t const n_bytes = tu_fifo_read_n(&_audiod_fct[func_id].ep_out_ff, buffer, bufsize);
+#if CFG_TUD_XFER_TIMESTAMP
+  usbd_stream_ts_consume(&_audiod_fct[func_id].ts_out, n_bytes, tud_sof_clock());
+#endif
+  return n_bytes;
 }
 
 bool tud_audio_n_clear_ep_out_ff(uint8_t func_id)
 {
   TU_VERIFY(func_id < CFG_TUD_AUDIO && _audiod_fct[func_id].p_desc != NULL);
+#if CFG_TUD_XFER_TIMESTAMP
+  tu_varclr(&_audiod_fct[func_id].ts_out);
+#endif
   return tu_fifo_clear(&_audiod_fct[func_id].ep_out_ff);
 }
 
@@ -709,6 +781,13 @@ static bool audiod_decode_type_I_pcm(uint8_t rhport, audiod_function_t* audio, u
   uint16_t const nBytesPerFFToRead      = n_bytes_received / n_ff_used;
   uint8_t cnt_ff;
 
+#if AUDIOD_GAIN_RX
+  // Every FIFO ramps from the same gain, the gain stage is skipped at unity
+  audiod_gain_t * const gain = &audio->gain_rx;
+  uint16_t const gain_start = gain->current;
+  bool const use_gain = gain->mute || (gain->target != TUD_AUDIO_GAIN_UNITY) || (gain_start != TUD_AUDIO_GAIN_UNITY);
+#endif
+
   // Decode
   uint8_t * src;
   uint8_t * dst_end;
@@ -722,16 +801,32 @@ static bool audiod_decode_type_I_pcm(uint8_t rhport, audiod_function_t* audio, u
     if (info.len_lin != 0)
     {
       info.len_lin = tu_min16(nBytesPerFFToRead, info.len_lin);
+      info.len_wrap = tu_min16(nBytesPerFFToRead - info.len_lin, info.len_wrap);
       src = &audio->lin_buf_out[cnt_ff*audio->n_channels_per_ff_rx * audio->n_bytes_per_sampe_rx];
-      dst_end = info.ptr_lin + info.len_lin;
-      src = audiod_interleaved_copy_bytes_fast_decode(audio->n_bytes_per_sampe_rx, info.ptr_lin, dst_end, src, n_ff_used);
 
-      // Handle wrapped part of FIFO
-      info.len_wrap = tu_min16(nBytesPerFFToRead - info.len_lin, info.len_wrap);
-      if (info.len_wrap != 0)
+#if AUDIOD_GAIN_RX
+      if (use_gain)
       {
-        dst_end = info.ptr_wrap + info.len_wrap;
-        audiod_interleaved_copy_bytes_fast_decode(audio->n_bytes_per_sampe_rx, info.ptr_wrap, dst_end, src, n_ff_used);
+        uint8_t const n_bytes = audio->n_bytes_per_sampe_rx;
+        uint16_t const src_step = n_bytes * n_ff_used;
+
+        gain->current = gain_start;
+        audiod_gain_copy(n_bytes, info.ptr_lin, n_bytes, src, src_step, info.len_lin / n_bytes, gain);
+        src += (info.len_lin / n_bytes) * src_step;
+        audiod_gain_copy(n_bytes, info.ptr_wrap, n_bytes, src, src_step, info.len_wrap / n_bytes, gain);
+      }
+      else
+#endif
+      {
+        dst_end = info.ptr_lin + info.len_lin;
+        src = audiod_interleaved_copy_bytes_fast_decode(audio->n_bytes_per_sampe_rx, info.ptr_lin, dst_end, src, n_ff_used);
+
+        // Handle wrapped part of FIFO
+        if (info.len_wrap != 0)
+        {
+          dst_end = info.ptr_wrap + info.len_wrap;
+          audiod_interleaved_copy_bytes_fast_decode(audio->n_bytes_per_sampe_rx, info.ptr_wrap, dst_end, src, n_ff_used);
+        }
       }
       tu_fifo_advance_write_pointer(&audio->rx_supp_ff[cnt_ff], info.len_lin + info.len_wrap);
     }
@@ -764,12 +859,19 @@ static bool audiod_decode_type_I_pcm(uint8_t rhport, audiod_function_t* audio, u
 uint16_t tud_audio_n_write(uint8_t func_id, const void * data, uint16_t len)
 {
   TU_VERIFY(func_id < CFG_TUD_AUDIO && _audiod_fct[func_id].p_desc != NULL);
-  return tu_fifo_write_n(&_audiod_fct[func_id].ep_in_ff, data, len);
+  uint16_t const n_bytes = tu_fifo_write_n(&_audiod_fct[func_id].ep_in_ff, data, len);
+#if CFG_TUD_XFER_TIMESTAMP
+  usbd_stream_ts_mark(&_audiod_fct[func_id].ts_in, n_bytes, tud_sof_clock());
+#endif
+  return n_bytes;
 }
 
 bool tud_audio_n_clear_ep_in_ff(uint8_t func_id)                          // Delete all content in the EP IN FIFO
 {
   TU_VERIFY(func_id < CFG_TUD_AUDIO && _audiod_fct[func_id].p_desc != NULL);
+#if CFG_TUD_XFER_TIMESTAMP
+  tu_varclr(&_audiod_fct[func_id].ts_in);
+#endif
   return tu_fifo_clear(&_audiod_fct[func_id].ep_in_ff);
 }
 
@@ -907,6 +1009,14 @@ static bool audiod_tx_done_cb(uint8_t rhport, audiod_function_t * audio)
 
   n_bytes_tx = tu_min16(tu_fifo_count(&audio->ep_in_ff), audio->ep_in_sz);      // Limit up to max packet size, more can not be done for ISO
 
+#if CFG_TUD_AUDIO_ENABLE_IMPLICIT_FEEDBACK
+  // Send as many audio frames as the codec clock produced
+  if (audio->implicit_fb.frame_sz)
+  {
+    n_bytes_tx = audiod_implicit_fb_n_frames(audio, n_bytes_tx / audio->implicit_fb.frame_sz) * audio->implicit_fb.frame_sz;
+  }
+#endif
+
 #if USE_LINEAR_BUFFER_TX
   tu_fifo_read_n(&audio->ep_in_ff, audio->lin_buf_in, n_bytes_tx);
   TU_VERIFY(usbd_edpt_xfer(rhport, audio->ep_in, audio->lin_buf_in, n_bytes_tx));
@@ -1035,7 +1145,24 @@ static uint16_t audiod_encode_type_I_pcm(uint8_t rhport, audiod_function_t* audi
   nBytesPerFFToSend = tu_min16(nBytesPerFFToSend, capPerFF);
 
   // Round to full number of samples (flooring)
-  nBytesPerFFToSend = (nBytesPerFFToSend / nBytesToCopy) * nBytesToCopy;
+#if CFG_TUD_AUDIO_ENABLE_IMPLICIT_FEEDBACK
+  // and send as many audio frames as the codec clock produced
+  if (audio->implicit_fb.frame_sz)
+  {
+    nBytesPerFFToSend = audiod_implicit_fb_n_frames(audio, nBytesPerFFToSend / nBytesToCopy) * nBytesToCopy;
+  }
+  else
+#endif
+  {
+    nBytesPerFFToSend = (nBytesPerFFToSend / nBytesToCopy) * nBytesToCopy;
+  }
+
+#if AUDIOD_GAIN_TX
+  // Every FIFO ramps from the same gain, the gain stage is skipped at unity
+  audiod_gain_t * const gain = &audio->gain_tx;
+  uint16_t const gain_start = gain->current;
+  bool const use_gain = gain->mute || (gain->target != TUD_AUDIO_GAIN_UNITY) || (gain_start != TUD_AUDIO_GAIN_UNITY);
+#endif
 
   // Encode
   uint8_t * dst;
@@ -1051,18 +1178,33 @@ static uint16_t audiod_encode_type_I_pcm(uint8_t rhport, audiod_function_t* audi
 
     if (info.len_lin != 0)
     {
-      info.len_lin = tu_min16(nBytesPerFFToSend, info.len_lin);       // Limit up to desired length
-      src_end = (uint8_t *)info.ptr_lin + info.len_lin;
-      dst = audiod_interleaved_copy_bytes_fast_encode(audio->n_bytes_per_sampe_tx, info.ptr_lin, src_end, dst, n_ff_used);
-
       // Limit up to desired length
+      info.len_lin = tu_min16(nBytesPerFFToSend, info.len_lin);
       info.len_wrap = tu_min16(nBytesPerFFToSend - info.len_lin, info.len_wrap);
 
-      // Handle wrapped part of FIFO
-      if (info.len_wrap != 0)
+#if AUDIOD_GAIN_TX
+      if (use_gain)
       {
-        src_end = (uint8_t *)info.ptr_wrap + info.len_wrap;
-        audiod_interleaved_copy_bytes_fast_encode(audio->n_bytes_per_sampe_tx, info.ptr_wrap, src_end, dst, n_ff_used);
+        uint8_t const n_bytes = audio->n_bytes_per_sampe_tx;
+        uint16_t const dst_step = n_bytes * n_ff_used;
+
+        gain->current = gain_start;
+        audiod_gain_copy(n_bytes, dst, dst_step, info.ptr_lin, n_bytes, info.len_lin / n_bytes, gain);
+        dst += (info.len_lin / n_bytes) * dst_step;
+        audiod_gain_copy(n_bytes, dst, dst_step, info.ptr_wrap, n_bytes, info.len_wrap / n_bytes, gain);
+      }
+      else
+#endif
+      {
+        src_end = (uint8_t *)info.ptr_lin + info.len_lin;
+        dst = audiod_interleaved_copy_bytes_fast_encode(audio->n_bytes_per_sampe_tx, info.ptr_lin, src_end, dst, n_ff_used);
+
+        // Handle wrapped part of FIFO
+        if (info.len_wrap != 0)
+        {
+          src_end = (uint8_t *)info.ptr_wrap + info.len_wrap;
+          audiod_interleaved_copy_bytes_fast_encode(audio->n_bytes_per_sampe_tx, info.ptr_wrap, src_end, dst, n_ff_used);
+        }
       }
 
       tu_fifo_advance_read_pointer(&audio->tx_supp_ff[cnt_ff], info.len_lin + info.len_wrap);
@@ -1073,6 +1215,113 @@ static uint16_t audiod_encode_type_I_pcm(uint8_t rhport, audiod_function_t* audi
 }
 #endif //CFG_TUD_AUDIO_ENABLE_ENCODING
 
+//--------------------------------------------------------------------+
+// GAIN API
+//--------------------------------------------------------------------+
+#if CFG_TUD_AUDIO_ENABLE_GAIN
+
+uint16_t tud_audio_gain_from_db(int16_t volume)
+{
+  // -inf dB
+  if (volume == INT16_MIN) return 0;
+
+  // log2(gain) in Q16: volume / (256 * 20 * log10(2)) * 65536 ~ volume * 42.52
+  int32_t const log2_gain = (int32_t) volume * 10885 / 256;
+  int32_t n = log2_gain / 65536;
+  int32_t f = log2_gain - n * 65536;
+  if (f < 0)
+  {
+    n--;
+    f += 65536;
+  }
+
+  if (n >= 1) return UINT16_MAX;
+  if (n < -16) return 0;
+
+  // 2^f for f in [0, 1) in Q16: 1 + f * (0.6565 + 0.3435 * f), error below 0.4%
+  uint32_t const fu = (uint32_t) f;
+  uint32_t const pow2_f = 65536u + ((fu * (43024u + ((fu * 22512u) >> 16))) >> 16);
+
+  // Q16 to Q1.15
+  return (uint16_t) tu_min32(pow2_f >> (1 - n), UINT16_MAX);
+}
+
+#endif // CFG_TUD_AUDIO_ENABLE_GAIN
+
+#if AUDIOD_GAIN_RX || AUDIOD_GAIN_TX
+
+// Copy n_samples PCM samples of n_bytes (little endian, left-justified) and scale them by the gain. Gain ramps by
+// CFG_TUD_AUDIO_GAIN_RAMP_STEP per sample towards target (or zero if muted), result saturates.
+static void audiod_gain_copy(uint8_t const n_bytes, uint8_t * dst, uint16_t const dst_step, uint8_t const * src, uint16_t const src_step, uint16_t n_samples, audiod_gain_t * gain)
+{
+  uint16_t const target = gain->mute ? 0 : gain->target;
+  uint16_t cur = gain->current;
+  uint8_t const shift = (uint8_t) (32 - 8*n_bytes);
+
+  while (n_samples--)
+  {
+    if (cur != target)
+    {
+      cur = (cur < target) ? (uint16_t) tu_min32((uint32_t) cur + CFG_TUD_AUDIO_GAIN_RAMP_STEP, target)
+                           : (uint16_t) tu_max32((uint32_t) cur - tu_min32(cur, CFG_TUD_AUDIO_GAIN_RAMP_STEP), target);
+    }
+
+    // Justify sample to the MSB of a 32 bit word
+    uint32_t u = 0;
+    for (uint8_t i = 0; i < n_bytes; i++) u |= ((uint32_t) src[i]) << (8*i + shift);
+
+    int64_t v = ((int64_t) (int32_t) u * cur) >> 15;
+    if (v > INT32_MAX) v = INT32_MAX;
+    if (v < INT32_MIN) v = INT32_MIN;
+
+    u = (uint32_t) (int32_t) v;
+    for (uint8_t i = 0; i < n_bytes; i++) dst[i] = (uint8_t) (u >> (8*i + shift));
+
+    src += src_step;
+    dst += dst_step;
+  }
+
+  gain->current = cur;
+}
+
+#endif
+
+#if AUDIOD_GAIN_RX
+
+bool tud_audio_n_set_rx_gain(uint8_t func_id, uint16_t gain)
+{
+  TU_VERIFY(func_id < CFG_TUD_AUDIO);
+  _audiod_fct[func_id].gain_rx.target = gain;
+  return true;
+}
+
+bool tud_audio_n_set_rx_mute(uint8_t func_id, bool mute)
+{
+  TU_VERIFY(func_id < CFG_TUD_AUDIO);
+  _audiod_fct[func_id].gain_rx.mute = mute;
+  return true;
+}
+
+#endif
+
+#if AUDIOD_GAIN_TX
+
+bool tud_audio_n_set_tx_gain(uint8_t func_id, uint16_t gain)
+{
+  TU_VERIFY(func_id < CFG_TUD_AUDIO);
+  _audiod_fct[func_id].gain_tx.target = gain;
+  return true;
+}
+
+bool tud_audio_n_set_tx_mute(uint8_t func_id, bool mute)
+{
+  TU_VERIFY(func_id < CFG_TUD_AUDIO);
+  _audiod_fct[func_id].gain_tx.mute = mute;
+  return true;
+}
+
+#endif
+
 // This function is called once a transmit of a feedback packet was successfully completed. Here, we get the next feedback value to be sent
 
 #if CFG_TUD_AUDIO_ENABLE_EP_OUT && CFG_TUD_AUDIO_ENABLE_FEEDBACK_EP
@@ -1395,6 +1644,13 @@ void audiod_init(void)
 #endif
     }
 #endif // CFG_TUD_AUDIO_ENABLE_TYPE_I_DECODING
+
+#if AUDIOD_GAIN_RX
+    audio->gain_rx.target = audio->gain_rx.current = TUD_AUDIO_GAIN_UNITY;
+#endif
+#if AUDIOD_GAIN_TX
+    audio->gain_tx.target = audio->gain_tx.current = TUD_AUDIO_GAIN_UNITY;
+#endif
   }
 }
 
@@ -1477,6 +1733,8 @@ uint16_t audiod_open(uint8_t rhport, tusb_desc_interface_t const * itf_desc, uin
 #endif
       }
 
+      audiod_build_lookup(&_audiod_fct[i]);
+
 #if USE_ISO_EP_ALLOCATION
   #if CFG_TUD_AUDIO_ENABLE_EP_IN
       uint8_t  ep_in = 0;
@@ -1515,13 +1773,13 @@ uint16_t audiod_open(uint8_t rhport, tusb_desc_interface_t const * itf_desc, uin
               {
   #if CFG_TUD_AUDIO_ENABLE_EP_IN
                 ep_in = desc_ep->bEndpointAddress;
-                ep_in_size = TU_MAX(tu_edpt_packet_size(desc_ep), ep_in_size);
+                ep_in_size = TU_MAX(tu_edpt_bytes_per_interval(desc_ep), ep_in_size);
   #endif
               } else
               {
   #if CFG_TUD_AUDIO_ENABLE_EP_OUT
                 ep_out = desc_ep->bEndpointAddress;
-                ep_out_size = TU_MAX(tu_edpt_packet_size(desc_ep), ep_out_size);
+                ep_out_size = TU_MAX(tu_edpt_bytes_per_interval(desc_ep), ep_out_size);
   #endif
               }
             }
@@ -1628,6 +1886,9 @@ static bool audiod_set_interface(uint8_t rhport, tusb_control_request_t const *
       tu_fifo_clear(&audio->tx_supp_ff[cnt]);
     }
   #endif
+  #if CFG_TUD_XFER_TIMESTAMP
+    tu_varclr(&audio->ts_in);
+  #endif
 
     // Invoke callback - can be used to stop data sampling
     if (tud_audio_set_itf_close_EP_cb) TU_VERIFY(tud_audio_set_itf_close_EP_cb(rhport, p_request));
@@ -1654,6 +1915,9 @@ static bool audiod_set_interface(uint8_t rhport, tusb_control_request_t const *
       tu_fifo_clear(&audio->rx_supp_ff[cnt]);
     }
   #endif
+  #if CFG_TUD_XFER_TIMESTAMP
+    tu_varclr(&audio->ts_out);
+  #endif
 
     // Invoke callback - can be used to stop data sampling
     if (tud_audio_set_itf_close_EP_cb) TU_VERIFY(tud_audio_set_itf_close_EP_cb(rhport, p_request));
@@ -1684,7 +1948,7 @@ static bool audiod_set_interface(uint8_t rhport, tusb_control_request_t const *
     // Find correct interface
     if (tu_desc_type(p_desc) == TUSB_DESC_INTERFACE && ((tusb_desc_interface_t const * )p_desc)->bInterfaceNumber == itf && ((tusb_desc_interface_t const * )p_desc)->bAlternateSetting == alt)
     {
-#if CFG_TUD_AUDIO_ENABLE_ENCODING || CFG_TUD_AUDIO_ENABLE_DECODING
+#if CFG_TUD_AUDIO_ENABLE_ENCODING || CFG_TUD_AUDIO_ENABLE_DECODING || CFG_TUD_AUDIO_ENABLE_IMPLICIT_FEEDBACK
       uint8_t const * p_desc_parse_for_params = p_desc;
 #endif
       // From this point forward follow the EP descriptors associated to the current alternate setting interface - Open EPs if necessary
@@ -1705,12 +1969,22 @@ static bool audiod_set_interface(uint8_t rhport, tusb_control_request_t const *
           usbd_edpt_clear_stall(rhport, ep_addr);
 
 #if CFG_TUD_AUDIO_ENABLE_EP_IN
+#if CFG_TUD_AUDIO_ENABLE_IMPLICIT_FEEDBACK
+          if (tu_edpt_dir(ep_addr) == TUSB_DIR_IN && (desc_ep->bmAttributes.usage == 0x00 || desc_ep->bmAttributes.usage == 0x02))   // Check if usage is data EP or implicit feedback data EP
+#else
           if (tu_edpt_dir(ep_addr) == TUSB_DIR_IN && desc_ep->bmAttributes.usage == 0x00)   // Check if usage is data EP
+#endif
           {
             // Save address
             audio->ep_in = ep_addr;
             audio->ep_in_as_intf_num = itf;
-            audio->ep_in_sz = tu_edpt_packet_size(desc_ep);
+            audio->ep_in_sz = tu_edpt_bytes_per_interval(desc_ep);
+
+  #if CFG_TUD_AUDIO_ENABLE_IMPLICIT_FEEDBACK
+            audio->implicit_fb.frame_sz = audiod_implicit_fb_frame_size(p_desc_parse_for_params, p_desc_end);
+            audio->implicit_fb.interval_shift = (uint8_t) (desc_ep->bInterval - 1);
+            audio->implicit_fb.phase = 0;
+  #endif
 
             // If software encoding is enabled, parse for the corresponding parameters - doing this here means only AS interfaces with EPs get scanned for parameters
   #if CFG_TUD_AUDIO_ENABLE_ENCODING
@@ -1741,7 +2015,7 @@ static bool audiod_set_interface(uint8_t rhport, tusb_control_request_t const *
             // Save address
             audio->ep_out = ep_addr;
             audio->ep_out_as_intf_num = itf;
-            audio->ep_out_sz = tu_edpt_packet_size(desc_ep);
+            audio->ep_out_sz = tu_edpt_bytes_per_interval(desc_ep);
 
   #if CFG_TUD_AUDIO_ENABLE_DECODING
             audiod_parse_for_AS_params(audio, p_desc_parse_for_params, p_desc_end, itf);
@@ -2060,6 +2334,70 @@ bool audiod_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_
   return true;
 }
 
+#if CFG_TUD_XFER_TIMESTAMP
+
+#if CFG_TUD_AUDIO_ENABLE_EP_IN
+// Transmitted packet leaves the stream, latency of application writes is sampled once fully transmitted
+static void audiod_tx_stamp(uint8_t rhport, uint8_t func_id, audiod_function_t* audio, uint32_t n_bytes)
+{
+  tud_stream_stamp_t stamp;
+  stamp.sof    = usbd_edpt_xfer_sof(rhport, audio->ep_in);
+  stamp.len    = n_bytes;
+  stamp.offset = usbd_stream_ts_consume(&audio->ts_in, n_bytes, stamp.sof);
+
+  if (tud_audio_tx_stamp_cb && n_bytes) tud_audio_tx_stamp_cb(func_id, &stamp);
+}
+#endif
+
+#if CFG_TUD_AUDIO_ENABLE_EP_OUT
+// Received packet enters the stream, latency is sampled once application read all of it
+static void audiod_rx_stamp(uint8_t rhport, uint8_t func_id, audiod_function_t* audio, uint32_t n_bytes)
+{
+  tud_stream_stamp_t stamp;
+  stamp.sof    = usbd_edpt_xfer_sof(rhport, audio->ep_out);
+  stamp.len    = n_bytes;
+  stamp.offset = usbd_stream_ts_mark(&audio->ts_out, n_bytes, stamp.sof);
+
+  if (tud_audio_rx_stamp_cb && n_bytes) tud_audio_rx_stamp_cb(func_id, &stamp);
+}
+#endif
+
+#if CFG_TUD_AUDIO_ENABLE_EP_IN
+bool tud_audio_n_tx_latency(uint8_t func_id, tud_latency_stat_t* stat, bool clear)
+{
+  TU_VERIFY(func_id < CFG_TUD_AUDIO && _audiod_fct[func_id].p_desc != NULL);
+  usbd_stream_ts_stat(&_audiod_fct[func_id].ts_in, stat, clear);
+  return true;
+}
+
+#if !CFG_TUD_AUDIO_ENABLE_ENCODING
+uint32_t tud_audio_n_tx_offset(uint8_t func_id)
+{
+  TU_VERIFY(func_id < CFG_TUD_AUDIO, 0);
+  return _audiod_fct[func_id].ts_in.wr_offset;
+}
+#endif
+#endif
+
+#if CFG_TUD_AUDIO_ENABLE_EP_OUT
+bool tud_audio_n_rx_latency(uint8_t func_id, tud_latency_stat_t* stat, bool clear)
+{
+  TU_VERIFY(func_id < CFG_TUD_AUDIO && _audiod_fct[func_id].p_desc != NULL);
+  usbd_stream_ts_stat(&_audiod_fct[func_id].ts_out, stat, clear);
+  return true;
+}
+
+#if !CFG_TUD_AUDIO_ENABLE_DECODING
+uint32_t tud_audio_n_rx_offset(uint8_t func_id)
+{
+  TU_VERIFY(func_id < CFG_TUD_AUDIO, 0);
+  return _audiod_fct[func_id].ts_out.rd_offset;
+}
+#endif
+#endif
+
+#endif // CFG_TUD_XFER_TIMESTAMP
+
 bool audiod_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes)
 {
   (void) result;
@@ -2100,6 +2438,10 @@ bool audiod_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint3
       // Be aware - we as a device are not able to know if the host polls for data with a faster rate as we stated this in the descriptors. Therefore we always have to put something into the EPs buffer. However, once we did that, there is no way of aborting this or replacing what we put into the buffer before!
       // This is the only place where we can fill something into the EPs buffer!
 
+#if CFG_TUD_XFER_TIMESTAMP
+      audiod_tx_stamp(rhport, func_id, audio, xferred_bytes);
+#endif
+
       // Load new data
       TU_VERIFY(audiod_tx_done_cb(rhport, audio));
 
@@ -2113,6 +2455,9 @@ bool audiod_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint3
     // New audio packet received
     if (audio->ep_out == ep_addr)
     {
+#if CFG_TUD_XFER_TIMESTAMP
+      audiod_rx_stamp(rhport, func_id, audio, xferred_bytes);
+#endif
       TU_VERIFY(audiod_rx_done_cb(rhport, audio, (uint16_t) xferred_bytes));
       return true;
     }
@@ -2303,29 +2648,15 @@ static bool audiod_get_AS_interface_index(uint8_t itf, audiod_function_t * audio
 {
   if (audio->p_desc)
   {
-    // Get pointer at end
-    uint8_t const *p_desc_end = audio->p_desc + audio->desc_length - TUD_AUDIO_DESC_IAD_LEN;
-
-    // Advance past AC descriptors
-    uint8_t const *p_desc = tu_desc_next(audio->p_desc);
-    p_desc += ((audio_desc_cs_ac_interface_t const *)p_desc)->wTotalLength;
-
-    uint8_t tmp = 0;
-    while (p_desc < p_desc_end)
+    uint8_t tmp;
+    for (tmp = 0; tmp < audio->n_as_itf; tmp++)
     {
-      // We assume the number of alternate settings is increasing thus we return the index of alternate setting zero!
-      if (tu_desc_type(p_desc) == TUSB_DESC_INTERFACE && ((tusb_desc_interface_t const * )p_desc)->bAlternateSetting == 0)
+      if (audio->as_itf_num[tmp] == itf)
       {
-        if (((tusb_desc_interface_t const * )p_desc)->bInterfaceNumber == itf)
-        {
-          *idxItf = tmp;
-          *pp_desc_int = p_desc;
-          return true;
-        }
-        // Increase index, bytes read, and pointer
-        tmp++;
+        *idxItf = tmp;
+        *pp_desc_int = audio->p_desc + audio->as_itf_offset[tmp];
+        return true;
       }
-      p_desc = tu_desc_next(p_desc);
     }
   }
   return false;
@@ -2359,25 +2690,17 @@ static bool audiod_verify_entity_exists(uint8_t itf, uint8_t entityID, uint8_t *
     // Look for the correct driver by checking if the unique standard AC interface number fits
     if (_audiod_fct[i].p_desc && ((tusb_desc_interface_t const *)_audiod_fct[i].p_desc)->bInterfaceNumber == itf)
     {
-      // Get pointers after class specific AC descriptors and end of AC descriptors - entities are defined in between
-      uint8_t const *p_desc = tu_desc_next(_audiod_fct[i].p_desc);                                          // Points to CS AC descriptor
-      uint8_t const *p_desc_end = ((audio_desc_cs_ac_interface_t const *)p_desc)->wTotalLength + p_desc;
-      p_desc = tu_desc_next(p_desc);                                                                            // Get past CS AC descriptor
-
-      while (p_desc < p_desc_end)
+      if (tu_bit_test(_audiod_fct[i].entity_bitmap[entityID >> 5], entityID & 0x1f))
       {
-        if (p_desc[3] == entityID)  // Entity IDs are always at offset 3
-        {
-          *func_id = i;
-          return true;
-        }
-        p_desc = tu_desc_next(p_desc);
+        *func_id = i;
+        return true;
       }
     }
   }
   return false;
 }
 
+// Verify the AC or an AS interface with the given number exists and returns also the corresponding driver index
 static bool audiod_verify_itf_exists(uint8_t itf, uint8_t *func_id)
 {
   uint8_t i;
@@ -2385,24 +2708,48 @@ static bool audiod_verify_itf_exists(uint8_t itf, uint8_t *func_id)
   {
     if (_audiod_fct[i].p_desc)
     {
-      // Get pointer at beginning and end
-      uint8_t const *p_desc = _audiod_fct[i].p_desc;
-      uint8_t const *p_desc_end = _audiod_fct[i].p_desc + _audiod_fct[i].desc_length - TUD_AUDIO_DESC_IAD_LEN;
-
-      while (p_desc < p_desc_end)
+      uint8_t idxItf;
+      uint8_t const *dummy;
+      if (((tusb_desc_interface_t const *)_audiod_fct[i].p_desc)->bInterfaceNumber == itf ||
+          audiod_get_AS_interface_index(itf, &_audiod_fct[i], &idxItf, &dummy))
       {
-        if (tu_desc_type(p_desc) == TUSB_DESC_INTERFACE && ((tusb_desc_interface_t const *)_audiod_fct[i].p_desc)->bInterfaceNumber == itf)
-        {
-          *func_id = i;
-          return true;
-        }
-        p_desc = tu_desc_next(p_desc);
+        *func_id = i;
+        return true;
       }
     }
   }
   return false;
 }
 
+// Build entity and AS interface lookup tables of an audio function, called once on open.
+// Entities are defined between the class specific AC descriptor and the end of the AC descriptors, AS interfaces follow.
+static void audiod_build_lookup(audiod_function_t *audio)
+{
+  uint8_t const *p_desc_end = audio->p_desc + audio->desc_length - TUD_AUDIO_DESC_IAD_LEN;
+  uint8_t const *p_desc = tu_desc_next(audio->p_desc);                                                  // Points to CS AC descriptor
+  uint8_t const *p_ac_end = ((audio_desc_cs_ac_interface_t const *)p_desc)->wTotalLength + p_desc;
+
+  tu_memclr(audio->entity_bitmap, sizeof(audio->entity_bitmap));
+  audio->n_as_itf = 0;
+
+  for (p_desc = tu_desc_next(p_desc); p_desc < p_ac_end; p_desc = tu_desc_next(p_desc))
+  {
+    uint8_t const id = p_desc[3];   // Entity IDs are always at offset 3
+    audio->entity_bitmap[id >> 5] |= TU_BIT(id & 0x1f);
+  }
+
+  // We assume the number of alternate settings is increasing thus we record alternate setting zero only
+  for (p_desc = p_ac_end; p_desc < p_desc_end && audio->n_as_itf < AUDIOD_N_AS_INT_MAX; p_desc = tu_desc_next(p_desc))
+  {
+    if (tu_desc_type(p_desc) == TUSB_DESC_INTERFACE && ((tusb_desc_interface_t const *)p_desc)->bAlternateSetting == 0)
+    {
+      audio->as_itf_num[audio->n_as_itf]    = ((tusb_desc_interface_t const *)p_desc)->bInterfaceNumber;
+      audio->as_itf_offset[audio->n_as_itf] = (uint16_t) (p_desc - audio->p_desc);
+      audio->n_as_itf++;
+    }
+  }
+}
+
 static bool audiod_verify_ep_exists(uint8_t ep, uint8_t *func_id)
 {
   uint8_t i;
@@ -2554,6 +2901,60 @@ bool tud_audio_n_fb_set(uint8_t func_id, uint32_t feedback)
 }
 #endif
 
+#if CFG_TUD_AUDIO_ENABLE_EP_IN && CFG_TUD_AUDIO_ENABLE_IMPLICIT_FEEDBACK
+
+bool tud_audio_n_implicit_fb_set(uint8_t func_id, uint32_t rate)
+{
+  TU_VERIFY(func_id < CFG_TUD_AUDIO);
+  _audiod_fct[func_id].implicit_fb.rate = rate;
+  return true;
+}
+
+// Number of audio frames to send within next IN packet, limited by the number of frames available
+static uint16_t audiod_implicit_fb_n_frames(audiod_function_t* audio, uint16_t n_frames_available)
+{
+  uint32_t const rate = audio->implicit_fb.rate;
+  if (rate == 0) return n_frames_available;
+
+  // Accumulate samples per packet interval
+  uint32_t const phase = audio->implicit_fb.phase + (rate << audio->implicit_fb.interval_shift);
+  uint16_t const n_frames = (uint16_t) tu_min32(phase >> 16, n_frames_available);
+
+  // Carry over the fraction only, samples missing due to an underrun are not caught up later on
+  audio->implicit_fb.phase = phase & 0xFFFF;
+
+  return n_frames;
+}
+
+// Bytes per audio frame of the Type I format described by the AS interface (alternate setting) at p_desc, 0 if unknown
+static uint16_t audiod_implicit_fb_frame_size(uint8_t const * p_desc, uint8_t const * p_desc_end)
+{
+  uint8_t n_channels = 0;
+  uint8_t subslot_sz = 0;
+
+  p_desc = tu_desc_next(p_desc);    // Exclude standard AS interface descriptor
+
+  while (p_desc < p_desc_end && tu_desc_type(p_desc) != TUSB_DESC_INTERFACE)
+  {
+    if (tu_desc_type(p_desc) == TUSB_DESC_CS_INTERFACE)
+    {
+      if (tu_desc_subtype(p_desc) == AUDIO_CS_AS_INTERFACE_AS_GENERAL)
+      {
+        n_channels = ((audio_desc_cs_as_interface_t const *) p_desc)->bNrChannels;
+      }
+      else if (tu_desc_subtype(p_desc) == AUDIO_CS_AS_INTERFACE_FORMAT_TYPE && ((audio_desc_type_I_format_t const *) p_desc)->bFormatType == AUDIO_FORMAT_TYPE_I)
+      {
+        subslot_sz = ((audio_desc_type_I_format_t const *) p_desc)->bSubslotSize;
+      }
+    }
+    p_desc = tu_desc_next(p_desc);
+  }
+
+  return (uint16_t) (n_channels * subslot_sz);
+}
+
+#endif
+
 // No security checks here - internal function only which should always succeed
 uint8_t audiod_get_audio_fct_idx(audiod_function_t * audio)
 {
@@ -186,6 +186,12 @@
 #define CFG_TUD_AUDIO_ENABLE_FEEDBACK_EP                    0                             // Feedback - 0 or 1
 #endif
 
+// Enable/disable implicit feedback (duplex devices): sizes of IN data packets (e.g. microphone) are paced by a rate set
+// with tud_audio_n_implicit_fb_set() and the host derives its OUT rate from them. IN data EP may have usage implicit feedback.
+#ifndef CFG_TUD_AUDIO_ENABLE_IMPLICIT_FEEDBACK
+#define CFG_TUD_AUDIO_ENABLE_IMPLICIT_FEEDBACK              0                             // 0 or 1
+#endif
+
 // Enable/disable conversion from 16.16 to 10.14 format on full-speed devices. See tud_audio_n_fb_set().
 #ifndef CFG_TUD_AUDIO_ENABLE_FEEDBACK_FORMAT_CORRECTION
 #define CFG_TUD_AUDIO_ENABLE_FEEDBACK_FORMAT_CORRECTION     0                             // 0 or 1
@@ -263,6 +269,17 @@
 #define CFG_TUD_AUDIO_ENABLE_TYPE_I_DECODING                0
 #endif
 
+// Gain/mute stage applied to PCM Type I samples within the decoding/encoding copy, see tud_audio_n_set_rx_gain().
+// Saves an extra pass over the support FIFOs if volume/mute of a feature unit is to be applied by the device.
+#ifndef CFG_TUD_AUDIO_ENABLE_GAIN
+#define CFG_TUD_AUDIO_ENABLE_GAIN                           0
+#endif
+
+// Maximum gain change per sample in Q1.15 on gain or mute change to avoid clicks - default ramps from mute to unity within 1024 samples
+#ifndef CFG_TUD_AUDIO_GAIN_RAMP_STEP
+#define CFG_TUD_AUDIO_GAIN_RAMP_STEP                        32
+#endif
+
 // Type I Coding parameters not given within UAC2 descriptors
 // It would be possible to allow for a more flexible setting and not fix this parameter as done below. However, this is most often not needed and kept for later if really necessary. The more flexible setting could be implemented within set_interface(), however, how the values are saved per alternate setting is to be determined!
 #if CFG_TUD_AUDIO_ENABLE_EP_IN && CFG_TUD_AUDIO_ENABLE_ENCODING && CFG_TUD_AUDIO_ENABLE_TYPE_I_ENCODING
@@ -388,10 +405,50 @@ uint16_t tud_audio_n_write_support_ff             (uint8_t func_id, uint8_t ff_i
 tu_fifo_t* tud_audio_n_get_tx_support_ff          (uint8_t func_id, uint8_t ff_idx);
 #endif
 
+#if CFG_TUD_AUDIO_ENABLE_GAIN
+// Gain in Q1.15 fixed point: TUD_AUDIO_GAIN_UNITY is 0 dB, above amplifies with saturation. Gain and mute
+// are applied while decoding (RX) / encoding (TX) and ramped by CFG_TUD_AUDIO_GAIN_RAMP_STEP per sample.
+// Typically set from tud_audio_set_req_entity_cb() on feature unit volume and mute requests.
+#define TUD_AUDIO_GAIN_UNITY  0x8000u
+
+// Convert UAC2 volume in 1/256 dB (e.g. feature unit CUR volume) to gain, -inf dB (0x8000) is silence
+uint16_t tud_audio_gain_from_db                   (int16_t volume);
+#endif
+
+#if CFG_TUD_AUDIO_ENABLE_GAIN && CFG_TUD_AUDIO_ENABLE_EP_OUT && CFG_TUD_AUDIO_ENABLE_DECODING
+bool     tud_audio_n_set_rx_gain                  (uint8_t func_id, uint16_t gain);
+bool     tud_audio_n_set_rx_mute                  (uint8_t func_id, bool mute);
+#endif
+
+#if CFG_TUD_AUDIO_ENABLE_GAIN && CFG_TUD_AUDIO_ENABLE_EP_IN && CFG_TUD_AUDIO_ENABLE_ENCODING
+bool     tud_audio_n_set_tx_gain                  (uint8_t func_id, uint16_t gain);
+bool     tud_audio_n_set_tx_mute                  (uint8_t func_id, bool mute);
+#endif
+
 #if CFG_TUD_AUDIO_INT_CTR_EPSIZE_IN
 uint16_t    tud_audio_int_ctr_n_write             (uint8_t func_id, uint8_t const* buffer, uint16_t len);
 #endif
 
+#if CFG_TUD_XFER_TIMESTAMP
+// Latency in SOF frames: TX from tud_audio_n_write() until the packet holding the last written byte is
+// transmitted, RX from reception until the last byte of a packet is read by tud_audio_n_read(). Only sampled
+// without encoding/decoding. Stream offsets count bytes since the alternate setting was activated and
+// match the offset of stamps passed to tud_audio_tx_stamp_cb() / tud_audio_rx_stamp_cb().
+#if CFG_TUD_AUDIO_ENABLE_EP_IN
+bool     tud_audio_n_tx_latency                   (uint8_t func_id, tud_latency_stat_t* stat, bool clear);
+#if !CFG_TUD_AUDIO_ENABLE_ENCODING
+uint32_t tud_audio_n_tx_offset                    (uint8_t func_id); // stream offset of next byte written
+#endif
+#endif
+
+#if CFG_TUD_AUDIO_ENABLE_EP_OUT
+bool     tud_audio_n_rx_latency                   (uint8_t func_id, tud_latency_stat_t* stat, bool clear);
+#if !CFG_TUD_AUDIO_ENABLE_DECODING
+uint32_t tud_audio_n_rx_offset                    (uint8_t func_id); // stream offset of next byte read
+#endif
+#endif
+#endif
+
 //--------------------------------------------------------------------+
 // Application API (Interface0)
 //--------------------------------------------------------------------+
@@ -414,6 +471,11 @@ static inline uint16_t tud_audio_read_support_ff            (uint8_t ff_idx, voi
 static inline tu_fifo_t* tud_audio_get_rx_support_ff        (uint8_t ff_idx);
 #endif
 
+#if CFG_TUD_AUDIO_ENABLE_GAIN && CFG_TUD_AUDIO_ENABLE_EP_OUT && CFG_TUD_AUDIO_ENABLE_DECODING
+static inline bool     tud_audio_set_rx_gain                (uint16_t gain);
+static inline bool     tud_audio_set_rx_mute                (bool mute);
+#endif
+
 // TX API
 
 #if CFG_TUD_AUDIO_ENABLE_EP_IN && !CFG_TUD_AUDIO_ENABLE_ENCODING
@@ -429,12 +491,27 @@ static inline uint16_t tud_audio_write_support_ff           (uint8_t ff_idx, con
 static inline tu_fifo_t* tud_audio_get_tx_support_ff        (uint8_t ff_idx);
 #endif
 
+#if CFG_TUD_AUDIO_ENABLE_GAIN && CFG_TUD_AUDIO_ENABLE_EP_IN && CFG_TUD_AUDIO_ENABLE_ENCODING
+static inline bool     tud_audio_set_tx_gain                (uint16_t gain);
+static inline bool     tud_audio_set_tx_mute                (bool mute);
+#endif
+
 // INT CTR API
 
 #if CFG_TUD_AUDIO_INT_CTR_EPSIZE_IN
 static inline uint16_t tud_audio_int_ctr_write              (uint8_t const* buffer, uint16_t len);
 #endif
 
+// Timestamp API
+
+#if CFG_TUD_XFER_TIMESTAMP && CFG_TUD_AUDIO_ENABLE_EP_IN
+static inline bool     tud_audio_tx_latency                 (tud_latency_stat_t* stat, bool clear);
+#endif
+
+#if CFG_TUD_XFER_TIMESTAMP && CFG_TUD_AUDIO_ENABLE_EP_OUT
+static inline bool     tud_audio_rx_latency                 (tud_latency_stat_t* stat, bool clear);
+#endif
+
 // Buffer control EP data and schedule a transmit
 // This function is intended to be used if you do not have a persistent buffer or memory location available (e.g. non-local variables) and need to answer onto a
 // get request. This function buffers your answer request frame into the control buffer of the corresponding audio driver and schedules a transmit for sending it.
@@ -457,6 +534,16 @@ TU_ATTR_WEAK bool tud_audio_rx_done_pre_read_cb(uint8_t rhport, uint16_t n_bytes
 TU_ATTR_WEAK bool tud_audio_rx_done_post_read_cb(uint8_t rhport, uint16_t n_bytes_received, uint8_t func_id, uint8_t ep_out, uint8_t cur_alt_setting);
 #endif
 
+#if CFG_TUD_XFER_TIMESTAMP
+// Invoked when a non-empty packet completed on the wire, stamp holds its stream offset and SOF frame number
+#if CFG_TUD_AUDIO_ENABLE_EP_IN
+TU_ATTR_WEAK void tud_audio_tx_stamp_cb(uint8_t func_id, tud_stream_stamp_t const* stamp);
+#endif
+#if CFG_TUD_AUDIO_ENABLE_EP_OUT
+TU_ATTR_WEAK void tud_audio_rx_stamp_cb(uint8_t func_id, tud_stream_stamp_t const* stamp);
+#endif
+#endif
+
 #if CFG_TUD_AUDIO_ENABLE_EP_OUT && CFG_TUD_AUDIO_ENABLE_FEEDBACK_EP
 TU_ATTR_WEAK void tud_audio_fb_done_cb(uint8_t func_id);
 
@@ -531,6 +618,17 @@ TU_ATTR_WEAK TU_ATTR_FAST_FUNC void tud_audio_feedback_interval_isr(uint8_t func
 
 #endif // CFG_TUD_AUDIO_ENABLE_EP_OUT && CFG_TUD_AUDIO_ENABLE_FEEDBACK_EP
 
+#if CFG_TUD_AUDIO_ENABLE_EP_IN && CFG_TUD_AUDIO_ENABLE_IMPLICIT_FEEDBACK
+// Implicit feedback: IN data packets carry as many audio frames (one sample of every channel) as the codec produces,
+// the host then sends the same amount per OUT packet. The rate is given in samples per (micro)frame in 16.16 format
+// just like the explicit feedback value, and should be derived from the real codec clock e.g. the number of samples
+// the codec produced over a number of SOFs. Fractions are accumulated over packets, e.g. 44.1 kHz on full speed
+// results in nine packets of 44 frames followed by one of 45. A rate of zero sends whatever is available (default).
+// The frame size is taken from the Type I format of the active alternate setting.
+bool tud_audio_n_implicit_fb_set(uint8_t func_id, uint32_t rate);
+static inline bool tud_audio_implicit_fb_set(uint32_t rate);
+#endif
+
 #if CFG_TUD_AUDIO_INT_CTR_EPSIZE_IN
 TU_ATTR_WEAK bool tud_audio_int_ctr_done_cb(uint8_t rhport, uint16_t n_bytes_copied);
 #endif
@@ -618,6 +716,20 @@ static inline tu_fifo_t* tud_audio_get_rx_support_ff(uint8_t ff_idx)
 
 #endif
 
+#if CFG_TUD_AUDIO_ENABLE_GAIN && CFG_TUD_AUDIO_ENABLE_EP_OUT && CFG_TUD_AUDIO_ENABLE_DECODING
+
+static inline bool tud_audio_set_rx_gain(uint16_t gain)
+{
+  return tud_audio_n_set_rx_gain(0, gain);
+}
+
+static inline bool tud_audio_set_rx_mute(bool mute)
+{
+  return tud_audio_n_set_rx_mute(0, mute);
+}
+
+#endif
+
 // TX API
 
 #if CFG_TUD_AUDIO_ENABLE_EP_IN && !CFG_TUD_AUDIO_ENABLE_ENCODING
@@ -663,6 +775,20 @@ static inline tu_fifo_t* tud_audio_get_tx_support_ff(uint8_t ff_idx)
 
 #endif
 
+#if CFG_TUD_AUDIO_ENABLE_GAIN && CFG_TUD_AUDIO_ENABLE_EP_IN && CFG_TUD_AUDIO_ENABLE_ENCODING
+
+static inline bool tud_audio_set_tx_gain(uint16_t gain)
+{
+  return tud_audio_n_set_tx_gain(0, gain);
+}
+
+static inline bool tud_audio_set_tx_mute(bool mute)
+{
+  return tud_audio_n_set_tx_mute(0, mute);
+}
+
+#endif
+
 #if CFG_TUD_AUDIO_INT_CTR_EPSIZE_IN
 static inline uint16_t tud_audio_int_ctr_write(uint8_t const* buffer, uint16_t len)
 {
@@ -670,6 +796,20 @@ static inline uint16_t tud_audio_int_ctr_write(uint8_t const* buffer, uint16_t l
 }
 #endif
 
+#if CFG_TUD_XFER_TIMESTAMP && CFG_TUD_AUDIO_ENABLE_EP_IN
+static inline bool tud_audio_tx_latency(tud_latency_stat_t* stat, bool clear)
+{
+  return tud_audio_n_tx_latency(0, stat, clear);
+}
+#endif
+
+#if CFG_TUD_XFER_TIMESTAMP && CFG_TUD_AUDIO_ENABLE_EP_OUT
+static inline bool tud_audio_rx_latency(tud_latency_stat_t* stat, bool clear)
+{
+  return tud_audio_n_rx_latency(0, stat, clear);
+}
+#endif
+
 #if CFG_TUD_AUDIO_ENABLE_EP_OUT && CFG_TUD_AUDIO_ENABLE_FEEDBACK_EP
 
 static inline bool tud_audio_fb_set(uint32_t feedback)
@@ -679,6 +819,15 @@ static inline bool tud_audio_fb_set(uint32_t feedback)
 
 #endif
 
+#if CFG_TUD_AUDIO_ENABLE_EP_IN && CFG_TUD_AUDIO_ENABLE_IMPLICIT_FEEDBACK
+
+static inline bool tud_audio_implicit_fb_set(uint32_t rate)
+{
+  return tud_audio_n_implicit_fb_set(0, rate);
+}
+
+#endif
+
 //--------------------------------------------------------------------+
 // Internal Class Driver API
 //--------------------------------------------------------------------+
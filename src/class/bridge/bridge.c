@@ -0,0 +1,516 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#include "tusb_option.h"
+
+#if (CFG_TUD_ENABLED && CFG_TUH_ENABLED && CFG_TUSB_BRIDGE)
+
+#include "device/usbd.h"
+#include "device/usbd_pvt.h"
+#include "host/usbh.h"
+
+#include "bridge.h"
+
+#if !CFG_TUH_API_EDPT_XFER
+  #error "CFG_TUSB_BRIDGE requires CFG_TUH_API_EDPT_XFER"
+#endif
+
+TU_VERIFY_STATIC(CFG_TUSB_BRIDGE_BUF_COUNT < 0xFF, "too many buffers");
+TU_VERIFY_STATIC(CFG_TUSB_BRIDGE_BUFSIZE <= UINT16_MAX, "buffer too large");
+
+//--------------------------------------------------------------------+
+// MACRO CONSTANT TYPEDEF
+//--------------------------------------------------------------------+
+#define BUF_NONE  0xFF
+
+typedef struct
+{
+  uint16_t len;
+  uint8_t  ref;  // 0 is free (credit), pipeline holds one reference from receive until sent
+  bool     zlp;  // send zero length packet after data to keep transfer boundary
+} bridge_buf_t;
+
+typedef struct
+{
+  // device side
+  uint8_t  rhport;
+  uint8_t  d_ep;       // bound endpoint, 0 if not bound
+  bool     d_opened;
+  uint8_t  d_xfer;     // transfer type
+  uint16_t d_mps;
+
+  // host side
+  uint8_t  daddr;      // 0 if not opened
+  uint8_t  h_ep;
+  uint8_t  h_xfer;
+  uint16_t h_mps;
+
+  bool     halted;     // receive failed e.g stalled, stop until re-opened
+
+  uint8_t  rx_buf;     // buffer being received
+  uint8_t  tx_buf;     // buffer being sent
+
+  // received buffers waiting to be sent, in order
+  uint8_t  queue[CFG_TUSB_BRIDGE_BUF_COUNT];
+  uint8_t  queue_head;
+  uint8_t  queue_count;
+
+  bridge_buf_t buf[CFG_TUSB_BRIDGE_BUF_COUNT];
+} bridge_channel_t;
+
+CFG_TUD_MEM_SECTION static bridge_channel_t _bridge[CFG_TUSB_BRIDGE];
+CFG_TUD_MEM_SECTION CFG_TUD_MEM_ALIGN static uint8_t _bridge_data[CFG_TUSB_BRIDGE][CFG_TUSB_BRIDGE_BUF_COUNT][TUD_EPBUF_SIZE(CFG_TUSB_BRIDGE_BUFSIZE)];
+
+// Device and host task may run in different threads
+#if OSAL_MUTEX_REQUIRED
+  static osal_mutex_def_t _bridge_mutexdef;
+  static osal_mutex_t _bridge_mutex;
+#else
+  #define _bridge_mutex   NULL
+#endif
+
+TU_ATTR_ALWAYS_INLINE static inline void bridge_lock(void) {
+  (void) osal_mutex_lock(_bridge_mutex, OSAL_TIMEOUT_WAIT_FOREVER);
+}
+
+TU_ATTR_ALWAYS_INLINE static inline void bridge_unlock(void) {
+  (void) osal_mutex_unlock(_bridge_mutex);
+}
+
+// IN channel: attached device -> upstream host, receive on host side and send on device side
+TU_ATTR_ALWAYS_INLINE static inline bool is_ch_in(bridge_channel_t const* p_ch) {
+  return tu_edpt_dir(p_ch->d_ep) == TUSB_DIR_IN;
+}
+
+static void host_xfer_cb(tuh_xfer_t* xfer);
+
+//--------------------------------------------------------------------+
+// Pipeline, called with lock held
+//--------------------------------------------------------------------+
+
+static bool ep_xfer(uint8_t ch, bool host_side, uint8_t* buffer, uint16_t len)
+{
+  bridge_channel_t* p_ch = &_bridge[ch];
+
+  if (host_side)
+  {
+    tuh_xfer_t xfer =
+    {
+      .daddr       = p_ch->daddr,
+      .ep_addr     = p_ch->h_ep,
+      .buflen      = len,
+      .buffer      = buffer,
+      .complete_cb = host_xfer_cb,
+      .user_data   = ch
+    };
+    return tuh_edpt_xfer(&xfer);
+  }
+
+  TU_VERIFY(usbd_edpt_claim(p_ch->rhport, p_ch->d_ep));
+  if (!usbd_edpt_xfer(p_ch->rhport, p_ch->d_ep, buffer, len))
+  {
+    usbd_edpt_release(p_ch->rhport, p_ch->d_ep);
+    return false;
+  }
+  return true;
+}
+
+static void buf_release(bridge_channel_t* p_ch, uint8_t buf_id)
+{
+  bridge_buf_t* buf = &p_ch->buf[buf_id];
+  TU_ASSERT(buf->ref, );
+  buf->ref--;
+}
+
+static void channel_service(uint8_t ch)
+{
+  bridge_channel_t* p_ch = &_bridge[ch];
+  bool const ch_in = is_ch_in(p_ch);
+  bool const src_opened  = ch_in ? (p_ch->daddr != 0) : p_ch->d_opened;
+  bool const sink_opened = ch_in ? p_ch->d_opened : (p_ch->daddr != 0);
+
+  // post a receive if there is credit
+  if (src_opened && !p_ch->halted && p_ch->rx_buf == BUF_NONE)
+  {
+    for (uint8_t i = 0; i < CFG_TUSB_BRIDGE_BUF_COUNT; i++)
+    {
+      bridge_buf_t* buf = &p_ch->buf[i];
+      if (buf->ref) continue;
+
+      // interrupt transfer is one report per packet
+      uint8_t  const xfer_type = ch_in ? p_ch->h_xfer : p_ch->d_xfer;
+      uint16_t const mps       = ch_in ? p_ch->h_mps  : p_ch->d_mps;
+      uint16_t const len = (xfer_type == TUSB_XFER_INTERRUPT) ? tu_min16(mps, CFG_TUSB_BRIDGE_BUFSIZE) : CFG_TUSB_BRIDGE_BUFSIZE;
+
+      buf->ref = 1;
+      buf->len = len;
+      buf->zlp = false;
+      if (ep_xfer(ch, ch_in, _bridge_data[ch][i], len))
+      {
+        p_ch->rx_buf = i;
+      }else
+      {
+        buf->ref = 0;
+      }
+      break;
+    }
+  }
+
+  // send oldest received buffer
+  if (sink_opened && p_ch->tx_buf == BUF_NONE && p_ch->queue_count)
+  {
+    uint8_t const buf_id = p_ch->queue[p_ch->queue_head];
+    if (ep_xfer(ch, !ch_in, _bridge_data[ch][buf_id], p_ch->buf[buf_id].len))
+    {
+      p_ch->tx_buf = buf_id;
+      p_ch->queue_head = (uint8_t) ((p_ch->queue_head + 1) % CFG_TUSB_BRIDGE_BUF_COUNT);
+      p_ch->queue_count--;
+    }
+  }
+}
+
+// Drop data of one side: in flight transfer is aborted by caller or closed by the stack
+static void channel_drop(bridge_channel_t* p_ch, bool host_side)
+{
+  bool const src = (host_side == is_ch_in(p_ch));
+
+  if (src)
+  {
+    if (p_ch->rx_buf != BUF_NONE) buf_release(p_ch, p_ch->rx_buf);
+    p_ch->rx_buf = BUF_NONE;
+    p_ch->halted = false;
+  }else
+  {
+    if (p_ch->tx_buf != BUF_NONE) buf_release(p_ch, p_ch->tx_buf);
+    p_ch->tx_buf = BUF_NONE;
+
+    while (p_ch->queue_count)
+    {
+      buf_release(p_ch, p_ch->queue[p_ch->queue_head]);
+      p_ch->queue_head = (uint8_t) ((p_ch->queue_head + 1) % CFG_TUSB_BRIDGE_BUF_COUNT);
+      p_ch->queue_count--;
+    }
+  }
+}
+
+//--------------------------------------------------------------------+
+// Transfer complete
+//--------------------------------------------------------------------+
+
+static void rx_complete(uint8_t ch, xfer_result_t result, uint32_t xferred_bytes)
+{
+  bridge_channel_t* p_ch = &_bridge[ch];
+
+  bridge_lock();
+  uint8_t const buf_id = p_ch->rx_buf;
+  p_ch->rx_buf = BUF_NONE;
+
+  if (buf_id == BUF_NONE)
+  {
+    bridge_unlock();
+    return;
+  }
+
+  bridge_buf_t* buf = &p_ch->buf[buf_id];
+
+  if (result != XFER_RESULT_SUCCESS)
+  {
+    buf_release(p_ch, buf_id);
+    p_ch->halted = true;
+    channel_service(ch);
+    bridge_unlock();
+    return;
+  }
+
+  // transfer ended with short packet whose length is multiple of sink packet size:
+  // sink needs a zero length packet to end it as well
+  uint16_t const sink_mps = is_ch_in(p_ch) ? p_ch->d_mps : p_ch->h_mps;
+  buf->zlp = (xferred_bytes < buf->len) && xferred_bytes && sink_mps && !(xferred_bytes % sink_mps);
+  buf->len = (uint16_t) xferred_bytes;
+
+  uint8_t const tail = (uint8_t) ((p_ch->queue_head + p_ch->queue_count) % CFG_TUSB_BRIDGE_BUF_COUNT);
+  p_ch->queue[tail] = buf_id;
+  p_ch->queue_count++;
+
+  // keep buffer while application inspects it
+  buf->ref++;
+  channel_service(ch);
+  bridge_unlock();
+
+  if (tu_bridge_rx_cb) tu_bridge_rx_cb(ch, buf_id, _bridge_data[ch][buf_id], (uint16_t) xferred_bytes);
+
+  tu_bridge_buf_unref(ch, buf_id);
+}
+
+static void tx_complete(uint8_t ch)
+{
+  bridge_channel_t* p_ch = &_bridge[ch];
+
+  bridge_lock();
+  uint8_t const buf_id = p_ch->tx_buf;
+
+  if (buf_id != BUF_NONE)
+  {
+    bridge_buf_t* buf = &p_ch->buf[buf_id];
+    if (buf->zlp)
+    {
+      buf->zlp = false;
+      if (ep_xfer(ch, !is_ch_in(p_ch), _bridge_data[ch][buf_id], 0))
+      {
+        bridge_unlock();
+        return;
+      }
+    }
+
+    p_ch->tx_buf = BUF_NONE;
+    buf_release(p_ch, buf_id);
+  }
+
+  channel_service(ch);
+  bridge_unlock();
+}
+
+static void host_xfer_cb(tuh_xfer_t* xfer)
+{
+  uint8_t const ch = (uint8_t) xfer->user_data;
+  bridge_channel_t* p_ch = &_bridge[ch];
+
+  // channel is closed or re-opened meanwhile
+  if (xfer->daddr != p_ch->daddr || xfer->ep_addr != p_ch->h_ep) return;
+
+  if (is_ch_in(p_ch))
+  {
+    rx_complete(ch, xfer->result, xfer->actual_len);
+  }else
+  {
+    tx_complete(ch);
+  }
+}
+
+//--------------------------------------------------------------------+
+// Application API
+//--------------------------------------------------------------------+
+
+bool tu_bridge_device_bind(uint8_t ch, uint8_t ep_addr)
+{
+  TU_VERIFY(ch < CFG_TUSB_BRIDGE && tu_edpt_number(ep_addr));
+  bridge_channel_t* p_ch = &_bridge[ch];
+  TU_VERIFY(!p_ch->d_opened && !p_ch->daddr);
+
+  p_ch->d_ep = ep_addr;
+  return true;
+}
+
+bool tu_bridge_host_open(uint8_t ch, uint8_t daddr, tusb_desc_endpoint_t const* desc_ep)
+{
+  TU_VERIFY(ch < CFG_TUSB_BRIDGE);
+  bridge_channel_t* p_ch = &_bridge[ch];
+  TU_VERIFY(p_ch->d_ep && !p_ch->daddr);
+  TU_VERIFY(tu_edpt_dir(desc_ep->bEndpointAddress) == tu_edpt_dir(p_ch->d_ep));
+  TU_VERIFY(desc_ep->bmAttributes.xfer == TUSB_XFER_BULK || desc_ep->bmAttributes.xfer == TUSB_XFER_INTERRUPT);
+
+  TU_ASSERT(tuh_edpt_open(daddr, desc_ep));
+
+  bridge_lock();
+  p_ch->h_ep   = desc_ep->bEndpointAddress;
+  p_ch->h_xfer = desc_ep->bmAttributes.xfer;
+  p_ch->h_mps  = tu_edpt_packet_size(desc_ep);
+  p_ch->daddr  = daddr;
+  channel_service(ch);
+  bridge_unlock();
+
+  return true;
+}
+
+void tu_bridge_host_close(uint8_t ch)
+{
+  TU_VERIFY(ch < CFG_TUSB_BRIDGE, );
+  bridge_channel_t* p_ch = &_bridge[ch];
+  TU_VERIFY(p_ch->daddr, );
+
+  bridge_lock();
+  // buffers are returned to pool, abort transfer still writing/reading them
+  tuh_edpt_abort_xfer(p_ch->daddr, p_ch->h_ep);
+  channel_drop(p_ch, true);
+  p_ch->daddr = 0;
+  channel_service(ch);
+  bridge_unlock();
+}
+
+bool tu_bridge_connected(uint8_t ch)
+{
+  TU_VERIFY(ch < CFG_TUSB_BRIDGE);
+  return _bridge[ch].d_opened && _bridge[ch].daddr;
+}
+
+uint8_t tu_bridge_credits(uint8_t ch)
+{
+  TU_VERIFY(ch < CFG_TUSB_BRIDGE, 0);
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < CFG_TUSB_BRIDGE_BUF_COUNT; i++)
+  {
+    if (!_bridge[ch].buf[i].ref) count++;
+  }
+  return count;
+}
+
+void tu_bridge_buf_ref(uint8_t ch, uint8_t buf_id)
+{
+  TU_VERIFY(ch < CFG_TUSB_BRIDGE && buf_id < CFG_TUSB_BRIDGE_BUF_COUNT, );
+  bridge_lock();
+  TU_ASSERT(_bridge[ch].buf[buf_id].ref < UINT8_MAX, );
+  _bridge[ch].buf[buf_id].ref++;
+  bridge_unlock();
+}
+
+void tu_bridge_buf_unref(uint8_t ch, uint8_t buf_id)
+{
+  TU_VERIFY(ch < CFG_TUSB_BRIDGE && buf_id < CFG_TUSB_BRIDGE_BUF_COUNT, );
+  bridge_lock();
+  buf_release(&_bridge[ch], buf_id);
+  // credit may be returned
+  channel_service(ch);
+  bridge_unlock();
+}
+
+//--------------------------------------------------------------------+
+// USBD Driver API
+//--------------------------------------------------------------------+
+
+void bridged_init(void)
+{
+  tu_memclr(_bridge, sizeof(_bridge));
+  for (uint8_t ch = 0; ch < CFG_TUSB_BRIDGE; ch++)
+  {
+    _bridge[ch].rx_buf = _bridge[ch].tx_buf = BUF_NONE;
+  }
+
+#if OSAL_MUTEX_REQUIRED
+  _bridge_mutex = osal_mutex_create(&_bridge_mutexdef);
+#endif
+}
+
+void bridged_reset(uint8_t rhport)
+{
+  bridge_lock();
+  for (uint8_t ch = 0; ch < CFG_TUSB_BRIDGE; ch++)
+  {
+    bridge_channel_t* p_ch = &_bridge[ch];
+    if (p_ch->d_opened && p_ch->rhport == rhport)
+    {
+      // endpoints are closed by the stack
+      channel_drop(p_ch, false);
+      p_ch->d_opened = false;
+      channel_service(ch);
+    }
+  }
+  bridge_unlock();
+}
+
+// Claim interface having a bound endpoint
+uint16_t bridged_open(uint8_t rhport, tusb_desc_interface_t const * itf_desc, uint16_t max_len)
+{
+  uint8_t const* p_desc   = (uint8_t const*) itf_desc;
+  uint8_t const* desc_end = p_desc + max_len;
+  bool claimed = false;
+
+  // endpoints of this interface (alternate 0 only)
+  p_desc = tu_desc_next(p_desc);
+  uint8_t const* ep_start = p_desc;
+  while (p_desc < desc_end && tu_desc_len(p_desc) && tu_desc_type(p_desc) != TUSB_DESC_INTERFACE &&
+         tu_desc_type(p_desc) != TUSB_DESC_INTERFACE_ASSOCIATION)
+  {
+    if (tu_desc_type(p_desc) == TUSB_DESC_ENDPOINT)
+    {
+      uint8_t const ep_addr = ((tusb_desc_endpoint_t const*) p_desc)->bEndpointAddress;
+      for (uint8_t ch = 0; ch < CFG_TUSB_BRIDGE; ch++)
+      {
+        if (_bridge[ch].d_ep == ep_addr) claimed = true;
+      }
+    }
+    p_desc = tu_desc_next(p_desc);
+  }
+
+  TU_VERIFY(claimed, 0);
+
+  for (uint8_t const* p = ep_start; p < p_desc; p = tu_desc_next(p))
+  {
+    if (tu_desc_type(p) != TUSB_DESC_ENDPOINT) continue;
+
+    tusb_desc_endpoint_t const* desc_ep = (tusb_desc_endpoint_t const*) p;
+    TU_ASSERT(usbd_edpt_open(rhport, desc_ep), 0);
+
+    bridge_lock();
+    for (uint8_t ch = 0; ch < CFG_TUSB_BRIDGE; ch++)
+    {
+      bridge_channel_t* p_ch = &_bridge[ch];
+      if (p_ch->d_ep == desc_ep->bEndpointAddress)
+      {
+        p_ch->rhport   = rhport;
+        p_ch->d_xfer   = desc_ep->bmAttributes.xfer;
+        p_ch->d_mps    = tu_edpt_packet_size(desc_ep);
+        p_ch->d_opened = true;
+        channel_service(ch);
+      }
+    }
+    bridge_unlock();
+  }
+
+  return (uint16_t) (p_desc - (uint8_t const*) itf_desc);
+}
+
+bool bridged_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t const * request)
+{
+  (void) rhport;
+  (void) stage;
+  (void) request;
+
+  // control requests are not forwarded
+  return false;
+}
+
+bool bridged_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes)
+{
+  for (uint8_t ch = 0; ch < CFG_TUSB_BRIDGE; ch++)
+  {
+    bridge_channel_t* p_ch = &_bridge[ch];
+    if (!(p_ch->d_opened && p_ch->rhport == rhport && p_ch->d_ep == ep_addr)) continue;
+
+    if (is_ch_in(p_ch))
+    {
+      tx_complete(ch);
+    }else
+    {
+      rx_complete(ch, result, xferred_bytes);
+    }
+    return true;
+  }
+
+  // other endpoint of bridged interface
+  return true;
+}
+
+#endif
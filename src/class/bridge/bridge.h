@@ -0,0 +1,113 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#ifndef _TUSB_BRIDGE_H_
+#define _TUSB_BRIDGE_H_
+
+#include "common/tusb_common.h"
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+//--------------------------------------------------------------------+
+// Host <-> Device endpoint bridge for dual-role firmware (isolator, proxy)
+//
+// A channel binds an endpoint of the device stack to an endpoint of the same direction on a device
+// attached to the host stack. IN channel forwards data from attached device to upstream host, OUT
+// channel the other way. Each transfer is received into a buffer of the channel pool and sent from
+// the same buffer, there is no copy.
+//
+// Flow control is credit based: a receive is only posted when a buffer is free, so when the sink is
+// slow or not opened yet the source endpoint NAKs after CFG_TUSB_BRIDGE_BUF_COUNT transfers. Added
+// latency is bounded to the buffers in flight. Buffers are reference counted, application can hold
+// a received buffer (e.g to mirror or log it), its credit is returned when last reference is released.
+//
+// Only endpoint data is forwarded, control requests to the bridged interface are not.
+//--------------------------------------------------------------------+
+
+//--------------------------------------------------------------------+
+// Class Driver Configuration
+// Number of channels is CFG_TUSB_BRIDGE, requires both device and host stack
+//--------------------------------------------------------------------+
+
+// Size of each buffer, must be multiple of max packet size of bulk endpoints
+#ifndef CFG_TUSB_BRIDGE_BUFSIZE
+#define CFG_TUSB_BRIDGE_BUFSIZE  512
+#endif
+
+// Buffers (credits) per channel
+#ifndef CFG_TUSB_BRIDGE_BUF_COUNT
+#define CFG_TUSB_BRIDGE_BUF_COUNT  2
+#endif
+
+//--------------------------------------------------------------------+
+// Application API
+//--------------------------------------------------------------------+
+
+// Bind device endpoint to channel. Must be called before the device is configured: bridge driver
+// claims the interface having this endpoint in the configuration descriptor
+bool tu_bridge_device_bind(uint8_t ch, uint8_t ep_addr);
+
+// Open endpoint of attached device and start forwarding, e.g in tuh_mount_cb(). Direction must be
+// the same as bound device endpoint
+bool tu_bridge_host_open(uint8_t ch, uint8_t daddr, tusb_desc_endpoint_t const* desc_ep);
+
+// Stop forwarding to/from attached device e.g in tuh_umount_cb(). Queued data is dropped
+void tu_bridge_host_close(uint8_t ch);
+
+// Check if both device and host endpoint are opened
+bool tu_bridge_connected(uint8_t ch);
+
+// Number of free buffers of channel
+uint8_t tu_bridge_credits(uint8_t ch);
+
+// Hold a received buffer after it is forwarded, must be released with tu_bridge_buf_unref()
+void tu_bridge_buf_ref(uint8_t ch, uint8_t buf_id);
+void tu_bridge_buf_unref(uint8_t ch, uint8_t buf_id);
+
+//--------------------------------------------------------------------+
+// Application Callback API (weak is optional)
+//--------------------------------------------------------------------+
+
+// Invoked when a transfer is received, before it is forwarded. Data is valid until this returns
+// unless buffer is referenced with tu_bridge_buf_ref()
+TU_ATTR_WEAK void tu_bridge_rx_cb(uint8_t ch, uint8_t buf_id, uint8_t const* data, uint16_t len);
+
+//--------------------------------------------------------------------+
+// Internal Class Driver API
+//--------------------------------------------------------------------+
+void     bridged_init            (void);
+void     bridged_reset           (uint8_t rhport);
+uint16_t bridged_open            (uint8_t rhport, tusb_desc_interface_t const * itf_desc, uint16_t max_len);
+bool     bridged_control_xfer_cb (uint8_t rhport, uint8_t stage, tusb_control_request_t const * request);
+bool     bridged_xfer_cb         (uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes);
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif /* _TUSB_BRIDGE_H_ */
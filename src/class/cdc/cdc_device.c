@@ -54,14 +54,26 @@ typedef struct
   uint8_t ep_notif;
   uint8_t ep_in;
   uint8_t ep_out;
+  uint16_t ep_in_mps;   // for ZLP detection
 
   // Bit 0:  DTR (Data Terminal Ready), Bit 1: RTS (Request to Send)
   uint8_t line_state;
 
+#if CFG_TUSB_MULTICORE
+  volatile bool tx_discard; // write_clear() requested by application core
+#endif
+
   /*------------- From this point, data is not cleared by bus reset -------------*/
   char    wanted_char;
   TU_ATTR_ALIGNED(4) cdc_line_coding_t line_coding;
 
+#if CFG_TUSB_MULTICORE
+  // rx fifo is discarded on bus reset by its consumer: application core catches up with reset count of stack core
+  volatile uint8_t  rx_reset_seq; // written by stack core only
+  volatile uint8_t  rx_reset_ack; // written by application core only
+  volatile uint16_t rx_reset_idx; // rx fifo write index at bus reset
+#endif
+
   // FIFO
   tu_fifo_t rx_ff;
   tu_fifo_t tx_ff;
@@ -73,8 +85,8 @@ typedef struct
   OSAL_MUTEX_DEF(tx_ff_mutex);
 
   // Endpoint Transfer buffer
-  CFG_TUSB_MEM_ALIGN uint8_t epout_buf[CFG_TUD_CDC_EP_BUFSIZE];
-  CFG_TUSB_MEM_ALIGN uint8_t epin_buf[CFG_TUD_CDC_EP_BUFSIZE];
+  TUD_EPBUF_DEF(epout_buf, CFG_TUD_CDC_EP_BUFSIZE);
+  TUD_EPBUF_DEF(epin_buf, CFG_TUD_CDC_EP_BUFSIZE);
 
 }cdcd_interface_t;
 
@@ -114,6 +126,83 @@ static bool _prep_out_transaction (cdcd_interface_t* p_cdc)
   }
 }
 
+static uint32_t _write_flush (cdcd_interface_t* p_cdc)
+{
+  // Skip if usb is not ready yet
+  TU_VERIFY( tud_ready(), 0 );
+
+  // No data to send
+  if ( !tu_fifo_count(&p_cdc->tx_ff) ) return 0;
+
+  uint8_t const rhport = 0;
+
+  // Claim the endpoint
+  TU_VERIFY( usbd_edpt_claim(rhport, p_cdc->ep_in), 0 );
+
+  // Pull data from FIFO
+  uint16_t const count = tu_fifo_read_n(&p_cdc->tx_ff, p_cdc->epin_buf, sizeof(p_cdc->epin_buf));
+
+  if ( count )
+  {
+    TU_ASSERT( usbd_edpt_xfer(rhport, p_cdc->ep_in, p_cdc->epin_buf, count), 0 );
+    return count;
+  }else
+  {
+    // Release endpoint since we don't make any transfer
+    // Note: data is dropped if terminal is not connected
+    usbd_edpt_release(rhport, p_cdc->ep_in);
+    return 0;
+  }
+}
+
+#if CFG_TUSB_MULTICORE
+// Invoked by usbd task on the stack core, application core only touches the fifos
+static void _xcore_func (void* param)
+{
+  cdcd_interface_t* p_cdc = (cdcd_interface_t*) param;
+
+  if ( p_cdc->tx_discard )
+  {
+    // tx fifo is consumed by stack core, discard by advancing read index only
+    p_cdc->tx_discard = false;
+    tu_fifo_advance_read_pointer(&p_cdc->tx_ff, tu_fifo_count(&p_cdc->tx_ff));
+  }
+
+  _prep_out_transaction(p_cdc);
+  _write_flush(p_cdc);
+}
+
+static void _xcore_request (cdcd_interface_t* p_cdc)
+{
+  usbd_xcore_request((uint8_t) (USBD_XCORE_CDC + (p_cdc - _cdcd_itf)), _xcore_func, p_cdc);
+}
+#endif
+
+// Discard data received before a bus reset, stack core can't since it is the producer of rx fifo
+static void _app_rx_sync (cdcd_interface_t* p_cdc)
+{
+#if CFG_TUSB_MULTICORE
+  uint8_t const seq = __atomic_load_n(&p_cdc->rx_reset_seq, __ATOMIC_ACQUIRE);
+  if ( seq != p_cdc->rx_reset_ack )
+  {
+    tu_fifo_discard_until(&p_cdc->rx_ff, p_cdc->rx_reset_idx);
+    p_cdc->rx_reset_ack = seq;
+  }
+#else
+  (void) p_cdc;
+#endif
+}
+
+// Application consumed data from rx fifo, try to receive more
+static void _app_prep_out (cdcd_interface_t* p_cdc)
+{
+#if CFG_TUSB_MULTICORE
+  _xcore_request(p_cdc);
+#else
+  _prep_out_transaction(p_cdc);
+#endif
+}
+
 //--------------------------------------------------------------------+
 // APPLICATION API
 //--------------------------------------------------------------------+
@@ -144,27 +233,36 @@ void tud_cdc_n_set_wanted_char (uint8_t itf, char wanted)
 //--------------------------------------------------------------------+
 uint32_t tud_cdc_n_available(uint8_t itf)
 {
+  _app_rx_sync(&_cdcd_itf[itf]);
   return tu_fifo_count(&_cdcd_itf[itf].rx_ff);
 }
 
 uint32_t tud_cdc_n_read(uint8_t itf, void* buffer, uint32_t bufsize)
 {
   cdcd_interface_t* p_cdc = &_cdcd_itf[itf];
+  _app_rx_sync(p_cdc);
   uint32_t num_read = tu_fifo_read_n(&p_cdc->rx_ff, buffer, (uint16_t) TU_MIN(bufsize, UINT16_MAX));
-  _prep_out_transaction(p_cdc);
+  _app_prep_out(p_cdc);
   return num_read;
 }
 
 bool tud_cdc_n_peek(uint8_t itf, uint8_t* chr)
 {
+  _app_rx_sync(&_cdcd_itf[itf]);
   return tu_fifo_peek(&_cdcd_itf[itf].rx_ff, chr);
 }
 
 void tud_cdc_n_read_flush (uint8_t itf)
 {
   cdcd_interface_t* p_cdc = &_cdcd_itf[itf];
+  _app_rx_sync(p_cdc);
+#if CFG_TUSB_MULTICORE
+  // rx fifo is produced by stack core, discard by advancing read index only
+  tu_fifo_advance_read_pointer(&p_cdc->rx_ff, tu_fifo_count(&p_cdc->rx_ff));
+#else
   tu_fifo_clear(&p_cdc->rx_ff);
-  _prep_out_transaction(p_cdc);
+#endif
+  _app_prep_out(p_cdc);
 }
 
 //--------------------------------------------------------------------+
@@ -189,31 +287,14 @@ uint32_t tud_cdc_n_write_flush (uint8_t itf)
 {
   cdcd_interface_t* p_cdc = &_cdcd_itf[itf];
 
-  // Skip if usb is not ready yet
+#if CFG_TUSB_MULTICORE
+  // Transfer is started by stack core, return number of bytes queued for sending
   TU_VERIFY( tud_ready(), 0 );
-
-  // No data to send
-  if ( !tu_fifo_count(&p_cdc->tx_ff) ) return 0;
-
-  uint8_t const rhport = 0;
-
-  // Claim the endpoint
-  TU_VERIFY( usbd_edpt_claim(rhport, p_cdc->ep_in), 0 );
-
-  // Pull data from FIFO
-  uint16_t const count = tu_fifo_read_n(&p_cdc->tx_ff, p_cdc->epin_buf, sizeof(p_cdc->epin_buf));
-
-  if ( count )
-  {
-    TU_ASSERT( usbd_edpt_xfer(rhport, p_cdc->ep_in, p_cdc->epin_buf, count), 0 );
-    return count;
-  }else
-  {
-    // Release endpoint since we don't make any transfer
-    // Note: data is dropped if terminal is not connected
-    usbd_edpt_release(rhport, p_cdc->ep_in);
-    return 0;
-  }
+  _xcore_request(p_cdc);
+  return tu_fifo_count(&p_cdc->tx_ff);
+#else
+  return _write_flush(p_cdc);
+#endif
 }
 
 uint32_t tud_cdc_n_write_available (uint8_t itf)
@@ -223,7 +304,15 @@ uint32_t tud_cdc_n_write_available (uint8_t itf)
 
 bool tud_cdc_n_write_clear (uint8_t itf)
 {
+#if CFG_TUSB_MULTICORE
+  // tx fifo is consumed by stack core, data queued so far is discarded there
+  cdcd_interface_t* p_cdc = &_cdcd_itf[itf];
+  p_cdc->tx_discard = true;
+  _xcore_request(p_cdc);
+  return true;
+#else
   return tu_fifo_clear(&_cdcd_itf[itf].tx_ff);
+#endif
 }
 
 //--------------------------------------------------------------------+
@@ -251,7 +340,8 @@ void cdcd_init(void)
     // Config TX fifo as overwritable at initialization and will be changed to non-overwritable
     // if terminal supports DTR bit. Without DTR we do not know if data is actually polled by terminal.
     // In this way, the most current data is prioritized.
-    tu_fifo_config(&p_cdc->tx_ff, p_cdc->tx_ff_buf, TU_ARRAY_SIZE(p_cdc->tx_ff_buf), 1, true);
+    // Multi-core: overwriting moves read index from the producer side, which is not lock-free
+    tu_fifo_config(&p_cdc->tx_ff, p_cdc->tx_ff_buf, TU_ARRAY_SIZE(p_cdc->tx_ff_buf), 1, !CFG_TUSB_MULTICORE);
 
     tu_fifo_config_mutex(&p_cdc->rx_ff, NULL, osal_mutex_create(&p_cdc->rx_ff_mutex));
     tu_fifo_config_mutex(&p_cdc->tx_ff, osal_mutex_create(&p_cdc->tx_ff_mutex), NULL);
@@ -267,9 +357,16 @@ void cdcd_reset(uint8_t rhport)
     cdcd_interface_t* p_cdc = &_cdcd_itf[i];
 
     tu_memclr(p_cdc, ITF_MEM_RESET_SIZE);
+#if CFG_TUSB_MULTICORE
+    // fifos are only emptied by their consumer: tx here, rx by application core on its next access
+    tu_fifo_advance_read_pointer(&p_cdc->tx_ff, tu_fifo_count(&p_cdc->tx_ff));
+    p_cdc->rx_reset_idx = tu_fifo_write_index(&p_cdc->rx_ff);
+    __atomic_store_n(&p_cdc->rx_reset_seq, (uint8_t) (p_cdc->rx_reset_seq + 1), __ATOMIC_RELEASE);
+#else
     tu_fifo_clear(&p_cdc->rx_ff);
     tu_fifo_clear(&p_cdc->tx_ff);
     tu_fifo_set_overwritable(&p_cdc->tx_ff, true);
+#endif
   }
 }
 
@@ -327,6 +424,10 @@ uint16_t cdcd_open(uint8_t rhport, tusb_desc_interface_t const * itf_desc, uint1
     // Open endpoint pair
     TU_ASSERT( usbd_open_edpt_pair(rhport, p_desc, 2, TUSB_XFER_BULK, &p_cdc->ep_out, &p_cdc->ep_in), 0 );
 
+    tusb_desc_endpoint_t const* desc_ep = (tusb_desc_endpoint_t const*) p_desc;
+    if ( desc_ep->bEndpointAddress != p_cdc->ep_in ) desc_ep = (tusb_desc_endpoint_t const*) tu_desc_next(desc_ep);
+    p_cdc->ep_in_mps = tu_edpt_packet_size(desc_ep);
+
     drv_len += 2*sizeof(tusb_desc_endpoint_t);
   }
 
@@ -394,8 +495,10 @@ bool cdcd_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t
 
         p_cdc->line_state = (uint8_t) request->wValue;
 
+#if !CFG_TUSB_MULTICORE
         // Disable fifo overwriting if DTR bit is set
         tu_fifo_set_overwritable(&p_cdc->tx_ff, !dtr);
+#endif
 
         TU_LOG_DRV("  Set Control Line State: DTR = %d, RTS = %d\r\n", dtr, rts);
 
@@ -468,11 +571,11 @@ bool cdcd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_
     // invoke transmit callback to possibly refill tx fifo
     if ( tud_cdc_tx_complete_cb ) tud_cdc_tx_complete_cb(itf);
 
-    if ( 0 == tud_cdc_n_write_flush(itf) )
+    if ( 0 == _write_flush(p_cdc) )
     {
       // If there is no data left, a ZLP should be sent if
-      // xferred_bytes is multiple of EP Packet size and not zero
-      if ( !tu_fifo_count(&p_cdc->tx_ff) && xferred_bytes && (0 == (xferred_bytes & (BULK_PACKET_SIZE-1))) )
+      // xferred_bytes is multiple of EP Packet size and not zero.
+      if ( !tu_fifo_count(&p_cdc->tx_ff) && xferred_bytes && (0 == (xferred_bytes % p_cdc->ep_in_mps)) )
       {
         if ( usbd_edpt_claim(rhport, p_cdc->ep_in) )
         {
@@ -75,6 +75,22 @@ typedef struct {
 CFG_TUH_MEM_SECTION
 static cdch_interface_t cdch_data[CFG_TUH_CDC];
 
+// Ready set, bit n for interface index n
+TU_VERIFY_STATIC(CFG_TUH_CDC <= 32, "ready mask is 32-bit");
+
+enum {
+  READY_RX = 0,
+  READY_TX,
+  READY_COUNT
+};
+
+// An interface is ready when its bit differs between the word written by usbh task and the one written by
+// application API. Each word has a single writer, so no read-modify-write is shared between both sides.
+static struct {
+  volatile uint32_t task[READY_COUNT];
+  volatile uint32_t app[READY_COUNT];
+} _cdch_ready;
+
 //--------------------------------------------------------------------+
 // Serial Driver
 //--------------------------------------------------------------------+
@@ -212,6 +228,54 @@ static cdch_interface_t* make_new_itf(uint8_t daddr, tusb_desc_interface_t const
   return NULL;
 }
 
+static uint8_t ready_get(uint8_t idx)
+{
+  uint32_t const bit = TU_BIT(idx);
+  return (uint8_t) (((_cdch_ready.task[READY_RX] ^ _cdch_ready.app[READY_RX]) & bit ? TUH_CDC_READY_RX : 0) |
+                    ((_cdch_ready.task[READY_TX] ^ _cdch_ready.app[READY_TX]) & bit ? TUH_CDC_READY_TX : 0));
+}
+
+// Bring ready bits of interface in line with its FIFO levels by flipping own word only. Flipping is repeated
+// until consistent since the other side may have flipped its word based on an older state meanwhile.
+static void ready_update(uint8_t idx, volatile uint32_t* own, volatile uint32_t const* other)
+{
+  cdch_interface_t* p_cdc = &cdch_data[idx];
+  uint32_t const bit = TU_BIT(idx);
+
+  for (uint8_t i = 0; i < READY_COUNT; i++) {
+    while (1) {
+      bool const level = (p_cdc->daddr != 0) &&
+                         (i == READY_RX ? tu_edpt_stream_read_available(&p_cdc->stream.rx)
+                                        : tu_edpt_stream_write_available(&p_cdc->stream.tx)) != 0;
+      bool const ready = ((own[i] ^ other[i]) & bit) != 0;
+      if (level == ready) break;
+
+      own[i] ^= bit;
+    }
+  }
+}
+
+// FIFO levels changed by usbh task
+TU_ATTR_ALWAYS_INLINE static inline void ready_update_task(uint8_t idx)
+{
+  ready_update(idx, _cdch_ready.task, _cdch_ready.app);
+}
+
+// FIFO levels changed by application
+TU_ATTR_ALWAYS_INLINE static inline void ready_update_app(uint8_t idx)
+{
+  ready_update(idx, _cdch_ready.app, _cdch_ready.task);
+}
+
+// Update from usbh task and invoke callback for events that were not ready before
+static void ready_notify(uint8_t idx, uint8_t was_ready)
+{
+  ready_update_task(idx);
+
+  uint8_t const events = ready_get(idx) & (uint8_t) ~was_ready;
+  if (events && tuh_cdc_ready_cb) tuh_cdc_ready_cb(idx, events);
+}
+
 static bool open_ep_stream_pair(cdch_interface_t* p_cdc , tusb_desc_endpoint_t const *desc_ep);
 static void set_config_complete(cdch_interface_t * p_cdc, uint8_t idx, uint8_t itf_num);
 static void cdch_internal_control_complete(tuh_xfer_t* xfer);
@@ -296,7 +360,9 @@ uint32_t tuh_cdc_write(uint8_t idx, void const* buffer, uint32_t bufsize)
   cdch_interface_t* p_cdc = get_itf(idx);
   TU_VERIFY(p_cdc);
 
-  return tu_edpt_stream_write(&p_cdc->stream.tx, buffer, bufsize);
+  uint32_t const count = tu_edpt_stream_write(&p_cdc->stream.tx, buffer, bufsize);
+  ready_update_app(idx);
+  return count;
 }
 
 uint32_t tuh_cdc_write_flush(uint8_t idx)
@@ -304,7 +370,9 @@ uint32_t tuh_cdc_write_flush(uint8_t idx)
   cdch_interface_t* p_cdc = get_itf(idx);
   TU_VERIFY(p_cdc);
 
-  return tu_edpt_stream_write_xfer(&p_cdc->stream.tx);
+  uint32_t const count = tu_edpt_stream_write_xfer(&p_cdc->stream.tx);
+  ready_update_app(idx);
+  return count;
 }
 
 bool tuh_cdc_write_clear(uint8_t idx)
@@ -312,7 +380,9 @@ bool tuh_cdc_write_clear(uint8_t idx)
   cdch_interface_t* p_cdc = get_itf(idx);
   TU_VERIFY(p_cdc);
 
-  return tu_edpt_stream_clear(&p_cdc->stream.tx);
+  bool const ret = tu_edpt_stream_clear(&p_cdc->stream.tx);
+  ready_update_app(idx);
+  return ret;
 }
 
 uint32_t tuh_cdc_write_available(uint8_t idx)
@@ -332,7 +402,9 @@ uint32_t tuh_cdc_read (uint8_t idx, void* buffer, uint32_t bufsize)
   cdch_interface_t* p_cdc = get_itf(idx);
   TU_VERIFY(p_cdc);
 
-  return tu_edpt_stream_read(&p_cdc->stream.rx, buffer, bufsize);
+  uint32_t const count = tu_edpt_stream_read(&p_cdc->stream.rx, buffer, bufsize);
+  ready_update_app(idx);
+  return count;
 }
 
 uint32_t tuh_cdc_read_available(uint8_t idx)
@@ -358,9 +430,18 @@ bool tuh_cdc_read_clear (uint8_t idx)
 
   bool ret = tu_edpt_stream_clear(&p_cdc->stream.rx);
   tu_edpt_stream_read_xfer(&p_cdc->stream.rx);
+  ready_update_app(idx);
   return ret;
 }
 
+uint32_t tuh_cdc_ready_mask(uint8_t events)
+{
+  uint32_t mask = 0;
+  if (events & TUH_CDC_READY_RX) mask |= _cdch_ready.task[READY_RX] ^ _cdch_ready.app[READY_RX];
+  if (events & TUH_CDC_READY_TX) mask |= _cdch_ready.task[READY_TX] ^ _cdch_ready.app[READY_TX];
+  return mask;
+}
+
 //--------------------------------------------------------------------+
 // Control Endpoint API
 //--------------------------------------------------------------------+
@@ -517,6 +598,7 @@ bool tuh_cdc_set_line_coding(uint8_t idx, cdc_line_coding_t const* line_coding,
 void cdch_init(void)
 {
   tu_memclr(cdch_data, sizeof(cdch_data));
+  tu_memclr((void*) (uintptr_t) &_cdch_ready, sizeof(_cdch_ready));
 
   for(size_t i=0; i<CFG_TUH_CDC; i++)
   {
@@ -549,6 +631,7 @@ void cdch_close(uint8_t daddr)
       p_cdc->bInterfaceNumber = 0;
       tu_edpt_stream_close(&p_cdc->stream.tx);
       tu_edpt_stream_close(&p_cdc->stream.rx);
+      ready_update_task(idx);
     }
   }
 }
@@ -561,6 +644,9 @@ bool cdch_xfer_cb(uint8_t daddr, uint8_t ep_addr, xfer_result_t event, uint32_t
   cdch_interface_t * p_cdc = get_itf(idx);
   TU_ASSERT(p_cdc);
 
+  // callbacks below may read/write and change FIFO levels
+  uint8_t const was_ready = ready_get(idx);
+
   if ( ep_addr == p_cdc->stream.tx.ep_addr ) {
     // invoke tx complete callback to possibly refill tx fifo
     if (tuh_cdc_tx_complete_cb) tuh_cdc_tx_complete_cb(idx);
@@ -570,6 +656,8 @@ bool cdch_xfer_cb(uint8_t daddr, uint8_t ep_addr, xfer_result_t event, uint32_t
       // - xferred_bytes is multiple of EP Packet size and not zero
       tu_edpt_stream_write_zlp_if_needed(&p_cdc->stream.tx, xferred_bytes);
     }
+
+    ready_notify(idx, was_ready);
   }
   else if ( ep_addr == p_cdc->stream.rx.ep_addr ) {
     #if CFG_TUH_CDC_FTDI
@@ -592,6 +680,8 @@ bool cdch_xfer_cb(uint8_t daddr, uint8_t ep_addr, xfer_result_t event, uint32_t
 
     // prepare for next transfer if needed
     tu_edpt_stream_read_xfer(&p_cdc->stream.rx);
+
+    ready_notify(idx, was_ready);
   }else if ( ep_addr == p_cdc->ep_notif ) {
     // TODO handle notification endpoint
   }else {
@@ -678,6 +768,9 @@ static void set_config_complete(cdch_interface_t * p_cdc, uint8_t idx, uint8_t i
   // Prepare for incoming data
   tu_edpt_stream_read_xfer(&p_cdc->stream.rx);
 
+  // TX FIFO is empty, ready to write
+  ready_notify(idx, 0);
+
   // notify usbh that driver enumeration is complete
   usbh_driver_set_config_complete(p_cdc->daddr, itf_num);
 }
@@ -132,6 +132,32 @@ bool tuh_cdc_peek(uint8_t idx, uint8_t* ch);
 // Clear the received FIFO
 bool tuh_cdc_read_clear (uint8_t idx);
 
+//--------------------------------------------------------------------+
+// Ready Set API
+// Instead of polling read/write available of every interface, application can get a bitmask of interfaces
+// (bit n for index n) that have data to read and/or space to write. The mask is kept up to date by usbh task
+// and by the read/write API, which should be called from a single application context.
+// tuh_cdc_ready_cb() is invoked from usbh task when an interface becomes ready.
+//--------------------------------------------------------------------+
+
+enum {
+  TUH_CDC_READY_RX = 0x01, // RX FIFO has data
+  TUH_CDC_READY_TX = 0x02, // TX FIFO has space
+};
+
+// Get bitmask of interfaces that are ready for any of events (TUH_CDC_READY_RX | TUH_CDC_READY_TX)
+uint32_t tuh_cdc_ready_mask(uint8_t events);
+
+// Remove lowest interface from mask and return its index, TUSB_INDEX_INVALID_8 if mask is empty
+// e.g for(uint8_t idx = tuh_cdc_ready_next(&mask); idx != TUSB_INDEX_INVALID_8; idx = tuh_cdc_ready_next(&mask))
+TU_ATTR_ALWAYS_INLINE static inline uint8_t tuh_cdc_ready_next(uint32_t* mask)
+{
+  if (*mask == 0) return TUSB_INDEX_INVALID_8;
+  uint8_t const idx = tu_ctz32(*mask);
+  *mask &= *mask - 1;
+  return idx;
+}
+
 //--------------------------------------------------------------------+
 // Control Endpoint (Request) API
 // Each Function will make a USB control transfer request to/from device
@@ -188,6 +214,10 @@ TU_ATTR_WEAK extern void tuh_cdc_rx_cb(uint8_t idx);
 // Invoked when a TX is complete and therefore space becomes available in TX buffer
 TU_ATTR_WEAK extern void tuh_cdc_tx_complete_cb(uint8_t idx);
 
+// Invoked when interface becomes ready: RX FIFO gets data and/or TX FIFO gets space.
+// events is bitmap of TUH_CDC_READY_RX/TX that were not ready before
+TU_ATTR_WEAK extern void tuh_cdc_ready_cb(uint8_t idx, uint8_t events);
+
 //--------------------------------------------------------------------+
 // Internal Class Driver API
 //--------------------------------------------------------------------+
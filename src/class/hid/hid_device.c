@@ -50,8 +50,8 @@ typedef struct
   uint8_t idle_rate;     // up to application to handle idle rate
   uint16_t report_desc_len;
 
-  CFG_TUSB_MEM_ALIGN uint8_t epin_buf[CFG_TUD_HID_EP_BUFSIZE];
-  CFG_TUSB_MEM_ALIGN uint8_t epout_buf[CFG_TUD_HID_EP_BUFSIZE];
+  TUD_EPBUF_DEF(epin_buf, CFG_TUD_HID_EP_BUFSIZE);
+  TUD_EPBUF_DEF(epout_buf, CFG_TUD_HID_EP_BUFSIZE);
 
   // TODO save hid descriptor since host can specifically request this after enumeration
   // Note: HID descriptor may be not available from application after enumeration
@@ -672,7 +672,10 @@ uint8_t tuh_hid_parse_report_descriptor(tuh_hid_report_info_t* report_info_arr,
     uint8_t const type = header.type;
     uint8_t const size = header.size;
 
-    uint8_t const data8 = desc_report[0];
+    // truncated item, its data would be read past the descriptor
+    if (size > desc_len) break;
+
+    uint8_t const data8 = size ? desc_report[0] : 0;
 
     TU_LOG(3, "tag = %d, type = %d, size = %d, data = ", tag, type, size);
     for(uint32_t i=0; i<size; i++) TU_LOG(3, "%02X ", desc_report[i]);
@@ -709,7 +712,7 @@ uint8_t tuh_hid_parse_report_descriptor(tuh_hid_report_info_t* report_info_arr,
         {
           case RI_GLOBAL_USAGE_PAGE:
             // only take in account the "usage page" before REPORT ID
-            if ( ri_collection_depth == 0 ) memcpy(&info->usage_page, desc_report, size);
+            if ( ri_collection_depth == 0 ) memcpy(&info->usage_page, desc_report, tu_min8(size, sizeof(info->usage_page)));
           break;
 
           case RI_GLOBAL_LOGICAL_MIN   : break;
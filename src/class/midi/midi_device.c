@@ -72,8 +72,8 @@ typedef struct
   #endif
 
   // Endpoint Transfer buffer
-  CFG_TUSB_MEM_ALIGN uint8_t epout_buf[CFG_TUD_MIDI_EP_BUFSIZE];
-  CFG_TUSB_MEM_ALIGN uint8_t epin_buf[CFG_TUD_MIDI_EP_BUFSIZE];
+  TUD_EPBUF_DEF(epout_buf, CFG_TUD_MIDI_EP_BUFSIZE);
+  TUD_EPBUF_DEF(epin_buf, CFG_TUD_MIDI_EP_BUFSIZE);
 
 } midid_interface_t;
 
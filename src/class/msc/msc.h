@@ -58,7 +58,8 @@ typedef enum
 {
   MSC_PROTOCOL_CBI              = 0 ,  ///< Control/Bulk/Interrupt protocol (with command completion interrupt)
   MSC_PROTOCOL_CBI_NO_INTERRUPT = 1 ,  ///< Control/Bulk/Interrupt protocol (without command completion interrupt)
-  MSC_PROTOCOL_BOT              = 0x50 ///< Bulk-Only Transport
+  MSC_PROTOCOL_BOT              = 0x50,///< Bulk-Only Transport
+  MSC_PROTOCOL_UAS              = 0x62 ///< USB Attached SCSI
 }msc_protocol_type_t;
 
 /// MassStorage Class-Specific Control Request
@@ -103,6 +104,102 @@ typedef struct TU_ATTR_PACKED
 
 TU_VERIFY_STATIC(sizeof(msc_csw_t) == 13, "size is not correct");
 
+//--------------------------------------------------------------------+
+// USB Attached SCSI (UAS)
+//--------------------------------------------------------------------+
+
+/// Pipe Usage descriptor type, follows each endpoint descriptor of an UAS interface
+#define MSC_UAS_DESC_PIPE_USAGE   0x24
+
+/// Pipe ID in Pipe Usage descriptor
+typedef enum
+{
+  MSC_UAS_PIPE_COMMAND  = 1,
+  MSC_UAS_PIPE_STATUS   = 2,
+  MSC_UAS_PIPE_DATA_IN  = 3,
+  MSC_UAS_PIPE_DATA_OUT = 4
+}msc_uas_pipe_id_t;
+
+/// Information Unit ID
+typedef enum
+{
+  MSC_UAS_IU_COMMAND     = 0x01,
+  MSC_UAS_IU_SENSE       = 0x03,
+  MSC_UAS_IU_RESPONSE    = 0x04,
+  MSC_UAS_IU_TASK_MGMT   = 0x05,
+  MSC_UAS_IU_READ_READY  = 0x06,
+  MSC_UAS_IU_WRITE_READY = 0x07
+}msc_uas_iu_id_t;
+
+/// SCSI status in Sense IU
+enum
+{
+  MSC_UAS_STATUS_GOOD            = 0x00,
+  MSC_UAS_STATUS_CHECK_CONDITION = 0x02
+};
+
+/// Pipe Usage descriptor
+typedef struct TU_ATTR_PACKED
+{
+  uint8_t bLength;
+  uint8_t bDescriptorType; ///< MSC_UAS_DESC_PIPE_USAGE
+  uint8_t bPipeID;         ///< Value from \ref msc_uas_pipe_id_t
+  uint8_t bReserved;
+}msc_uas_desc_pipe_usage_t;
+
+/// Command IU, sent on command pipe. Multi-byte fields are big endian
+typedef struct TU_ATTR_PACKED
+{
+  uint8_t  iu_id;       ///< MSC_UAS_IU_COMMAND
+  uint8_t  reserved1;
+  uint16_t tag;         ///< Identify the command in following Read/Write Ready and Sense IU
+  uint8_t  prio_attr;   ///< Task priority (bit 6:3) and attribute (bit 2:0), 0 is SIMPLE
+  uint8_t  reserved5;
+  uint8_t  add_cdb_len; ///< Additional CDB length in dwords (bit 7:2)
+  uint8_t  reserved7;
+  uint8_t  lun[8];      ///< SAM LUN, single level LUN is in byte 1
+  uint8_t  cdb[16];
+}msc_uas_cmd_iu_t;
+
+TU_VERIFY_STATIC(sizeof(msc_uas_cmd_iu_t) == 32, "size is not correct");
+
+/// Sense IU, sent on status pipe when a command is complete
+typedef struct TU_ATTR_PACKED
+{
+  uint8_t  iu_id;            ///< MSC_UAS_IU_SENSE
+  uint8_t  reserved1;
+  uint16_t tag;
+  uint16_t status_qualifier;
+  uint8_t  status;           ///< SCSI status, MSC_UAS_STATUS_GOOD if command is successful
+  uint8_t  reserved7[7];
+  uint16_t sense_len;        ///< Length of following sense data
+  uint8_t  sense_data[18];
+}msc_uas_sense_iu_t;
+
+TU_VERIFY_STATIC(sizeof(msc_uas_sense_iu_t) == 34, "size is not correct");
+
+/// Response IU, sent on status pipe e.g when command IU is invalid
+typedef struct TU_ATTR_PACKED
+{
+  uint8_t  iu_id;       ///< MSC_UAS_IU_RESPONSE
+  uint8_t  reserved1;
+  uint16_t tag;
+  uint8_t  add_response_info[3];
+  uint8_t  response_code;
+}msc_uas_response_iu_t;
+
+TU_VERIFY_STATIC(sizeof(msc_uas_response_iu_t) == 8, "size is not correct");
+
+/// Read Ready / Write Ready IU: device is ready for data phase of tagged command
+typedef struct TU_ATTR_PACKED
+{
+  uint8_t  iu_id;       ///< MSC_UAS_IU_READ_READY or MSC_UAS_IU_WRITE_READY
+  uint8_t  reserved1;
+  uint16_t tag;
+}msc_uas_ready_iu_t;
+
+TU_VERIFY_STATIC(sizeof(msc_uas_ready_iu_t) == 4, "size is not correct");
+
 //--------------------------------------------------------------------+
 // SCSI Constant
 //--------------------------------------------------------------------+
@@ -121,6 +218,7 @@ typedef enum
   SCSI_CMD_READ_FORMAT_CAPACITY         = 0x23, ///< The command allows the Host to request a list of the possible format capacities for an installed writable media. This command also has the capability to report the writable capacity for a media when it is installed
   SCSI_CMD_READ_10                      = 0x28, ///< The READ (10) command requests that the device server read the specified logical block(s) and transfer them to the data-in buffer.
   SCSI_CMD_WRITE_10                     = 0x2A, ///< The WRITE (10) command requests that the device server transfer the specified logical block(s) from the data-out buffer and write them.
+  SCSI_CMD_REPORT_LUNS                  = 0xA0, ///< The REPORT LUNS command requests the list of logical unit numbers accessible to the initiator.
 }scsi_cmd_type_t;
 
 /// SCSI Sense Key
@@ -307,6 +405,30 @@ typedef struct TU_ATTR_PACKED
 
 TU_VERIFY_STATIC( sizeof(scsi_start_stop_unit_t) == 6, "size is not correct");
 
+/// SCSI Report LUNs Command
+typedef struct TU_ATTR_PACKED
+{
+  uint8_t  cmd_code      ; ///< SCSI OpCode for \ref SCSI_CMD_REPORT_LUNS
+  uint8_t  reserved1     ;
+  uint8_t  select_report ; ///< 0: all logical units except well known ones
+  uint8_t  reserved3[3]  ;
+  uint32_t alloc_length  ; ///< Big Endian, at least 16
+  uint8_t  reserved10    ;
+  uint8_t  control       ;
+} scsi_report_luns_t;
+
+TU_VERIFY_STATIC( sizeof(scsi_report_luns_t) == 12, "size is not correct");
+
+/// SCSI Report LUNs Response Data with first LUN entry, the list continues if there is more than one LUN
+typedef struct TU_ATTR_PACKED
+{
+  uint32_t list_length ; ///< Big Endian, length in bytes of LUN list, 8 bytes per LUN
+  uint32_t reserved    ;
+  uint8_t  lun[8]      ; ///< SAM LUN, single level LUN is in byte 1
+} scsi_report_luns_resp_t;
+
+TU_VERIFY_STATIC( sizeof(scsi_report_luns_resp_t) == 16, "size is not correct");
+
 //--------------------------------------------------------------------+
 // SCSI MMC
 //--------------------------------------------------------------------+
@@ -51,6 +51,39 @@ enum
   MSC_STAGE_STATUS,
 };
 
+#if CFG_TUH_MSC_UAS
+enum
+{
+  UAS_CMD_FREE = 0,
+  UAS_CMD_QUEUED, // waiting for command pipe
+  UAS_CMD_SENT,   // waiting for Read/Write Ready or Sense IU
+  UAS_CMD_DATA,   // data phase
+  UAS_CMD_SENSED, // Sense IU received before data phase is complete
+  UAS_CMD_ABORTED // failed to application, waiting for Sense IU to retire the tag
+};
+
+// index of endpoint is pipe id - 1
+enum
+{
+  UAS_EP_COMMAND = MSC_UAS_PIPE_COMMAND - 1,
+  UAS_EP_STATUS  = MSC_UAS_PIPE_STATUS - 1,
+  UAS_EP_DATA_IN = MSC_UAS_PIPE_DATA_IN - 1,
+  UAS_EP_DATA_OUT = MSC_UAS_PIPE_DATA_OUT - 1,
+  UAS_EP_COUNT
+};
+
+typedef struct
+{
+  uint8_t   state;
+  void*     buffer;
+  uint32_t  xferred;
+  uint8_t   status; // from Sense IU in UAS_CMD_SENSED
+  tuh_msc_complete_cb_t complete_cb;
+  uintptr_t complete_arg;
+  msc_cbw_t cbw; // command as issued by application, passed back on completion
+}msch_uas_cmd_t;
+#endif
+
 typedef struct
 {
   uint8_t itf_num;
@@ -75,8 +108,36 @@ typedef struct
 
   CFG_TUH_MEM_ALIGN msc_cbw_t cbw;
   CFG_TUH_MEM_ALIGN msc_csw_t csw;
+
+#if CFG_TUH_MSC_UAS
+  //------------- UAS -------------//
+  bool    uas_avail; // interface has UAS alternate setting
+  bool    uas;       // UAS alternate is selected
+  uint8_t uas_alt;
+  uint8_t uas_data_slot; // command in data phase
+  uint8_t uas_cmd_slot;  // command IU on command pipe
+  uint8_t uas_halted;    // bitmap of UAS_EP_* waiting for Clear Feature ENDPOINT_HALT
+  bool    uas_clearing;  // Clear Feature is in progress or scheduled
+  uint8_t uas_ep[UAS_EP_COUNT];
+  tusb_desc_endpoint_t uas_ep_desc[UAS_EP_COUNT]; // opened when UAS is selected
+  tusb_desc_endpoint_t bot_ep_desc[2];            // Bulk-Only endpoints by direction, compared on UAS open
+
+  // commands waiting for command pipe, in issued order
+  uint8_t uas_queue[CFG_TUH_MSC_UAS_QUEUE_DEPTH];
+  uint8_t uas_queue_head;
+  uint8_t uas_queue_count;
+
+  msch_uas_cmd_t uas_cmd[CFG_TUH_MSC_UAS_QUEUE_DEPTH];
+
+  CFG_TUH_MEM_ALIGN msc_uas_cmd_iu_t uas_cmd_iu[CFG_TUH_MSC_UAS_QUEUE_DEPTH];
+  CFG_TUH_MEM_ALIGN uint8_t uas_status[CFG_TUH_MSC_UAS_STATUS_BUFSIZE];
+#endif
 }msch_interface_t;
 
+#if CFG_TUH_MSC_UAS
+TU_VERIFY_STATIC(CFG_TUH_MSC_UAS_STATUS_BUFSIZE >= sizeof(msc_uas_sense_iu_t), "UAS status buffer is too small");
+#endif
+
 CFG_TUH_MEM_SECTION static msch_interface_t _msch_itf[CFG_TUH_DEVICE_MAX];
 
 // buffer used to read scsi information when mounted
@@ -118,12 +179,36 @@ bool tuh_msc_mounted(uint8_t dev_addr)
   return p_msc->mounted;
 }
 
+#if CFG_TUH_MSC_UAS
+static uint8_t uas_find_free(msch_interface_t const* p_msc);
+static bool uas_command(uint8_t dev_addr, msch_interface_t* p_msc, msc_cbw_t const* cbw, void* data,
+                        tuh_msc_complete_cb_t complete_cb, uintptr_t arg);
+#endif
+
 bool tuh_msc_ready(uint8_t dev_addr)
 {
   msch_interface_t* p_msc = get_itf(dev_addr);
+
+#if CFG_TUH_MSC_UAS
+  if (p_msc->uas)
+  {
+    return p_msc->mounted && (uas_find_free(p_msc) < CFG_TUH_MSC_UAS_QUEUE_DEPTH);
+  }
+#endif
+
   return p_msc->mounted && !usbh_edpt_busy(dev_addr, p_msc->ep_in) && !usbh_edpt_busy(dev_addr, p_msc->ep_out);
 }
 
+bool tuh_msc_is_uas(uint8_t dev_addr)
+{
+#if CFG_TUH_MSC_UAS
+  return get_itf(dev_addr)->uas;
+#else
+  (void) dev_addr;
+  return false;
+#endif
+}
+
 //--------------------------------------------------------------------+
 // PUBLIC API: SCSI COMMAND
 //--------------------------------------------------------------------+
@@ -140,6 +225,10 @@ bool tuh_msc_scsi_command(uint8_t dev_addr, msc_cbw_t const* cbw, void* data, tu
   msch_interface_t* p_msc = get_itf(dev_addr);
   TU_VERIFY(p_msc->configured);
 
+#if CFG_TUH_MSC_UAS
+  if (p_msc->uas) return uas_command(dev_addr, p_msc, cbw, data, complete_cb, arg);
+#endif
+
   // TODO claim endpoint
 
   p_msc->cbw = *cbw;
@@ -321,9 +410,18 @@ void msch_close(uint8_t dev_addr)
   tu_memclr(p_msc, sizeof(msch_interface_t));
 }
 
+#if CFG_TUH_MSC_UAS
+static bool uas_xfer_cb(uint8_t dev_addr, msch_interface_t* p_msc, uint8_t ep_addr, xfer_result_t event, uint32_t xferred_bytes);
+#endif
+
 bool msch_xfer_cb(uint8_t dev_addr, uint8_t ep_addr, xfer_result_t event, uint32_t xferred_bytes)
 {
   msch_interface_t* p_msc = get_itf(dev_addr);
+
+#if CFG_TUH_MSC_UAS
+  if (p_msc->uas) return uas_xfer_cb(dev_addr, p_msc, ep_addr, event, xferred_bytes);
+#endif
+
   msc_cbw_t const * cbw = &p_msc->cbw;
   msc_csw_t       * csw = &p_msc->csw;
 
@@ -378,6 +476,377 @@ bool msch_xfer_cb(uint8_t dev_addr, uint8_t ep_addr, xfer_result_t event, uint32
   return true;
 }
 
+//--------------------------------------------------------------------+
+// USB Attached SCSI
+// Without streams (USB 2.0), device tells which command it is ready to transfer data for with
+// Read/Write Ready IU on status pipe, followed by the data phase and Sense IU for that tag.
+// Tag is command slot index + 1.
+//--------------------------------------------------------------------+
+#if CFG_TUH_MSC_UAS
+
+static uint8_t uas_find_free(msch_interface_t const* p_msc)
+{
+  uint8_t slot;
+  for(slot = 0; slot < CFG_TUH_MSC_UAS_QUEUE_DEPTH; slot++)
+  {
+    if (p_msc->uas_cmd[slot].state == UAS_CMD_FREE) break;
+  }
+  return slot;
+}
+
+static bool uas_outstanding(msch_interface_t const* p_msc)
+{
+  for(uint8_t slot = 0; slot < CFG_TUH_MSC_UAS_QUEUE_DEPTH; slot++)
+  {
+    uint8_t const state = p_msc->uas_cmd[slot].state;
+    if (state == UAS_CMD_SENT || state == UAS_CMD_DATA || state == UAS_CMD_ABORTED) return true;
+  }
+  return false;
+}
+
+// Send next queued command IU if command pipe is idle
+static void uas_send_next(uint8_t dev_addr, msch_interface_t* p_msc)
+{
+  uint8_t const ep_cmd = p_msc->uas_ep[UAS_EP_COMMAND];
+  if (p_msc->uas_queue_count == 0 || (p_msc->uas_halted & TU_BIT(UAS_EP_COMMAND)) ||
+      usbh_edpt_busy(dev_addr, ep_cmd)) return;
+
+  uint8_t const slot = p_msc->uas_queue[p_msc->uas_queue_head];
+  p_msc->uas_queue_head = (uint8_t) ((p_msc->uas_queue_head + 1) % CFG_TUH_MSC_UAS_QUEUE_DEPTH);
+  p_msc->uas_queue_count--;
+
+  p_msc->uas_cmd[slot].state = UAS_CMD_SENT;
+  p_msc->uas_cmd_slot = slot;
+  TU_ASSERT(usbh_edpt_xfer(dev_addr, ep_cmd, (uint8_t*) &p_msc->uas_cmd_iu[slot], sizeof(msc_uas_cmd_iu_t)), );
+}
+
+// Keep a status request pending while there is command waiting for it
+static void uas_status_xfer(uint8_t dev_addr, msch_interface_t* p_msc)
+{
+  uint8_t const ep_status = p_msc->uas_ep[UAS_EP_STATUS];
+  if (!uas_outstanding(p_msc) || (p_msc->uas_halted & TU_BIT(UAS_EP_STATUS)) ||
+      usbh_edpt_busy(dev_addr, ep_status)) return;
+
+  // multiple of max packet size (checked when parsed) so that device never sends more than requested
+  uint16_t const mps = tu_edpt_packet_size(&p_msc->uas_ep_desc[UAS_EP_STATUS]);
+  uint16_t const len = (uint16_t) (CFG_TUH_MSC_UAS_STATUS_BUFSIZE - (CFG_TUH_MSC_UAS_STATUS_BUFSIZE % mps));
+
+  TU_ASSERT(usbh_edpt_xfer(dev_addr, ep_status, p_msc->uas_status, len), );
+}
+
+// Start data phase of command that device is ready for, unless its data pipe is being cleared
+static void uas_data_xfer(uint8_t dev_addr, msch_interface_t* p_msc)
+{
+  msch_uas_cmd_t* cmd = &p_msc->uas_cmd[p_msc->uas_data_slot];
+  if (cmd->state != UAS_CMD_DATA) return;
+
+  uint8_t const ep_idx = (cmd->cbw.dir & TUSB_DIR_IN_MASK) ? UAS_EP_DATA_IN : UAS_EP_DATA_OUT;
+  uint8_t const ep_data = p_msc->uas_ep[ep_idx];
+  if ((p_msc->uas_halted & TU_BIT(ep_idx)) || usbh_edpt_busy(dev_addr, ep_data)) return;
+
+  TU_ASSERT(usbh_edpt_xfer(dev_addr, ep_data, cmd->buffer, (uint16_t) cmd->cbw.total_bytes), );
+}
+
+static bool uas_command(uint8_t dev_addr, msch_interface_t* p_msc, msc_cbw_t const* cbw, void* data,
+                        tuh_msc_complete_cb_t complete_cb, uintptr_t arg)
+{
+  uint8_t const slot = uas_find_free(p_msc);
+  TU_VERIFY(slot < CFG_TUH_MSC_UAS_QUEUE_DEPTH);
+
+  msch_uas_cmd_t* cmd = &p_msc->uas_cmd[slot];
+  cmd->state        = UAS_CMD_QUEUED;
+  cmd->buffer       = data;
+  cmd->xferred      = 0;
+  cmd->complete_cb  = complete_cb;
+  cmd->complete_arg = arg;
+  cmd->cbw          = *cbw;
+
+  msc_uas_cmd_iu_t* iu = &p_msc->uas_cmd_iu[slot];
+  tu_memclr(iu, sizeof(msc_uas_cmd_iu_t));
+  iu->iu_id  = MSC_UAS_IU_COMMAND;
+  iu->tag    = tu_htons((uint16_t) (slot + 1));
+  iu->lun[1] = cbw->lun;
+  memcpy(iu->cdb, cbw->command, sizeof(iu->cdb));
+
+  uint8_t const tail = (uint8_t) ((p_msc->uas_queue_head + p_msc->uas_queue_count) % CFG_TUH_MSC_UAS_QUEUE_DEPTH);
+  p_msc->uas_queue[tail] = slot;
+  p_msc->uas_queue_count++;
+
+  uas_send_next(dev_addr, p_msc);
+  return true;
+}
+
+static void uas_complete(uint8_t dev_addr, msch_interface_t* p_msc, uint8_t slot, uint8_t status)
+{
+  msch_uas_cmd_t* cmd = &p_msc->uas_cmd[slot];
+
+  // free slot before invoking callback which may issue next command
+  msc_cbw_t const cbw = cmd->cbw;
+  msc_csw_t const csw =
+  {
+    .signature    = MSC_CSW_SIGNATURE,
+    .tag          = cbw.tag,
+    .data_residue = cbw.total_bytes - cmd->xferred,
+    .status       = status
+  };
+  tuh_msc_complete_cb_t const complete_cb = cmd->complete_cb;
+
+  tuh_msc_complete_data_t const cb_data =
+  {
+    .cbw = &cbw,
+    .csw = &csw,
+    .scsi_data = cmd->buffer,
+    .user_arg = cmd->complete_arg
+  };
+
+  // aborted command keeps its tag until device retires it with Sense IU
+  if (cmd->state != UAS_CMD_ABORTED) cmd->state = UAS_CMD_FREE;
+
+  if (complete_cb) complete_cb(dev_addr, &cb_data);
+}
+
+//------------- Error Recovery -------------//
+static void uas_clear_halt(uint8_t dev_addr, msch_interface_t* p_msc);
+
+static void uas_clear_halt_retry(void* param)
+{
+  uint8_t const daddr = (uint8_t) (uintptr_t) param;
+  msch_interface_t* p_msc = get_itf(daddr);
+  if (!p_msc->uas) return;
+
+  p_msc->uas_clearing = false;
+  uas_clear_halt(daddr, p_msc);
+}
+
+static void uas_clear_halt_complete(tuh_xfer_t* xfer)
+{
+  uint8_t const daddr = xfer->daddr;
+  msch_interface_t* p_msc = get_itf(daddr);
+  if (!p_msc->uas) return;
+
+  // don't retry a failed Clear Feature forever, next transfer on that pipe will tell
+  if (XFER_RESULT_SUCCESS != xfer->result)
+  {
+    TU_LOG_DRV("  UAS Clear Stall EP %02X failed\r\n", p_msc->uas_ep[xfer->user_data]);
+  }
+
+  p_msc->uas_clearing = false;
+  p_msc->uas_halted &= (uint8_t) ~TU_BIT(xfer->user_data);
+  uas_clear_halt(daddr, p_msc);
+}
+
+// Clear halted pipes one at a time, then resume status, data and command pipes
+static void uas_clear_halt(uint8_t dev_addr, msch_interface_t* p_msc)
+{
+  if (p_msc->uas_clearing) return;
+
+  if (p_msc->uas_halted == 0)
+  {
+    uas_status_xfer(dev_addr, p_msc);
+    uas_data_xfer(dev_addr, p_msc);
+    uas_send_next(dev_addr, p_msc);
+    return;
+  }
+
+  uint8_t const idx = tu_ctz32(p_msc->uas_halted);
+  p_msc->uas_clearing = true;
+
+  if (!tuh_edpt_clear_stall(dev_addr, p_msc->uas_ep[idx], uas_clear_halt_complete, idx))
+  {
+    // control pipe is busy, try again later
+    p_msc->uas_clearing = usbh_defer_func_ms(uas_clear_halt_retry, (void*) (uintptr_t) dev_addr, 1);
+  }
+}
+
+static void uas_pipe_error(uint8_t dev_addr, msch_interface_t* p_msc, uint8_t ep_idx)
+{
+  TU_LOG_DRV("  UAS pipe %u error\r\n", ep_idx + 1);
+  p_msc->uas_halted |= (uint8_t) TU_BIT(ep_idx);
+  uas_clear_halt(dev_addr, p_msc);
+}
+
+// Status pipe: Read/Write Ready IU starts data phase, Sense or Response IU completes the command
+static void uas_status_complete(uint8_t dev_addr, msch_interface_t* p_msc, uint32_t xferred_bytes)
+{
+  msc_uas_sense_iu_t const* iu = (msc_uas_sense_iu_t const*) ((void*) p_msc->uas_status);
+  TU_VERIFY(xferred_bytes >= sizeof(msc_uas_ready_iu_t), );
+
+  uint16_t const tag = tu_ntohs(iu->tag);
+  TU_VERIFY(tag >= 1 && tag <= CFG_TUH_MSC_UAS_QUEUE_DEPTH, );
+  uint8_t const slot = (uint8_t) (tag - 1);
+  msch_uas_cmd_t* cmd = &p_msc->uas_cmd[slot];
+
+  switch (iu->iu_id)
+  {
+    case MSC_UAS_IU_READ_READY:
+    case MSC_UAS_IU_WRITE_READY:
+      TU_VERIFY(cmd->state == UAS_CMD_SENT, );
+      cmd->state = UAS_CMD_DATA;
+      p_msc->uas_data_slot = slot;
+      uas_data_xfer(dev_addr, p_msc);
+    break;
+
+    case MSC_UAS_IU_SENSE:
+    case MSC_UAS_IU_RESPONSE:
+    {
+      // Response IU: command is rejected e.g invalid or overlapped tag
+      bool const good = (iu->iu_id == MSC_UAS_IU_SENSE) &&
+                        (xferred_bytes >= offsetof(msc_uas_sense_iu_t, sense_data)) &&
+                        (iu->status == MSC_UAS_STATUS_GOOD);
+      uint8_t const status = good ? MSC_CSW_STATUS_PASSED : MSC_CSW_STATUS_FAILED;
+
+      switch (cmd->state)
+      {
+        case UAS_CMD_SENT:
+          uas_complete(dev_addr, p_msc, slot, status);
+        break;
+
+        case UAS_CMD_DATA:
+        {
+          // device terminates data phase (e.g stalled), complete when data transfer returns if started
+          uint8_t const ep_data = p_msc->uas_ep[(cmd->cbw.dir & TUSB_DIR_IN_MASK) ? UAS_EP_DATA_IN : UAS_EP_DATA_OUT];
+          if (usbh_edpt_busy(dev_addr, ep_data))
+          {
+            cmd->state  = UAS_CMD_SENSED;
+            cmd->status = status;
+          }else
+          {
+            uas_complete(dev_addr, p_msc, slot, status);
+          }
+        }
+        break;
+
+        case UAS_CMD_ABORTED:
+          cmd->state = UAS_CMD_FREE;
+        break;
+
+        default: break;
+      }
+    }
+    break;
+
+    default: break;
+  }
+}
+
+static bool uas_xfer_cb(uint8_t dev_addr, msch_interface_t* p_msc, uint8_t ep_addr, xfer_result_t event, uint32_t xferred_bytes)
+{
+  bool const success = (event == XFER_RESULT_SUCCESS);
+
+  if (ep_addr == p_msc->uas_ep[UAS_EP_COMMAND])
+  {
+    if (!success)
+    {
+      // Command IU is not accepted, tag is never seen by device
+      msch_uas_cmd_t* cmd = &p_msc->uas_cmd[p_msc->uas_cmd_slot];
+      if (cmd->state == UAS_CMD_SENT) uas_complete(dev_addr, p_msc, p_msc->uas_cmd_slot, MSC_CSW_STATUS_FAILED);
+      uas_pipe_error(dev_addr, p_msc, UAS_EP_COMMAND);
+      return true;
+    }
+
+    uas_status_xfer(dev_addr, p_msc);
+    uas_send_next(dev_addr, p_msc);
+  }
+  else if (ep_addr == p_msc->uas_ep[UAS_EP_STATUS])
+  {
+    if (!success)
+    {
+      // status is re-armed when pipe is cleared, device sends the IU again
+      uas_pipe_error(dev_addr, p_msc, UAS_EP_STATUS);
+      return true;
+    }
+
+    uas_status_complete(dev_addr, p_msc, xferred_bytes);
+    uas_status_xfer(dev_addr, p_msc);
+  }
+  else if (ep_addr == p_msc->uas_ep[UAS_EP_DATA_IN] || ep_addr == p_msc->uas_ep[UAS_EP_DATA_OUT])
+  {
+    uint8_t const slot = p_msc->uas_data_slot;
+    msch_uas_cmd_t* cmd = &p_msc->uas_cmd[slot];
+    cmd->xferred = xferred_bytes;
+
+    if (cmd->state == UAS_CMD_SENSED)
+    {
+      uas_complete(dev_addr, p_msc, slot, success ? cmd->status : MSC_CSW_STATUS_FAILED);
+    }
+    else if (cmd->state == UAS_CMD_DATA)
+    {
+      if (success)
+      {
+        // data phase is done, wait for Sense IU
+        cmd->state = UAS_CMD_SENT;
+      }else
+      {
+        cmd->state = UAS_CMD_ABORTED;
+        uas_complete(dev_addr, p_msc, slot, MSC_CSW_STATUS_FAILED);
+      }
+    }
+
+    if (!success)
+    {
+      uas_pipe_error(dev_addr, p_msc, (ep_addr == p_msc->uas_ep[UAS_EP_DATA_IN]) ? UAS_EP_DATA_IN : UAS_EP_DATA_OUT);
+    }
+  }
+
+  return true;
+}
+
+// Look for UAS alternate setting: 4 bulk endpoints, each followed by a Pipe Usage descriptor
+static void uas_parse(msch_interface_t* p_msc, tusb_desc_interface_t const *desc_itf, uint16_t max_len)
+{
+  uint8_t const* p_desc   = (uint8_t const*) desc_itf;
+  uint8_t const* desc_end = p_desc + max_len;
+  tusb_desc_interface_t const* uas_itf = NULL;
+  tusb_desc_endpoint_t const* desc_ep = NULL;
+  uint8_t found = 0;
+
+  while (p_desc < desc_end && tu_desc_len(p_desc) && found != 0x0F)
+  {
+    switch (tu_desc_type(p_desc))
+    {
+      case TUSB_DESC_INTERFACE:
+      {
+        tusb_desc_interface_t const* itf = (tusb_desc_interface_t const*) p_desc;
+        bool const is_uas = (itf->bInterfaceClass == TUSB_CLASS_MSC && itf->bInterfaceSubClass == MSC_SUBCLASS_SCSI &&
+                             itf->bInterfaceProtocol == MSC_PROTOCOL_UAS && itf->bNumEndpoints == UAS_EP_COUNT);
+        uas_itf = is_uas ? itf : NULL;
+        desc_ep = NULL;
+        found = 0;
+      }
+      break;
+
+      case TUSB_DESC_ENDPOINT:
+        desc_ep = (tusb_desc_endpoint_t const*) p_desc;
+      break;
+
+      case MSC_UAS_DESC_PIPE_USAGE:
+      {
+        msc_uas_desc_pipe_usage_t const* pipe = (msc_uas_desc_pipe_usage_t const*) p_desc;
+        if (uas_itf && desc_ep && desc_ep->bmAttributes.xfer == TUSB_XFER_BULK &&
+            pipe->bPipeID >= MSC_UAS_PIPE_COMMAND && pipe->bPipeID <= MSC_UAS_PIPE_DATA_OUT)
+        {
+          uint8_t const idx = (uint8_t) (pipe->bPipeID - 1);
+          p_msc->uas_ep_desc[idx] = *desc_ep;
+          p_msc->uas_ep[idx] = desc_ep->bEndpointAddress;
+          found |= (uint8_t) TU_BIT(idx);
+          if (found == 0x0F) p_msc->uas_alt = uas_itf->bAlternateSetting;
+        }
+        desc_ep = NULL;
+      }
+      break;
+
+      default: break;
+    }
+
+    p_desc = tu_desc_next(p_desc);
+  }
+
+  p_msc->uas_avail = (found == 0x0F) &&
+                     (tu_edpt_packet_size(&p_msc->uas_ep_desc[UAS_EP_STATUS]) <= CFG_TUH_MSC_UAS_STATUS_BUFSIZE);
+}
+
+#endif
+
 //--------------------------------------------------------------------+
 // MSC Enumeration
 //--------------------------------------------------------------------+
@@ -390,8 +859,24 @@ static bool config_read_capacity_complete(uint8_t dev_addr, tuh_msc_complete_dat
 bool msch_open(uint8_t rhport, uint8_t dev_addr, tusb_desc_interface_t const *desc_itf, uint16_t max_len)
 {
   (void) rhport;
-  TU_VERIFY (MSC_SUBCLASS_SCSI == desc_itf->bInterfaceSubClass &&
-             MSC_PROTOCOL_BOT  == desc_itf->bInterfaceProtocol);
+  TU_VERIFY (MSC_SUBCLASS_SCSI == desc_itf->bInterfaceSubClass);
+
+#if CFG_TUH_MSC_UAS
+  {
+    msch_interface_t* p_msc = get_itf(dev_addr);
+    uas_parse(p_msc, desc_itf, max_len);
+
+    if (MSC_PROTOCOL_UAS == desc_itf->bInterfaceProtocol)
+    {
+      // UAS only interface, no Bulk-Only to fall back to
+      TU_VERIFY(p_msc->uas_avail && p_msc->uas_alt == desc_itf->bAlternateSetting);
+      p_msc->itf_num = desc_itf->bInterfaceNumber;
+      return true;
+    }
+  }
+#endif
+
+  TU_VERIFY (MSC_PROTOCOL_BOT == desc_itf->bInterfaceProtocol);
 
   // msc driver length is fixed
   uint16_t const drv_len = (uint16_t) (sizeof(tusb_desc_interface_t) + desc_itf->bNumEndpoints * sizeof(tusb_desc_endpoint_t));
@@ -405,6 +890,10 @@ bool msch_open(uint8_t rhport, uint8_t dev_addr, tusb_desc_interface_t const *de
     TU_ASSERT(TUSB_DESC_ENDPOINT == ep_desc->bDescriptorType && TUSB_XFER_BULK == ep_desc->bmAttributes.xfer);
     TU_ASSERT(tuh_edpt_open(dev_addr, ep_desc));
 
+#if CFG_TUH_MSC_UAS
+    p_msc->bot_ep_desc[tu_edpt_dir(ep_desc->bEndpointAddress)] = *ep_desc;
+#endif
+
     if ( tu_edpt_dir(ep_desc->bEndpointAddress) == TUSB_DIR_IN )
     {
       p_msc->ep_in = ep_desc->bEndpointAddress;
@@ -421,12 +910,116 @@ bool msch_open(uint8_t rhport, uint8_t dev_addr, tusb_desc_interface_t const *de
   return true;
 }
 
+static bool config_get_maxlun(uint8_t dev_addr, uint8_t itf_num);
+
+#if CFG_TUH_MSC_UAS
+static bool config_report_luns_complete(uint8_t dev_addr, tuh_msc_complete_data_t const* cb_data);
+
+// Open UAS endpoints (except ones shared with Bulk-Only alternate) and start SCSI enumeration
+static bool config_uas_start(uint8_t dev_addr)
+{
+  msch_interface_t* p_msc = get_itf(dev_addr);
+
+  for(uint8_t i=0; i<UAS_EP_COUNT; i++)
+  {
+    tusb_desc_endpoint_t const* desc_ep = &p_msc->uas_ep_desc[i];
+    uint8_t const ep_addr = desc_ep->bEndpointAddress;
+
+    if (ep_addr == p_msc->ep_in || ep_addr == p_msc->ep_out)
+    {
+      // endpoint shared with Bulk-Only alternate is already open, unless UAS alternate describes it differently
+      if (0 == memcmp(desc_ep, &p_msc->bot_ep_desc[tu_edpt_dir(ep_addr)], sizeof(tusb_desc_endpoint_t))) continue;
+
+      // re-open with new descriptor, HCD without close support reconfigures on open
+      (void) tuh_edpt_close(dev_addr, ep_addr);
+    }
+
+    TU_ASSERT(tuh_edpt_open(dev_addr, desc_ep));
+  }
+
+  p_msc->uas = true;
+
+  // UAS has no Get Max LUN request, ask logical unit 0 for the LUN list
+  TU_LOG_DRV("MSC UAS, SCSI Report LUNs\r\n");
+  msc_cbw_t cbw;
+  cbw_init(&cbw, 0);
+
+  cbw.total_bytes = sizeof(scsi_report_luns_resp_t);
+  cbw.dir         = TUSB_DIR_IN_MASK;
+  cbw.cmd_len     = sizeof(scsi_report_luns_t);
+
+  scsi_report_luns_t const cmd_report_luns =
+  {
+    .cmd_code     = SCSI_CMD_REPORT_LUNS,
+    .alloc_length = tu_htonl(sizeof(scsi_report_luns_resp_t))
+  };
+  memcpy(cbw.command, &cmd_report_luns, cbw.cmd_len);
+
+  TU_ASSERT(tuh_msc_scsi_command(dev_addr, &cbw, _msch_buffer, config_report_luns_complete, 0));
+  return true;
+}
+
+static bool config_report_luns_complete(uint8_t dev_addr, tuh_msc_complete_data_t const* cb_data)
+{
+  msch_interface_t* p_msc = get_itf(dev_addr);
+  scsi_report_luns_resp_t const* resp = (scsi_report_luns_resp_t const*) ((void const*) _msch_buffer);
+
+  // list length is the full list even if only the first entry fits in response. LUNs are expected to be
+  // single level 0..n-1 (as Get Max LUN), failure means LUN 0 only
+  uint32_t const count = (cb_data->csw->status == MSC_CSW_STATUS_PASSED) ? tu_ntohl(resp->list_length) / 8 : 0;
+  p_msc->max_lun = (uint8_t) tu_max32(1, tu_min32(count, CFG_TUH_MSC_MAXLUN));
+
+  TU_LOG_DRV("  Max LUN = %u\r\n", p_msc->max_lun);
+
+  // TODO multiple LUN support
+  TU_LOG_DRV("SCSI Test Unit Ready\r\n");
+  TU_ASSERT(tuh_msc_test_unit_ready(dev_addr, 0, config_test_unit_ready_complete, 0));
+  return true;
+}
+
+static void config_set_interface_complete(tuh_xfer_t* xfer)
+{
+  uint8_t const daddr = xfer->daddr;
+  msch_interface_t* p_msc = get_itf(daddr);
+
+  if (XFER_RESULT_SUCCESS == xfer->result)
+  {
+    config_uas_start(daddr);
+  }else
+  {
+    // fall back to Bulk-Only
+    TU_LOG_DRV("  Set UAS alternate failed, use Bulk-Only\r\n");
+    p_msc->uas_avail = false;
+    config_get_maxlun(daddr, p_msc->itf_num);
+  }
+}
+#endif
+
 bool msch_set_config(uint8_t dev_addr, uint8_t itf_num) {
   msch_interface_t* p_msc = get_itf(dev_addr);
   TU_ASSERT(p_msc->itf_num == itf_num);
 
   p_msc->configured = true;
 
+#if CFG_TUH_MSC_UAS
+  if (p_msc->uas_avail)
+  {
+    if (p_msc->ep_in == 0)
+    {
+      // UAS only interface, already selected
+      return config_uas_start(dev_addr);
+    }
+
+    TU_LOG_DRV("MSC Set UAS alternate %u\r\n", p_msc->uas_alt);
+    return tuh_interface_set(dev_addr, itf_num, p_msc->uas_alt, config_set_interface_complete, 0);
+  }
+#endif
+
+  return config_get_maxlun(dev_addr, itf_num);
+}
+
+static bool config_get_maxlun(uint8_t dev_addr, uint8_t itf_num)
+{
   //------------- Get Max Lun -------------//
   TU_LOG_DRV("MSC Get Max Lun\r\n");
   tusb_control_request_t const request = {
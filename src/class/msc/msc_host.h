@@ -41,6 +41,23 @@
 #define CFG_TUH_MSC_MAXLUN  4
 #endif
 
+// USB Attached SCSI (UAS): used when interface has an UAS alternate setting, Bulk-Only otherwise.
+// UAS allows multiple outstanding commands identified by tag
+#ifndef CFG_TUH_MSC_UAS
+#define CFG_TUH_MSC_UAS  0
+#endif
+
+// Maximum number of outstanding UAS commands
+#ifndef CFG_TUH_MSC_UAS_QUEUE_DEPTH
+#define CFG_TUH_MSC_UAS_QUEUE_DEPTH  4
+#endif
+
+// Status pipe buffer, status endpoint with larger max packet size falls back to Bulk-Only.
+// Status request is a multiple of max packet size so that Sense IU with long sense data does not babble
+#ifndef CFG_TUH_MSC_UAS_STATUS_BUFSIZE
+#define CFG_TUH_MSC_UAS_STATUS_BUFSIZE  (TUH_OPT_HIGH_SPEED ? 512 : 64)
+#endif
+
 typedef struct {
   msc_cbw_t const* cbw; // SCSI command
   msc_csw_t const* csw; // SCSI status
@@ -58,10 +75,14 @@ typedef bool (*tuh_msc_complete_cb_t)(uint8_t dev_addr, tuh_msc_complete_data_t
 // This function true after tuh_msc_mounted_cb() and false after tuh_msc_unmounted_cb()
 bool tuh_msc_mounted(uint8_t dev_addr);
 
-// Check if the interface is currently ready or busy transferring data
+// Check if the interface is currently ready or busy transferring data.
+// With UAS, true if there is room to queue another command
 bool tuh_msc_ready(uint8_t dev_addr);
 
-// Get Max Lun
+// Check if device is driven with USB Attached SCSI (UAS) instead of Bulk-Only
+bool tuh_msc_is_uas(uint8_t dev_addr);
+
+// Get Max Lun. With UAS this is number of LUNs in REPORT LUNS response, assuming single level LUN 0..n-1
 uint8_t tuh_msc_get_maxlun(uint8_t dev_addr);
 
 // Get number of block
@@ -71,8 +92,8 @@ uint32_t tuh_msc_get_block_count(uint8_t dev_addr, uint8_t lun);
 uint32_t tuh_msc_get_block_size(uint8_t dev_addr, uint8_t lun);
 
 // Perform a full SCSI command (cbw, data, csw) in non-blocking manner.
-// Complete callback is invoked when SCSI op is complete.
-// return true if success, false if there is already pending operation.
+// Complete callback is invoked when SCSI op is complete. With UAS, csw is built from Sense IU.
+// return true if success, false if there is already pending operation (or UAS queue is full).
 bool tuh_msc_scsi_command(uint8_t dev_addr, msc_cbw_t const* cbw, void* data, tuh_msc_complete_cb_t complete_cb, uintptr_t arg);
 
 // Perform SCSI Inquiry command
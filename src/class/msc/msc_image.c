@@ -0,0 +1,242 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#include "tusb_option.h"
+
+#if (CFG_TUD_ENABLED && CFG_TUD_MSC && CFG_TUD_MSC_IMAGE)
+
+#include "msc_image.h"
+
+//--------------------------------------------------------------------+
+// MACRO CONSTANT TYPEDEF
+//--------------------------------------------------------------------+
+
+typedef struct
+{
+  uint8_t const* image;   // NULL if entry is unused
+  uint32_t chunk;
+  uint32_t stamp;         // last use, least recent is evicted first
+  uint8_t  buf[CFG_TUD_MSC_IMAGE_CHUNK_SIZE];
+} msc_image_cache_t;
+
+static struct
+{
+  msc_image_cache_t entry[CFG_TUD_MSC_IMAGE_CACHE];
+  uint32_t stamp;
+} _cache;
+
+//--------------------------------------------------------------------+
+// Helper
+//--------------------------------------------------------------------+
+
+TU_ATTR_ALWAYS_INLINE static inline uint32_t chunk_offset(tud_msc_image_t const* img, uint32_t idx)
+{
+  return tu_le32toh(tu_unaligned_read32(img->data + sizeof(msc_image_header_t) + 4*idx));
+}
+
+// Decoded size of chunk, only the last one can be short
+static uint32_t chunk_size(tud_msc_image_t const* img, uint32_t idx)
+{
+  uint32_t const full  = (uint32_t) img->chunk_blocks * img->block_size;
+  uint32_t const total = img->block_count * img->block_size;
+  return tu_min32(full, total - idx * full);
+}
+
+// Read variable length field of LZ4 token, which continues while bytes are 255
+static bool lz4_length(uint8_t const** p_src, uint8_t const* src_end, uint32_t* len)
+{
+  uint8_t const* src = *p_src;
+  uint8_t b;
+  do
+  {
+    TU_VERIFY(src < src_end);
+    b = *src++;
+    *len += b;
+  } while ( b == 255 );
+
+  *p_src = src;
+  return true;
+}
+
+// Decode one LZ4 block, sequences of: token | literal length | literals | offset | match length
+static bool lz4_decode(uint8_t const* src, uint32_t src_len, uint8_t* dst, uint32_t dst_len)
+{
+  uint8_t const* const src_end   = src + src_len;
+  uint8_t* const       dst_start = dst;
+  uint8_t* const       dst_end   = dst + dst_len;
+
+  while ( src < src_end )
+  {
+    uint8_t const token = *src++;
+
+    uint32_t lit_len = token >> 4;
+    if ( lit_len == 15 ) TU_VERIFY(lz4_length(&src, src_end, &lit_len));
+    TU_VERIFY(lit_len <= (uint32_t) (src_end - src) && lit_len <= (uint32_t) (dst_end - dst));
+
+    memcpy(dst, src, lit_len);
+    src += lit_len;
+    dst += lit_len;
+
+    // last sequence has literals only
+    if ( src == src_end ) break;
+
+    TU_VERIFY(src_end - src >= 2);
+    uint32_t const match_offset = tu_u16(src[1], src[0]);
+    src += 2;
+    TU_VERIFY(match_offset && match_offset <= (uint32_t) (dst - dst_start));
+
+    uint32_t match_len = token & 0x0f;
+    if ( match_len == 15 ) TU_VERIFY(lz4_length(&src, src_end, &match_len));
+    match_len += 4;
+    TU_VERIFY(match_len <= (uint32_t) (dst_end - dst));
+
+    uint8_t const* match = dst - match_offset;
+    if ( match_offset >= match_len )
+    {
+      memcpy(dst, match, match_len);
+      dst += match_len;
+    }else
+    {
+      // overlapping match repeats the last match_offset bytes
+      while ( match_len-- ) *dst++ = *match++;
+    }
+  }
+
+  return dst == dst_end;
+}
+
+// Get decoded chunk, either straight from image if stored uncompressed, or through the cache
+static uint8_t const* chunk_get(tud_msc_image_t const* img, uint32_t idx)
+{
+  uint32_t const start    = chunk_offset(img, idx);
+  uint32_t const comp_len = chunk_offset(img, idx+1) - start;
+  uint32_t const size     = chunk_size(img, idx);
+
+  if ( comp_len == size ) return img->data + start;
+
+  msc_image_cache_t* victim = &_cache.entry[0];
+  for(uint8_t i=0; i<CFG_TUD_MSC_IMAGE_CACHE; i++)
+  {
+    msc_image_cache_t* entry = &_cache.entry[i];
+    if ( entry->image == img->data && entry->chunk == idx )
+    {
+      entry->stamp = ++_cache.stamp;
+      return entry->buf;
+    }
+
+    if ( entry->image == NULL || (victim->image && entry->stamp < victim->stamp) ) victim = entry;
+  }
+
+  victim->image = NULL;
+  TU_VERIFY(lz4_decode(img->data + start, comp_len, victim->buf, size), NULL);
+
+  victim->image = img->data;
+  victim->chunk = idx;
+  victim->stamp = ++_cache.stamp;
+
+  return victim->buf;
+}
+
+//--------------------------------------------------------------------+
+// Application API
+//--------------------------------------------------------------------+
+
+bool tud_msc_image_init(tud_msc_image_t* img, void const* image, uint32_t image_size)
+{
+  TU_VERIFY(image_size >= sizeof(msc_image_header_t));
+
+  msc_image_header_t hdr;
+  memcpy(&hdr, image, sizeof(hdr));
+
+  img->data         = (uint8_t const*) image;
+  img->block_size   = tu_le16toh(hdr.block_size);
+  img->chunk_blocks = tu_le16toh(hdr.chunk_blocks);
+  img->block_count  = tu_le32toh(hdr.block_count);
+  img->chunk_count  = tu_le32toh(hdr.chunk_count);
+
+  TU_VERIFY(tu_le32toh(hdr.signature) == MSC_IMAGE_SIGNATURE);
+  TU_VERIFY(img->block_size && img->chunk_blocks && img->block_count);
+  TU_VERIFY((uint32_t) img->chunk_blocks * img->block_size <= CFG_TUD_MSC_IMAGE_CHUNK_SIZE);
+  TU_VERIFY(img->block_count <= UINT32_MAX / img->block_size);
+
+  // counts are untrusted: bound them by image size before any arithmetic that could wrap
+  TU_VERIFY(img->chunk_count < (image_size - sizeof(msc_image_header_t)) / 4);
+  TU_VERIFY(img->chunk_count == img->block_count / img->chunk_blocks + (img->block_count % img->chunk_blocks ? 1 : 0));
+
+  // index must be within image, chunks must be in order
+  uint32_t const data_start = sizeof(msc_image_header_t) + 4*(img->chunk_count + 1);
+  TU_VERIFY(chunk_offset(img, 0) >= data_start);
+
+  for(uint32_t i=0; i<img->chunk_count; i++)
+  {
+    uint32_t const start = chunk_offset(img, i);
+    uint32_t const end   = chunk_offset(img, i+1);
+    TU_VERIFY(start <= end && end <= image_size && end - start <= chunk_size(img, i));
+  }
+
+  // drop cached chunks of a previous image at the same address
+  for(uint8_t i=0; i<CFG_TUD_MSC_IMAGE_CACHE; i++)
+  {
+    if ( _cache.entry[i].image == img->data ) _cache.entry[i].image = NULL;
+  }
+
+  return true;
+}
+
+int32_t tud_msc_image_read(tud_msc_image_t const* img, uint32_t lba, uint32_t offset, void* buffer, uint32_t bufsize)
+{
+  TU_VERIFY(lba < img->block_count, -1);
+
+  uint32_t const total = img->block_count * img->block_size;
+  uint32_t addr = lba * img->block_size + offset;
+  TU_VERIFY(addr < total, -1);
+
+  bufsize = tu_min32(bufsize, total - addr);
+
+  uint32_t const full = (uint32_t) img->chunk_blocks * img->block_size;
+  uint8_t* out = (uint8_t*) buffer;
+  uint32_t count = 0;
+
+  // request can span multiple chunks
+  while ( count < bufsize )
+  {
+    uint32_t const idx = addr / full;
+    uint32_t const pos = addr % full;
+
+    uint8_t const* chunk = chunk_get(img, idx);
+    TU_VERIFY(chunk, -1);
+
+    uint32_t const n = tu_min32(chunk_size(img, idx) - pos, bufsize - count);
+    memcpy(out + count, chunk + pos, n);
+
+    count += n;
+    addr  += n;
+  }
+
+  return (int32_t) count;
+}
+
+#endif
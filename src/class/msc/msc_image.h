@@ -0,0 +1,110 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#ifndef _TUSB_MSC_IMAGE_H_
+#define _TUSB_MSC_IMAGE_H_
+
+#include "common/tusb_common.h"
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+//--------------------------------------------------------------------+
+// Block compressed read-only disk image
+//
+// Image is split into chunks of chunk_blocks blocks, each compressed independently (LZ4 block format) so that
+// any block can be read by decoding only its chunk. A chunk whose compressed size equals its decoded size is
+// stored as is. Decoded chunks are kept in a small LRU cache shared by all images.
+//
+// Layout (little endian), see tools/mkmscimg.py
+//   msc_image_header_t
+//   uint32_t offset[chunk_count + 1]  : chunk i spans offset[i] to offset[i+1], relative to image start
+//   chunk data
+//
+// Typical usage in application callbacks
+//   capacity_cb : *block_count = tud_msc_image_block_count(&img); *block_size = tud_msc_image_block_size(&img);
+//   read10_cb   : return tud_msc_image_read(&img, lba, offset, buffer, bufsize);
+//   is_writable : return false;
+//--------------------------------------------------------------------+
+
+// Largest decoded chunk (chunk_blocks * block_size) supported, this is the size of each cache entry
+#ifndef CFG_TUD_MSC_IMAGE_CHUNK_SIZE
+#define CFG_TUD_MSC_IMAGE_CHUNK_SIZE  4096
+#endif
+
+// Number of decoded chunks cached
+#ifndef CFG_TUD_MSC_IMAGE_CACHE
+#define CFG_TUD_MSC_IMAGE_CACHE       2
+#endif
+
+#define MSC_IMAGE_SIGNATURE   0x495A5554 // "TUZI"
+
+typedef struct TU_ATTR_PACKED
+{
+  uint32_t signature;
+  uint16_t block_size;
+  uint16_t chunk_blocks;
+  uint32_t block_count;
+  uint32_t chunk_count;
+} msc_image_header_t;
+
+TU_VERIFY_STATIC(sizeof(msc_image_header_t) == 16, "size is not correct");
+
+typedef struct
+{
+  uint8_t const* data;
+  uint32_t block_count;
+  uint32_t chunk_count;
+  uint16_t block_size;
+  uint16_t chunk_blocks;
+} tud_msc_image_t;
+
+//--------------------------------------------------------------------+
+// Application API
+//--------------------------------------------------------------------+
+
+// Validate image header and index, return false if image is malformed or its chunks exceed CFG_TUD_MSC_IMAGE_CHUNK_SIZE
+bool tud_msc_image_init(tud_msc_image_t* img, void const* image, uint32_t image_size);
+
+// Read from image, same semantics as tud_msc_read10_cb(). Return number of bytes read or -1 on error
+int32_t tud_msc_image_read(tud_msc_image_t const* img, uint32_t lba, uint32_t offset, void* buffer, uint32_t bufsize);
+
+TU_ATTR_ALWAYS_INLINE static inline uint32_t tud_msc_image_block_count(tud_msc_image_t const* img)
+{
+  return img->block_count;
+}
+
+TU_ATTR_ALWAYS_INLINE static inline uint16_t tud_msc_image_block_size(tud_msc_image_t const* img)
+{
+  return img->block_size;
+}
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif /* _TUSB_MSC_IMAGE_H_ */
@@ -61,11 +61,13 @@ typedef struct
 #define CFG_TUD_NET_PACKET_PREFIX_LEN sizeof(rndis_data_packet_t)
 #define CFG_TUD_NET_PACKET_SUFFIX_LEN 0
 
-CFG_TUD_MEM_SECTION CFG_TUSB_MEM_ALIGN tu_static
-uint8_t received[CFG_TUD_NET_PACKET_PREFIX_LEN + CFG_TUD_NET_MTU + CFG_TUD_NET_PACKET_PREFIX_LEN];
+#define NETD_PACKET_SIZE  (CFG_TUD_NET_PACKET_PREFIX_LEN + CFG_TUD_NET_MTU + CFG_TUD_NET_PACKET_PREFIX_LEN)
 
-CFG_TUD_MEM_SECTION CFG_TUSB_MEM_ALIGN tu_static
-uint8_t transmitted[CFG_TUD_NET_PACKET_PREFIX_LEN + CFG_TUD_NET_MTU + CFG_TUD_NET_PACKET_PREFIX_LEN];
+CFG_TUD_MEM_SECTION CFG_TUD_MEM_ALIGN tu_static
+uint8_t received[TUD_EPBUF_SIZE(NETD_PACKET_SIZE)];
+
+CFG_TUD_MEM_SECTION CFG_TUD_MEM_ALIGN tu_static
+uint8_t transmitted[TUD_EPBUF_SIZE(NETD_PACKET_SIZE)];
 
 struct ecm_notify_struct
 {
@@ -111,7 +113,7 @@ tu_static bool can_xmit;
 
 void tud_network_recv_renew(void)
 {
-  usbd_edpt_xfer(0, _netd_itf.ep_out, received, sizeof(received));
+  usbd_edpt_xfer(0, _netd_itf.ep_out, received, NETD_PACKET_SIZE);
 }
 
 static void do_in_xfer(uint8_t *buf, uint16_t len)
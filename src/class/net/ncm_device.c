@@ -154,7 +154,7 @@ CFG_TUD_MEM_SECTION CFG_TUSB_MEM_ALIGN tu_static const ntb_parameters_t ntb_para
 
 CFG_TUD_MEM_SECTION CFG_TUSB_MEM_ALIGN tu_static transmit_ntb_t transmit_ntb[2];
 
-CFG_TUD_MEM_SECTION CFG_TUSB_MEM_ALIGN tu_static uint8_t receive_ntb[CFG_TUD_NCM_OUT_NTB_MAX_SIZE];
+CFG_TUD_MEM_SECTION CFG_TUD_MEM_ALIGN tu_static uint8_t receive_ntb[TUD_EPBUF_SIZE(CFG_TUD_NCM_OUT_NTB_MAX_SIZE)];
 
 tu_static ncm_interface_t ncm_interface;
 
@@ -236,7 +236,7 @@ void tud_network_recv_renew(void)
 {
   if (!ncm_interface.num_datagrams)
   {
-    usbd_edpt_xfer(0, ncm_interface.ep_out, receive_ntb, sizeof(receive_ntb));
+    usbd_edpt_xfer(0, ncm_interface.ep_out, receive_ntb, CFG_TUD_NCM_OUT_NTB_MAX_SIZE);
     return;
   }
 
@@ -0,0 +1,193 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#include "tusb_option.h"
+
+#if ( CFG_TUD_ENABLED && (CFG_TUD_ECM_RNDIS || CFG_TUD_NCM) )
+
+#include "device/usbd.h"
+#include "net_device.h"
+
+//--------------------------------------------------------------------+
+// MACRO CONSTANT TYPEDEF
+//--------------------------------------------------------------------+
+
+enum {
+  ETH_HDR_LEN       = 14,
+  ETH_TYPE_OFFSET   = 12,
+  ETH_TYPE_IPV4     = 0x0800,
+
+  IPV4_HDR_LEN_MIN  = 20,
+  IPV4_CSUM_OFFSET  = 10,
+
+  IP_PROTO_TCP      = 6,
+  IP_PROTO_UDP      = 17,
+  TCP_CSUM_OFFSET   = 16,
+  UDP_CSUM_OFFSET   = 6,
+};
+
+typedef struct {
+  uint8_t* ip;
+  uint16_t hdr_len;    // IPv4 header length
+  uint16_t total_len;  // IPv4 packet length, without Ethernet padding
+  uint16_t l4_csum;    // offset of TCP/UDP checksum from ip, 0 if none or fragment
+  uint32_t pseudo;     // pseudo header sum
+} ipv4_info_t;
+
+//--------------------------------------------------------------------+
+// Helper
+//--------------------------------------------------------------------+
+
+// Ones' complement arithmetic on host order 16-bit sums
+TU_ATTR_ALWAYS_INLINE static inline uint16_t csum_add(uint32_t a, uint32_t b)
+{
+  return tu_csum_fold(a + b);
+}
+
+TU_ATTR_ALWAYS_INLINE static inline uint16_t csum_sub(uint32_t a, uint16_t b)
+{
+  return tu_csum_fold(a + (uint16_t) ~b);
+}
+
+// Sum of big endian 16-bit words, odd byte is zero padded. Bytes starting at an odd offset of the
+// packet swap their position within a word.
+static uint16_t csum_be(uint8_t const* p, uint16_t len, bool odd)
+{
+  uint32_t sum = 0;
+  for(uint16_t i=0; i+1 < len; i += 2) sum += tu_u16(p[i], p[i+1]);
+  if (len & 1) sum += tu_u16(p[len-1], 0);
+
+  uint16_t const folded = tu_csum_fold(sum);
+  return odd ? TU_BSWAP16(folded) : folded;
+}
+
+static bool ipv4_parse(uint8_t const* frame, uint16_t size, ipv4_info_t* info)
+{
+  TU_VERIFY(size >= ETH_HDR_LEN + IPV4_HDR_LEN_MIN);
+  TU_VERIFY(tu_u16(frame[ETH_TYPE_OFFSET], frame[ETH_TYPE_OFFSET+1]) == ETH_TYPE_IPV4);
+
+  uint8_t* ip = (uint8_t*) (uintptr_t) (frame + ETH_HDR_LEN);
+  TU_VERIFY((ip[0] >> 4) == 4);
+
+  info->ip        = ip;
+  info->hdr_len   = (uint16_t) ((ip[0] & 0x0f) * 4);
+  info->total_len = tu_u16(ip[2], ip[3]);
+  info->l4_csum   = 0;
+  info->pseudo    = 0;
+
+  TU_VERIFY(info->hdr_len >= IPV4_HDR_LEN_MIN && info->hdr_len <= info->total_len &&
+            info->total_len <= size - ETH_HDR_LEN);
+
+  uint8_t const proto = ip[9];
+  bool const fragment = (tu_u16(ip[6], ip[7]) & 0x3fff) != 0; // MF flag or offset
+  if ( !fragment && (proto == IP_PROTO_TCP || proto == IP_PROTO_UDP) )
+  {
+    info->l4_csum = (uint16_t) (info->hdr_len + (proto == IP_PROTO_TCP ? TCP_CSUM_OFFSET : UDP_CSUM_OFFSET));
+    TU_VERIFY(info->l4_csum + 2 <= info->total_len);
+
+    // source + destination address, protocol, TCP/UDP length
+    uint16_t const l4_len = (uint16_t) (info->total_len - info->hdr_len);
+    info->pseudo = csum_be(ip + 12, 8, false) + (uint32_t) proto + l4_len;
+  }
+
+  return true;
+}
+
+// Sum of TCP/UDP segment: packet sum without Ethernet padding and IPv4 header
+static uint16_t ipv4_l4_sum(uint16_t size, uint16_t csum, ipv4_info_t const* info, uint16_t hdr_sum)
+{
+  uint16_t const pad_len = (uint16_t) (size - ETH_HDR_LEN - info->total_len);
+  if ( pad_len ) csum = csum_sub(csum, csum_be(info->ip + info->total_len, pad_len, info->total_len & 1));
+
+  return csum_sub(csum, hdr_sum);
+}
+
+//--------------------------------------------------------------------+
+// Checksum Offload API
+//--------------------------------------------------------------------+
+
+uint16_t tud_network_csum_copy(void* dst, void const* src, uint16_t size)
+{
+  // dst can be src to only compute the sum
+  if ( dst != src ) memcpy(dst, src, tu_min16(size, ETH_HDR_LEN));
+  if ( size <= ETH_HDR_LEN ) return 0;
+
+  uint32_t const sum = tu_csum_copy((uint8_t*) dst + ETH_HDR_LEN, (uint8_t const*) src + ETH_HDR_LEN, size - ETH_HDR_LEN, 0);
+
+  return tu_ntohs(tu_csum_fold(sum));
+}
+
+bool tud_network_csum_verify(uint8_t const* frame, uint16_t size, uint16_t csum)
+{
+  ipv4_info_t info;
+  if ( !ipv4_parse(frame, size, &info) )
+  {
+    // not IPv4, or a malformed one that is left to the IP stack
+    return true;
+  }
+
+  uint16_t const hdr_sum = csum_be(info.ip, info.hdr_len, false);
+  TU_VERIFY(hdr_sum == 0xffff);
+
+  // TCP/UDP checksum of a fragment covers the reassembled datagram, only IPv4 header is verified
+  if ( !info.l4_csum ) return true;
+  uint8_t const proto = info.ip[9];
+
+  // UDP checksum is optional
+  if ( proto == IP_PROTO_UDP && 0 == tu_u16(info.ip[info.l4_csum], info.ip[info.l4_csum+1]) ) return true;
+
+  uint16_t const l4_sum = ipv4_l4_sum(size, csum, &info, hdr_sum);
+  return csum_add(l4_sum, info.pseudo) == 0xffff;
+}
+
+void tud_network_csum_fill(uint8_t* frame, uint16_t size, uint16_t csum)
+{
+  ipv4_info_t info;
+  if ( !ipv4_parse(frame, size, &info) ) return;
+
+  uint8_t* ip = info.ip;
+  uint16_t const hdr_sum = csum_be(ip, info.hdr_len, false);
+
+  if ( info.l4_csum )
+  {
+    // remove whatever checksum the stack left in the field
+    uint16_t const old = tu_u16(ip[info.l4_csum], ip[info.l4_csum+1]);
+    uint16_t const l4_sum = csum_sub(ipv4_l4_sum(size, csum, &info, hdr_sum), old);
+
+    uint16_t value = (uint16_t) ~csum_add(l4_sum, info.pseudo);
+    if ( ip[9] == IP_PROTO_UDP && value == 0 ) value = 0xffff; // zero means no checksum for UDP
+
+    ip[info.l4_csum]   = tu_u16_high(value);
+    ip[info.l4_csum+1] = tu_u16_low(value);
+  }
+
+  uint16_t const old = tu_u16(ip[IPV4_CSUM_OFFSET], ip[IPV4_CSUM_OFFSET+1]);
+  uint16_t const value = (uint16_t) ~csum_sub(hdr_sum, old);
+  ip[IPV4_CSUM_OFFSET]   = tu_u16_high(value);
+  ip[IPV4_CSUM_OFFSET+1] = tu_u16_low(value);
+}
+
+#endif
@@ -77,6 +77,21 @@ bool tud_network_can_xmit(uint16_t size);
 // if network_can_xmit() returns true, network_xmit() can be called once
 void tud_network_xmit(void *ref, uint16_t arg);
 
+//------------- Checksum Offload -------------//
+// Fused copy + checksum for use in tud_network_recv_cb() and tud_network_xmit_cb(), so that the IP stack
+// can skip its own pass over the frame (e.g lwIP with CHECKSUM_CHECK_* / CHECKSUM_GEN_* disabled)
+
+// Copy an Ethernet frame, return the ones' complement sum (host order) of everything after the Ethernet header.
+// dst can be the same as src to only compute the sum
+uint16_t tud_network_csum_copy(void* dst, void const* src, uint16_t size);
+
+// Verify IPv4 header and TCP/UDP checksum of a frame using the sum returned by tud_network_csum_copy().
+// Non-IPv4 frames and other protocols are passed (true), for IPv4 fragments only the IPv4 header is verified
+bool tud_network_csum_verify(uint8_t const* frame, uint16_t size, uint16_t csum);
+
+// Fill in IPv4 header and TCP/UDP checksum of a frame using the sum returned by tud_network_csum_copy()
+void tud_network_csum_fill(uint8_t* frame, uint16_t size, uint16_t csum);
+
 //--------------------------------------------------------------------+
 // Application Callbacks (WEAK is optional)
 //--------------------------------------------------------------------+
@@ -126,10 +126,10 @@ typedef struct
   uint8_t ep_int_in;
   // IN buffer is only used for first packet, not the remainder
   // in order to deal with prepending header
-  CFG_TUSB_MEM_ALIGN uint8_t ep_bulk_in_buf[USBTMCD_BUFFER_SIZE];
+  TUD_EPBUF_DEF(ep_bulk_in_buf, USBTMCD_BUFFER_SIZE);
   uint32_t ep_bulk_in_wMaxPacketSize;
   // OUT buffer receives one packet at a time
-  CFG_TUSB_MEM_ALIGN uint8_t ep_bulk_out_buf[USBTMCD_BUFFER_SIZE];
+  TUD_EPBUF_DEF(ep_bulk_out_buf, USBTMCD_BUFFER_SIZE);
   uint32_t ep_bulk_out_wMaxPacketSize;
 
   uint32_t transfer_size_remaining; // also used for requested length for bulk IN.
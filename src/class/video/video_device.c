@@ -107,6 +107,10 @@ typedef struct TU_ATTR_PACKED {
     uint16_t end;    /* Offset of the end of video streaming interface descriptor */
     uint16_t cur;    /* Offset of the current settings */
     uint16_t ep[2];  /* Offset of endpoint descriptors. 0: streaming, 1: still capture */
+    uint16_t fmt[CFG_TUD_VIDEO_STREAMING_FORMAT_MAX];     /* Offset of format descriptors by bFormatIndex-1, 0: not indexed */
+    uint8_t  fmt_frm[CFG_TUD_VIDEO_STREAMING_FORMAT_MAX]; /* Position of the first frame of each format in frm[] */
+    uint8_t  fmt_nfrm[CFG_TUD_VIDEO_STREAMING_FORMAT_MAX];/* Number of indexed frames of each format */
+    uint16_t frm[CFG_TUD_VIDEO_STREAMING_FRAME_MAX];      /* Offset of frame descriptors grouped by format */
   } desc;
   uint8_t *buffer;   /* frame buffer. assume linear buffer. no support for stride access */
   uint32_t bufsize;  /* frame buffer size */
@@ -115,7 +119,7 @@ typedef struct TU_ATTR_PACKED {
   uint8_t  error_code;/* error code */
   uint8_t  state;    /* 0:probing 1:committed 2:streaming */
   /*------------- From this point, data is not cleared by bus reset -------------*/
-  CFG_TUSB_MEM_ALIGN uint8_t ep_buf[CFG_TUD_VIDEO_STREAMING_EP_BUFSIZE]; /* EP transfer buffer for streaming */
+  TUD_EPBUF_DEF(ep_buf, CFG_TUD_VIDEO_STREAMING_EP_BUFSIZE); /* EP transfer buffer for streaming */
 } videod_streaming_interface_t;
 
 /* video control interface */
@@ -140,6 +144,11 @@ typedef struct TU_ATTR_PACKED {
 CFG_TUD_MEM_SECTION tu_static videod_interface_t _videod_itf[CFG_TUD_VIDEO];
 CFG_TUD_MEM_SECTION tu_static videod_streaming_interface_t _videod_streaming_itf[CFG_TUD_VIDEO_STREAMING];
 
+#if CFG_TUD_XFER_TIMESTAMP
+/* frame queued until fully transmitted, kept out of the packed streaming interface */
+tu_static usbd_stream_ts_t _videod_stm_ts[CFG_TUD_VIDEO_STREAMING];
+#endif
+
 tu_static uint8_t const _cap_get     = 0x1u; /* support for GET */
 tu_static uint8_t const _cap_get_set = 0x3u; /* support for GET and SET */
 
@@ -329,7 +338,7 @@ static inline void const *_find_desc_format(void const *beg, void const *end, ui
     if ((fmt == VIDEO_CS_ITF_VS_FORMAT_UNCOMPRESSED ||
          fmt == VIDEO_CS_ITF_VS_FORMAT_MJPEG ||
          fmt == VIDEO_CS_ITF_VS_FORMAT_DV ||
-         fmt == VIDEO_CS_ITF_VS_FRAME_FRAME_BASED) &&
+         fmt == VIDEO_CS_ITF_VS_FORMAT_FRAME_BASED) &&
         fmtnum == p[3]) {
       return cur;
     }
@@ -355,6 +364,92 @@ static inline void const *_find_desc_frame(void const *beg, void const *end, uin
   return end;
 }
 
+/** Index format and frame descriptors of the streaming interface at open time,
+ *  so that probe/commit requests don't need to walk the descriptors.
+ *  Descriptors not fitting into the tables are still found by _find_desc_format/_find_desc_frame.
+ *
+ * @param[in,out] stm      Streaming interface context. */
+static void _index_vs_formats(videod_streaming_interface_t *stm)
+{
+  uint8_t const *desc = _videod_itf[stm->index_vc].beg;
+  tusb_desc_vs_itf_t const *vs = (tusb_desc_vs_itf_t const *)(desc + stm->desc.beg);
+  void const *end = _end_of_streaming_descriptor(vs);
+  uint_fast8_t nfrm = 0;
+  uint_fast8_t fmt_idx = CFG_TUD_VIDEO_STREAMING_FORMAT_MAX; /* current format, invalid if not indexed */
+
+  for (void const *cur = tu_desc_next(vs); cur < end; cur = tu_desc_next(cur)) {
+    if (TUSB_DESC_CS_INTERFACE != tu_desc_type(cur)) continue;
+    uint8_t const *p = (uint8_t const *)cur;
+    uint_fast8_t subtype = p[2];
+    uint_fast8_t index   = p[3];
+    uint16_t ofs = (uint16_t) (p - desc);
+
+    switch (subtype) {
+      case VIDEO_CS_ITF_VS_FORMAT_UNCOMPRESSED:
+      case VIDEO_CS_ITF_VS_FORMAT_MJPEG:
+      case VIDEO_CS_ITF_VS_FORMAT_DV:
+      case VIDEO_CS_ITF_VS_FORMAT_FRAME_BASED:
+        fmt_idx = CFG_TUD_VIDEO_STREAMING_FORMAT_MAX;
+        if (index && index <= CFG_TUD_VIDEO_STREAMING_FORMAT_MAX) {
+          fmt_idx = index - 1;
+          stm->desc.fmt[fmt_idx]      = ofs;
+          stm->desc.fmt_frm[fmt_idx]  = (uint8_t) nfrm;
+          stm->desc.fmt_nfrm[fmt_idx] = 0;
+        }
+        break;
+
+      case VIDEO_CS_ITF_VS_FRAME_UNCOMPRESSED:
+      case VIDEO_CS_ITF_VS_FRAME_MJPEG:
+      case VIDEO_CS_ITF_VS_FRAME_FRAME_BASED:
+        /* frames are indexed as long as they are in bFrameIndex order */
+        if (fmt_idx < CFG_TUD_VIDEO_STREAMING_FORMAT_MAX && nfrm < CFG_TUD_VIDEO_STREAMING_FRAME_MAX &&
+            index == stm->desc.fmt_nfrm[fmt_idx] + 1 &&
+            nfrm == stm->desc.fmt_frm[fmt_idx] + stm->desc.fmt_nfrm[fmt_idx]) {
+          stm->desc.frm[nfrm++] = ofs;
+          stm->desc.fmt_nfrm[fmt_idx]++;
+        }
+        break;
+
+      default: break;
+    }
+  }
+}
+
+/** Get the format descriptor with the specified format number.
+ *
+ * @return The pointer for format descriptor.
+ * @retval NULL   did not found format descriptor */
+static tusb_desc_cs_video_fmt_t const* _get_desc_fmt(videod_streaming_interface_t const *stm, uint_fast8_t fmtnum)
+{
+  uint8_t const *desc = _videod_itf[stm->index_vc].beg;
+  if (fmtnum && fmtnum <= CFG_TUD_VIDEO_STREAMING_FORMAT_MAX && stm->desc.fmt[fmtnum - 1]) {
+    return (tusb_desc_cs_video_fmt_t const *)(desc + stm->desc.fmt[fmtnum - 1]);
+  }
+  tusb_desc_vs_itf_t const *vs = (tusb_desc_vs_itf_t const *)(desc + stm->desc.beg);
+  void const *end = _end_of_streaming_descriptor(vs);
+  void const *fmt = _find_desc_format(tu_desc_next(vs), end, fmtnum);
+  return (fmt < end) ? (tusb_desc_cs_video_fmt_t const *)fmt : NULL;
+}
+
+/** Get the frame descriptor with the specified frame number of the specified format.
+ *
+ * @return The pointer for frame descriptor.
+ * @retval NULL   did not found frame descriptor */
+static tusb_desc_cs_video_frm_t const* _get_desc_frm(videod_streaming_interface_t const *stm, uint_fast8_t fmtnum, uint_fast8_t frmnum)
+{
+  uint8_t const *desc = _videod_itf[stm->index_vc].beg;
+  if (fmtnum && fmtnum <= CFG_TUD_VIDEO_STREAMING_FORMAT_MAX && stm->desc.fmt[fmtnum - 1] &&
+      frmnum && frmnum <= stm->desc.fmt_nfrm[fmtnum - 1]) {
+    return (tusb_desc_cs_video_frm_t const *)(desc + stm->desc.frm[stm->desc.fmt_frm[fmtnum - 1] + frmnum - 1]);
+  }
+  tusb_desc_cs_video_fmt_t const *fmt = _get_desc_fmt(stm, fmtnum);
+  if (!fmt) return NULL;
+  tusb_desc_vs_itf_t const *vs = (tusb_desc_vs_itf_t const *)(desc + stm->desc.beg);
+  void const *end = _end_of_streaming_descriptor(vs);
+  void const *frm = _find_desc_frame(tu_desc_next(fmt), end, frmnum);
+  return (frm < end) ? (tusb_desc_cs_video_frm_t const *)frm : NULL;
+}
+
 /** Set uniquely determined values to variables that have not been set
  *
  * @param[in,out] param       Target */
@@ -383,9 +478,8 @@ static bool _update_streaming_parameters(videod_streaming_interface_t const *stm
   param->bUsage           = 0;
   param->bBitDepthLuma    = 8;
 
-  void const *end = _end_of_streaming_descriptor(vs);
-  tusb_desc_cs_video_fmt_t const *fmt = _find_desc_format(tu_desc_next(vs), end, fmtnum);
-  TU_ASSERT(fmt != end);
+  tusb_desc_cs_video_fmt_t const *fmt = _get_desc_fmt(stm, fmtnum);
+  TU_ASSERT(fmt);
 
   switch (fmt->bDescriptorSubType) {
     case VIDEO_CS_ITF_VS_FORMAT_UNCOMPRESSED:
@@ -403,8 +497,8 @@ static bool _update_streaming_parameters(videod_streaming_interface_t const *stm
     frmnum = 1;
     param->bFrameIndex = 1;
   }
-  tusb_desc_cs_video_frm_t const *frm = _find_desc_frame(tu_desc_next(fmt), end, frmnum);
-  TU_ASSERT(frm != end);
+  tusb_desc_cs_video_frm_t const *frm = _get_desc_frm(stm, fmtnum, frmnum);
+  TU_ASSERT(frm);
 
   /* Set the parameters determined by the frame  */
   uint_fast32_t frame_size = param->dwMaxVideoFrameSize;
@@ -479,10 +573,9 @@ static bool _negotiate_streaming_parameters(videod_streaming_interface_t const *
 
   uint_fast8_t frmnum = param->bFrameIndex;
   if (!frmnum) {
-    tusb_desc_vs_itf_t const *vs = _get_desc_vs(stm);
-    TU_ASSERT(vs);
-    void const *end = _end_of_streaming_descriptor(vs);
-    tusb_desc_cs_video_fmt_t const *fmt = _find_desc_format(tu_desc_next(vs), end, fmtnum);
+    TU_ASSERT(_get_desc_vs(stm));
+    tusb_desc_cs_video_fmt_t const *fmt = _get_desc_fmt(stm, fmtnum);
+    TU_ASSERT(fmt);
     switch (request) {
       case VIDEO_REQUEST_GET_MAX:
         frmnum = fmt->bNumFrameDescriptors;
@@ -505,7 +598,8 @@ static bool _negotiate_streaming_parameters(videod_streaming_interface_t const *
     }
     param->bFrameIndex = (uint8_t)frmnum;
     /* Set the parameters determined by the frame */
-    tusb_desc_cs_video_frm_t const *frm = _find_desc_frame(tu_desc_next(fmt), end, frmnum);
+    tusb_desc_cs_video_frm_t const *frm = _get_desc_frm(stm, fmtnum, frmnum);
+    TU_ASSERT(frm);
     uint_fast32_t frame_size;
     switch (fmt->bDescriptorSubType) {
       case VIDEO_CS_ITF_VS_FORMAT_UNCOMPRESSED:
@@ -521,11 +615,9 @@ static bool _negotiate_streaming_parameters(videod_streaming_interface_t const *
   }
 
   if (!param->dwFrameInterval) {
-    tusb_desc_vs_itf_t const *vs = _get_desc_vs(stm);
-    TU_ASSERT(vs);
-    void const *end = _end_of_streaming_descriptor(vs);
-    tusb_desc_cs_video_fmt_t const *fmt = _find_desc_format(tu_desc_next(vs), end, fmtnum);
-    tusb_desc_cs_video_frm_t const *frm = _find_desc_frame(tu_desc_next(fmt), end, frmnum);
+    TU_ASSERT(_get_desc_vs(stm));
+    tusb_desc_cs_video_frm_t const *frm = _get_desc_frm(stm, fmtnum, frmnum);
+    TU_ASSERT(frm);
 
     uint_fast32_t interval, interval_ms;
     switch (request) {
@@ -707,8 +799,8 @@ static bool _open_vs_itf(uint8_t rhport, videod_streaming_interface_t *stm, uint
     uint_fast32_t max_size = stm->max_payload_transfer_size;
     if (altnum) {
       if ((TUSB_XFER_ISOCHRONOUS == ep->bmAttributes.xfer) &&
-          (tu_edpt_packet_size(ep) < max_size)) {
-        /* FS must be less than or equal to max packet size */
+          (tu_edpt_bytes_per_interval(ep) < max_size)) {
+        /* Payload must fit into packet size x transactions per (micro)frame */
         return false;
       }
     } else {
@@ -1016,6 +1108,9 @@ static int handle_video_stm_cs_req(uint8_t rhport, uint8_t stage,
               tusb_video_payload_header_t *hdr = (tusb_video_payload_header_t*)self->ep_buf;
               hdr->bHeaderLength = sizeof(*hdr);
               hdr->bmHeaderInfo  = 0;
+#if CFG_TUD_XFER_TIMESTAMP
+              tu_varclr(&_videod_stm_ts[self - _videod_streaming_itf]);
+#endif
             }
           }
           return VIDEO_ERROR_NONE;
@@ -1104,7 +1199,7 @@ bool tud_video_n_streaming(uint_fast8_t ctl_idx, uint_fast8_t stm_idx)
   return true;
 }
 
-bool tud_video_n_frame_xfer(uint_fast8_t ctl_idx, uint_fast8_t stm_idx, void *buffer, size_t bufsize)
+static bool _frame_xfer(uint_fast8_t ctl_idx, uint_fast8_t stm_idx, void *buffer, size_t bufsize, uint32_t const *pts)
 {
   TU_ASSERT(ctl_idx < CFG_TUD_VIDEO);
   TU_ASSERT(stm_idx < CFG_TUD_VIDEO_STREAMING);
@@ -1129,14 +1224,48 @@ bool tud_video_n_frame_xfer(uint_fast8_t ctl_idx, uint_fast8_t stm_idx, void *bu
   tusb_video_payload_header_t *hdr = (tusb_video_payload_header_t*)stm->ep_buf;
   hdr->FrameID   ^= 1;
   hdr->EndOfFrame = 0;
+  /* PTS is repeated in every payload of the frame */
+  if (pts) {
+    hdr->bHeaderLength    = sizeof(*hdr) + 4;
+    hdr->PresentationTime = 1;
+    tu_unaligned_write32(&stm->ep_buf[sizeof(*hdr)], *pts);
+  } else {
+    hdr->bHeaderLength    = sizeof(*hdr);
+    hdr->PresentationTime = 0;
+  }
   /* update the packet data */
   stm->buffer     = (uint8_t*)buffer;
   stm->bufsize    = bufsize;
+#if CFG_TUD_XFER_TIMESTAMP
+  usbd_stream_ts_mark(&_videod_stm_ts[stm - _videod_streaming_itf], (uint32_t) bufsize, tud_sof_clock());
+#endif
   uint_fast16_t pkt_len = _prepare_in_payload(stm);
   TU_ASSERT( usbd_edpt_xfer(0, ep_addr, stm->ep_buf, (uint16_t) pkt_len), 0);
   return true;
 }
 
+bool tud_video_n_frame_xfer(uint_fast8_t ctl_idx, uint_fast8_t stm_idx, void *buffer, size_t bufsize)
+{
+  return _frame_xfer(ctl_idx, stm_idx, buffer, bufsize, NULL);
+}
+
+bool tud_video_n_frame_xfer_pts(uint_fast8_t ctl_idx, uint_fast8_t stm_idx, void *buffer, size_t bufsize, uint32_t pts)
+{
+  return _frame_xfer(ctl_idx, stm_idx, buffer, bufsize, &pts);
+}
+
+#if CFG_TUD_XFER_TIMESTAMP
+bool tud_video_n_latency(uint_fast8_t ctl_idx, uint_fast8_t stm_idx, tud_latency_stat_t *stat, bool clear)
+{
+  TU_ASSERT(ctl_idx < CFG_TUD_VIDEO);
+  TU_ASSERT(stm_idx < CFG_TUD_VIDEO_STREAMING);
+  videod_streaming_interface_t *stm = _get_instance_streaming(ctl_idx, stm_idx);
+  if (!stm) return false;
+  usbd_stream_ts_stat(&_videod_stm_ts[stm - _videod_streaming_itf], stat, clear);
+  return true;
+}
+#endif
+
 //--------------------------------------------------------------------+
 // USBD Driver API
 //--------------------------------------------------------------------+
@@ -1150,6 +1279,9 @@ void videod_init(void)
     videod_streaming_interface_t *stm = &_videod_streaming_itf[i];
     tu_memclr(stm, ITF_STM_MEM_RESET_SIZE);
   }
+#if CFG_TUD_XFER_TIMESTAMP
+  tu_varclr(&_videod_stm_ts);
+#endif
 }
 
 void videod_reset(uint8_t rhport)
@@ -1163,6 +1295,9 @@ void videod_reset(uint8_t rhport)
     videod_streaming_interface_t *stm = &_videod_streaming_itf[i];
     tu_memclr(stm, ITF_STM_MEM_RESET_SIZE);
   }
+#if CFG_TUD_XFER_TIMESTAMP
+  tu_varclr(&_videod_stm_ts);
+#endif
 }
 
 uint16_t videod_open(uint8_t rhport, tusb_desc_interface_t const * itf_desc, uint16_t max_len)
@@ -1208,6 +1343,7 @@ uint16_t videod_open(uint8_t rhport, tusb_desc_interface_t const * itf_desc, uin
     cur = _next_desc_itf(cur, end);
     stm->desc.end = (uint16_t) ((uintptr_t)cur - (uintptr_t)itf_desc);
     stm->state = VS_STATE_PROBING;
+    _index_vs_formats(stm);
     if (0 == stm_idx && 1 == bInCollection) {
       /* If there is only one streaming interface and no alternate settings,
        * host may not issue set_interface so open the streaming interface here. */
@@ -1280,6 +1416,19 @@ bool videod_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint3
   }
 
   TU_ASSERT(itf < CFG_TUD_VIDEO_STREAMING);
+#if CFG_TUD_XFER_TIMESTAMP
+  {
+    /* stamp the frame data of the completed payload, header excluded */
+    uint_fast16_t const hdr_len = stm->ep_buf[0];
+    tud_stream_stamp_t stamp;
+    stamp.sof    = usbd_edpt_xfer_sof(rhport, ep_addr);
+    stamp.len    = xferred_bytes > hdr_len ? xferred_bytes - hdr_len : 0;
+    stamp.offset = usbd_stream_ts_consume(&_videod_stm_ts[itf], stamp.len, stamp.sof);
+    if (tud_video_stamp_cb) {
+      tud_video_stamp_cb(stm->index_vc, stm->index_vs, &stamp);
+    }
+  }
+#endif
   if (stm->offset < stm->bufsize) {
     /* Claim the endpoint */
     TU_VERIFY( usbd_edpt_claim(rhport, ep_addr), 0);
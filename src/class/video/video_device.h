@@ -35,6 +35,20 @@
 extern "C" {
 #endif
 
+//--------------------------------------------------------------------+
+// Class Driver Configuration
+//--------------------------------------------------------------------+
+
+// Number of format and frame descriptors per streaming interface indexed when the interface is opened.
+// Probe/commit lookups beyond these are done by walking the descriptors.
+#ifndef CFG_TUD_VIDEO_STREAMING_FORMAT_MAX
+#define CFG_TUD_VIDEO_STREAMING_FORMAT_MAX  4
+#endif
+
+#ifndef CFG_TUD_VIDEO_STREAMING_FRAME_MAX
+#define CFG_TUD_VIDEO_STREAMING_FRAME_MAX   8
+#endif
+
 //--------------------------------------------------------------------+
 // Application API (Multiple Ports)
 // CFG_TUD_VIDEO > 1
@@ -54,6 +68,25 @@ bool tud_video_n_streaming(uint_fast8_t ctl_idx, uint_fast8_t stm_idx);
  * @param[in] bufsize    Byte size of the frame buffer */
 bool tud_video_n_frame_xfer(uint_fast8_t ctl_idx, uint_fast8_t stm_idx, void *buffer, size_t bufsize);
 
+/** Transfer a frame with presentation time stamp in the payload headers
+ *
+ * @param[in] ctl_idx    Destination control interface index
+ * @param[in] stm_idx    Destination streaming interface index
+ * @param[in] buffer     Frame buffer. The caller must not use this buffer until the operation is completed.
+ * @param[in] bufsize    Byte size of the frame buffer
+ * @param[in] pts        Source clock time in units of dwClockFrequency when the frame was captured */
+bool tud_video_n_frame_xfer_pts(uint_fast8_t ctl_idx, uint_fast8_t stm_idx, void *buffer, size_t bufsize, uint32_t pts);
+
+#if CFG_TUD_XFER_TIMESTAMP
+/** Get latency in SOF frames from tud_video_n_frame_xfer() until the frame is fully transmitted
+ *
+ * @param[in] ctl_idx    Destination control interface index
+ * @param[in] stm_idx    Destination streaming interface index
+ * @param[out] stat      Latency statistics, may be NULL
+ * @param[in] clear      Reset statistics after reading */
+bool tud_video_n_latency(uint_fast8_t ctl_idx, uint_fast8_t stm_idx, tud_latency_stat_t *stat, bool clear);
+#endif
+
 /*------------- Optional callbacks -------------*/
 /** Invoked when compeletion of a frame transfer
  *
@@ -61,6 +94,15 @@ bool tud_video_n_frame_xfer(uint_fast8_t ctl_idx, uint_fast8_t stm_idx, void *bu
  * @param[in] stm_idx    Destination streaming interface index */
 TU_ATTR_WEAK void tud_video_frame_xfer_complete_cb(uint_fast8_t ctl_idx, uint_fast8_t stm_idx);
 
+#if CFG_TUD_XFER_TIMESTAMP
+/** Invoked when a payload completed on the wire
+ *
+ * @param[in] ctl_idx    Destination control interface index
+ * @param[in] stm_idx    Destination streaming interface index
+ * @param[in] stamp      Byte offset and length within the frame stream and SOF frame number */
+TU_ATTR_WEAK void tud_video_stamp_cb(uint_fast8_t ctl_idx, uint_fast8_t stm_idx, tud_stream_stamp_t const *stamp);
+#endif
+
 //--------------------------------------------------------------------+
 // Application Callback API (weak is optional)
 //--------------------------------------------------------------------+
@@ -0,0 +1,120 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#ifndef _TUSB_ZERO_H_
+#define _TUSB_ZERO_H_
+
+#include "common/tusb_common.h"
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+//--------------------------------------------------------------------+
+// Source/sink and loopback test function, modeled after Linux gadget zero
+//
+// Source/sink interface: IN endpoint continuously sends data, OUT endpoint continuously receives
+// and verifies it. Alternate settings select the transfer type, typically 0: bulk, 1: interrupt,
+// 2: isochronous, each with one IN and one OUT endpoint.
+// Loopback interface: data received on OUT endpoint is sent back on IN endpoint.
+//
+// Data pattern is relative to the start of each packet: byte i of a packet is (i % 63) with
+// ZERO_PATTERN_MOD63, same as Linux usbtest so that it can be used as host side.
+//--------------------------------------------------------------------+
+
+// Vendor specific interface subclass and protocol
+enum {
+  ZERO_SUBCLASS           = 0x5A,
+  ZERO_PROTOCOL_SRC_SINK  = 0x01,
+  ZERO_PROTOCOL_LOOPBACK  = 0x02,
+};
+
+typedef enum {
+  ZERO_PATTERN_ZERO  = 0, // all zeros
+  ZERO_PATTERN_MOD63 = 1, // (offset in packet) % 63
+  ZERO_PATTERN_NONE  = 2, // not generated nor verified
+} zero_pattern_t;
+
+// Class requests to interface, vendor requests are always passed to application by usbd
+enum {
+  ZERO_REQ_CTRL_WRITE = 0x5B, // OUT: data is stored in control buffer
+  ZERO_REQ_CTRL_READ  = 0x5C, // IN : return control buffer
+  ZERO_REQ_SET_PARAM  = 0x5D, // OUT: zero_param_t
+  ZERO_REQ_GET_STAT   = 0x5E, // IN : zero_stat_t, wValue = 1 to clear after reading
+};
+
+// Source/sink parameters, little endian on the wire
+typedef struct TU_ATTR_PACKED {
+  uint8_t  pattern;   // zero_pattern_t
+  uint8_t  zlp;       // send zero length packet after IN transfer that is a multiple of packet size
+  uint16_t len_min;   // IN transfer length sweeps from len_min to len_max by len_step,
+  uint16_t len_max;   // fixed len_max if len_step is 0. Limited to the function buffer size
+  uint16_t len_step;
+} zero_param_t;
+
+TU_VERIFY_STATIC(sizeof(zero_param_t) == 8, "size is not correct");
+
+// Statistics, little endian on the wire
+typedef struct TU_ATTR_PACKED {
+  uint32_t in_xfers;
+  uint32_t out_xfers;
+  uint64_t in_bytes;
+  uint64_t out_bytes;
+  uint32_t errors;    // received transfers not matching pattern
+} zero_stat_t;
+
+TU_VERIFY_STATIC(sizeof(zero_stat_t) == 28, "size is not correct");
+
+TU_ATTR_ALWAYS_INLINE static inline
+void zero_pattern_fill(uint8_t pattern, uint8_t* buf, uint32_t len, uint16_t packet_size)
+{
+  if ( pattern == ZERO_PATTERN_MOD63 )
+  {
+    for ( uint32_t i = 0; i < len; i++ ) buf[i] = (uint8_t) ((i % packet_size) % 63);
+  }
+  else if ( pattern == ZERO_PATTERN_ZERO )
+  {
+    tu_memclr(buf, len);
+  }
+}
+
+// Return true if data matches pattern
+TU_ATTR_ALWAYS_INLINE static inline
+bool zero_pattern_check(uint8_t pattern, uint8_t const* buf, uint32_t len, uint16_t packet_size)
+{
+  for ( uint32_t i = 0; i < len && pattern != ZERO_PATTERN_NONE; i++ )
+  {
+    uint8_t const expected = (pattern == ZERO_PATTERN_MOD63) ? (uint8_t) ((i % packet_size) % 63) : 0;
+    if ( buf[i] != expected ) return false;
+  }
+  return true;
+}
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif /* _TUSB_ZERO_H_ */
@@ -0,0 +1,542 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#include "tusb_option.h"
+
+#if (CFG_TUD_ENABLED && CFG_TUD_ZERO)
+
+//--------------------------------------------------------------------+
+// INCLUDE
+//--------------------------------------------------------------------+
+#include "device/usbd.h"
+#include "device/usbd_pvt.h"
+
+#include "zero_device.h"
+
+//--------------------------------------------------------------------+
+// MACRO CONSTANT TYPEDEF
+//--------------------------------------------------------------------+
+typedef struct
+{
+  uint8_t const* desc;    // first (alt 0) interface descriptor, NULL if not opened
+  uint16_t desc_len;      // all alternate settings
+
+  uint8_t itf_num;
+  uint8_t protocol;
+  uint8_t alt;
+  uint8_t xfer_type;
+
+  uint8_t  ep_in;
+  uint8_t  ep_out;
+  uint16_t mps_in;
+  uint16_t mps_out;
+
+  // source
+  uint16_t in_len;        // length of next IN transfer when sweeping
+  bool     zlp_pending;
+  bool     in_refill;     // pattern changed, refill buf[0] before next IN transfer
+
+  // loopback: buf[0] and buf[1] are used in turn
+  uint8_t  lb_rx_idx;
+  uint8_t  lb_tx_idx;
+  uint8_t  lb_count;      // received buffers not yet sent back
+  uint16_t lb_len[2];
+
+  zero_stat_t stat;
+
+  /*------------- From this point, data is not cleared by bus reset -------------*/
+  zero_param_t param;
+
+  CFG_TUSB_MEM_ALIGN uint8_t ctrl_buf[CFG_TUD_ZERO_CTRL_BUFSIZE];
+  CFG_TUD_MEM_ALIGN uint8_t buf[2][TUD_EPBUF_SIZE(CFG_TUD_ZERO_BUFSIZE)]; // source/sink: IN, OUT
+} zerod_interface_t;
+
+#define ITF_MEM_RESET_SIZE   offsetof(zerod_interface_t, param)
+
+TU_VERIFY_STATIC(CFG_TUD_ZERO_CTRL_BUFSIZE >= sizeof(zero_stat_t), "control buffer too small");
+
+//--------------------------------------------------------------------+
+// INTERNAL OBJECT & FUNCTION DECLARATION
+//--------------------------------------------------------------------+
+CFG_TUD_MEM_SECTION tu_static zerod_interface_t _zerod_itf[CFG_TUD_ZERO];
+
+static zerod_interface_t* find_itf_by_num(uint8_t itf_num)
+{
+  for ( uint8_t i = 0; i < CFG_TUD_ZERO; i++ )
+  {
+    if ( _zerod_itf[i].desc && _zerod_itf[i].itf_num == itf_num ) return &_zerod_itf[i];
+  }
+  return NULL;
+}
+
+static zerod_interface_t* find_itf_by_ep(uint8_t ep_addr)
+{
+  for ( uint8_t i = 0; i < CFG_TUD_ZERO; i++ )
+  {
+    if ( _zerod_itf[i].desc && (ep_addr == _zerod_itf[i].ep_in || ep_addr == _zerod_itf[i].ep_out) ) return &_zerod_itf[i];
+  }
+  return NULL;
+}
+
+// OUT transfer length: whole buffer in multiple of packet size, single packet for isochronous
+static uint16_t rx_len(zerod_interface_t const* p)
+{
+  if ( p->xfer_type == TUSB_XFER_ISOCHRONOUS ) return p->mps_out;
+  return (uint16_t) (CFG_TUD_ZERO_BUFSIZE - (CFG_TUD_ZERO_BUFSIZE % p->mps_out));
+}
+
+//--------------------------------------------------------------------+
+// Source / Sink
+//--------------------------------------------------------------------+
+static bool source_xfer(uint8_t rhport, zerod_interface_t* p)
+{
+  uint16_t len;
+
+  // buf[0] is not in use by a transfer at this point
+  if ( p->in_refill )
+  {
+    zero_pattern_fill(p->param.pattern, p->buf[0], CFG_TUD_ZERO_BUFSIZE, p->mps_in);
+    p->in_refill = false;
+  }
+
+  if ( p->zlp_pending )
+  {
+    len = 0;
+    p->zlp_pending = false;
+  }
+  else
+  {
+    zero_param_t const* param = &p->param;
+    if ( param->len_step )
+    {
+      len = p->in_len;
+      p->in_len = (uint16_t) (p->in_len + param->len_step);
+      if ( p->in_len > param->len_max || p->in_len < len ) p->in_len = param->len_min;
+    }
+    else
+    {
+      len = param->len_max;
+    }
+
+    if ( p->xfer_type == TUSB_XFER_ISOCHRONOUS ) len = tu_min16(len, p->mps_in);
+    p->zlp_pending = param->zlp && len && (p->xfer_type != TUSB_XFER_ISOCHRONOUS) && (0 == (len % p->mps_in));
+  }
+
+  return usbd_edpt_xfer(rhport, p->ep_in, p->buf[0], len);
+}
+
+static bool sink_xfer(uint8_t rhport, zerod_interface_t* p)
+{
+  return usbd_edpt_xfer(rhport, p->ep_out, p->buf[1], rx_len(p));
+}
+
+//--------------------------------------------------------------------+
+// Loopback
+//--------------------------------------------------------------------+
+static bool loopback_xfer(uint8_t rhport, zerod_interface_t* p)
+{
+  // send back oldest received buffer
+  if ( p->lb_count && !usbd_edpt_busy(rhport, p->ep_in) )
+  {
+    TU_ASSERT(usbd_edpt_xfer(rhport, p->ep_in, p->buf[p->lb_tx_idx], p->lb_len[p->lb_tx_idx]));
+  }
+
+  // receive into free buffer
+  if ( p->lb_count < 2 && !usbd_edpt_busy(rhport, p->ep_out) )
+  {
+    TU_ASSERT(usbd_edpt_xfer(rhport, p->ep_out, p->buf[p->lb_rx_idx], rx_len(p)));
+  }
+
+  return true;
+}
+
+//--------------------------------------------------------------------+
+// Alternate Setting
+//--------------------------------------------------------------------+
+static bool set_alt(uint8_t rhport, zerod_interface_t* p, uint8_t alt)
+{
+  uint8_t const* desc_end = p->desc + p->desc_len;
+
+  // find interface descriptor of alternate setting
+  uint8_t const* p_desc = p->desc;
+  while ( p_desc < desc_end )
+  {
+    if ( TUSB_DESC_INTERFACE == tu_desc_type(p_desc) &&
+         alt == ((tusb_desc_interface_t const*) p_desc)->bAlternateSetting ) break;
+    p_desc = tu_desc_next(p_desc);
+  }
+  TU_VERIFY(p_desc < desc_end);
+
+  // close endpoints of previous setting, in-flight transfers are aborted.
+  // Reserved ISO endpoints are kept, they are reconfigured when opened again
+  if ( !TUP_DCD_EDPT_ISO_ALLOC || p->xfer_type != TUSB_XFER_ISOCHRONOUS )
+  {
+    if ( p->ep_in  ) usbd_edpt_close(rhport, p->ep_in);
+    if ( p->ep_out ) usbd_edpt_close(rhport, p->ep_out);
+  }
+  p->ep_in = p->ep_out = 0;
+  p->zlp_pending = false;
+  p->in_len      = p->param.len_min;
+  p->lb_rx_idx = p->lb_tx_idx = p->lb_count = 0;
+
+  // open endpoints of new setting
+  p_desc = tu_desc_next(p_desc);
+  while ( p_desc < desc_end && TUSB_DESC_INTERFACE != tu_desc_type(p_desc) )
+  {
+    if ( TUSB_DESC_ENDPOINT == tu_desc_type(p_desc) )
+    {
+      tusb_desc_endpoint_t const* desc_ep = (tusb_desc_endpoint_t const*) p_desc;
+      uint16_t const mps = tu_edpt_packet_size(desc_ep);
+      TU_ASSERT(mps && mps <= CFG_TUD_ZERO_BUFSIZE);
+#if TUP_DCD_EDPT_ISO_ALLOC
+      if ( desc_ep->bmAttributes.xfer == TUSB_XFER_ISOCHRONOUS )
+      {
+        TU_ASSERT(usbd_edpt_iso_activate(rhport, desc_ep));
+      }
+      else
+#endif
+      {
+        TU_ASSERT(usbd_edpt_open(rhport, desc_ep));
+      }
+
+      p->xfer_type = desc_ep->bmAttributes.xfer;
+      if ( tu_edpt_dir(desc_ep->bEndpointAddress) == TUSB_DIR_IN )
+      {
+        p->ep_in  = desc_ep->bEndpointAddress;
+        p->mps_in = mps;
+      }
+      else
+      {
+        p->ep_out  = desc_ep->bEndpointAddress;
+        p->mps_out = mps;
+      }
+    }
+    p_desc = tu_desc_next(p_desc);
+  }
+  p->alt = alt;
+
+  // start streaming
+  if ( p->protocol == ZERO_PROTOCOL_LOOPBACK )
+  {
+    TU_VERIFY(p->ep_in && p->ep_out);
+    TU_ASSERT(loopback_xfer(rhport, p));
+  }
+  else
+  {
+    if ( p->ep_in )
+    {
+      p->in_refill = true;
+      TU_ASSERT(source_xfer(rhport, p));
+    }
+    if ( p->ep_out ) TU_ASSERT(sink_xfer(rhport, p));
+  }
+
+  return true;
+}
+
+#if TUP_DCD_EDPT_ISO_ALLOC
+// Reserve ISO endpoints of all alternate settings with their largest packet size
+static bool iso_alloc(uint8_t rhport, zerod_interface_t const* p)
+{
+  uint8_t  ep_addr[2] = { 0, 0 };
+  uint16_t ep_size[2] = { 0, 0 };
+
+  uint8_t const* desc_end = p->desc + p->desc_len;
+  for ( uint8_t const* p_desc = p->desc; p_desc < desc_end; p_desc = tu_desc_next(p_desc) )
+  {
+    tusb_desc_endpoint_t const* desc_ep = (tusb_desc_endpoint_t const*) p_desc;
+    if ( TUSB_DESC_ENDPOINT == tu_desc_type(p_desc) && desc_ep->bmAttributes.xfer == TUSB_XFER_ISOCHRONOUS )
+    {
+      uint8_t const dir = tu_edpt_dir(desc_ep->bEndpointAddress);
+      ep_addr[dir] = desc_ep->bEndpointAddress;
+      ep_size[dir] = TU_MAX(tu_edpt_packet_size(desc_ep), ep_size[dir]);
+    }
+  }
+
+  for ( uint8_t dir = 0; dir < 2; dir++ )
+  {
+    if ( ep_addr[dir] ) TU_ASSERT(usbd_edpt_iso_alloc(rhport, ep_addr[dir], ep_size[dir]));
+  }
+
+  return true;
+}
+#endif
+
+static bool param_valid(zero_param_t const* param)
+{
+  return (param->pattern <= ZERO_PATTERN_NONE) && (param->len_max <= CFG_TUD_ZERO_BUFSIZE) &&
+         (param->len_min <= param->len_max);
+}
+
+static void param_apply(zerod_interface_t* p, zero_param_t const* param)
+{
+  // pattern only depends on offset in packet, buffer is refilled only if changed.
+  // An IN transfer may be in flight, refill is deferred to the next source_xfer()
+  if ( param->pattern != p->param.pattern ) p->in_refill = true;
+  p->param  = *param;
+  p->in_len = param->len_min;
+}
+
+//--------------------------------------------------------------------+
+// APPLICATION API
+//--------------------------------------------------------------------+
+bool tud_zero_n_mounted(uint8_t idx)
+{
+  TU_VERIFY(idx < CFG_TUD_ZERO);
+  return _zerod_itf[idx].desc != NULL;
+}
+
+uint8_t tud_zero_n_alt(uint8_t idx)
+{
+  TU_VERIFY(idx < CFG_TUD_ZERO, 0);
+  return _zerod_itf[idx].alt;
+}
+
+bool tud_zero_n_set_param(uint8_t idx, zero_param_t const* param)
+{
+  TU_VERIFY(idx < CFG_TUD_ZERO && param_valid(param));
+  param_apply(&_zerod_itf[idx], param);
+  return true;
+}
+
+bool tud_zero_n_get_param(uint8_t idx, zero_param_t* param)
+{
+  TU_VERIFY(idx < CFG_TUD_ZERO);
+  *param = _zerod_itf[idx].param;
+  return true;
+}
+
+bool tud_zero_n_stat(uint8_t idx, zero_stat_t* stat, bool clear)
+{
+  TU_VERIFY(idx < CFG_TUD_ZERO);
+  zerod_interface_t* p = &_zerod_itf[idx];
+  if ( stat ) *stat = p->stat;
+  if ( clear ) tu_varclr(&p->stat);
+  return true;
+}
+
+//--------------------------------------------------------------------+
+// USBD Driver API
+//--------------------------------------------------------------------+
+void zerod_init(void)
+{
+  tu_memclr(_zerod_itf, sizeof(_zerod_itf));
+
+  for ( uint8_t i = 0; i < CFG_TUD_ZERO; i++ )
+  {
+    zero_param_t* param = &_zerod_itf[i].param;
+    param->pattern = ZERO_PATTERN_MOD63;
+    param->len_min = param->len_max = CFG_TUD_ZERO_BUFSIZE;
+  }
+}
+
+void zerod_reset(uint8_t rhport)
+{
+  (void) rhport;
+
+  for ( uint8_t i = 0; i < CFG_TUD_ZERO; i++ )
+  {
+    tu_memclr(&_zerod_itf[i], ITF_MEM_RESET_SIZE);
+  }
+}
+
+uint16_t zerod_open(uint8_t rhport, tusb_desc_interface_t const * itf_desc, uint16_t max_len)
+{
+  TU_VERIFY(TUSB_CLASS_VENDOR_SPECIFIC == itf_desc->bInterfaceClass &&
+            ZERO_SUBCLASS == itf_desc->bInterfaceSubClass &&
+            (ZERO_PROTOCOL_SRC_SINK == itf_desc->bInterfaceProtocol ||
+             ZERO_PROTOCOL_LOOPBACK == itf_desc->bInterfaceProtocol), 0);
+
+  // Find available interface
+  zerod_interface_t* p = NULL;
+  for ( uint8_t i = 0; i < CFG_TUD_ZERO; i++ )
+  {
+    if ( !_zerod_itf[i].desc )
+    {
+      p = &_zerod_itf[i];
+      break;
+    }
+  }
+  TU_VERIFY(p, 0);
+
+  // Claim all alternate settings of this interface
+  uint8_t const* p_desc   = tu_desc_next(itf_desc);
+  uint8_t const* desc_end = ((uint8_t const*) itf_desc) + max_len;
+  while ( p_desc < desc_end )
+  {
+    uint8_t const type = tu_desc_type(p_desc);
+    if ( TUSB_DESC_INTERFACE_ASSOCIATION == type ) break;
+    if ( TUSB_DESC_INTERFACE == type &&
+         itf_desc->bInterfaceNumber != ((tusb_desc_interface_t const*) p_desc)->bInterfaceNumber ) break;
+    p_desc = tu_desc_next(p_desc);
+  }
+
+  p->desc     = (uint8_t const*) itf_desc;
+  p->desc_len = (uint16_t) (p_desc - p->desc);
+  p->itf_num  = itf_desc->bInterfaceNumber;
+  p->protocol = itf_desc->bInterfaceProtocol;
+
+#if TUP_DCD_EDPT_ISO_ALLOC
+  if ( !iso_alloc(rhport, p) )
+  {
+    p->desc = NULL;
+    return 0;
+  }
+#endif
+
+  if ( !set_alt(rhport, p, 0) )
+  {
+    p->desc = NULL;
+    return 0;
+  }
+
+  return p->desc_len;
+}
+
+bool zerod_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t const * request)
+{
+  TU_VERIFY(request->bmRequestType_bit.recipient == TUSB_REQ_RCPT_INTERFACE);
+
+  zerod_interface_t* p = find_itf_by_num(tu_u16_low(request->wIndex));
+  TU_VERIFY(p);
+
+  if ( request->bmRequestType_bit.type == TUSB_REQ_TYPE_STANDARD )
+  {
+    switch ( request->bRequest )
+    {
+      case TUSB_REQ_GET_INTERFACE:
+        if ( stage == CONTROL_STAGE_SETUP ) TU_VERIFY(tud_control_xfer(rhport, request, &p->alt, 1));
+        break;
+
+      case TUSB_REQ_SET_INTERFACE:
+        if ( stage == CONTROL_STAGE_SETUP )
+        {
+          TU_VERIFY(set_alt(rhport, p, tu_u16_low(request->wValue)));
+          tud_control_status(rhport, request);
+        }
+        break;
+
+      default: return false;
+    }
+    return true;
+  }
+
+  TU_VERIFY(request->bmRequestType_bit.type == TUSB_REQ_TYPE_CLASS);
+
+  switch ( request->bRequest )
+  {
+    case ZERO_REQ_CTRL_WRITE:
+    case ZERO_REQ_CTRL_READ:
+      if ( stage == CONTROL_STAGE_SETUP )
+      {
+        TU_VERIFY(request->wLength <= CFG_TUD_ZERO_CTRL_BUFSIZE);
+        TU_VERIFY(tud_control_xfer(rhport, request, p->ctrl_buf, request->wLength));
+      }
+      break;
+
+    case ZERO_REQ_SET_PARAM:
+      if ( stage == CONTROL_STAGE_SETUP )
+      {
+        TU_VERIFY(request->wLength == sizeof(zero_param_t));
+        TU_VERIFY(tud_control_xfer(rhport, request, p->ctrl_buf, sizeof(zero_param_t)));
+      }
+      else if ( stage == CONTROL_STAGE_DATA )
+      {
+        zero_param_t param;
+        memcpy(&param, p->ctrl_buf, sizeof(param));
+        param.len_min  = tu_le16toh(param.len_min);
+        param.len_max  = tu_le16toh(param.len_max);
+        param.len_step = tu_le16toh(param.len_step);
+        TU_VERIFY(param_valid(&param));
+        param_apply(p, &param);
+      }
+      break;
+
+    case ZERO_REQ_GET_STAT:
+      if ( stage == CONTROL_STAGE_SETUP )
+      {
+        memcpy(p->ctrl_buf, &p->stat, sizeof(zero_stat_t));
+        if ( request->wValue ) tu_varclr(&p->stat);
+        TU_VERIFY(tud_control_xfer(rhport, request, p->ctrl_buf, tu_min16(request->wLength, sizeof(zero_stat_t))));
+      }
+      break;
+
+    default: return false;
+  }
+
+  return true;
+}
+
+bool zerod_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes)
+{
+  zerod_interface_t* p = find_itf_by_ep(ep_addr);
+  TU_VERIFY(p);
+
+  zero_stat_t* stat = &p->stat;
+
+  if ( p->protocol == ZERO_PROTOCOL_LOOPBACK )
+  {
+    if ( ep_addr == p->ep_out )
+    {
+      stat->out_xfers++;
+      stat->out_bytes += xferred_bytes;
+      p->lb_len[p->lb_rx_idx] = (uint16_t) xferred_bytes;
+      p->lb_rx_idx ^= 1;
+      p->lb_count++;
+    }
+    else
+    {
+      stat->in_xfers++;
+      stat->in_bytes += xferred_bytes;
+      p->lb_tx_idx ^= 1;
+      p->lb_count--;
+    }
+    return loopback_xfer(rhport, p);
+  }
+
+  if ( ep_addr == p->ep_in )
+  {
+    stat->in_xfers++;
+    stat->in_bytes += xferred_bytes;
+    TU_ASSERT(source_xfer(rhport, p));
+  }
+  else
+  {
+    stat->out_xfers++;
+    stat->out_bytes += xferred_bytes;
+    if ( result != XFER_RESULT_SUCCESS ||
+         !zero_pattern_check(p->param.pattern, p->buf[1], xferred_bytes, p->mps_out) )
+    {
+      stat->errors++;
+      if ( tud_zero_rx_error_cb ) tud_zero_rx_error_cb((uint8_t) (p - _zerod_itf), p->buf[1], xferred_bytes);
+    }
+    TU_ASSERT(sink_xfer(rhport, p));
+  }
+
+  return true;
+}
+
+#endif
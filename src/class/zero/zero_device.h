@@ -0,0 +1,124 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#ifndef _TUSB_ZERO_DEVICE_H_
+#define _TUSB_ZERO_DEVICE_H_
+
+#include "common/tusb_common.h"
+#include "zero.h"
+
+//--------------------------------------------------------------------+
+// Class Driver Configuration
+//--------------------------------------------------------------------+
+
+// Transfer buffer size of each direction, must be at least the largest endpoint size.
+// Larger buffer queues multiple packets per transfer for better throughput.
+#ifndef CFG_TUD_ZERO_BUFSIZE
+#define CFG_TUD_ZERO_BUFSIZE       (TUD_OPT_HIGH_SPEED ? 4096 : 1024)
+#endif
+
+// Buffer for ZERO_REQ_CTRL_WRITE/READ control transfer test
+#ifndef CFG_TUD_ZERO_CTRL_BUFSIZE
+#define CFG_TUD_ZERO_CTRL_BUFSIZE  256
+#endif
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+//--------------------------------------------------------------------+
+// Application API (Multiple Interfaces)
+//--------------------------------------------------------------------+
+bool    tud_zero_n_mounted   (uint8_t idx);
+
+// Current alternate setting
+uint8_t tud_zero_n_alt       (uint8_t idx);
+
+// Set source/sink parameters, take effect with next transfer. Host can also set them with ZERO_REQ_SET_PARAM
+bool    tud_zero_n_set_param (uint8_t idx, zero_param_t const* param);
+bool    tud_zero_n_get_param (uint8_t idx, zero_param_t* param);
+
+// Get statistics, optionally clear them
+bool    tud_zero_n_stat      (uint8_t idx, zero_stat_t* stat, bool clear);
+
+//--------------------------------------------------------------------+
+// Application API (Single Interface)
+//--------------------------------------------------------------------+
+static inline bool    tud_zero_mounted   (void);
+static inline uint8_t tud_zero_alt       (void);
+static inline bool    tud_zero_set_param (zero_param_t const* param);
+static inline bool    tud_zero_get_param (zero_param_t* param);
+static inline bool    tud_zero_stat      (zero_stat_t* stat, bool clear);
+
+//--------------------------------------------------------------------+
+// Application Callback API (weak is optional)
+//--------------------------------------------------------------------+
+
+// Invoked when received data does not match the pattern
+TU_ATTR_WEAK void tud_zero_rx_error_cb(uint8_t idx, uint8_t const* buf, uint32_t len);
+
+//--------------------------------------------------------------------+
+// Inline Functions
+//--------------------------------------------------------------------+
+static inline bool tud_zero_mounted(void)
+{
+  return tud_zero_n_mounted(0);
+}
+
+static inline uint8_t tud_zero_alt(void)
+{
+  return tud_zero_n_alt(0);
+}
+
+static inline bool tud_zero_set_param(zero_param_t const* param)
+{
+  return tud_zero_n_set_param(0, param);
+}
+
+static inline bool tud_zero_get_param(zero_param_t* param)
+{
+  return tud_zero_n_get_param(0, param);
+}
+
+static inline bool tud_zero_stat(zero_stat_t* stat, bool clear)
+{
+  return tud_zero_n_stat(0, stat, clear);
+}
+
+//--------------------------------------------------------------------+
+// Internal Class Driver API
+//--------------------------------------------------------------------+
+void     zerod_init           (void);
+void     zerod_reset          (uint8_t rhport);
+uint16_t zerod_open           (uint8_t rhport, tusb_desc_interface_t const * itf_desc, uint16_t max_len);
+bool     zerod_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t const * request);
+bool     zerod_xfer_cb        (uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes);
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif /* _TUSB_ZERO_DEVICE_H_ */
@@ -0,0 +1,755 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#include "tusb_option.h"
+
+#if (CFG_TUH_ENABLED && CFG_TUH_ZERO)
+
+#include "host/usbh.h"
+#include "host/usbh_pvt.h"
+
+#include "zero_host.h"
+
+// Level where CFG_TUSB_DEBUG must be at least for this driver is logged
+#ifndef CFG_TUH_ZERO_LOG_LEVEL
+  #define CFG_TUH_ZERO_LOG_LEVEL   CFG_TUH_LOG_LEVEL
+#endif
+
+#define TU_LOG_DRV(...)   TU_LOG(CFG_TUH_ZERO_LOG_LEVEL, __VA_ARGS__)
+
+//--------------------------------------------------------------------+
+// MACRO CONSTANT TYPEDEF
+//--------------------------------------------------------------------+
+
+enum {
+  ZEROH_ALT_MAX  = 4,
+  ZEROH_ALT_NONE = 0xff, // endpoints closed for alternate setting change
+};
+
+enum {
+  TEST_IDLE = 0,
+  TEST_SET_ALT,
+  TEST_SET_PARAM,
+  TEST_CLEAR_STAT,
+  TEST_RUN,
+  TEST_GET_STAT,
+};
+
+typedef struct
+{
+  uint8_t daddr;
+  uint8_t itf_num;
+  uint8_t protocol;
+  uint8_t alt;
+  uint8_t alt_count;
+  bool    mounted;
+  bool    native;   // implements this class i.e ZERO_REQ_SET_PARAM and ZERO_REQ_GET_STAT
+
+  // endpoints of current alternate setting
+  uint8_t  ep_in;
+  uint8_t  ep_out;
+  uint8_t  xfer_type;
+  uint16_t mps_in;
+  uint16_t mps_out;
+
+  tusb_desc_endpoint_t ep_desc[ZEROH_ALT_MAX][2]; // [alt][dir]
+
+  // running test
+  uint8_t  stage;
+  bool     stop;
+  bool     in_busy;
+  bool     out_busy;
+  bool     out_zlp;
+  tuh_zero_test_t test;
+
+  uint32_t in_queued;
+  uint32_t in_done;
+  uint32_t out_queued;
+  uint32_t out_done;
+
+  uint32_t t_start;
+  uint32_t t_submit[CFG_TUH_ZERO_QUEUE_DEPTH];
+  uint64_t lat_sum;
+  uint32_t lat_hist[TUH_ZERO_LATENCY_BUCKETS];
+  tuh_zero_result_t result;
+
+  CFG_TUH_MEM_ALIGN uint8_t ctrl_buf[sizeof(zero_stat_t)];
+  CFG_TUH_MEM_ALIGN uint8_t tx_buf[CFG_TUH_ZERO_BUFSIZE];
+  CFG_TUH_MEM_ALIGN uint8_t rx_buf[CFG_TUH_ZERO_QUEUE_DEPTH][CFG_TUH_ZERO_BUFSIZE];
+} zeroh_interface_t;
+
+CFG_TUH_MEM_SECTION
+tu_static zeroh_interface_t _zeroh_itf[CFG_TUH_ZERO];
+
+static bool test_stage(zeroh_interface_t* p, uint8_t stage);
+static void test_stop(zeroh_interface_t* p, xfer_result_t status);
+static void test_check_done(zeroh_interface_t* p);
+static void test_complete(zeroh_interface_t* p);
+
+TU_ATTR_ALWAYS_INLINE static inline uint8_t get_idx(zeroh_interface_t const* p)
+{
+  return (uint8_t) (p - _zeroh_itf);
+}
+
+TU_ATTR_ALWAYS_INLINE static inline zeroh_interface_t* get_itf(uint8_t idx)
+{
+  TU_VERIFY(idx < CFG_TUH_ZERO, NULL);
+  zeroh_interface_t* p = &_zeroh_itf[idx];
+  return p->mounted ? p : NULL;
+}
+
+static zeroh_interface_t* get_itf_by_ep(uint8_t daddr, uint8_t ep_addr)
+{
+  for(uint8_t i=0; i<CFG_TUH_ZERO; i++)
+  {
+    zeroh_interface_t* p = &_zeroh_itf[i];
+    if ( p->daddr == daddr && (p->ep_in == ep_addr || p->ep_out == ep_addr) ) return p;
+  }
+  return NULL;
+}
+
+TU_ATTR_ALWAYS_INLINE static inline uint32_t time_us(void)
+{
+  return tuh_zero_time_us_cb ? tuh_zero_time_us_cb() : 0;
+}
+
+//--------------------------------------------------------------------+
+// Latency histogram
+//--------------------------------------------------------------------+
+
+// values below 4 us have their own bucket, then 4 buckets per power of 2
+static uint8_t lat_bucket(uint32_t us)
+{
+  if ( us < 4 ) return (uint8_t) us;
+
+  uint8_t const msb = tu_log2(us);
+  uint32_t const idx = 4u*(msb-1u) + ((us >> (msb-2u)) & 3u);
+  return (uint8_t) tu_min32(idx, TUH_ZERO_LATENCY_BUCKETS-1);
+}
+
+// largest value of a bucket, last one also collects everything beyond the histogram range
+static uint32_t lat_bucket_max(uint8_t idx)
+{
+  if ( idx < 4 ) return idx;
+  if ( idx == TUH_ZERO_LATENCY_BUCKETS-1 ) return UINT32_MAX;
+
+  uint8_t const shift = (uint8_t) (idx/4 - 1);
+  return ((4u + (idx & 3u) + 1u) << shift) - 1u;
+}
+
+static uint32_t lat_percentile(zeroh_interface_t const* p, uint8_t percent)
+{
+  tuh_zero_result_t const* r = &p->result;
+  if ( !r->count ) return 0;
+
+  uint64_t target = ((uint64_t) r->count * tu_min8(percent, 100) + 99) / 100;
+  if ( !target ) target = 1;
+
+  uint64_t sum = 0;
+  for(uint8_t i=0; i<TUH_ZERO_LATENCY_BUCKETS; i++)
+  {
+    sum += p->lat_hist[i];
+    if ( sum >= target ) return tu_min32(lat_bucket_max(i), r->lat_max_us);
+  }
+
+  return r->lat_max_us;
+}
+
+static void xfer_record(zeroh_interface_t* p, uint32_t t_submit, uint32_t len, bool valid)
+{
+  tuh_zero_result_t* r = &p->result;
+  uint32_t const lat = time_us() - t_submit;
+
+  if ( !r->count || lat < r->lat_min_us ) r->lat_min_us = lat;
+  if ( lat > r->lat_max_us ) r->lat_max_us = lat;
+  p->lat_sum += lat;
+  p->lat_hist[lat_bucket(lat)]++;
+
+  r->count++;
+  r->bytes += len;
+  if ( !valid ) r->errors++;
+}
+
+//--------------------------------------------------------------------+
+// Application API
+//--------------------------------------------------------------------+
+
+uint8_t tuh_zero_itf_get_index(uint8_t daddr, uint8_t itf_num)
+{
+  for(uint8_t i=0; i<CFG_TUH_ZERO; i++)
+  {
+    zeroh_interface_t const* p = &_zeroh_itf[i];
+    if ( p->mounted && p->daddr == daddr && p->itf_num == itf_num ) return i;
+  }
+  return TUSB_INDEX_INVALID_8;
+}
+
+bool tuh_zero_mounted(uint8_t idx)
+{
+  return get_itf(idx) != NULL;
+}
+
+uint8_t tuh_zero_protocol(uint8_t idx)
+{
+  zeroh_interface_t const* p = get_itf(idx);
+  return p ? p->protocol : 0;
+}
+
+uint8_t tuh_zero_alt_count(uint8_t idx)
+{
+  zeroh_interface_t const* p = get_itf(idx);
+  return p ? p->alt_count : 0;
+}
+
+bool tuh_zero_busy(uint8_t idx)
+{
+  zeroh_interface_t const* p = get_itf(idx);
+  return p && (p->stage != TEST_IDLE);
+}
+
+bool tuh_zero_test_start(uint8_t idx, tuh_zero_test_t const* test)
+{
+  zeroh_interface_t* p = get_itf(idx);
+  TU_VERIFY(p && p->stage == TEST_IDLE);
+
+  bool const loopback = (test->type == TUH_ZERO_TEST_LOOPBACK);
+  TU_VERIFY(loopback == (p->protocol == ZERO_PROTOCOL_LOOPBACK));
+  TU_VERIFY(test->type <= TUH_ZERO_TEST_LOOPBACK && test->pattern <= ZERO_PATTERN_NONE);
+  TU_VERIFY(test->xfer_len && test->xfer_len <= CFG_TUH_ZERO_BUFSIZE && test->count);
+  TU_VERIFY(test->queue_depth && test->queue_depth <= CFG_TUH_ZERO_QUEUE_DEPTH);
+  TU_VERIFY(loopback || test->alt < p->alt_count);
+
+  TU_LOG_DRV("ZERO[%u] test %u: alt %u, %u x %u bytes, queue %u\r\n", idx, test->type, test->alt,
+             (unsigned) test->count, test->xfer_len, test->queue_depth);
+
+  p->test = *test;
+  p->stop = false;
+  p->out_zlp = false;
+  p->in_queued = p->in_done = 0;
+  p->out_queued = p->out_done = 0;
+  tu_memclr(&p->result, sizeof(p->result));
+  p->lat_sum = 0;
+  tu_memclr(p->lat_hist, sizeof(p->lat_hist));
+
+  uint8_t stage;
+  if ( loopback )
+  {
+    stage = TEST_CLEAR_STAT;
+  }else
+  {
+    stage = (test->alt != p->alt) ? TEST_SET_ALT : TEST_SET_PARAM;
+  }
+
+  if ( !test_stage(p, stage) )
+  {
+    p->stage = TEST_IDLE;
+    return false;
+  }
+
+  return true;
+}
+
+bool tuh_zero_result(uint8_t idx, tuh_zero_result_t* result)
+{
+  TU_VERIFY(idx < CFG_TUH_ZERO);
+  *result = _zeroh_itf[idx].result;
+  return true;
+}
+
+uint32_t tuh_zero_latency_percentile(uint8_t idx, uint8_t percent)
+{
+  TU_VERIFY(idx < CFG_TUH_ZERO, 0);
+  return lat_percentile(&_zeroh_itf[idx], percent);
+}
+
+//--------------------------------------------------------------------+
+// Test
+//--------------------------------------------------------------------+
+
+static void test_control_complete(tuh_xfer_t* xfer);
+
+// Endpoints of the new alternate setting usually have the same addresses, close current ones first.
+// Fails without changing anything if host controller cannot close endpoints
+static bool alt_close(zeroh_interface_t* p)
+{
+  if ( p->ep_in  ) TU_VERIFY(tuh_edpt_close(p->daddr, p->ep_in));
+  if ( p->ep_out ) TU_VERIFY(tuh_edpt_close(p->daddr, p->ep_out));
+
+  p->alt    = ZEROH_ALT_NONE;
+  p->ep_in  = p->ep_out = 0;
+  return true;
+}
+
+static bool alt_open(zeroh_interface_t* p, uint8_t alt)
+{
+  tusb_desc_endpoint_t const* desc_in  = &p->ep_desc[alt][TUSB_DIR_IN];
+  tusb_desc_endpoint_t const* desc_out = &p->ep_desc[alt][TUSB_DIR_OUT];
+  TU_ASSERT(desc_in->bLength && desc_out->bLength);
+
+  TU_ASSERT(tuh_edpt_open(p->daddr, desc_in));
+  TU_ASSERT(tuh_edpt_open(p->daddr, desc_out));
+
+  p->alt       = alt;
+  p->ep_in     = desc_in->bEndpointAddress;
+  p->ep_out    = desc_out->bEndpointAddress;
+  p->xfer_type = desc_in->bmAttributes.xfer;
+  p->mps_in    = tu_edpt_packet_size(desc_in);
+  p->mps_out   = tu_edpt_packet_size(desc_out);
+
+  return true;
+}
+
+static bool control_request(zeroh_interface_t* p, uint8_t request, uint8_t dir, uint16_t value, uint16_t len)
+{
+  tusb_control_request_t const req =
+  {
+    .bmRequestType_bit =
+    {
+      .recipient = TUSB_REQ_RCPT_INTERFACE,
+      .type      = TUSB_REQ_TYPE_CLASS,
+      .direction = dir & 1u
+    },
+    .bRequest = request,
+    .wValue   = tu_htole16(value),
+    .wIndex   = tu_htole16(p->itf_num),
+    .wLength  = tu_htole16(len)
+  };
+
+  tuh_xfer_t xfer =
+  {
+    .daddr       = p->daddr,
+    .ep_addr     = 0,
+    .setup       = &req,
+    .buffer      = p->ctrl_buf,
+    .complete_cb = test_control_complete,
+    .user_data   = get_idx(p)
+  };
+
+  return tuh_control_xfer(&xfer);
+}
+
+static void submit_in(zeroh_interface_t* p)
+{
+  tuh_zero_test_t const* t = &p->test;
+  if ( t->type == TUH_ZERO_TEST_SINK || p->stop || p->in_busy || p->in_queued >= t->count ) return;
+
+  // loopback only reads back what was written
+  if ( t->type == TUH_ZERO_TEST_LOOPBACK && p->in_queued >= p->out_queued ) return;
+
+  uint8_t const slot = (uint8_t) (p->in_queued % t->queue_depth);
+  if ( t->type == TUH_ZERO_TEST_SOURCE ) p->t_submit[slot] = time_us();
+
+  if ( usbh_edpt_claim(p->daddr, p->ep_in) &&
+       usbh_edpt_xfer(p->daddr, p->ep_in, p->rx_buf[slot], t->xfer_len) )
+  {
+    p->in_busy = true;
+    p->in_queued++;
+  }else
+  {
+    test_stop(p, XFER_RESULT_FAILED);
+  }
+}
+
+static void submit_out(zeroh_interface_t* p)
+{
+  tuh_zero_test_t const* t = &p->test;
+  if ( t->type == TUH_ZERO_TEST_SOURCE || p->stop || p->out_busy || p->out_queued >= t->count ) return;
+
+  // loopback writes at most queue depth ahead of reading back
+  if ( t->type == TUH_ZERO_TEST_LOOPBACK && p->out_queued - p->in_done >= t->queue_depth ) return;
+
+  // pattern only depends on offset in packet, all transfers share the same data
+  p->t_submit[p->out_queued % t->queue_depth] = time_us();
+
+  if ( usbh_edpt_claim(p->daddr, p->ep_out) &&
+       usbh_edpt_xfer(p->daddr, p->ep_out, p->tx_buf, t->xfer_len) )
+  {
+    p->out_busy = true;
+    p->out_queued++;
+  }else
+  {
+    test_stop(p, XFER_RESULT_FAILED);
+  }
+}
+
+static void submit_zlp(zeroh_interface_t* p)
+{
+  if ( usbh_edpt_claim(p->daddr, p->ep_out) &&
+       usbh_edpt_xfer(p->daddr, p->ep_out, p->tx_buf, 0) )
+  {
+    p->out_busy = true;
+    p->out_zlp  = true;
+  }else
+  {
+    test_stop(p, XFER_RESULT_FAILED);
+  }
+}
+
+// Submit request or transfers of a test stage
+static bool test_stage(zeroh_interface_t* p, uint8_t stage)
+{
+  p->stage = stage;
+
+  switch ( stage )
+  {
+    case TEST_SET_ALT:
+      TU_VERIFY(alt_close(p));
+      return tuh_interface_set(p->daddr, p->itf_num, p->test.alt, test_control_complete, get_idx(p));
+
+    case TEST_SET_PARAM:
+    {
+      // isochronous endpoint transfers one packet at a time
+      if ( p->xfer_type == TUSB_XFER_ISOCHRONOUS )
+      {
+        p->test.xfer_len = tu_min16(p->test.xfer_len, tu_min16(p->mps_in, p->mps_out));
+      }
+
+      // other devices e.g Linux g_zero are configured by their own means
+      if ( !p->native ) return test_stage(p, TEST_RUN);
+
+      zero_param_t const param =
+      {
+        .pattern  = p->test.pattern,
+        .zlp      = 0,
+        .len_min  = tu_htole16(p->test.xfer_len),
+        .len_max  = tu_htole16(p->test.xfer_len),
+        .len_step = 0
+      };
+      memcpy(p->ctrl_buf, &param, sizeof(param));
+
+      return control_request(p, ZERO_REQ_SET_PARAM, TUSB_DIR_OUT, 0, sizeof(zero_param_t));
+    }
+
+    case TEST_CLEAR_STAT:
+      if ( !p->native ) return test_stage(p, TEST_RUN);
+      return control_request(p, ZERO_REQ_GET_STAT, TUSB_DIR_IN, 1, sizeof(zero_stat_t));
+
+    case TEST_RUN:
+      if ( p->test.type != TUH_ZERO_TEST_SOURCE )
+      {
+        zero_pattern_fill(p->test.pattern, p->tx_buf, p->test.xfer_len, p->mps_out);
+      }
+
+      p->t_start = time_us();
+      submit_out(p);
+      submit_in(p);
+      test_check_done(p);
+      return true;
+
+    case TEST_GET_STAT:
+      if ( !p->native )
+      {
+        test_complete(p);
+        return true;
+      }
+      return control_request(p, ZERO_REQ_GET_STAT, TUSB_DIR_IN, 0, sizeof(zero_stat_t));
+
+    default: return false;
+  }
+}
+
+static void test_control_complete(tuh_xfer_t* xfer)
+{
+  uint8_t const idx = (uint8_t) xfer->user_data;
+  TU_VERIFY(idx < CFG_TUH_ZERO, );
+  zeroh_interface_t* p = &_zeroh_itf[idx];
+
+  bool ok = (xfer->result == XFER_RESULT_SUCCESS);
+  uint8_t next;
+
+  switch ( p->stage )
+  {
+    case TEST_SET_ALT:
+      ok = ok && alt_open(p, p->test.alt);
+      next = TEST_SET_PARAM;
+    break;
+
+    case TEST_SET_PARAM:
+      next = TEST_CLEAR_STAT;
+    break;
+
+    case TEST_CLEAR_STAT:
+      next = TEST_RUN;
+    break;
+
+    case TEST_GET_STAT:
+      if ( ok )
+      {
+        zero_stat_t stat;
+        memcpy(&stat, p->ctrl_buf, sizeof(stat));
+        p->result.dev_errors = tu_le32toh(stat.errors);
+      }else
+      {
+        p->result.status = XFER_RESULT_FAILED;
+      }
+      test_complete(p);
+    return;
+
+    default: return;
+  }
+
+  if ( !ok || !test_stage(p, next) )
+  {
+    p->result.status = (xfer->result == XFER_RESULT_SUCCESS) ? XFER_RESULT_FAILED : xfer->result;
+    test_complete(p);
+  }
+}
+
+static void test_stop(zeroh_interface_t* p, xfer_result_t status)
+{
+  if ( p->result.status == XFER_RESULT_SUCCESS ) p->result.status = status;
+  p->stop = true;
+
+  // loopback read would never complete once writing stopped
+  if ( p->in_busy && tuh_edpt_abort_xfer(p->daddr, p->ep_in) ) p->in_busy = false;
+}
+
+static void test_check_done(zeroh_interface_t* p)
+{
+  if ( p->stage != TEST_RUN || p->in_busy || p->out_busy ) return;
+
+  uint32_t const done = (p->test.type == TUH_ZERO_TEST_SINK) ? p->out_done : p->in_done;
+  if ( !p->stop && done < p->test.count ) return;
+
+  p->result.elapsed_us = time_us() - p->t_start;
+
+  if ( p->stop || !test_stage(p, TEST_GET_STAT) )
+  {
+    if ( p->result.status == XFER_RESULT_SUCCESS ) p->result.status = XFER_RESULT_FAILED;
+    test_complete(p);
+  }
+}
+
+static void test_complete(zeroh_interface_t* p)
+{
+  tuh_zero_result_t* r = &p->result;
+  r->lat_avg_us = r->count ? (uint32_t) (p->lat_sum / r->count) : 0;
+  r->lat_p50_us = lat_percentile(p, 50);
+  r->lat_p90_us = lat_percentile(p, 90);
+  r->lat_p99_us = lat_percentile(p, 99);
+
+  TU_LOG_DRV("ZERO[%u] test complete: status %u, %u xfers, %u errors\r\n", get_idx(p), r->status,
+             (unsigned) r->count, (unsigned) (r->errors + r->dev_errors));
+
+  p->stage = TEST_IDLE;
+  if (tuh_zero_test_complete_cb) tuh_zero_test_complete_cb(get_idx(p), r);
+}
+
+//--------------------------------------------------------------------+
+// USBH API
+//--------------------------------------------------------------------+
+
+void zeroh_init(void)
+{
+  tu_memclr(_zeroh_itf, sizeof(_zeroh_itf));
+}
+
+bool zeroh_open(uint8_t rhport, uint8_t daddr, tusb_desc_interface_t const *desc_itf, uint16_t max_len)
+{
+  (void) rhport;
+
+  // interface of this class, or of another device selected by application
+  bool const native = (TUSB_CLASS_VENDOR_SPECIFIC == desc_itf->bInterfaceClass &&
+                       ZERO_SUBCLASS              == desc_itf->bInterfaceSubClass);
+  uint8_t protocol = desc_itf->bInterfaceProtocol;
+  if ( !native ) protocol = tuh_zero_match_cb ? tuh_zero_match_cb(daddr, desc_itf) : 0;
+
+  TU_VERIFY(ZERO_PROTOCOL_SRC_SINK == protocol || ZERO_PROTOCOL_LOOPBACK == protocol);
+
+  zeroh_interface_t* p = NULL;
+  for(uint8_t i=0; i<CFG_TUH_ZERO; i++)
+  {
+    if ( 0 == _zeroh_itf[i].daddr )
+    {
+      p = &_zeroh_itf[i];
+      break;
+    }
+  }
+  TU_VERIFY(p);
+
+  TU_LOG_DRV("ZERO opening Interface %u (addr = %u)\r\n", desc_itf->bInterfaceNumber, daddr);
+
+  tu_memclr(p, sizeof(zeroh_interface_t));
+  p->daddr    = daddr;
+  p->itf_num  = desc_itf->bInterfaceNumber;
+  p->protocol = protocol;
+  p->native   = native;
+
+  // collect endpoints of all alternate settings, each has one IN and one OUT endpoint
+  uint8_t const* p_desc = (uint8_t const*) desc_itf;
+  uint8_t const* desc_end = p_desc + max_len;
+  uint8_t alt = 0;
+
+  while ( p_desc < desc_end && tu_desc_len(p_desc) )
+  {
+    if ( TUSB_DESC_INTERFACE == tu_desc_type(p_desc) )
+    {
+      alt = ((tusb_desc_interface_t const*) p_desc)->bAlternateSetting;
+      if ( alt < ZEROH_ALT_MAX ) p->alt_count = tu_max8(p->alt_count, (uint8_t) (alt + 1));
+    }
+    else if ( TUSB_DESC_ENDPOINT == tu_desc_type(p_desc) && alt < ZEROH_ALT_MAX &&
+              tu_desc_len(p_desc) >= sizeof(tusb_desc_endpoint_t) )
+    {
+      tusb_desc_endpoint_t const* desc_ep = (tusb_desc_endpoint_t const*) p_desc;
+      memcpy(&p->ep_desc[alt][tu_edpt_dir(desc_ep->bEndpointAddress)], desc_ep, sizeof(tusb_desc_endpoint_t));
+    }
+
+    p_desc = tu_desc_next(p_desc);
+  }
+
+  if ( !alt_open(p, 0) )
+  {
+    p->daddr = 0;
+    return false;
+  }
+
+  // loopback has no alternate setting
+  if ( p->protocol == ZERO_PROTOCOL_LOOPBACK ) p->alt_count = 1;
+
+  return true;
+}
+
+bool zeroh_set_config(uint8_t daddr, uint8_t itf_num)
+{
+  uint8_t idx = TUSB_INDEX_INVALID_8;
+  for(uint8_t i=0; i<CFG_TUH_ZERO; i++)
+  {
+    if ( _zeroh_itf[i].daddr == daddr && _zeroh_itf[i].itf_num == itf_num ) idx = i;
+  }
+  TU_VERIFY(idx < CFG_TUH_ZERO);
+
+  _zeroh_itf[idx].mounted = true;
+  if (tuh_zero_mount_cb) tuh_zero_mount_cb(idx);
+
+  // notify usbh that driver enumeration is complete
+  usbh_driver_set_config_complete(daddr, itf_num);
+
+  return true;
+}
+
+bool zeroh_xfer_cb(uint8_t daddr, uint8_t ep_addr, xfer_result_t event, uint32_t xferred_bytes)
+{
+  zeroh_interface_t* p = get_itf_by_ep(daddr, ep_addr);
+  TU_VERIFY(p);
+
+  tuh_zero_test_t const* t = &p->test;
+  bool const success = (event == XFER_RESULT_SUCCESS);
+
+  // isochronous transfer may fail occasionally, counted as error but test goes on
+  bool const fatal = !success && (p->xfer_type != TUSB_XFER_ISOCHRONOUS);
+
+  if ( ep_addr == p->ep_in )
+  {
+    p->in_busy = false;
+    if ( p->stage != TEST_RUN ) return true;
+
+    uint8_t const slot = (uint8_t) (p->in_done % t->queue_depth);
+
+    if ( fatal )
+    {
+      p->in_done++;
+      test_stop(p, event);
+    }
+    else if ( success && !xferred_bytes && t->type == TUH_ZERO_TEST_LOOPBACK )
+    {
+      // echo of zero length packet that device received after a transfer filling its buffer, read again
+      p->in_queued--;
+    }else
+    {
+      p->in_done++;
+
+      // queue next transfer to other buffer before verifying this one
+      if ( t->queue_depth > 1 ) submit_in(p);
+
+      // source length may differ from transfer queued by device before parameters were set
+      bool const len_ok = (t->type == TUH_ZERO_TEST_SOURCE) ? (xferred_bytes > 0) : (xferred_bytes == t->xfer_len);
+      bool const valid = success && len_ok &&
+                         zero_pattern_check(t->pattern, p->rx_buf[slot], xferred_bytes, p->mps_in);
+
+      xfer_record(p, p->t_submit[slot], success ? xferred_bytes : 0, valid);
+      if ( !valid )
+      {
+        TU_LOG_DRV("ZERO[%u] invalid IN data, %u bytes\r\n", get_idx(p), (unsigned) xferred_bytes);
+      }
+    }
+  }else
+  {
+    p->out_busy = false;
+    if ( p->stage != TEST_RUN ) return true;
+
+    // zero length packet terminating previous loopback transfer
+    if ( p->out_zlp )
+    {
+      p->out_zlp = false;
+      if ( fatal ) test_stop(p, event);
+    }else
+    {
+      uint8_t const slot = (uint8_t) (p->out_done % t->queue_depth);
+      p->out_done++;
+
+      if ( fatal )
+      {
+        test_stop(p, event);
+      }
+      else if ( t->type == TUH_ZERO_TEST_SINK )
+      {
+        xfer_record(p, p->t_submit[slot], success ? xferred_bytes : 0, success);
+      }
+      else if ( 0 == (t->xfer_len % p->mps_out) )
+      {
+        // device may expect more data otherwise, it echoes the packet if its buffer was already full
+        submit_zlp(p);
+      }
+    }
+  }
+
+  submit_out(p);
+  submit_in(p);
+  test_check_done(p);
+
+  return true;
+}
+
+void zeroh_close(uint8_t daddr)
+{
+  for(uint8_t i=0; i<CFG_TUH_ZERO; i++)
+  {
+    zeroh_interface_t* p = &_zeroh_itf[i];
+    if ( p->daddr != daddr ) continue;
+
+    TU_LOG_DRV("  ZEROh close addr = %u index = %u\r\n", daddr, i);
+
+    bool const mounted = p->mounted;
+    p->daddr   = 0;
+    p->mounted = false;
+    p->stage   = TEST_IDLE;
+    p->ep_in   = p->ep_out = 0;
+
+    if ( mounted && tuh_zero_umount_cb ) tuh_zero_umount_cb(i);
+  }
+}
+
+#endif
@@ -0,0 +1,162 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#ifndef _TUSB_ZERO_HOST_H_
+#define _TUSB_ZERO_HOST_H_
+
+#include "common/tusb_common.h"
+#include "zero.h"
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+//--------------------------------------------------------------------+
+// Class Driver Configuration
+//--------------------------------------------------------------------+
+
+// Buffer size of each queued transfer, limits test transfer length
+#ifndef CFG_TUH_ZERO_BUFSIZE
+#define CFG_TUH_ZERO_BUFSIZE       (TUH_OPT_HIGH_SPEED ? 4096 : 1024)
+#endif
+
+// Max number of queued transfers per test. Only one transfer per endpoint is in flight at a time,
+// next one is submitted from completion of the previous before its data is verified. Loopback
+// writes up to queue depth transfers ahead of reading them back
+#ifndef CFG_TUH_ZERO_QUEUE_DEPTH
+#define CFG_TUH_ZERO_QUEUE_DEPTH   2
+#endif
+
+//--------------------------------------------------------------------+
+// Test parameters and result
+//--------------------------------------------------------------------+
+
+typedef enum {
+  TUH_ZERO_TEST_SOURCE = 0, // IN transfers from source/sink interface, data is verified by host
+  TUH_ZERO_TEST_SINK,       // OUT transfers to source/sink interface, data is verified by device
+  TUH_ZERO_TEST_LOOPBACK,   // OUT transfers to loopback interface and read back, data is verified by host
+} tuh_zero_test_type_t;
+
+typedef struct {
+  uint8_t  type;        // tuh_zero_test_type_t
+  uint8_t  alt;         // source/sink alternate setting i.e transfer type, ignored by loopback
+  uint8_t  pattern;     // zero_pattern_t
+  uint8_t  queue_depth; // 1 .. CFG_TUH_ZERO_QUEUE_DEPTH
+  uint16_t xfer_len;    // bytes per transfer, limited to one packet for isochronous
+  uint32_t count;       // number of transfers
+} tuh_zero_test_t;
+
+// Latency histogram: 4 buckets per power of 2 microseconds, up to ~8 seconds
+#define TUH_ZERO_LATENCY_BUCKETS   88
+
+typedef struct {
+  xfer_result_t status; // XFER_RESULT_SUCCESS unless a transfer or request failed
+  uint32_t count;       // completed transfers
+  uint32_t errors;      // transfers failed to verify on host
+  uint32_t dev_errors;  // transfers failed to verify on device
+  uint64_t bytes;
+  uint32_t elapsed_us;  // from first submitted to last completed transfer
+
+  // transfer latency: submit to completion, or OUT submit to IN completion for loopback
+  uint32_t lat_min_us;
+  uint32_t lat_max_us;
+  uint32_t lat_avg_us;
+  uint32_t lat_p50_us;  // percentiles are upper bound of their histogram bucket
+  uint32_t lat_p90_us;
+  uint32_t lat_p99_us;
+} tuh_zero_result_t;
+
+//--------------------------------------------------------------------+
+// Application API
+//--------------------------------------------------------------------+
+
+// Get index of interface, TUSB_INDEX_INVALID_8 if not mounted
+uint8_t tuh_zero_itf_get_index(uint8_t daddr, uint8_t itf_num);
+
+bool    tuh_zero_mounted(uint8_t idx);
+
+// ZERO_PROTOCOL_SRC_SINK or ZERO_PROTOCOL_LOOPBACK
+uint8_t tuh_zero_protocol(uint8_t idx);
+
+// Number of alternate settings of source/sink interface
+uint8_t tuh_zero_alt_count(uint8_t idx);
+
+// Test is running
+bool    tuh_zero_busy(uint8_t idx);
+
+// Start test: select alternate setting and set device parameters if needed, clear device statistics,
+// then run transfers. tuh_zero_test_complete_cb() is invoked when done.
+// Changing alternate setting requires host controller support for closing endpoints (hcd_edpt_close),
+// test is rejected otherwise. Interfaces bound by tuh_zero_match_cb() are not sent any class request:
+// pattern and length must match the device configuration, device errors are not reported
+bool    tuh_zero_test_start(uint8_t idx, tuh_zero_test_t const* test);
+
+// Result of last test
+bool    tuh_zero_result(uint8_t idx, tuh_zero_result_t* result);
+
+// Latency percentile (0-100) of last test in microseconds
+uint32_t tuh_zero_latency_percentile(uint8_t idx, uint8_t percent);
+
+// Throughput in KB/s (1000 bytes)
+TU_ATTR_ALWAYS_INLINE static inline
+uint32_t tuh_zero_result_kBps(tuh_zero_result_t const* result)
+{
+  return result->elapsed_us ? (uint32_t) ((result->bytes * 1000u) / result->elapsed_us) : 0;
+}
+
+//--------------------------------------------------------------------+
+// Application Callback API (weak is optional)
+//--------------------------------------------------------------------+
+
+// Invoked for interfaces not implementing this class, to test other devices e.g Linux g_zero (0525:a4a0)
+// whose source/sink and loopback interfaces have no class code. Application can check tuh_vid_pid_get() or the
+// interface descriptor. Return ZERO_PROTOCOL_SRC_SINK or ZERO_PROTOCOL_LOOPBACK to bind, 0 to skip
+TU_ATTR_WEAK uint8_t tuh_zero_match_cb(uint8_t daddr, tusb_desc_interface_t const* desc_itf);
+
+// Invoked when an interface is mounted/unmounted
+TU_ATTR_WEAK void tuh_zero_mount_cb(uint8_t idx);
+TU_ATTR_WEAK void tuh_zero_umount_cb(uint8_t idx);
+
+// Invoked when test is complete
+TU_ATTR_WEAK void tuh_zero_test_complete_cb(uint8_t idx, tuh_zero_result_t const* result);
+
+// Microsecond time source for throughput and latency. Without it only counts and errors are reported
+TU_ATTR_WEAK uint32_t tuh_zero_time_us_cb(void);
+
+//--------------------------------------------------------------------+
+// Internal Class Driver API
+//--------------------------------------------------------------------+
+void zeroh_init       (void);
+bool zeroh_open       (uint8_t rhport, uint8_t dev_addr, tusb_desc_interface_t const *itf_desc, uint16_t max_len);
+bool zeroh_set_config (uint8_t dev_addr, uint8_t itf_num);
+bool zeroh_xfer_cb    (uint8_t dev_addr, uint8_t ep_addr, xfer_result_t event, uint32_t xferred_bytes);
+void zeroh_close      (uint8_t dev_addr);
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif /* _TUSB_ZERO_HOST_H_ */
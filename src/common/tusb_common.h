@@ -57,6 +57,29 @@
 // Generate a mask with bit from high (31) to low (0) set, e.g TU_GENMASK(3, 0) = 0b1111
 #define TU_GENMASK(h, l)      ( (UINT32_MAX << (l)) & (UINT32_MAX >> (31 - (h))) )
 
+// Round up buffer size to multiple of D-Cache line, e.g for buffer used with cache maintenance
+#define TU_DCACHE_ALIGNED_SIZE(_size) \
+  ((((_size) + CFG_TUSB_MEM_DCACHE_LINE_SIZE - 1) / CFG_TUSB_MEM_DCACHE_LINE_SIZE) * CFG_TUSB_MEM_DCACHE_LINE_SIZE)
+
+// Device transfer buffer size, padded to whole cache lines when CFG_TUD_MEM_DCACHE_ENABLE is set since
+// invalidating OUT buffer would otherwise discard neighbor variables sharing its first/last line
+#define TUD_EPBUF_SIZE(_size)   (CFG_TUD_MEM_DCACHE_ENABLE ? TU_DCACHE_ALIGNED_SIZE(_size) : (_size))
+
+// Declare device transfer buffer as struct member, aligned with CFG_TUD_MEM_ALIGN and padded with
+// TUD_EPBUF_SIZE(). sizeof(_name) is still _size
+#define TUD_EPBUF_DEF(_name, _size) \
+  union { \
+    CFG_TUD_MEM_ALIGN uint8_t _name[_size]; \
+    uint8_t _name##_dcache_padding[TUD_EPBUF_SIZE(_size)]; \
+  }
+
+// Same as TUD_EPBUF_DEF() for a typed transfer buffer e.g a protocol wrapper
+#define TUD_EPBUF_TYPE_DEF(_type, _name) \
+  union { \
+    CFG_TUD_MEM_ALIGN _type _name; \
+    uint8_t _name##_dcache_padding[TUD_EPBUF_SIZE(sizeof(_type))]; \
+  }
+
 //--------------------------------------------------------------------+
 // Includes
 //--------------------------------------------------------------------+
@@ -195,6 +218,20 @@ static inline bool tu_is_power_of_two(uint32_t value)
    return (value != 0) && ((value & (value - 1)) == 0);
 }
 
+// Count trailing zeros i.e position of the lowest set bit. Value must not be zero
+TU_ATTR_ALWAYS_INLINE static inline uint8_t tu_ctz32(uint32_t value)
+{
+#if defined(__GNUC__)
+  return (uint8_t) __builtin_ctz(value);
+#elif defined(__ICCARM__)
+  return (uint8_t) __iar_builtin_CLZ(__iar_builtin_RBIT(value));
+#else
+  uint8_t result = 0;
+  while ( !(value & 1u) ) { value >>= 1; result++; }
+  return result;
+#endif
+}
+
 //------------- Unaligned Access -------------//
 #if TUP_ARCH_STRICT_ALIGN
 
@@ -282,6 +319,19 @@ TU_ATTR_ALWAYS_INLINE static inline void tu_unaligned_write16(void *mem, uint16_
 
 #endif
 
+//------------- Checksum -------------//
+
+// Copy len bytes and add them to the Internet (ones' complement) partial sum in the same pass.
+// Sum is kept in memory byte order, partial sums can be chained as long as every segment but the last
+// has even length. Use tu_csum_fold() to get the final 16-bit sum.
+uint32_t tu_csum_copy(void* dst, void const* src, uint32_t len, uint32_t sum);
+
+TU_ATTR_ALWAYS_INLINE static inline uint16_t tu_csum_fold(uint32_t sum) {
+  sum = (sum & 0xffffu) + (sum >> 16);
+  sum = (sum & 0xffffu) + (sum >> 16);
+  return (uint16_t) sum;
+}
+
 // To be removed
 //------------- Binary constant -------------//
 #if defined(__GNUC__) && !defined(__CC_ARM)
@@ -55,6 +55,21 @@ TU_ATTR_ALWAYS_INLINE static inline void _ff_unlock(osal_mutex_t mutex)
 
 #endif
 
+#if CFG_TUSB_MULTICORE
+
+// Single producer single consumer on different cores: each index is only written by its owner.
+// Index is published with release after buffer access and read with acquire before buffer access,
+// so that the other core never sees an index ahead of the data (or free space) it describes.
+#define _ff_idx_load(_idx)          __atomic_load_n(&(_idx), __ATOMIC_ACQUIRE)
+#define _ff_idx_store(_idx, _val)   __atomic_store_n(&(_idx), (_val), __ATOMIC_RELEASE)
+
+#else
+
+#define _ff_idx_load(_idx)          (_idx)
+#define _ff_idx_store(_idx, _val)   ((_idx) = (_val))
+
+#endif
+
 /** \enum tu_fifo_copy_mode_t
  * \brief Write modes intended to allow special read and write functions to be able to
  *        copy data to and from USB hardware FIFOs as needed for e.g. STM32s and others
@@ -404,7 +419,7 @@ uint16_t _ff_correct_read_index(tu_fifo_t* f, uint16_t wr_idx)
     rd_idx = wr_idx + f->depth;
   }
 
-  f->rd_idx = rd_idx;
+  _ff_idx_store(f->rd_idx, rd_idx);
 
   return rd_idx;
 }
@@ -466,8 +481,8 @@ static uint16_t _tu_fifo_write_n(tu_fifo_t* f, const void * data, uint16_t n, tu
 
   _ff_lock(f->mutex_wr);
 
-  uint16_t wr_idx = f->wr_idx;
-  uint16_t rd_idx = f->rd_idx;
+  uint16_t wr_idx = _ff_idx_load(f->wr_idx);
+  uint16_t rd_idx = _ff_idx_load(f->rd_idx);
 
   uint8_t const* buf8 = (uint8_t const*) data;
 
@@ -537,7 +552,7 @@ static uint16_t _tu_fifo_write_n(tu_fifo_t* f, const void * data, uint16_t n, tu
     _ff_push_n(f, buf8, n, wr_ptr, copy_mode);
 
     // Advance index
-    f->wr_idx = advance_index(f->depth, wr_idx, n);
+    _ff_idx_store(f->wr_idx, advance_index(f->depth, wr_idx, n));
 
     TU_LOG(TU_FIFO_DBG, "\tnew_wr = %u\r\n", f->wr_idx);
   }
@@ -553,10 +568,10 @@ static uint16_t _tu_fifo_read_n(tu_fifo_t* f, void * buffer, uint16_t n, tu_fifo
 
   // Peek the data
   // f->rd_idx might get modified in case of an overflow so we can not use a local variable
-  n = _tu_fifo_peek_n(f, buffer, n, f->wr_idx, f->rd_idx, copy_mode);
+  n = _tu_fifo_peek_n(f, buffer, n, _ff_idx_load(f->wr_idx), _ff_idx_load(f->rd_idx), copy_mode);
 
   // Advance read pointer
-  f->rd_idx = advance_index(f->depth, f->rd_idx, n);
+  _ff_idx_store(f->rd_idx, advance_index(f->depth, _ff_idx_load(f->rd_idx), n));
 
   _ff_unlock(f->mutex_rd);
   return n;
@@ -583,7 +598,7 @@ static uint16_t _tu_fifo_read_n(tu_fifo_t* f, void * buffer, uint16_t n, tu_fifo
 /******************************************************************************/
 uint16_t tu_fifo_count(tu_fifo_t* f)
 {
-  return tu_min16(_ff_count(f->depth, f->wr_idx, f->rd_idx), f->depth);
+  return tu_min16(_ff_count(f->depth, _ff_idx_load(f->wr_idx), _ff_idx_load(f->rd_idx)), f->depth);
 }
 
 /******************************************************************************/
@@ -601,7 +616,7 @@ uint16_t tu_fifo_count(tu_fifo_t* f)
 /******************************************************************************/
 bool tu_fifo_empty(tu_fifo_t* f)
 {
-  return f->wr_idx == f->rd_idx;
+  return _ff_idx_load(f->wr_idx) == _ff_idx_load(f->rd_idx);
 }
 
 /******************************************************************************/
@@ -619,7 +634,7 @@ bool tu_fifo_empty(tu_fifo_t* f)
 /******************************************************************************/
 bool tu_fifo_full(tu_fifo_t* f)
 {
-  return _ff_count(f->depth, f->wr_idx, f->rd_idx) >= f->depth;
+  return _ff_count(f->depth, _ff_idx_load(f->wr_idx), _ff_idx_load(f->rd_idx)) >= f->depth;
 }
 
 /******************************************************************************/
@@ -637,7 +652,7 @@ bool tu_fifo_full(tu_fifo_t* f)
 /******************************************************************************/
 uint16_t tu_fifo_remaining(tu_fifo_t* f)
 {
-  return _ff_remaining(f->depth, f->wr_idx, f->rd_idx);
+  return _ff_remaining(f->depth, _ff_idx_load(f->wr_idx), _ff_idx_load(f->rd_idx));
 }
 
 /******************************************************************************/
@@ -663,14 +678,14 @@ uint16_t tu_fifo_remaining(tu_fifo_t* f)
 /******************************************************************************/
 bool tu_fifo_overflowed(tu_fifo_t* f)
 {
-  return _ff_count(f->depth, f->wr_idx, f->rd_idx) > f->depth;
+  return _ff_count(f->depth, _ff_idx_load(f->wr_idx), _ff_idx_load(f->rd_idx)) > f->depth;
 }
 
 // Only use in case tu_fifo_overflow() returned true!
 void tu_fifo_correct_read_pointer(tu_fifo_t* f)
 {
   _ff_lock(f->mutex_rd);
-  _ff_correct_read_index(f, f->wr_idx);
+  _ff_correct_read_index(f, _ff_idx_load(f->wr_idx));
   _ff_unlock(f->mutex_rd);
 }
 
@@ -696,10 +711,10 @@ bool tu_fifo_read(tu_fifo_t* f, void * buffer)
 
   // Peek the data
   // f->rd_idx might get modified in case of an overflow so we can not use a local variable
-  bool ret = _tu_fifo_peek(f, buffer, f->wr_idx, f->rd_idx);
+  bool ret = _tu_fifo_peek(f, buffer, _ff_idx_load(f->wr_idx), _ff_idx_load(f->rd_idx));
 
   // Advance pointer
-  f->rd_idx = advance_index(f->depth, f->rd_idx, ret);
+  _ff_idx_store(f->rd_idx, advance_index(f->depth, _ff_idx_load(f->rd_idx), ret));
 
   _ff_unlock(f->mutex_rd);
   return ret;
@@ -747,7 +762,7 @@ uint16_t tu_fifo_read_n_const_addr_full_words(tu_fifo_t* f, void * buffer, uint1
 bool tu_fifo_peek(tu_fifo_t* f, void * p_buffer)
 {
   _ff_lock(f->mutex_rd);
-  bool ret = _tu_fifo_peek(f, p_buffer, f->wr_idx, f->rd_idx);
+  bool ret = _tu_fifo_peek(f, p_buffer, _ff_idx_load(f->wr_idx), _ff_idx_load(f->rd_idx));
   _ff_unlock(f->mutex_rd);
   return ret;
 }
@@ -770,7 +785,7 @@ bool tu_fifo_peek(tu_fifo_t* f, void * p_buffer)
 uint16_t tu_fifo_peek_n(tu_fifo_t* f, void * p_buffer, uint16_t n)
 {
   _ff_lock(f->mutex_rd);
-  uint16_t ret = _tu_fifo_peek_n(f, p_buffer, n, f->wr_idx, f->rd_idx, TU_FIFO_COPY_INC);
+  uint16_t ret = _tu_fifo_peek_n(f, p_buffer, n, _ff_idx_load(f->wr_idx), _ff_idx_load(f->rd_idx), TU_FIFO_COPY_INC);
   _ff_unlock(f->mutex_rd);
   return ret;
 }
@@ -796,7 +811,7 @@ bool tu_fifo_write(tu_fifo_t* f, const void * data)
   _ff_lock(f->mutex_wr);
 
   bool ret;
-  uint16_t const wr_idx = f->wr_idx;
+  uint16_t const wr_idx = _ff_idx_load(f->wr_idx);
 
   if ( tu_fifo_full(f) && !f->overwritable )
   {
@@ -809,7 +824,7 @@ bool tu_fifo_write(tu_fifo_t* f, const void * data)
     _ff_push(f, data, wr_ptr);
 
     // Advance pointer
-    f->wr_idx = advance_index(f->depth, wr_idx, 1);
+    _ff_idx_store(f->wr_idx, advance_index(f->depth, wr_idx, 1));
 
     ret = true;
   }
@@ -920,7 +935,7 @@ bool tu_fifo_set_overwritable(tu_fifo_t *f, bool overwritable)
 /******************************************************************************/
 void tu_fifo_advance_write_pointer(tu_fifo_t *f, uint16_t n)
 {
-  f->wr_idx = advance_index(f->depth, f->wr_idx, n);
+  _ff_idx_store(f->wr_idx, advance_index(f->depth, _ff_idx_load(f->wr_idx), n));
 }
 
 /******************************************************************************/
@@ -941,7 +956,34 @@ void tu_fifo_advance_write_pointer(tu_fifo_t *f, uint16_t n)
 /******************************************************************************/
 void tu_fifo_advance_read_pointer(tu_fifo_t *f, uint16_t n)
 {
-  f->rd_idx = advance_index(f->depth, f->rd_idx, n);
+  _ff_idx_store(f->rd_idx, advance_index(f->depth, _ff_idx_load(f->rd_idx), n));
+}
+
+/******************************************************************************/
+/*!
+    @brief Discard, from the consumer side, all data written before the producer
+    took a snapshot of its write index with tu_fifo_write_index() e.g on bus reset.
+    Data written after the snapshot is kept. Only the read index is modified,
+    therefore it is safe while the producer runs on another core.
+
+    @param[in]  f
+                Pointer to the FIFO buffer to manipulate
+    @param[in]  wr_idx
+                Write index snapshot taken by producer
+
+    @returns Number of items discarded
+ */
+/******************************************************************************/
+uint16_t tu_fifo_discard_until(tu_fifo_t *f, uint16_t wr_idx)
+{
+  uint16_t const rd_idx = _ff_idx_load(f->rd_idx);
+  uint16_t const n      = _ff_count(f->depth, wr_idx, rd_idx);
+
+  // read index is already past snapshot
+  if ( n > _ff_count(f->depth, _ff_idx_load(f->wr_idx), rd_idx) ) return 0;
+
+  _ff_idx_store(f->rd_idx, advance_index(f->depth, rd_idx, n));
+  return n;
 }
 
 /******************************************************************************/
@@ -962,8 +1004,8 @@ void tu_fifo_advance_read_pointer(tu_fifo_t *f, uint16_t n)
 void tu_fifo_get_read_info(tu_fifo_t *f, tu_fifo_buffer_info_t *info)
 {
   // Operate on temporary values in case they change in between
-  uint16_t wr_idx = f->wr_idx;
-  uint16_t rd_idx = f->rd_idx;
+  uint16_t wr_idx = _ff_idx_load(f->wr_idx);
+  uint16_t rd_idx = _ff_idx_load(f->rd_idx);
 
   uint16_t cnt = _ff_count(f->depth, wr_idx, rd_idx);
 
@@ -1029,8 +1071,8 @@ void tu_fifo_get_read_info(tu_fifo_t *f, tu_fifo_buffer_info_t *info)
 /******************************************************************************/
 void tu_fifo_get_write_info(tu_fifo_t *f, tu_fifo_buffer_info_t *info)
 {
-  uint16_t wr_idx = f->wr_idx;
-  uint16_t rd_idx = f->rd_idx;
+  uint16_t wr_idx = _ff_idx_load(f->wr_idx);
+  uint16_t rd_idx = _ff_idx_load(f->rd_idx);
   uint16_t remain = _ff_remaining(f->depth, wr_idx, rd_idx);
 
   if (remain == 0)
@@ -1063,3 +1105,117 @@ void tu_fifo_get_write_info(tu_fifo_t *f, tu_fifo_buffer_info_t *info)
     info->ptr_wrap = f->buffer;              // Always start of buffer
   }
 }
+
+//--------------------------------------------------------------------+
+// Asynchronous copy
+//--------------------------------------------------------------------+
+
+static tu_fifo_copy_engine_t const* _ff_copy_engine = NULL;
+
+void tu_fifo_copy_engine_set(tu_fifo_copy_engine_t const* engine)
+{
+  _ff_copy_engine = engine;
+}
+
+void tu_fifo_copy_done(void* ctx)
+{
+  tu_fifo_async_t* op = (tu_fifo_async_t*) ctx;
+
+  // wait for all segments
+  if ( --op->pending ) return;
+
+  // Only now make data (write) or space (read) visible to the other side
+  if ( op->is_write )
+  {
+    tu_fifo_advance_write_pointer(op->f, op->count);
+  }else
+  {
+    tu_fifo_advance_read_pointer(op->f, op->count);
+  }
+
+  if ( op->complete_cb ) op->complete_cb(op);
+}
+
+static void _ff_copy_async(void* dst, void const* src, uint16_t len, tu_fifo_async_t* op)
+{
+  if ( _ff_copy_engine )
+  {
+    _ff_copy_engine->copy(dst, src, len, op);
+  }else
+  {
+    memcpy(dst, src, len);
+    tu_fifo_copy_done(op);
+  }
+}
+
+// Copy n items between fifo at ptr and linear app buffer, split at wrap boundary
+static void _ff_xfer_async(tu_fifo_async_t* op, uint8_t* app_buf, uint16_t n, uint16_t ptr)
+{
+  tu_fifo_t* f = op->f;
+
+  uint16_t const lin_count  = tu_min16(n, (uint16_t) (f->depth - ptr));
+  uint16_t const lin_bytes  = (uint16_t) (lin_count * f->item_size);
+  uint16_t const wrap_bytes = (uint16_t) ((n - lin_count) * f->item_size);
+
+  uint8_t* ff_buf = f->buffer + (ptr * f->item_size);
+
+  // set number of segments before submitting any since completion can happen right away
+  op->pending = (uint8_t) (wrap_bytes ? 2 : 1);
+
+  if ( op->is_write )
+  {
+    _ff_copy_async(ff_buf, app_buf, lin_bytes, op);
+    if ( wrap_bytes ) _ff_copy_async(f->buffer, app_buf + lin_bytes, wrap_bytes, op);
+  }else
+  {
+    _ff_copy_async(app_buf, ff_buf, lin_bytes, op);
+    if ( wrap_bytes ) _ff_copy_async(app_buf + lin_bytes, f->buffer, wrap_bytes, op);
+  }
+}
+
+uint16_t tu_fifo_write_n_async(tu_fifo_t* f, void const * data, uint16_t n, tu_fifo_async_t* op)
+{
+  _ff_lock(f->mutex_wr);
+
+  uint16_t const wr_idx = _ff_idx_load(f->wr_idx);
+  n = tu_min16(n, _ff_remaining(f->depth, wr_idx, _ff_idx_load(f->rd_idx)));
+
+  _ff_unlock(f->mutex_wr);
+
+  if ( n == 0 ) return 0;
+
+  op->f        = f;
+  op->count    = n;
+  op->is_write = true;
+  _ff_xfer_async(op, (uint8_t*) (uintptr_t) data, n, idx2ptr(f->depth, wr_idx));
+
+  return n;
+}
+
+uint16_t tu_fifo_read_n_async(tu_fifo_t* f, void * buffer, uint16_t n, tu_fifo_async_t* op)
+{
+  _ff_lock(f->mutex_rd);
+
+  uint16_t const wr_idx = _ff_idx_load(f->wr_idx);
+  uint16_t rd_idx = _ff_idx_load(f->rd_idx);
+
+  uint16_t cnt = _ff_count(f->depth, wr_idx, rd_idx);
+  if ( cnt > f->depth )
+  {
+    // overflowed, correct read index
+    rd_idx = _ff_correct_read_index(f, wr_idx);
+    cnt = f->depth;
+  }
+  n = tu_min16(n, cnt);
+
+  _ff_unlock(f->mutex_rd);
+
+  if ( n == 0 ) return 0;
+
+  op->f        = f;
+  op->count    = n;
+  op->is_write = false;
+  _ff_xfer_async(op, (uint8_t*) buffer, n, idx2ptr(f->depth, rd_idx));
+
+  return n;
+}
@@ -40,6 +40,9 @@ extern "C" {
 // Also, this FIFO is ready to be used in combination with a DMA as the write and
 // read pointers can be updated from within a DMA ISR. Overflows are detectable
 // within a certain number (see tu_fifo_overflow()).
+// With CFG_TUSB_MULTICORE, indices are accessed with acquire/release ordering so that
+// one producer and one consumer can run on different cores without lock. Functions that
+// modify both indices (clear, set_overwritable) and overwritable fifos are not covered.
 
 #include "common/tusb_common.h"
 #include "osal/osal.h"
@@ -192,12 +195,65 @@ uint16_t tu_fifo_depth(tu_fifo_t* f)
 void tu_fifo_advance_write_pointer(tu_fifo_t *f, uint16_t n);
 void tu_fifo_advance_read_pointer (tu_fifo_t *f, uint16_t n);
 
+// Producer takes a snapshot of its write index, consumer later discards everything written before it
+TU_ATTR_ALWAYS_INLINE static inline
+uint16_t tu_fifo_write_index(tu_fifo_t* f)
+{
+  return f->wr_idx;
+}
+
+uint16_t tu_fifo_discard_until(tu_fifo_t *f, uint16_t wr_idx);
+
 // If you want to read/write from/to the FIFO by use of a DMA, you may need to conduct two copies
 // to handle a possible wrapping part. These functions deliver a pointer to start
 // reading/writing from/to and a valid linear length along which no wrap occurs.
 void tu_fifo_get_read_info (tu_fifo_t *f, tu_fifo_buffer_info_t *info);
 void tu_fifo_get_write_info(tu_fifo_t *f, tu_fifo_buffer_info_t *info);
 
+//--------------------------------------------------------------------+
+// Asynchronous copy with pluggable copy engine
+//--------------------------------------------------------------------+
+
+// Copy engine to offload copies e.g to a DMA memcpy channel. copy() starts copying len bytes from src to dst
+// and must call tu_fifo_copy_done(ctx) once complete, either in ISR or before returning (software fallback).
+// Requests must be completed in the same order as they are submitted.
+typedef struct
+{
+  void (*copy)(void* dst, void const* src, uint16_t len, void* ctx);
+} tu_fifo_copy_engine_t;
+
+typedef struct tu_fifo_async_s tu_fifo_async_t;
+typedef void (*tu_fifo_async_cb_t)(tu_fifo_async_t* op);
+
+// Asynchronous operation, owned by caller and must stay valid until complete_cb is invoked
+struct tu_fifo_async_s
+{
+  tu_fifo_async_cb_t complete_cb; // invoked when copy is complete and fifo index is advanced
+  void* user_data;
+
+  // internal
+  tu_fifo_t* f;
+  uint16_t count;          // number of items
+  bool is_write;
+  volatile uint8_t pending; // number of outstanding segments
+};
+
+// Set copy engine used by asynchronous operations, NULL to use memcpy() synchronously
+void tu_fifo_copy_engine_set(tu_fifo_copy_engine_t const* engine);
+
+// Called by copy engine when a copy request is complete
+void tu_fifo_copy_done(void* ctx);
+
+// Write up to n items (limited to remaining space), write pointer is only advanced when copy is complete
+// so that reader never sees partially copied data. Return number of items to be written.
+// Note: there must be at most one asynchronous write in flight and no other write in the meantime.
+uint16_t tu_fifo_write_n_async(tu_fifo_t* f, void const * data, uint16_t n, tu_fifo_async_t* op);
+
+// Read up to n items, read pointer is only advanced when copy is complete so that writer
+// never overwrites data being copied. Return number of items to be read.
+// Note: there must be at most one asynchronous read in flight and no other read in the meantime.
+uint16_t tu_fifo_read_n_async(tu_fifo_t* f, void * buffer, uint16_t n, tu_fifo_async_t* op);
+
 
 #ifdef __cplusplus
 }
@@ -403,6 +403,26 @@
   #define TUP_RHPORT_HIGHSPEED    0
 #endif
 
+// DCD supports high-bandwidth ISO endpoint (up to 3 transactions per microframe).
+// Note: ChipIdea dQH Mult field is only valid for ISO, high-bandwidth interrupt is not supported
+#ifndef TUP_DCD_EDPT_ISO_HIGH_BANDWIDTH
+  #if defined(TUP_USBIP_CHIPIDEA_HS)
+    #define TUP_DCD_EDPT_ISO_HIGH_BANDWIDTH   1
+  #else
+    #define TUP_DCD_EDPT_ISO_HIGH_BANDWIDTH   0
+  #endif
+#endif
+
+// DCD needs packet buffer of ISO endpoints allocated once with dcd_edpt_iso_alloc() when interface is opened,
+// alternate settings then only (re)configure it with dcd_edpt_iso_activate() instead of dcd_edpt_open()
+#ifndef TUP_DCD_EDPT_ISO_ALLOC
+  #if defined(TUP_USBIP_FSDEV)
+    #define TUP_DCD_EDPT_ISO_ALLOC   1
+  #else
+    #define TUP_DCD_EDPT_ISO_ALLOC   0
+  #endif
+#endif
+
 // fast function, normally mean placing function in SRAM
 #ifndef TU_ATTR_FAST_FUNC
   #define TU_ATTR_FAST_FUNC
@@ -34,13 +34,20 @@
  extern "C" {
 #endif
 
-typedef struct TU_ATTR_PACKED
+typedef union
 {
-  volatile uint8_t busy    : 1;
-  volatile uint8_t stalled : 1;
-  volatile uint8_t claimed : 1;
+  struct TU_ATTR_PACKED
+  {
+    volatile uint8_t busy    : 1;
+    volatile uint8_t stalled : 1;
+    volatile uint8_t claimed : 1;
+  };
+
+  volatile uint8_t value; // all states as a whole, used for atomic claim/release
 }tu_edpt_state_t;
 
+TU_VERIFY_STATIC(sizeof(tu_edpt_state_t) == 1, "size is not correct");
+
 typedef struct {
   bool is_host; // host or device most
   union {
@@ -77,10 +84,10 @@ void tu_edpt_bind_driver(uint8_t ep2drv[][2], tusb_desc_interface_t const* p_des
 // Calculate total length of n interfaces (depending on IAD)
 uint16_t tu_desc_get_interface_total_len(tusb_desc_interface_t const* desc_itf, uint8_t itf_count, uint16_t max_len);
 
-// Claim an endpoint with provided mutex
+// Claim an endpoint, using compare-and-swap if supported by the core, otherwise with provided mutex
 bool tu_edpt_claim(tu_edpt_state_t* ep_state, osal_mutex_t mutex);
 
-// Release an endpoint with provided mutex
+// Release an endpoint, using compare-and-swap if supported by the core, otherwise with provided mutex
 bool tu_edpt_release(tu_edpt_state_t* ep_state, osal_mutex_t mutex);
 
 //--------------------------------------------------------------------+
@@ -76,8 +76,14 @@ enum
 
   TUSB_EPSIZE_ISO_FS_MAX = 1023,
   TUSB_EPSIZE_ISO_HS_MAX = 1024,
+
+  // High-bandwidth highspeed ISO/Interrupt endpoint can have up to 3 transactions per microframe
+  TUSB_EDPT_HIGH_BANDWIDTH_MULT_MAX = 3,
 };
 
+// wMaxPacketSize of high-bandwidth endpoint with _mult (1-3) transactions per microframe
+#define TUSB_EDPT_HIGH_BANDWIDTH_SIZE(_size, _mult)   ((_size) | (((_mult) - 1) << 11))
+
 /// Isochronous End Point Attributes
 typedef enum
 {
@@ -530,6 +536,18 @@ TU_ATTR_ALWAYS_INLINE static inline uint16_t tu_edpt_packet_size(tusb_desc_endpo
   return tu_le16toh(desc_ep->wMaxPacketSize) & TU_GENMASK(10, 0);
 }
 
+// Number of transactions per microframe (bit 12..11 of wMaxPacketSize + 1), more than 1 for high-bandwidth endpoint
+TU_ATTR_ALWAYS_INLINE static inline uint8_t tu_edpt_mult(tusb_desc_endpoint_t const* desc_ep)
+{
+  return (uint8_t) (((tu_le16toh(desc_ep->wMaxPacketSize) >> 11) & 0x03u) + 1u);
+}
+
+// Max bytes per service interval: packet size x transactions per microframe
+TU_ATTR_ALWAYS_INLINE static inline uint16_t tu_edpt_bytes_per_interval(tusb_desc_endpoint_t const* desc_ep)
+{
+  return (uint16_t) (tu_edpt_packet_size(desc_ep) * tu_edpt_mult(desc_ep));
+}
+
 #if CFG_TUSB_DEBUG
 TU_ATTR_ALWAYS_INLINE static inline const char *tu_edpt_dir_str(tusb_dir_t dir)
 {
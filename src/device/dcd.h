@@ -104,6 +104,9 @@ typedef struct TU_ATTR_ALIGNED(4)
 
 //--------------------------------------------------------------------+
 // Memory API
+// When CFG_TUD_MEM_DCACHE_ENABLE is set, usbd calls these for every usbd_edpt_xfer() buffer:
+// clean before IN, invalidate before and after OUT, also for usbd_edpt_xfer_fifo(). OUT buffers must
+// therefore be aligned and padded to CFG_TUSB_MEM_DCACHE_LINE_SIZE (see TUD_EPBUF_DEF, TUD_EPBUF_SIZE)
 //--------------------------------------------------------------------+
 
 // clean/flush data cache: write cache -> memory.
@@ -185,6 +188,8 @@ void dcd_edpt_clear_stall     (uint8_t rhport, uint8_t ep_addr);
 
 // Allocate packet buffer used by ISO endpoints
 // Some MCU need manual packet buffer allocation, we allocation largest size to avoid clustering
+// Note: DCD with TUP_DCD_EDPT_ISO_HIGH_BANDWIDTH must honor tu_edpt_mult() of ISO endpoint descriptor in
+// dcd_edpt_open()/dcd_edpt_iso_activate() and split transfer into up to 3 transactions per microframe
 TU_ATTR_WEAK bool dcd_edpt_iso_alloc(uint8_t rhport, uint8_t ep_addr, uint16_t largest_packet_size);
 
 // Configure and enable an ISO endpoint according to descriptor
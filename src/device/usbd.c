@@ -43,6 +43,17 @@
   #define CFG_TUD_TASK_QUEUE_SZ   16
 #endif
 
+// Record transfer complete into a per-endpoint slot and pending bitmap instead of the event queue.
+// Completion can never be dropped due to full queue and ISR cost is only a few stores.
+#ifndef CFG_TUD_XFER_EVENT_BITMAP
+  #define CFG_TUD_XFER_EVENT_BITMAP   0
+#endif
+
+// Max number of SOF scheduler callbacks registered by class drivers and application
+#ifndef CFG_TUD_SOF_SCHED_MAX
+  #define CFG_TUD_SOF_SCHED_MAX   4
+#endif
+
 //--------------------------------------------------------------------+
 // Device Data
 //--------------------------------------------------------------------+
@@ -75,6 +86,53 @@ typedef struct
 
 tu_static usbd_device_t _usbd_dev;
 
+// SOF scheduler entry, slot is free if cb is NULL
+typedef struct
+{
+  tud_sof_sched_cb_t cb;
+  void* param;
+  uint16_t interval;
+  uint16_t offset;
+  bool synced;         // next_frame is derived from frame number on the first SOF after added
+  uint32_t next_frame; // extended frame number of next invocation
+} usbd_sof_sched_t;
+
+tu_static usbd_sof_sched_t _usbd_sof_sched[CFG_TUD_SOF_SCHED_MAX];
+
+// Frame number reported by DCD extended to 32 bits, since most DCDs report the 11-bit SOF frame number
+tu_static uint32_t _usbd_sof_frame;
+tu_static uint16_t _usbd_sof_frame_last;
+tu_static bool _usbd_sof_frame_valid;
+
+// SOF interrupt is enabled as long as there is scheduler callback or legacy usbd_sof_enable() request
+tu_static uint8_t _usbd_sof_sched_count;
+tu_static bool _usbd_sof_requested;
+tu_static bool _usbd_sof_enabled;
+
+static void usbd_sof_sched_dispatch(uint8_t rhport, uint32_t frame_count);
+static void usbd_sof_update(void);
+
+#if CFG_TUD_XFER_TIMESTAMP
+// Number of SOF received and SOF count when last transfer of each endpoint completed, both updated in ISR
+tu_static volatile uint32_t _usbd_sof_clock;
+tu_static uint32_t _usbd_xfer_sof[CFG_TUD_ENDPPOINT_MAX][2];
+#endif
+
+#if CFG_TUD_MEM_DCACHE_ENABLE
+// Buffer of pending OUT transfer, invalidated again on completion since CPU may have speculatively
+// loaded its lines while DMA was in progress. Fifo transfer can have a second (wrapped) part
+typedef struct
+{
+  uint8_t* buf[2];
+  uint16_t len[2];
+} usbd_xfer_out_buf_t;
+
+tu_static usbd_xfer_out_buf_t _usbd_xfer_out_buf[CFG_TUD_ENDPPOINT_MAX];
+
+static void usbd_dcache_xfer_start(uint8_t epnum, uint8_t dir, uint8_t idx, uint8_t* buffer, uint16_t len);
+static void usbd_dcache_xfer_complete(uint8_t epnum, uint32_t xferred_bytes);
+#endif
+
 //--------------------------------------------------------------------+
 // Class Driver
 //--------------------------------------------------------------------+
@@ -87,6 +145,19 @@ tu_static usbd_device_t _usbd_dev;
 // Built-in class drivers
 tu_static usbd_class_driver_t const _usbd_driver[] =
 {
+  // first: claims only interfaces having an endpoint bound to a bridge channel
+  #if CFG_TUH_ENABLED && CFG_TUSB_BRIDGE
+  {
+    DRIVER_NAME("BRIDGE")
+    .init             = bridged_init,
+    .reset            = bridged_reset,
+    .open             = bridged_open,
+    .control_xfer_cb  = bridged_control_xfer_cb,
+    .xfer_cb          = bridged_xfer_cb,
+    .sof              = NULL
+  },
+  #endif
+
   #if CFG_TUD_CDC
   {
     DRIVER_NAME("CDC")
@@ -159,6 +230,19 @@ tu_static usbd_class_driver_t const _usbd_driver[] =
   },
   #endif
 
+  // before vendor driver which claims any vendor specific interface
+  #if CFG_TUD_ZERO
+  {
+    DRIVER_NAME("ZERO")
+    .init             = zerod_init,
+    .reset            = zerod_reset,
+    .open             = zerod_open,
+    .control_xfer_cb  = zerod_control_xfer_cb,
+    .xfer_cb          = zerod_xfer_cb,
+    .sof              = NULL
+  },
+  #endif
+
   #if CFG_TUD_VENDOR
   {
     DRIVER_NAME("VENDOR")
@@ -278,6 +362,44 @@ tu_static osal_queue_t _usbd_q;
   #define _usbd_mutex   NULL
 #endif
 
+#if CFG_TUD_XFER_EVENT_BITMAP
+TU_VERIFY_STATIC(CFG_TUD_ENDPPOINT_MAX <= 16, "pending bitmap only supports up to 16 endpoints");
+
+// Transfer result of an endpoint, valid while its pending bit is set
+typedef struct
+{
+  uint32_t len;
+  uint8_t  result;
+} usbd_xfer_slot_t;
+
+tu_static usbd_xfer_slot_t _usbd_xfer_slot[CFG_TUD_ENDPPOINT_MAX][2];
+
+// bit (2*epnum + dir) is set when endpoint has a completed transfer not yet processed by usbd task
+tu_static volatile uint32_t _usbd_xfer_pending;
+
+// a DCD_EVENT_XFER_COMPLETE marker is in the queue, pending bits are processed when it is popped
+tu_static volatile bool _usbd_xfer_marker;
+#endif
+
+#if CFG_TUSB_MULTICORE
+// Request from application core, pending flag is only set by application core and only cleared by
+// usbd task. Plain stores with full fences are used so that it also works without atomic
+// read-modify-write instructions e.g Cortex-M0+
+typedef struct
+{
+  osal_task_func_t func;
+  void* param;
+  volatile bool pending;
+} usbd_xcore_slot_t;
+
+tu_static usbd_xcore_slot_t _usbd_xcore[TU_MAX(USBD_XCORE_COUNT, 1)];
+
+// wake up event is already queued for usbd task (RTOS)
+tu_static volatile bool _usbd_xcore_wake;
+
+#define usbd_xcore_fence()    __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#endif
+
 
 //--------------------------------------------------------------------+
 // Prototypes
@@ -285,6 +407,7 @@ tu_static osal_queue_t _usbd_q;
 static bool process_control_request(uint8_t rhport, tusb_control_request_t const * p_request);
 static bool process_set_config(uint8_t rhport, uint8_t cfg_num);
 static bool process_get_descriptor(uint8_t rhport, tusb_control_request_t const * p_request);
+static void process_xfer_complete(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes);
 
 // from usbd_control.c
 void usbd_control_reset(void);
@@ -401,6 +524,26 @@ bool tud_init (uint8_t rhport)
   _usbd_q = osal_queue_create(&_usbd_qdef);
   TU_ASSERT(_usbd_q);
 
+#if CFG_TUD_XFER_EVENT_BITMAP
+  _usbd_xfer_pending = 0;
+  _usbd_xfer_marker = false;
+#endif
+
+#if CFG_TUSB_MULTICORE
+  tu_varclr(&_usbd_xcore);
+  _usbd_xcore_wake = false;
+#endif
+
+#if CFG_TUD_XFER_TIMESTAMP
+  _usbd_sof_clock = 0;
+#endif
+
+  tu_varclr(&_usbd_sof_sched);
+  _usbd_sof_sched_count = 0;
+  _usbd_sof_requested = false;
+  _usbd_sof_enabled = false;
+  _usbd_sof_frame_valid = false;
+
   // Get application driver if available
   if ( usbd_app_driver_get_cb )
   {
@@ -422,6 +565,11 @@ bool tud_init (uint8_t rhport)
   dcd_init(rhport);
   dcd_int_enable(rhport);
 
+#if CFG_TUD_XFER_TIMESTAMP
+  // SOF is always needed as clock
+  usbd_sof_update();
+#endif
+
   return true;
 }
 
@@ -450,9 +598,84 @@ bool tud_task_event_ready(void)
   // Skip if stack is not initialized
   if ( !tud_inited() ) return false;
 
+#if CFG_TUD_XFER_EVENT_BITMAP
+  if ( _usbd_xfer_pending ) return true;
+#endif
+
+#if CFG_TUSB_MULTICORE
+  for ( uint8_t i = 0; i < USBD_XCORE_COUNT; i++ )
+  {
+    if ( _usbd_xcore[i].pending ) return true;
+  }
+#endif
+
   return !osal_queue_empty(_usbd_q);
 }
 
+#if CFG_TUSB_MULTICORE
+// Process requests posted by application core
+static void process_xcore_pending(void)
+{
+  for ( uint8_t i = 0; i < USBD_XCORE_COUNT; i++ )
+  {
+    usbd_xcore_slot_t* p_slot = &_usbd_xcore[i];
+
+    if ( p_slot->pending )
+    {
+      // clear before processing, a request posted meanwhile will be processed next time
+      p_slot->pending = false;
+      usbd_xcore_fence();
+
+      p_slot->func(p_slot->param);
+    }
+  }
+}
+
+#if CFG_TUSB_OS != OPT_OS_NONE
+static void xcore_wake_func(void* param)
+{
+  (void) param;
+
+  // allow next wake up event to be queued, then pick up all requests posted so far
+  _usbd_xcore_wake = false;
+  usbd_xcore_fence();
+
+  process_xcore_pending();
+}
+#endif
+#endif
+
+#if CFG_TUD_XFER_EVENT_BITMAP
+// Process all completed transfers recorded in the pending bitmap. It is called when the marker queued
+// with the first pending bit is popped, so that completions keep their order with other events e.g a
+// transfer completed after a bus reset is not processed before the reset.
+static void process_xfer_pending(void)
+{
+  // take and clear pending bits, usbd_int_set() is used as mutex with DCD ISR
+  usbd_int_set(false);
+  uint32_t pending = _usbd_xfer_pending;
+  _usbd_xfer_pending = 0;
+  _usbd_xfer_marker = false;
+  usbd_int_set(true);
+
+  while ( pending )
+  {
+    uint8_t const bit     = tu_ctz32(pending);
+    uint8_t const epnum   = bit >> 1;
+    uint8_t const dir     = bit & 1u;
+    uint8_t const ep_addr = tu_edpt_addr(epnum, dir);
+
+    pending &= ~TU_BIT(bit);
+
+    // copy out result before invoking callback, since a new transfer on this endpoint can complete right away
+    usbd_xfer_slot_t const slot = _usbd_xfer_slot[epnum][dir];
+
+    TU_LOG_USBD("USBD Xfer Complete ");
+    process_xfer_complete(_usbd_rhport, ep_addr, (xfer_result_t) slot.result, slot.len);
+  }
+}
+#endif
+
 /* USB Device Driver task
  * This top level thread manages all device controller event and delegates events to class-specific drivers.
  * This should be called periodically within the mainloop or rtos thread.
@@ -473,14 +696,25 @@ bool tud_task_event_ready(void)
  */
 void tud_task_ext(uint32_t timeout_ms, bool in_isr)
 {
-  (void) in_isr; // not implemented yet
-
   // Skip if stack is not initialized
   if ( !tud_inited() ) return;
 
+  // Deferred execution in (software) interrupt: process queued events only, must not block
+  if ( in_isr ) timeout_ms = 0;
+
   // Loop until there is no more events in the queue
   while (1)
   {
+#if CFG_TUD_XFER_EVENT_BITMAP
+    // marker could not be queued since queue was full: all events queued before the pending bits
+    // are processed once the queue is empty
+    if ( _usbd_xfer_pending && !_usbd_xfer_marker && osal_queue_empty(_usbd_q) ) process_xfer_pending();
+#endif
+
+#if CFG_TUSB_MULTICORE
+    process_xcore_pending();
+#endif
+
     dcd_event_t event;
     if ( !osal_queue_receive(_usbd_q, &event, timeout_ms) ) return;
 
@@ -495,6 +729,13 @@ void tud_task_ext(uint32_t timeout_ms, bool in_isr)
         TU_LOG_USBD(": %s Speed\r\n", tu_str_speed[event.bus_reset.speed]);
         usbd_reset(event.rhport);
         _usbd_dev.speed = event.bus_reset.speed;
+
+        // DCD may disable SOF interrupt on bus reset (e.g dwc2), enable it again if still needed
+        if ( _usbd_sof_enabled )
+        {
+          _usbd_sof_enabled = false;
+          usbd_sof_update();
+        }
       break;
 
       case DCD_EVENT_UNPLUGGED:
@@ -530,31 +771,14 @@ void tud_task_ext(uint32_t timeout_ms, bool in_isr)
       break;
 
       case DCD_EVENT_XFER_COMPLETE:
-      {
-        // Invoke the class callback associated with the endpoint address
-        uint8_t const ep_addr = event.xfer_complete.ep_addr;
-        uint8_t const epnum   = tu_edpt_number(ep_addr);
-        uint8_t const ep_dir  = tu_edpt_dir(ep_addr);
-
-        TU_LOG_USBD("on EP %02X with %u bytes\r\n", ep_addr, (unsigned int) event.xfer_complete.len);
-
-        _usbd_dev.ep_status[epnum][ep_dir].busy = 0;
-        _usbd_dev.ep_status[epnum][ep_dir].claimed = 0;
-
-        if ( 0 == epnum )
-        {
-          usbd_control_xfer_cb(event.rhport, ep_addr, (xfer_result_t) event.xfer_complete.result, event.xfer_complete
-          .len);
-        }
-        else
-        {
-          usbd_class_driver_t const * driver = get_driver( _usbd_dev.ep2drv[epnum][ep_dir] );
-          TU_ASSERT(driver, );
-
-          TU_LOG_USBD("  %s xfer callback\r\n", driver->name);
-          driver->xfer_cb(event.rhport, ep_addr, (xfer_result_t) event.xfer_complete.result, event.xfer_complete.len);
-        }
-      }
+#if CFG_TUD_XFER_EVENT_BITMAP
+        // only a marker, completed transfers are in the pending bitmap
+        TU_LOG_USBD("\r\n");
+        process_xfer_pending();
+#else
+        process_xfer_complete(event.rhport, event.xfer_complete.ep_addr,
+                              (xfer_result_t) event.xfer_complete.result, event.xfer_complete.len);
+#endif
       break;
 
       case DCD_EVENT_SUSPEND:
@@ -600,6 +824,35 @@ void tud_task_ext(uint32_t timeout_ms, bool in_isr)
   }
 }
 
+// Invoke the class callback associated with the endpoint address
+static void process_xfer_complete(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes)
+{
+  uint8_t const epnum  = tu_edpt_number(ep_addr);
+  uint8_t const ep_dir = tu_edpt_dir(ep_addr);
+
+  TU_LOG_USBD("on EP %02X with %u bytes\r\n", ep_addr, (unsigned int) xferred_bytes);
+
+  _usbd_dev.ep_status[epnum][ep_dir].busy = 0;
+  _usbd_dev.ep_status[epnum][ep_dir].claimed = 0;
+
+#if CFG_TUD_MEM_DCACHE_ENABLE
+  if ( ep_dir == TUSB_DIR_OUT ) usbd_dcache_xfer_complete(epnum, xferred_bytes);
+#endif
+
+  if ( 0 == epnum )
+  {
+    usbd_control_xfer_cb(rhport, ep_addr, result, xferred_bytes);
+  }
+  else
+  {
+    usbd_class_driver_t const * driver = get_driver( _usbd_dev.ep2drv[epnum][ep_dir] );
+    TU_ASSERT(driver, );
+
+    TU_LOG_USBD("  %s xfer callback\r\n", driver->name);
+    driver->xfer_cb(rhport, ep_addr, result, xferred_bytes);
+  }
+}
+
 //--------------------------------------------------------------------+
 // Control Request Parser & Handling
 //--------------------------------------------------------------------+
@@ -1077,8 +1330,25 @@ static bool process_get_descriptor(uint8_t rhport, tusb_control_request_t const
 //--------------------------------------------------------------------+
 // DCD Event Handler
 //--------------------------------------------------------------------+
+// Send event to usbd task and notify application, which may schedule the task e.g with a software interrupt
+TU_ATTR_ALWAYS_INLINE static inline bool queue_event(dcd_event_t const * event, bool in_isr)
+{
+  bool const ret = osal_queue_send(_usbd_q, event, in_isr);
+  if (tud_event_hook_cb) tud_event_hook_cb(event->rhport, event->event_id, in_isr);
+  return ret;
+}
+
 TU_ATTR_FAST_FUNC void dcd_event_handler(dcd_event_t const * event, bool in_isr)
 {
+#if CFG_TUD_XFER_TIMESTAMP
+  if ( event->event_id == DCD_EVENT_XFER_COMPLETE )
+  {
+    // stamp here since usbd task may process the completion much later
+    uint8_t const ep_addr = event->xfer_complete.ep_addr;
+    _usbd_xfer_sof[tu_edpt_number(ep_addr)][tu_edpt_dir(ep_addr)] = _usbd_sof_clock;
+  }
+#endif
+
   switch (event->event_id)
   {
     case DCD_EVENT_UNPLUGGED:
@@ -1086,7 +1356,7 @@ TU_ATTR_FAST_FUNC void dcd_event_handler(dcd_event_t const * event, bool in_isr)
       _usbd_dev.addressed  = 0;
       _usbd_dev.cfg_num    = 0;
       _usbd_dev.suspended  = 0;
-      osal_queue_send(_usbd_q, event, in_isr);
+      queue_event(event, in_isr);
     break;
 
     case DCD_EVENT_SUSPEND:
@@ -1097,7 +1367,7 @@ TU_ATTR_FAST_FUNC void dcd_event_handler(dcd_event_t const * event, bool in_isr)
       if ( _usbd_dev.connected )
       {
         _usbd_dev.suspended = 1;
-        osal_queue_send(_usbd_q, event, in_isr);
+        queue_event(event, in_isr);
       }
     break;
 
@@ -1106,11 +1376,15 @@ TU_ATTR_FAST_FUNC void dcd_event_handler(dcd_event_t const * event, bool in_isr)
       if ( _usbd_dev.connected )
       {
         _usbd_dev.suspended = 0;
-        osal_queue_send(_usbd_q, event, in_isr);
+        queue_event(event, in_isr);
       }
     break;
 
     case DCD_EVENT_SOF:
+#if CFG_TUD_XFER_TIMESTAMP
+      _usbd_sof_clock++;
+#endif
+
       // SOF driver handler in ISR context
       for (uint8_t i = 0; i < TOTAL_DRIVER_COUNT; i++)
       {
@@ -1121,6 +1395,8 @@ TU_ATTR_FAST_FUNC void dcd_event_handler(dcd_event_t const * event, bool in_isr)
         }
       }
 
+      usbd_sof_sched_dispatch(event->rhport, event->sof.frame_count);
+
       // Some MCUs after running dcd_remote_wakeup() does not have way to detect the end of remote wakeup
       // which last 1-15 ms. DCD can use SOF as a clear indicator that bus is back to operational
       if ( _usbd_dev.suspended )
@@ -1128,14 +1404,38 @@ TU_ATTR_FAST_FUNC void dcd_event_handler(dcd_event_t const * event, bool in_isr)
         _usbd_dev.suspended = 0;
 
         dcd_event_t const event_resume = { .rhport = event->rhport, .event_id = DCD_EVENT_RESUME };
-        osal_queue_send(_usbd_q, &event_resume, in_isr);
+        queue_event(&event_resume, in_isr);
       }
 
       // skip osal queue for SOF in usbd task
     break;
 
+#if CFG_TUD_XFER_EVENT_BITMAP
+    case DCD_EVENT_XFER_COMPLETE:
+    {
+      uint8_t const epnum = tu_edpt_number(event->xfer_complete.ep_addr);
+      uint8_t const dir   = tu_edpt_dir(event->xfer_complete.ep_addr);
+      uint32_t const mask = TU_BIT(2*epnum + dir);
+
+      _usbd_xfer_slot[epnum][dir].len    = event->xfer_complete.len;
+      _usbd_xfer_slot[epnum][dir].result = event->xfer_complete.result;
+
+      if (!in_isr) usbd_int_set(false);
+      _usbd_xfer_pending |= mask;
+      bool const need_marker = !_usbd_xfer_marker;
+      _usbd_xfer_marker = true;
+      if (!in_isr) usbd_int_set(true);
+
+      // Queue a marker only for the first pending transfer, all transfers completed until the marker is
+      // popped are processed at its position in the queue. If queue is full, marker is retried by the
+      // next completion, otherwise pending bits are processed once the queue is empty.
+      if ( need_marker && !queue_event(event, in_isr) ) _usbd_xfer_marker = false;
+    }
+    break;
+#endif
+
     default:
-      osal_queue_send(_usbd_q, event, in_isr);
+      queue_event(event, in_isr);
     break;
   }
 }
@@ -1194,16 +1494,58 @@ void usbd_defer_func(osal_task_func_t func, void* param, bool in_isr)
   dcd_event_handler(&event, in_isr);
 }
 
+#if CFG_TUSB_MULTICORE
+void usbd_xcore_request(uint8_t slot, osal_task_func_t func, void* param)
+{
+  usbd_xcore_slot_t* p_slot = &_usbd_xcore[slot];
+
+  // func and param never change for a slot, writing them while usbd task runs it is harmless
+  p_slot->func  = func;
+  p_slot->param = param;
+
+  // data written by application before request must be visible to usbd task
+  usbd_xcore_fence();
+  p_slot->pending = true;
+  usbd_xcore_fence();
+
+#if CFG_TUSB_OS != OPT_OS_NONE
+  // RTOS queue is safe across cores: queue a single wake up event for a blocked usbd task
+  if ( !_usbd_xcore_wake )
+  {
+    _usbd_xcore_wake = true;
+    usbd_defer_func(xcore_wake_func, NULL, false);
+  }
+#endif
+
+  if ( tud_xcore_wakeup_cb ) tud_xcore_wakeup_cb();
+}
+#endif
+
 //--------------------------------------------------------------------+
 // USBD Endpoint API
 //--------------------------------------------------------------------+
 
+// High-bandwidth endpoint (more than 1 transaction per microframe) is only supported for ISO by DCD
+static bool usbd_edpt_mult_supported(tusb_desc_endpoint_t const * desc_ep)
+{
+  if ( tu_edpt_mult(desc_ep) == 1 ) return true;
+  return TUP_DCD_EDPT_ISO_HIGH_BANDWIDTH && (desc_ep->bmAttributes.xfer == TUSB_XFER_ISOCHRONOUS);
+}
+
 bool usbd_edpt_open(uint8_t rhport, tusb_desc_endpoint_t const * desc_ep)
 {
   rhport = _usbd_rhport;
 
   TU_ASSERT(tu_edpt_number(desc_ep->bEndpointAddress) < CFG_TUD_ENDPPOINT_MAX);
   TU_ASSERT(tu_edpt_validate(desc_ep, (tusb_speed_t) _usbd_dev.speed));
+  TU_ASSERT(usbd_edpt_mult_supported(desc_ep));
+
+  // endpoint may be reconfigured without being closed e.g previously activated ISO endpoint of same address
+  uint8_t const epnum = tu_edpt_number(desc_ep->bEndpointAddress);
+  uint8_t const dir   = tu_edpt_dir(desc_ep->bEndpointAddress);
+  _usbd_dev.ep_status[epnum][dir].stalled = 0;
+  _usbd_dev.ep_status[epnum][dir].busy = 0;
+  _usbd_dev.ep_status[epnum][dir].claimed = 0;
 
   return dcd_edpt_open(rhport, desc_ep);
 }
@@ -1252,6 +1594,11 @@ bool usbd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, uint16_t
   // could return and USBD task can preempt and clear the busy
   _usbd_dev.ep_status[epnum][dir].busy = 1;
 
+#if CFG_TUD_MEM_DCACHE_ENABLE
+  usbd_dcache_xfer_start(epnum, dir, 0, buffer, total_bytes);
+  usbd_dcache_xfer_start(epnum, dir, 1, NULL, 0);
+#endif
+
   if ( dcd_edpt_xfer(rhport, ep_addr, buffer, total_bytes) )
   {
     return true;
@@ -1260,6 +1607,9 @@ bool usbd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, uint16_t
     // DCD error, mark endpoint as ready to allow next transfer
     _usbd_dev.ep_status[epnum][dir].busy = 0;
     _usbd_dev.ep_status[epnum][dir].claimed = 0;
+#if CFG_TUD_MEM_DCACHE_ENABLE
+    if ( dir == TUSB_DIR_OUT ) tu_varclr(&_usbd_xfer_out_buf[epnum]);
+#endif
     TU_LOG_USBD("FAILED\r\n");
     TU_BREAKPOINT();
     return false;
@@ -1286,6 +1636,24 @@ bool usbd_edpt_xfer_fifo(uint8_t rhport, uint8_t ep_addr, tu_fifo_t * ff, uint16
   // and usbd task can preempt and clear the busy
   _usbd_dev.ep_status[epnum][dir].busy = 1;
 
+#if CFG_TUD_MEM_DCACHE_ENABLE
+  // Maintain the part of fifo memory DMA will access: read part for IN, write part for OUT
+  tu_fifo_buffer_info_t info;
+  if ( dir == TUSB_DIR_IN )
+  {
+    tu_fifo_get_read_info(ff, &info);
+  }else
+  {
+    tu_fifo_get_write_info(ff, &info);
+  }
+
+  // info lengths are in items, total_bytes in bytes
+  uint16_t const lin_bytes  = tu_min16((uint16_t) (info.len_lin  * ff->item_size), total_bytes);
+  uint16_t const wrap_bytes = tu_min16((uint16_t) (info.len_wrap * ff->item_size), (uint16_t) (total_bytes - lin_bytes));
+  usbd_dcache_xfer_start(epnum, dir, 0, (uint8_t*) info.ptr_lin , lin_bytes);
+  usbd_dcache_xfer_start(epnum, dir, 1, (uint8_t*) info.ptr_wrap, wrap_bytes);
+#endif
+
   if (dcd_edpt_xfer_fifo(rhport, ep_addr, ff, total_bytes))
   {
     TU_LOG_USBD("OK\r\n");
@@ -1295,12 +1663,60 @@ bool usbd_edpt_xfer_fifo(uint8_t rhport, uint8_t ep_addr, tu_fifo_t * ff, uint16
     // DCD error, mark endpoint as ready to allow next transfer
     _usbd_dev.ep_status[epnum][dir].busy = 0;
     _usbd_dev.ep_status[epnum][dir].claimed = 0;
+#if CFG_TUD_MEM_DCACHE_ENABLE
+    if ( dir == TUSB_DIR_OUT ) tu_varclr(&_usbd_xfer_out_buf[epnum]);
+#endif
     TU_LOG_USBD("failed\r\n");
     TU_BREAKPOINT();
     return false;
   }
 }
 
+#if CFG_TUD_MEM_DCACHE_ENABLE
+// IN: write back data to memory for DMA to read. OUT: drop cached lines so that no dirty line
+// is evicted on top of data written by DMA. Buffer must be aligned and padded to cache line
+// (see TUD_EPBUF_DEF) otherwise neighbor variables sharing the line are discarded.
+static void usbd_dcache_xfer_start(uint8_t epnum, uint8_t dir, uint8_t idx, uint8_t* buffer, uint16_t len)
+{
+  if ( buffer == NULL || len == 0 )
+  {
+    buffer = NULL;
+    len    = 0;
+  }
+  else if ( dir == TUSB_DIR_IN )
+  {
+    if ( dcd_dcache_clean ) dcd_dcache_clean(buffer, len);
+  }
+  else
+  {
+    if ( dcd_dcache_invalidate ) dcd_dcache_invalidate(buffer, len);
+  }
+
+  if ( dir == TUSB_DIR_OUT )
+  {
+    _usbd_xfer_out_buf[epnum].buf[idx] = buffer;
+    _usbd_xfer_out_buf[epnum].len[idx] = len;
+  }
+}
+
+// Invalidate received bytes again before class driver reads them
+static void usbd_dcache_xfer_complete(uint8_t epnum, uint32_t xferred_bytes)
+{
+  usbd_xfer_out_buf_t* out_buf = &_usbd_xfer_out_buf[epnum];
+
+  for ( uint8_t i = 0; i < 2 && xferred_bytes; i++ )
+  {
+    if ( out_buf->buf[i] == NULL ) break;
+
+    uint16_t const len = (uint16_t) tu_min32(out_buf->len[i], xferred_bytes);
+    if ( dcd_dcache_invalidate ) dcd_dcache_invalidate(out_buf->buf[i], len);
+    xferred_bytes -= len;
+  }
+
+  tu_varclr(out_buf);
+}
+#endif
+
 bool usbd_edpt_busy(uint8_t rhport, uint8_t ep_addr)
 {
   (void) rhport;
@@ -1379,15 +1795,200 @@ void usbd_edpt_close(uint8_t rhport, uint8_t ep_addr)
   return;
 }
 
+// Enable/Disable SOF interrupt according to all consumers
+static void usbd_sof_update(void)
+{
+  bool const en = _usbd_sof_requested || (_usbd_sof_sched_count > 0) || CFG_TUD_XFER_TIMESTAMP;
+
+  if ( en != _usbd_sof_enabled )
+  {
+    if ( en )
+    {
+      // frames were not counted while SOF was disabled, derive phase from frame number again
+      _usbd_sof_frame_valid = false;
+      for (uint8_t i = 0; i < CFG_TUD_SOF_SCHED_MAX; i++) _usbd_sof_sched[i].synced = false;
+    }
+
+    _usbd_sof_enabled = en;
+    dcd_sof_enable(_usbd_rhport, en);
+  }
+}
+
 void usbd_sof_enable(uint8_t rhport, bool en)
 {
-  rhport = _usbd_rhport;
+  (void) rhport;
+
+  // SOF is kept enabled if scheduler still has callbacks
+  _usbd_sof_requested = en;
+  usbd_sof_update();
+}
+
+//--------------------------------------------------------------------+
+// SOF Scheduler
+//--------------------------------------------------------------------+
+
+bool tud_sof_sched_add(tud_sof_sched_cb_t cb, void* param, uint16_t interval, uint16_t offset)
+{
+  TU_VERIFY(cb && interval && (offset < interval));
+
+  for (uint8_t i = 0; i < CFG_TUD_SOF_SCHED_MAX; i++)
+  {
+    usbd_sof_sched_t* sched = &_usbd_sof_sched[i];
+    if ( sched->cb == NULL )
+    {
+      usbd_int_set(false);
+      sched->param     = param;
+      sched->interval  = interval;
+      sched->offset    = offset;
+      sched->synced    = false;
+      sched->cb        = cb;
+      _usbd_sof_sched_count++;
+      usbd_int_set(true);
+
+      usbd_sof_update();
+      return true;
+    }
+  }
 
-  // TODO: Check needed if all drivers including the user sof_cb does not need an active SOF ISR any more.
-  // Only if all drivers switched off SOF calls the SOF interrupt may be disabled
-  dcd_sof_enable(rhport, en);
+  TU_LOG_USBD("SOF scheduler is full, increase CFG_TUD_SOF_SCHED_MAX\r\n");
+  return false;
 }
 
+bool tud_sof_sched_remove(tud_sof_sched_cb_t cb, void* param)
+{
+  for (uint8_t i = 0; i < CFG_TUD_SOF_SCHED_MAX; i++)
+  {
+    usbd_sof_sched_t* sched = &_usbd_sof_sched[i];
+    if ( sched->cb == cb && sched->param == param )
+    {
+      usbd_int_set(false);
+      sched->cb = NULL;
+      _usbd_sof_sched_count--;
+      usbd_int_set(true);
+
+      usbd_sof_update();
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Invoked in ISR context on each SOF
+static void usbd_sof_sched_dispatch(uint8_t rhport, uint32_t frame_count)
+{
+  // extend frame number, delta is masked to 11 bits since it is the width reported by most DCDs
+  uint16_t const frame_raw = (uint16_t) frame_count;
+  if ( _usbd_sof_frame_valid )
+  {
+    _usbd_sof_frame += (uint16_t) ((frame_raw - _usbd_sof_frame_last) & 0x7FFu);
+  }else
+  {
+    _usbd_sof_frame = frame_raw;
+    _usbd_sof_frame_valid = true;
+  }
+  _usbd_sof_frame_last = frame_raw;
+
+  if ( _usbd_sof_sched_count == 0 ) return;
+
+  uint32_t const frame = _usbd_sof_frame;
+
+  for (uint8_t i = 0; i < CFG_TUD_SOF_SCHED_MAX; i++)
+  {
+    usbd_sof_sched_t* sched = &_usbd_sof_sched[i];
+    if ( !sched->cb ) continue;
+
+    if ( !sched->synced )
+    {
+      // first frame from now whose number modulo interval is offset, so that callbacks are aligned
+      // to the frame number and therefore to each other
+      uint16_t const phase = (uint16_t) (frame % sched->interval);
+      sched->next_frame = frame + (uint16_t) ((sched->offset + sched->interval - phase) % sched->interval);
+      sched->synced = true;
+    }
+
+    if ( (int32_t) (frame - sched->next_frame) >= 0 )
+    {
+      // invocations of missed SOFs are skipped, callback only runs on frames in phase
+      uint16_t const late = (uint16_t) ((frame - sched->next_frame) % sched->interval);
+      sched->next_frame = frame + sched->interval - late;
+
+      if ( late == 0 ) sched->cb(rhport, frame_count, sched->param);
+    }
+  }
+}
+
+#if CFG_TUD_XFER_TIMESTAMP
+//--------------------------------------------------------------------+
+// Transfer Timestamp
+//--------------------------------------------------------------------+
+
+uint32_t tud_sof_clock(void)
+{
+  return _usbd_sof_clock;
+}
+
+uint32_t usbd_edpt_xfer_sof(uint8_t rhport, uint8_t ep_addr)
+{
+  (void) rhport;
+  return _usbd_xfer_sof[tu_edpt_number(ep_addr)][tu_edpt_dir(ep_addr)];
+}
+
+uint32_t usbd_stream_ts_mark(usbd_stream_ts_t* ts, uint32_t len, uint32_t sof)
+{
+  uint32_t const offset = ts->wr_offset;
+  ts->wr_offset = offset + len;
+
+  // no latency sample for this data if consumer is too far behind
+  uint8_t const next = (uint8_t) ((ts->mark_wr + 1) % CFG_TUD_XFER_TIMESTAMP_MARKS);
+  if ( len && (next != ts->mark_rd) )
+  {
+    ts->mark[ts->mark_wr].end = ts->wr_offset;
+    ts->mark[ts->mark_wr].sof = sof;
+    ts->mark_wr = next;
+  }
+
+  return offset;
+}
+
+uint32_t usbd_stream_ts_consume(usbd_stream_ts_t* ts, uint32_t len, uint32_t sof)
+{
+  uint32_t const offset = ts->rd_offset;
+  ts->rd_offset = offset + len;
+
+  // sample latency of each mark whose data is now completely consumed
+  while ( ts->mark_rd != ts->mark_wr )
+  {
+    usbd_stream_mark_t const* mark = &ts->mark[ts->mark_rd];
+    if ( (int32_t) (ts->rd_offset - mark->end) < 0 ) break;
+
+    uint32_t const latency = sof - mark->sof;
+    tud_latency_stat_t* stat = &ts->stat;
+
+    // consumer is usbd task or application depending on stream direction, see usbd_stream_ts_stat()
+    (void) osal_mutex_lock(_usbd_mutex, OSAL_TIMEOUT_WAIT_FOREVER);
+    if ( (stat->count == 0) || (latency < stat->min) ) stat->min = latency;
+    if ( (stat->count == 0) || (latency > stat->max) ) stat->max = latency;
+    stat->last = latency;
+    stat->sum += latency;
+    stat->count++;
+    (void) osal_mutex_unlock(_usbd_mutex);
+
+    ts->mark_rd = (uint8_t) ((ts->mark_rd + 1) % CFG_TUD_XFER_TIMESTAMP_MARKS);
+  }
+
+  return offset;
+}
+
+void usbd_stream_ts_stat(usbd_stream_ts_t* ts, tud_latency_stat_t* stat, bool clear)
+{
+  (void) osal_mutex_lock(_usbd_mutex, OSAL_TIMEOUT_WAIT_FOREVER);
+  if ( stat ) *stat = ts->stat;
+  if ( clear ) tu_varclr(&ts->stat);
+  (void) osal_mutex_unlock(_usbd_mutex);
+}
+#endif
+
 bool usbd_edpt_iso_alloc(uint8_t rhport, uint8_t ep_addr, uint16_t largest_packet_size)
 {
   rhport = _usbd_rhport;
@@ -1408,6 +2009,7 @@ bool usbd_edpt_iso_activate(uint8_t rhport, tusb_desc_endpoint_t const * desc_ep
   TU_ASSERT(dcd_edpt_iso_activate);
   TU_ASSERT(epnum < CFG_TUD_ENDPPOINT_MAX);
   TU_ASSERT(tu_edpt_validate(desc_ep, (tusb_speed_t) _usbd_dev.speed));
+  TU_ASSERT(usbd_edpt_mult_supported(desc_ep));
 
   _usbd_dev.ep_status[epnum][dir].stalled = 0;
   _usbd_dev.ep_status[epnum][dir].busy = 0;
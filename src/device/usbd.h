@@ -45,7 +45,8 @@ bool tud_inited(void);
 
 // Task function should be called in main/rtos loop, extended version of tud_task()
 // - timeout_ms: millisecond to wait, zero = no wait, 0xFFFFFFFF = wait forever
-// - in_isr: if function is called in ISR
+// - in_isr: if function is called in ISR e.g a low priority software interrupt pended by tud_event_hook_cb(),
+//   in which case timeout_ms is ignored and the function never blocks
 void tud_task_ext(uint32_t timeout_ms, bool in_isr);
 
 // Task function should be called in main/rtos loop
@@ -104,6 +105,49 @@ bool tud_control_xfer(uint8_t rhport, tusb_control_request_t const * request, vo
 // Send STATUS (zero length) packet
 bool tud_control_status(uint8_t rhport, tusb_control_request_t const * request);
 
+//--------------------------------------------------------------------+
+// SOF Scheduler
+//--------------------------------------------------------------------+
+
+// Callback invoked in ISR context on scheduled SOF, frame_count is as reported by DCD
+typedef void (*tud_sof_sched_cb_t)(uint8_t rhport, uint32_t frame_count, void* param);
+
+// Register callback to be invoked every 'interval' SOFs (frame for full speed, microframe for high speed
+// if controller interrupts on each microframe) on frames whose number modulo interval is 'offset' (offset < interval).
+// Frame number is extended beyond the 11-bit wrap, callbacks with the same interval and offset run on the same frame.
+// SOF interrupt is only enabled while there is at least one registered callback.
+// Return false if all CFG_TUD_SOF_SCHED_MAX slots are in use
+bool tud_sof_sched_add(tud_sof_sched_cb_t cb, void* param, uint16_t interval, uint16_t offset);
+
+// Unregister callback previously added with the same param
+bool tud_sof_sched_remove(tud_sof_sched_cb_t cb, void* param);
+
+//--------------------------------------------------------------------+
+// Transfer Timestamp (CFG_TUD_XFER_TIMESTAMP)
+//--------------------------------------------------------------------+
+
+// Timestamp of a completed stream transfer
+typedef struct
+{
+  uint32_t offset; // stream offset of the first byte, counted from start of streaming
+  uint32_t len;    // number of bytes
+  uint32_t sof;    // tud_sof_clock() when transfer completed
+} tud_stream_stamp_t;
+
+// Latency statistics in SOF clock unit
+typedef struct
+{
+  uint32_t count;  // number of samples
+  uint32_t min;
+  uint32_t max;
+  uint32_t last;
+  uint64_t sum;    // average is sum/count
+} tud_latency_stat_t;
+
+// Number of SOF received since tud_init(): 1 ms frame for full speed, 125 us microframe for high speed if
+// controller interrupts on each microframe. Does not advance while bus is suspended.
+uint32_t tud_sof_clock(void);
+
 //--------------------------------------------------------------------+
 // Application Callbacks (WEAK is optional)
 //--------------------------------------------------------------------+
@@ -135,6 +179,15 @@ TU_ATTR_WEAK uint8_t const* tud_descriptor_device_qualifier_cb(void);
 // Configuration descriptor in the other speed e.g if high speed then this is for full speed and vice versa
 TU_ATTR_WEAK uint8_t const* tud_descriptor_other_speed_configuration_cb(uint8_t index);
 
+// Invoked when an event is queued for tud_task(), may be called in ISR context. Bare-metal application
+// can use it to pend a low priority software interrupt whose handler calls tud_task_ext(0, true), instead
+// of polling tud_task() in the main loop. Note: tud_task() must then not be called from anywhere else.
+TU_ATTR_WEAK void tud_event_hook_cb(uint8_t rhport, uint32_t eventid, bool in_isr);
+
+// Invoked on the application core when a request is posted for the stack core (CFG_TUSB_MULTICORE).
+// Bare-metal application can use it to wake up the other core e.g __sev() on RP2040
+TU_ATTR_WEAK void tud_xcore_wakeup_cb(void);
+
 // Invoked when device is mounted (configured)
 TU_ATTR_WEAK void tud_mount_cb(void);
 
@@ -623,6 +676,47 @@ TU_ATTR_WEAK bool tud_vendor_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb
   /* Endpoint In */\
   7, TUSB_DESC_ENDPOINT, _epin, TUSB_XFER_BULK, U16_TO_U8S_LE(_epsize), 0
 
+// Vendor interface carrying virtual channels, see class/vendor/vendor_mux.h
+// Interface number, string index, EP Out & IN address, EP size
+#define TUD_VENDOR_MUX_DESCRIPTOR(_itfnum, _stridx, _epout, _epin, _epsize) \
+  /* Interface */\
+  9, TUSB_DESC_INTERFACE, _itfnum, 0, 2, TUSB_CLASS_VENDOR_SPECIFIC, 0x4D, 0x01, _stridx,\
+  /* Endpoint Out */\
+  7, TUSB_DESC_ENDPOINT, _epout, TUSB_XFER_BULK, U16_TO_U8S_LE(_epsize), 0,\
+  /* Endpoint In */\
+  7, TUSB_DESC_ENDPOINT, _epin, TUSB_XFER_BULK, U16_TO_U8S_LE(_epsize), 0
+
+//--------------------------------------------------------------------+
+// Source/Sink and Loopback (gadget zero) Descriptor Templates, see class/zero/zero.h
+//--------------------------------------------------------------------+
+
+#define TUD_ZERO_SRC_SINK_DESC_LEN  (3*(9+7+7))
+
+// Source/sink with bulk (alt 0), interrupt (alt 1) and isochronous (alt 2) settings
+// Interface number, string index, EP Out & IN address, bulk EP size, interrupt EP size & interval, iso EP size & interval
+#define TUD_ZERO_SRC_SINK_DESCRIPTOR(_itfnum, _stridx, _epout, _epin, _bulksize, _intsize, _intinterval, _isosize, _isointerval) \
+  /* Interface: bulk */\
+  9, TUSB_DESC_INTERFACE, _itfnum, 0, 2, TUSB_CLASS_VENDOR_SPECIFIC, 0x5A, 0x01, _stridx,\
+  7, TUSB_DESC_ENDPOINT, _epout, TUSB_XFER_BULK, U16_TO_U8S_LE(_bulksize), 0,\
+  7, TUSB_DESC_ENDPOINT, _epin, TUSB_XFER_BULK, U16_TO_U8S_LE(_bulksize), 0,\
+  /* Interface: interrupt */\
+  9, TUSB_DESC_INTERFACE, _itfnum, 1, 2, TUSB_CLASS_VENDOR_SPECIFIC, 0x5A, 0x01, _stridx,\
+  7, TUSB_DESC_ENDPOINT, _epout, TUSB_XFER_INTERRUPT, U16_TO_U8S_LE(_intsize), _intinterval,\
+  7, TUSB_DESC_ENDPOINT, _epin, TUSB_XFER_INTERRUPT, U16_TO_U8S_LE(_intsize), _intinterval,\
+  /* Interface: isochronous */\
+  9, TUSB_DESC_INTERFACE, _itfnum, 2, 2, TUSB_CLASS_VENDOR_SPECIFIC, 0x5A, 0x01, _stridx,\
+  7, TUSB_DESC_ENDPOINT, _epout, TUSB_XFER_ISOCHRONOUS, U16_TO_U8S_LE(_isosize), _isointerval,\
+  7, TUSB_DESC_ENDPOINT, _epin, TUSB_XFER_ISOCHRONOUS, U16_TO_U8S_LE(_isosize), _isointerval
+
+#define TUD_ZERO_LOOPBACK_DESC_LEN  (9+7+7)
+
+// Loopback with bulk endpoints
+// Interface number, string index, EP Out & IN address, EP size
+#define TUD_ZERO_LOOPBACK_DESCRIPTOR(_itfnum, _stridx, _epout, _epin, _epsize) \
+  9, TUSB_DESC_INTERFACE, _itfnum, 0, 2, TUSB_CLASS_VENDOR_SPECIFIC, 0x5A, 0x02, _stridx,\
+  7, TUSB_DESC_ENDPOINT, _epout, TUSB_XFER_BULK, U16_TO_U8S_LE(_epsize), 0,\
+  7, TUSB_DESC_ENDPOINT, _epin, TUSB_XFER_BULK, U16_TO_U8S_LE(_epsize), 0
+
 //--------------------------------------------------------------------+
 // DFU Runtime Descriptor Templates
 //--------------------------------------------------------------------+
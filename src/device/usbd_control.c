@@ -55,8 +55,9 @@ typedef struct
 
 tu_static usbd_control_xfer_t _ctrl_xfer;
 
-CFG_TUD_MEM_SECTION CFG_TUSB_MEM_ALIGN
-tu_static uint8_t _usbd_ctrl_buf[CFG_TUD_ENDPOINT0_SIZE];
+// padded to whole cache lines when cache maintenance is enabled
+CFG_TUD_MEM_SECTION CFG_TUD_MEM_ALIGN
+tu_static uint8_t _usbd_ctrl_buf[TUD_EPBUF_SIZE(CFG_TUD_ENDPOINT0_SIZE)];
 
 //--------------------------------------------------------------------+
 // Application API
@@ -28,6 +28,7 @@
 
 #include "osal/osal.h"
 #include "common/tusb_fifo.h"
+#include "device/usbd.h"
 
 #ifdef __cplusplus
  extern "C" {
@@ -104,6 +105,7 @@ void usbd_edpt_clear_stall(uint8_t rhport, uint8_t ep_addr);
 bool usbd_edpt_stalled(uint8_t rhport, uint8_t ep_addr);
 
 // Allocate packet buffer used by ISO endpoints
+// For high-bandwidth endpoint, largest_packet_size should be the bytes per interval i.e tu_edpt_bytes_per_interval()
 bool usbd_edpt_iso_alloc(uint8_t rhport, uint8_t ep_addr, uint16_t largest_packet_size);
 
 // Configure and enable an ISO endpoint according to descriptor
@@ -119,6 +121,38 @@ bool usbd_edpt_ready(uint8_t rhport, uint8_t ep_addr)
 // Enable SOF interrupt
 void usbd_sof_enable(uint8_t rhport, bool en);
 
+// Stream latency tracker: producer marks data entering a fifo, consumer samples the time until
+// all of it left. Offsets count bytes since reset and are used to correlate with transfers.
+typedef struct
+{
+  uint32_t end; // stream offset after the marked data
+  uint32_t sof;
+} usbd_stream_mark_t;
+
+typedef struct
+{
+  volatile uint32_t wr_offset;
+  volatile uint32_t rd_offset;
+  usbd_stream_mark_t mark[CFG_TUD_XFER_TIMESTAMP_MARKS];
+  volatile uint8_t mark_wr;
+  volatile uint8_t mark_rd;
+  tud_latency_stat_t stat;
+} usbd_stream_ts_t;
+
+#if CFG_TUD_XFER_TIMESTAMP
+// SOF clock (see tud_sof_clock()) when the last transfer on endpoint completed
+uint32_t usbd_edpt_xfer_sof(uint8_t rhport, uint8_t ep_addr);
+
+// Producer side: len bytes entered the fifo at sof, return stream offset of the first byte
+uint32_t usbd_stream_ts_mark(usbd_stream_ts_t* ts, uint32_t len, uint32_t sof);
+
+// Consumer side: len bytes left the fifo at sof, return stream offset of the first byte
+uint32_t usbd_stream_ts_consume(usbd_stream_ts_t* ts, uint32_t len, uint32_t sof);
+
+// Copy and/or clear latency statistic, consistent with consumer running in another thread or core
+void usbd_stream_ts_stat(usbd_stream_ts_t* ts, tud_latency_stat_t* stat, bool clear);
+#endif
+
 /*------------------------------------------------------------------*/
 /* Helper
  *------------------------------------------------------------------*/
@@ -126,6 +160,20 @@ void usbd_sof_enable(uint8_t rhport, bool en);
 bool usbd_open_edpt_pair(uint8_t rhport, uint8_t const* p_desc, uint8_t ep_count, uint8_t xfer_type, uint8_t* ep_out, uint8_t* ep_in);
 void usbd_defer_func( osal_task_func_t func, void* param, bool in_isr );
 
+#if CFG_TUSB_MULTICORE
+// Request slots for application core, one per class interface
+enum
+{
+  USBD_XCORE_CDC    = 0,
+  USBD_XCORE_VENDOR = USBD_XCORE_CDC + CFG_TUD_CDC,
+  USBD_XCORE_COUNT  = USBD_XCORE_VENDOR + CFG_TUD_VENDOR
+};
+
+// Ask usbd task to invoke func(param) on the stack core, can be called from another core.
+// Requests on the same slot are coalesced until processed, func and param must be the same for a slot.
+void usbd_xcore_request(uint8_t slot, osal_task_func_t func, void* param);
+#endif
+
 
 #ifdef __cplusplus
  }
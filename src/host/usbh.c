@@ -45,6 +45,17 @@
   #define CFG_TUH_INTERFACE_MAX   8
 #endif
 
+// Number of software timers used for non-blocking delays such as enumeration reset/debouncing
+#ifndef CFG_TUH_TIMER_MAX
+  #define CFG_TUH_TIMER_MAX       2
+#endif
+
+// Number of match entries (of all drivers) indexed by interface class to select driver of an interface.
+// Drivers are probed one after another if exceeded
+#ifndef CFG_TUH_MATCH_INDEX_MAX
+  #define CFG_TUH_MATCH_INDEX_MAX 32
+#endif
+
 //--------------------------------------------------------------------+
 // USBH-HCD common data structure
 //--------------------------------------------------------------------+
@@ -111,6 +122,10 @@ typedef struct {
   }ep_callback[CFG_TUH_ENDPOINT_MAX][2];
 #endif
 
+#if CFG_TUH_MEM_DCACHE_ENABLE
+  uint8_t* ep_in_buf[CFG_TUH_ENDPOINT_MAX]; // IN buffer to invalidate on completion
+#endif
+
 } usbh_device_t;
 
 //--------------------------------------------------------------------+
@@ -123,6 +138,78 @@ typedef struct {
   #define DRIVER_NAME(_name)
 #endif
 
+#if CFG_TUH_CDC_FTDI
+  #include "class/cdc/serial/ftdi_sio.h"
+#endif
+
+#if CFG_TUH_CDC_CP210X
+  #include "class/cdc/serial/cp210x.h"
+#endif
+
+// Match tables of built-in drivers
+#if CFG_TUH_CDC
+static usbh_class_match_t const cdch_match_table[] =
+{
+  // Only support ACM subclass, protocol 0xFF can be RNDIS device
+  USBH_CLASS_MATCH_ITF_SUBCLASS(TUSB_CLASS_CDC, CDC_COMM_SUBCLASS_ABSTRACT_CONTROL_MODEL),
+
+  // vendor-specific serial, PID is checked by driver
+  #if CFG_TUH_CDC_FTDI
+  USBH_CLASS_MATCH_VID_ITF(TU_FTDI_VID, TUSB_CLASS_VENDOR_SPECIFIC),
+  #endif
+
+  #if CFG_TUH_CDC_CP210X
+  USBH_CLASS_MATCH_VID_ITF(TU_CP210X_VID, TUSB_CLASS_VENDOR_SPECIFIC),
+  #endif
+
+  USBH_CLASS_MATCH_END
+};
+#endif
+
+#if CFG_TUH_MSC
+static usbh_class_match_t const msch_match_table[] =
+{
+  USBH_CLASS_MATCH_ITF_INFO(TUSB_CLASS_MSC, MSC_SUBCLASS_SCSI, MSC_PROTOCOL_BOT),
+  #if CFG_TUH_MSC_UAS
+  USBH_CLASS_MATCH_ITF_INFO(TUSB_CLASS_MSC, MSC_SUBCLASS_SCSI, MSC_PROTOCOL_UAS),
+  #endif
+  USBH_CLASS_MATCH_END
+};
+#endif
+
+#if CFG_TUH_HID
+static usbh_class_match_t const hidh_match_table[] =
+{
+  USBH_CLASS_MATCH_ITF(TUSB_CLASS_HID),
+  USBH_CLASS_MATCH_END
+};
+#endif
+
+#if CFG_TUH_VENDOR_MUX
+static usbh_class_match_t const vmuxh_match_table[] =
+{
+  USBH_CLASS_MATCH_ITF_INFO(TUSB_CLASS_VENDOR_SPECIFIC, VENDOR_MUX_SUBCLASS, VENDOR_MUX_PROTOCOL),
+  USBH_CLASS_MATCH_END
+};
+#endif
+
+#if CFG_TUH_ZERO
+static usbh_class_match_t const zeroh_match_table[] =
+{
+  // vendor interfaces of other devices e.g Linux g_zero are bound by tuh_zero_match_cb(), checked by driver
+  USBH_CLASS_MATCH_ITF(TUSB_CLASS_VENDOR_SPECIFIC),
+  USBH_CLASS_MATCH_END
+};
+#endif
+
+#if CFG_TUH_HUB
+static usbh_class_match_t const hub_match_table[] =
+{
+  USBH_CLASS_MATCH_ITF_SUBCLASS(TUSB_CLASS_HUB, 0),
+  USBH_CLASS_MATCH_END
+};
+#endif
+
 static usbh_class_driver_t const usbh_class_drivers[] =
 {
   #if CFG_TUH_CDC
@@ -132,7 +219,8 @@ static usbh_class_driver_t const usbh_class_drivers[] =
       .open       = cdch_open,
       .set_config = cdch_set_config,
       .xfer_cb    = cdch_xfer_cb,
-      .close      = cdch_close
+      .close      = cdch_close,
+      .match_table = cdch_match_table
     },
   #endif
 
@@ -143,7 +231,8 @@ static usbh_class_driver_t const usbh_class_drivers[] =
       .open       = msch_open,
       .set_config = msch_set_config,
       .xfer_cb    = msch_xfer_cb,
-      .close      = msch_close
+      .close      = msch_close,
+      .match_table = msch_match_table
     },
   #endif
 
@@ -154,7 +243,8 @@ static usbh_class_driver_t const usbh_class_drivers[] =
       .open       = hidh_open,
       .set_config = hidh_set_config,
       .xfer_cb    = hidh_xfer_cb,
-      .close      = hidh_close
+      .close      = hidh_close,
+      .match_table = hidh_match_table
     },
   #endif
 
@@ -165,7 +255,32 @@ static usbh_class_driver_t const usbh_class_drivers[] =
       .open       = hub_open,
       .set_config = hub_set_config,
       .xfer_cb    = hub_xfer_cb,
-      .close      = hub_close
+      .close      = hub_close,
+      .match_table = hub_match_table
+    },
+  #endif
+
+  #if CFG_TUH_VENDOR_MUX
+    {
+      DRIVER_NAME("VMUX")
+      .init       = vmuxh_init,
+      .open       = vmuxh_open,
+      .set_config = vmuxh_set_config,
+      .xfer_cb    = vmuxh_xfer_cb,
+      .close      = vmuxh_close,
+      .match_table = vmuxh_match_table
+    },
+  #endif
+
+  #if CFG_TUH_ZERO
+    {
+      DRIVER_NAME("ZERO")
+      .init       = zeroh_init,
+      .open       = zeroh_open,
+      .set_config = zeroh_set_config,
+      .xfer_cb    = zeroh_xfer_cb,
+      .close      = zeroh_close,
+      .match_table = zeroh_match_table
     },
   #endif
 
@@ -231,6 +346,15 @@ static usbh_device_t _usbh_devices[TOTAL_DEVICES];
 OSAL_QUEUE_DEF(usbh_int_set, _usbh_qdef, CFG_TUH_TASK_QUEUE_SZ, hcd_event_t);
 static osal_queue_t _usbh_q;
 
+// Software timers: function is invoked in usbh task when expired, func = NULL means timer is free
+typedef struct {
+  osal_task_func_t func;
+  void* param;
+  uint32_t expire_ms;
+} usbh_timer_t;
+
+static usbh_timer_t _usbh_timers[CFG_TUH_TIMER_MAX];
+
 CFG_TUH_MEM_SECTION CFG_TUH_MEM_ALIGN
 static uint8_t _usbh_ctrl_buf[CFG_TUH_ENUMERATION_BUFSIZE];
 
@@ -260,18 +384,41 @@ static inline usbh_device_t* get_device(uint8_t dev_addr)
 
 static bool enum_new_device(hcd_event_t* event);
 static void process_removing_device(uint8_t rhport, uint8_t hub_addr, uint8_t hub_port);
+static void enum_abort(void);
+static void match_index_build(void);
 static bool usbh_edpt_control_open(uint8_t dev_addr, uint8_t max_packet_size);
 static bool usbh_control_xfer_cb (uint8_t daddr, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes);
 
+#if CFG_TUH_MEM_DCACHE_ENABLE
+static void usbh_dcache_xfer_start(uint8_t ep_addr, uint8_t* buffer, uint16_t len);
+static void usbh_dcache_xfer_complete(uint8_t daddr, uint8_t ep_addr, uint32_t xferred_bytes);
+#endif
+
+// USB frame number is 11-bit wide, some controllers (e.g rp2040, rusb2, musb, khci) do not extend it
+#define USBH_FRAME_NUMBER_MASK    0x7FFu
+
 #if CFG_TUSB_OS == OPT_OS_NONE
 // TODO rework time-related function later
 // weak and overridable
 TU_ATTR_WEAK void osal_task_delay(uint32_t msec) {
   const uint32_t start = hcd_frame_number(_usbh_controller);
-  while ( ( hcd_frame_number(_usbh_controller) - start ) < msec ) {}
+  while ( ( (hcd_frame_number(_usbh_controller) - start) & USBH_FRAME_NUMBER_MASK ) < msec ) {}
 }
 #endif
 
+// weak and overridable
+// Extend controller frame number to 32-bit milliseconds, require to be called at least every 2 seconds
+TU_ATTR_WEAK uint32_t tuh_time_millis(void) {
+  static uint32_t last_frame = 0;
+  static uint32_t ms = 0;
+
+  uint32_t const frame = hcd_frame_number(_usbh_controller);
+  ms += (frame - last_frame) & USBH_FRAME_NUMBER_MASK;
+  last_frame = frame;
+
+  return ms;
+}
+
 //--------------------------------------------------------------------+
 // Device API
 //--------------------------------------------------------------------+
@@ -362,10 +509,13 @@ bool tuh_init(uint8_t controller_id) {
     _app_driver = usbh_app_driver_get_cb(&_app_driver_count);
   }
 
+  match_index_build();
+
   // Device
   tu_memclr(&_dev0, sizeof(_dev0));
   tu_memclr(_usbh_devices, sizeof(_usbh_devices));
   tu_memclr(&_ctrl_xfer, sizeof(_ctrl_xfer));
+  tu_memclr(_usbh_timers, sizeof(_usbh_timers));
 
   for(uint8_t i=0; i<TOTAL_DEVICES; i++)
   {
@@ -391,11 +541,87 @@ bool tuh_init(uint8_t controller_id) {
   return true;
 }
 
+// Invoke expired timers, return milliseconds until the next timer expires (OSAL_TIMEOUT_WAIT_FOREVER if none)
+// Time base is only read while a timer is armed: some controllers (e.g max3421) count frames on demand
+static bool usbh_timer_armed(void) {
+  for (uint8_t i = 0; i < CFG_TUH_TIMER_MAX; i++) {
+    if ( _usbh_timers[i].func ) return true;
+  }
+  return false;
+}
+
+static uint32_t usbh_timer_process(void) {
+  uint32_t next_ms = OSAL_TIMEOUT_WAIT_FOREVER;
+  if ( !usbh_timer_armed() ) return next_ms;
+
+  uint32_t const now = tuh_time_millis();
+
+  for (uint8_t i = 0; i < CFG_TUH_TIMER_MAX; i++) {
+    usbh_timer_t* timer = &_usbh_timers[i];
+    if ( !timer->func ) continue;
+
+    int32_t const remaining = (int32_t) (timer->expire_ms - now);
+    if ( remaining <= 0 ) {
+      // free timer before invoking since func can start another one
+      osal_task_func_t const func = timer->func;
+      timer->func = NULL;
+      func(timer->param);
+
+      // newly started timers may not be accounted, check again as soon as possible
+      next_ms = 0;
+    } else {
+      // wake up at least every second so that the default frame-number based time base does not wrap
+      next_ms = tu_min32(next_ms, tu_min32((uint32_t) remaining, 1000));
+    }
+  }
+
+  return next_ms;
+}
+
+bool usbh_defer_func_ms(osal_task_func_t func, void* param, uint32_t delay_ms) {
+  for (uint8_t i = 0; i < CFG_TUH_TIMER_MAX; i++) {
+    usbh_timer_t* timer = &_usbh_timers[i];
+    if ( !timer->func ) {
+      timer->param     = param;
+      timer->expire_ms = tuh_time_millis() + delay_ms;
+      timer->func      = func;
+      return true;
+    }
+  }
+
+  TU_LOG1("USBH: no free timer, increase CFG_TUH_TIMER_MAX\r\n");
+  return false;
+}
+
+// Cancel pending timers of func with param, func = NULL matches any function
+static void usbh_timer_cancel(osal_task_func_t func, void* param) {
+  for (uint8_t i = 0; i < CFG_TUH_TIMER_MAX; i++) {
+    usbh_timer_t* timer = &_usbh_timers[i];
+    if ( timer->func && (func == NULL || timer->func == func) && timer->param == param ) {
+      timer->func = NULL;
+    }
+  }
+}
+
+// Check if any timer is expired
+static bool usbh_timer_expired(void) {
+  if ( !usbh_timer_armed() ) return false;
+
+  uint32_t const now = tuh_time_millis();
+
+  for (uint8_t i = 0; i < CFG_TUH_TIMER_MAX; i++) {
+    usbh_timer_t const* timer = &_usbh_timers[i];
+    if ( timer->func && ((int32_t) (timer->expire_ms - now)) <= 0 ) return true;
+  }
+
+  return false;
+}
+
 bool tuh_task_event_ready(void) {
   // Skip if stack is not initialized
   if ( !tuh_inited() ) return false;
 
-  return !osal_queue_empty(_usbh_q);
+  return !osal_queue_empty(_usbh_q) || usbh_timer_expired();
 }
 
 /* USB Host Driver task
@@ -417,16 +643,23 @@ bool tuh_task_event_ready(void) {
     @endcode
  */
 void tuh_task_ext(uint32_t timeout_ms, bool in_isr) {
-  (void) in_isr; // not implemented yet
-
   // Skip if stack is not initialized
   if ( !tuh_inited() ) return;
 
+  // Deferred execution in (software) interrupt: process queued events and expired timers only, must not block
+  if ( in_isr ) timeout_ms = 0;
+
   // Loop until there is no more events in the queue
   while (1)
   {
+    // invoke expired timers, and limit waiting time to the next expiring one
+    uint32_t const timer_ms = usbh_timer_process();
+
     hcd_event_t event;
-    if ( !osal_queue_receive(_usbh_q, &event, timeout_ms) ) return;
+    if ( !osal_queue_receive(_usbh_q, &event, tu_min32(timeout_ms, timer_ms)) ) {
+      (void) usbh_timer_process();
+      return;
+    }
 
     switch (event.event_id)
     {
@@ -436,13 +669,9 @@ void tuh_task_ext(uint32_t timeout_ms, bool in_isr) {
         if ( _dev0.enumerating ) {
           TU_LOG_USBH("[%u:] USBH Defer Attach until current enumeration complete\r\n", event.rhport);
 
-          bool is_empty = osal_queue_empty(_usbh_q);
+          // Re-queue and exit, otherwise we may loop forever when every queued event is a deferred attach
           osal_queue_send(_usbh_q, &event, in_isr);
-
-          if (is_empty) {
-            // Exit if this is the only event in the queue, otherwise we may loop forever
-            return;
-          }
+          return;
         }else {
           TU_LOG_USBH("[%u:] USBH DEVICE ATTACH\r\n", event.rhport);
           _dev0.enumerating = 1;
@@ -472,6 +701,10 @@ void tuh_task_ext(uint32_t timeout_ms, bool in_isr) {
         TU_LOG_USBH("on EP %02X with %u bytes: %s\r\n", ep_addr, (unsigned int) event.xfer_complete.len,
                     tu_str_xfer_result[event.xfer_complete.result]);
 
+        #if CFG_TUH_MEM_DCACHE_ENABLE
+        usbh_dcache_xfer_complete(event.dev_addr, ep_addr, event.xfer_complete.len);
+        #endif
+
         if (event.dev_addr == 0) {
           // device 0 only has control endpoint
           TU_ASSERT(epnum == 0, );
@@ -682,6 +915,9 @@ static bool usbh_control_xfer_cb (uint8_t dev_addr, uint8_t ep_addr, xfer_result
         {
           // DATA stage: initial data toggle is always 1
           _set_control_xfer_stage(CONTROL_STAGE_DATA);
+          #if CFG_TUH_MEM_DCACHE_ENABLE
+          usbh_dcache_xfer_start(tu_edpt_addr(0, request->bmRequestType_bit.direction), _ctrl_xfer.buffer, request->wLength);
+          #endif
           TU_ASSERT( hcd_edpt_xfer(rhport, dev_addr, tu_edpt_addr(0, request->bmRequestType_bit.direction), _ctrl_xfer.buffer, request->wLength) );
           return true;
         }
@@ -852,6 +1088,11 @@ bool usbh_edpt_xfer_with_callback(uint8_t dev_addr, uint8_t ep_addr, uint8_t * b
   dev->ep_callback[epnum][dir].user_data   = user_data;
 #endif
 
+#if CFG_TUH_MEM_DCACHE_ENABLE
+  if ( dir == TUSB_DIR_IN ) dev->ep_in_buf[epnum] = buffer;
+  usbh_dcache_xfer_start(ep_addr, buffer, total_bytes);
+#endif
+
   if ( hcd_edpt_xfer(dev->rhport, dev_addr, ep_addr, buffer, total_bytes) )
   {
     TU_LOG_USBH("OK\r\n");
@@ -891,6 +1132,55 @@ bool tuh_edpt_open(uint8_t dev_addr, tusb_desc_endpoint_t const * desc_ep)
   return hcd_edpt_open(usbh_get_rhport(dev_addr), dev_addr, desc_ep);
 }
 
+bool tuh_edpt_close(uint8_t daddr, uint8_t ep_addr)
+{
+  usbh_device_t* dev = get_device(daddr);
+  TU_VERIFY(dev && tu_edpt_number(ep_addr) && hcd_edpt_close);
+
+  TU_LOG_USBH("[%u] Close EP %02X\r\n", daddr, ep_addr);
+  TU_VERIFY(hcd_edpt_close(dev->rhport, daddr, ep_addr));
+
+  uint8_t const epnum = tu_edpt_number(ep_addr);
+  uint8_t const dir   = tu_edpt_dir(ep_addr);
+  dev->ep_status[epnum][dir].busy    = 0;
+  dev->ep_status[epnum][dir].claimed = 0;
+
+  return true;
+}
+
+#if CFG_TUH_MEM_DCACHE_ENABLE
+// OUT: write back data to memory for DMA to read. IN: drop cached lines so that no dirty line is evicted on top
+// of data written by DMA, then again on completion since lines could be fetched speculatively in the meantime.
+// Buffer must be aligned and padded to cache line (see CFG_TUH_MEM_ALIGN).
+static void usbh_dcache_xfer_start(uint8_t ep_addr, uint8_t* buffer, uint16_t len) {
+  if ( buffer == NULL || len == 0 ) return;
+
+  if ( tu_edpt_dir(ep_addr) == TUSB_DIR_IN ) {
+    if ( hcd_dcache_invalidate ) hcd_dcache_invalidate(buffer, len);
+  } else {
+    if ( hcd_dcache_clean ) hcd_dcache_clean(buffer, len);
+  }
+}
+
+static void usbh_dcache_xfer_complete(uint8_t daddr, uint8_t ep_addr, uint32_t xferred_bytes) {
+  if ( tu_edpt_dir(ep_addr) != TUSB_DIR_IN || xferred_bytes == 0 ) return;
+
+  uint8_t const epnum = tu_edpt_number(ep_addr);
+  uint8_t* buffer;
+
+  if ( epnum == 0 ) {
+    // only data stage of control transfer carries data
+    buffer = _ctrl_xfer.buffer;
+  } else {
+    usbh_device_t* dev = get_device(daddr);
+    TU_VERIFY(dev, );
+    buffer = dev->ep_in_buf[epnum];
+  }
+
+  if ( buffer && hcd_dcache_invalidate ) hcd_dcache_invalidate(buffer, xferred_bytes);
+}
+#endif
+
 bool usbh_edpt_busy(uint8_t dev_addr, uint8_t ep_addr) {
   usbh_device_t* dev = get_device(dev_addr);
   TU_VERIFY(dev);
@@ -934,6 +1224,7 @@ TU_ATTR_FAST_FUNC void hcd_event_handler(hcd_event_t const* event, bool in_isr)
 
     default:
       osal_queue_send(_usbh_q, event, in_isr);
+      if (tuh_event_hook_cb) tuh_event_hook_cb(event->rhport, event->event_id, in_isr);
     break;
   }
 }
@@ -1093,6 +1384,89 @@ bool tuh_configuration_set(uint8_t daddr, uint8_t config_num,
   return tuh_control_xfer(&xfer);
 }
 
+// Application callback of the pending Clear Feature(HALT), only one control transfer can be in progress
+static struct {
+  tuh_xfer_cb_t complete_cb;
+  uintptr_t user_data;
+} _clear_stall;
+
+// Device resets its data toggle on Clear Feature, host side must follow once the request is acknowledged
+static bool _clear_stall_toggle(uint8_t daddr, tusb_control_request_t const* request)
+{
+  uint8_t const ep_addr = (uint8_t) tu_le16toh(request->wIndex);
+  return hcd_edpt_clear_stall(usbh_get_rhport(daddr), daddr, ep_addr);
+}
+
+static void _clear_stall_complete_cb(tuh_xfer_t* xfer)
+{
+  // user callback can start another control transfer
+  xfer->complete_cb = _clear_stall.complete_cb;
+  xfer->user_data   = _clear_stall.user_data;
+
+  if ( xfer->result == XFER_RESULT_SUCCESS && !_clear_stall_toggle(xfer->daddr, xfer->setup) )
+  {
+    xfer->result = XFER_RESULT_FAILED;
+  }
+
+  xfer->complete_cb(xfer);
+}
+
+bool tuh_edpt_clear_stall(uint8_t daddr, uint8_t ep_addr,
+                          tuh_xfer_cb_t complete_cb, uintptr_t user_data)
+{
+  usbh_device_t const* dev = get_device(daddr);
+  TU_VERIFY(dev && tu_edpt_number(ep_addr));
+
+  TU_LOG_USBH("Clear Stall EP %02X\r\n", ep_addr);
+
+  tusb_control_request_t const request =
+  {
+    .bmRequestType_bit =
+    {
+      .recipient = TUSB_REQ_RCPT_ENDPOINT,
+      .type      = TUSB_REQ_TYPE_STANDARD,
+      .direction = TUSB_DIR_OUT
+    },
+    .bRequest = TUSB_REQ_CLEAR_FEATURE,
+    .wValue   = tu_htole16(TUSB_REQ_FEATURE_EDPT_HALT),
+    .wIndex   = tu_htole16(ep_addr),
+    .wLength  = 0
+  };
+
+  tuh_xfer_t xfer =
+  {
+    .daddr       = daddr,
+    .ep_addr     = 0,
+    .setup       = &request,
+    .buffer      = NULL,
+    .complete_cb = complete_cb,
+    .user_data   = user_data
+  };
+
+  if ( complete_cb )
+  {
+    // pre-check so that callback of a pending request is not overwritten
+    TU_VERIFY(_ctrl_xfer.stage == CONTROL_STAGE_IDLE);
+
+    _clear_stall.complete_cb = complete_cb;
+    _clear_stall.user_data   = user_data;
+    xfer.complete_cb = _clear_stall_complete_cb;
+    xfer.user_data   = 0;
+
+    return tuh_control_xfer(&xfer);
+  }
+
+  // blocking
+  TU_VERIFY(tuh_control_xfer(&xfer));
+  if ( xfer.result == XFER_RESULT_SUCCESS && !_clear_stall_toggle(daddr, &request) )
+  {
+    xfer.result = XFER_RESULT_FAILED;
+    if ( user_data ) *((xfer_result_t*) user_data) = XFER_RESULT_FAILED;
+  }
+
+  return true;
+}
+
 bool tuh_interface_set(uint8_t daddr, uint8_t itf_num, uint8_t itf_alt,
                        tuh_xfer_cb_t complete_cb, uintptr_t user_data)
 {
@@ -1102,7 +1476,7 @@ bool tuh_interface_set(uint8_t daddr, uint8_t itf_num, uint8_t itf_alt,
   {
     .bmRequestType_bit =
     {
-      .recipient = TUSB_REQ_RCPT_DEVICE,
+      .recipient = TUSB_REQ_RCPT_INTERFACE,
       .type      = TUSB_REQ_TYPE_STANDARD,
       .direction = TUSB_DIR_OUT
     },
@@ -1208,7 +1582,15 @@ static inline bool is_hub_addr(uint8_t daddr)
 static void process_removing_device(uint8_t rhport, uint8_t hub_addr, uint8_t hub_port)
 {
   //------------- find the all devices (star-network) under port that is unplugged -------------//
-  // TODO mark as disconnected in ISR, also handle dev0
+  // TODO mark as disconnected in ISR
+
+  // device being enumerated is under the removed port: stop enumeration so that its pending timers
+  // and control transfer do not continue with stale _dev0
+  if ( _dev0.enumerating && _dev0.rhport == rhport &&
+       (hub_addr == 0 || _dev0.hub_addr == hub_addr) &&
+       (hub_port == 0 || _dev0.hub_port == hub_port) ) {
+    enum_abort();
+  }
 
 #if 0
   // index as hub addr, value is hub port (0xFF for invalid)
@@ -1257,6 +1639,7 @@ static void process_removing_device(uint8_t rhport, uint8_t hub_addr, uint8_t hu
 
       hcd_device_close(rhport, daddr);
       clear_device(dev);
+      usbh_timer_cancel(NULL, (void*) (uintptr_t) daddr);
       // abort on-going control xfer if any
       if (_ctrl_xfer.daddr == daddr) _set_control_xfer_stage(CONTROL_STAGE_IDLE);
     }
@@ -1299,6 +1682,30 @@ static bool enum_request_set_addr(void);
 static bool _parse_configuration_descriptor (uint8_t dev_addr, tusb_desc_configuration_t const* desc_cfg);
 static void enum_full_complete(void);
 
+// Enumeration delays are scheduled with usbh timer and continued by these functions
+static void enum_retry_xfer(void* param);
+static void enum_roothub_reset_end(void* param);
+static void enum_roothub_debounced(void* param);
+#if CFG_TUH_HUB
+static void enum_hub_debounced(void* param);
+static void enum_hub_get_status_2(void* param);
+#endif
+
+// Schedule next enumeration step, enumeration is stopped if there is no free timer
+static bool enum_defer_func_ms(osal_task_func_t func, uint32_t delay_ms) {
+  if ( !usbh_defer_func_ms(func, NULL, delay_ms) ) {
+    enum_full_complete();
+    return false;
+  }
+  return true;
+}
+
+// Copy of failed enumeration transfer to be retried after a delay
+static struct {
+  tusb_control_request_t request;
+  tuh_xfer_t xfer;
+} _enum_retry;
+
 // process device enumeration
 static void process_enumeration(tuh_xfer_t* xfer)
 {
@@ -1315,9 +1722,13 @@ static void process_enumeration(tuh_xfer_t* xfer)
     if ( failed_count < ATTEMPT_COUNT_MAX )
     {
       failed_count++;
-      osal_task_delay(ATTEMPT_DELAY_MS); // delay a bit
       TU_LOG1("Enumeration attempt %u\r\n", failed_count);
-      TU_ASSERT(tuh_control_xfer(xfer), );
+
+      // xfer and its setup are temporary, save them to retry after a delay
+      _enum_retry.request    = *xfer->setup;
+      _enum_retry.xfer       = *xfer;
+      _enum_retry.xfer.setup = &_enum_retry.request;
+      TU_ASSERT(enum_defer_func_ms(enum_retry_xfer, ATTEMPT_DELAY_MS), );
     }else
     {
       enum_full_complete();
@@ -1358,8 +1769,7 @@ static void process_enumeration(tuh_xfer_t* xfer)
     break;
 
     case ENUM_HUB_GET_STATUS_2:
-      osal_task_delay(ENUM_RESET_DELAY);
-      TU_ASSERT( hub_port_get_status(_dev0.hub_addr, _dev0.hub_port, _usbh_ctrl_buf, process_enumeration, ENUM_HUB_CLEAR_RESET_2), );
+      TU_ASSERT( enum_defer_func_ms(enum_hub_get_status_2, ENUM_RESET_DELAY), );
     break;
 
     case ENUM_HUB_CLEAR_RESET_2:
@@ -1478,7 +1888,11 @@ static void process_enumeration(tuh_xfer_t* xfer)
     case ENUM_SET_CONFIG:
       // Parse configuration & set up drivers
       // Driver open aren't allowed to make any usb transfer yet
-      TU_ASSERT( _parse_configuration_descriptor(daddr, (tusb_desc_configuration_t*) _usbh_ctrl_buf), );
+      if ( !_parse_configuration_descriptor(daddr, (tusb_desc_configuration_t*) _usbh_ctrl_buf) ) {
+        // malformed configuration, give up on this device
+        enum_full_complete();
+        return;
+      }
 
       TU_ASSERT( tuh_configuration_set(daddr, CONFIG_NUM, process_enumeration, ENUM_CONFIG_DRIVER), );
     break;
@@ -1506,6 +1920,12 @@ static void process_enumeration(tuh_xfer_t* xfer)
   }
 }
 
+static void enum_retry_xfer(void* param)
+{
+  (void) param;
+  TU_ASSERT(tuh_control_xfer(&_enum_retry.xfer), );
+}
+
 static bool enum_new_device(hcd_event_t* event)
 {
   _dev0.rhport   = event->rhport;
@@ -1516,48 +1936,70 @@ static bool enum_new_device(hcd_event_t* event)
   {
     // connected/disconnected directly with roothub
     hcd_port_reset(_dev0.rhport);
-    osal_task_delay(ENUM_RESET_DELAY); // TODO may not work for no-OS on MCU that require reset_end() since
-                                        // sof of controller may not running while resetting
-    hcd_port_reset_end( _dev0.rhport);
-
-    // wait until device connection is stable TODO non blocking
-    osal_task_delay(ENUM_CONTACT_DEBOUNCING_DELAY);
-
-    // device unplugged while delaying
-    if ( !hcd_port_connect_status(_dev0.rhport) ) {
-      enum_full_complete();
-      return true;
-    }
-
-    _dev0.speed = hcd_port_speed_get(_dev0.rhport );
-    TU_LOG_USBH("%s Speed\r\n", tu_str_speed[_dev0.speed]);
-
-    // fake transfer to kick-off the enumeration process
-    tuh_xfer_t xfer;
-    xfer.daddr     = 0;
-    xfer.result    = XFER_RESULT_SUCCESS;
-    xfer.user_data = ENUM_ADDR0_DEVICE_DESC;
-
-
-    process_enumeration(&xfer);
 
+    // sof of controller may not running while resetting on some MCUs that require reset_end(),
+    // tuh_time_millis() should be overridden with a system tick for these
+    TU_ASSERT( enum_defer_func_ms(enum_roothub_reset_end, ENUM_RESET_DELAY) );
   }
 #if CFG_TUH_HUB
   else
   {
     // connected/disconnected via external hub
-    // wait until device connection is stable TODO non blocking
-    osal_task_delay(ENUM_CONTACT_DEBOUNCING_DELAY);
-
-    // ENUM_HUB_GET_STATUS
-    //TU_ASSERT( hub_port_get_status(_dev0.hub_addr, _dev0.hub_port, _usbh_ctrl_buf, enum_hub_get_status0_complete, 0) );
-    TU_ASSERT( hub_port_get_status(_dev0.hub_addr, _dev0.hub_port, _usbh_ctrl_buf, process_enumeration, ENUM_HUB_CLEAR_RESET_1) );
+    // wait until device connection is stable
+    TU_ASSERT( enum_defer_func_ms(enum_hub_debounced, ENUM_CONTACT_DEBOUNCING_DELAY) );
   }
 #endif // hub
 
   return true;
 }
 
+static void enum_roothub_reset_end(void* param)
+{
+  (void) param;
+  hcd_port_reset_end(_dev0.rhport);
+
+  // wait until device connection is stable
+  TU_ASSERT( enum_defer_func_ms(enum_roothub_debounced, ENUM_CONTACT_DEBOUNCING_DELAY), );
+}
+
+static void enum_roothub_debounced(void* param)
+{
+  (void) param;
+
+  // device unplugged while delaying
+  if ( !hcd_port_connect_status(_dev0.rhport) ) {
+    enum_full_complete();
+    return;
+  }
+
+  _dev0.speed = hcd_port_speed_get(_dev0.rhport );
+  TU_LOG_USBH("%s Speed\r\n", tu_str_speed[_dev0.speed]);
+
+  // fake transfer to kick-off the enumeration process
+  tuh_xfer_t xfer;
+  xfer.daddr     = 0;
+  xfer.result    = XFER_RESULT_SUCCESS;
+  xfer.user_data = ENUM_ADDR0_DEVICE_DESC;
+
+  process_enumeration(&xfer);
+}
+
+#if CFG_TUH_HUB
+static void enum_hub_debounced(void* param)
+{
+  (void) param;
+
+  // ENUM_HUB_GET_STATUS
+  TU_ASSERT( hub_port_get_status(_dev0.hub_addr, _dev0.hub_port, _usbh_ctrl_buf, process_enumeration, ENUM_HUB_CLEAR_RESET_1), );
+}
+
+static void enum_hub_get_status_2(void* param)
+{
+  (void) param;
+  TU_ASSERT( hub_port_get_status(_dev0.hub_addr, _dev0.hub_port, _usbh_ctrl_buf, process_enumeration, ENUM_HUB_CLEAR_RESET_2), );
+}
+#endif
+
 static uint8_t get_new_address(bool is_hub) {
   uint8_t start;
   uint8_t end;
@@ -1625,6 +2067,179 @@ static bool enum_request_set_addr(void)
   return true;
 }
 
+// Check if interface matches an entry of match table
+static bool match_entry(usbh_class_match_t const* match, usbh_device_t const* dev, tusb_desc_interface_t const* desc_itf)
+{
+  uint8_t const flags = match->flags;
+
+  if ( (flags & USBH_MATCH_VID         ) && match->vid          != dev->vid                      ) return false;
+  if ( (flags & USBH_MATCH_PID         ) && match->pid          != dev->pid                      ) return false;
+  if ( (flags & USBH_MATCH_ITF_CLASS   ) && match->itf_class    != desc_itf->bInterfaceClass     ) return false;
+  if ( (flags & USBH_MATCH_ITF_SUBCLASS) && match->itf_subclass != desc_itf->bInterfaceSubClass  ) return false;
+  if ( (flags & USBH_MATCH_ITF_PROTOCOL) && match->itf_protocol != desc_itf->bInterfaceProtocol  ) return false;
+
+  return true;
+}
+
+// Check if interface matches driver's match table, driver without table matches everything
+static bool driver_match_interface(usbh_class_driver_t const* driver, usbh_device_t const* dev,
+                                   tusb_desc_interface_t const* desc_itf)
+{
+  usbh_class_match_t const* match = driver->match_table;
+  if ( match == NULL ) return true;
+
+  for ( ; match->flags; match++ )
+  {
+    if ( match_entry(match, dev, desc_itf) ) return true;
+  }
+
+  return false;
+}
+
+//------------- Driver lookup -------------//
+
+// Match entries of all drivers: entries with interface class are sorted by (class, driver id) and followed by
+// entries without class (VID/PID only, or match = NULL for driver without table) sorted by driver id.
+// An interface is only checked against entries of its class and class-less ones.
+typedef struct {
+  usbh_class_match_t const* match;
+  uint8_t itf_class;
+  uint8_t drv_id;
+} usbh_match_index_t;
+
+static usbh_match_index_t _usbh_match_index[CFG_TUH_MATCH_INDEX_MAX];
+static uint8_t _usbh_match_class_count;
+static uint8_t _usbh_match_count;
+static bool _usbh_match_overflow; // index is not complete, fall back to probing drivers one after another
+
+static bool match_index_add(usbh_class_match_t const* match, uint8_t drv_id)
+{
+  TU_VERIFY(_usbh_match_count < CFG_TUH_MATCH_INDEX_MAX);
+
+  usbh_match_index_t const entry = {
+    .match     = match,
+    .itf_class = (match && (match->flags & USBH_MATCH_ITF_CLASS)) ? match->itf_class : 0,
+    .drv_id    = drv_id
+  };
+  uint8_t pos = _usbh_match_count;
+
+  if ( match && (match->flags & USBH_MATCH_ITF_CLASS) )
+  {
+    // drivers are added in order, inserting after entries of same class keeps driver id sorted
+    pos = _usbh_match_class_count;
+    while ( pos > 0 && _usbh_match_index[pos-1].itf_class > entry.itf_class ) pos--;
+    _usbh_match_class_count++;
+  }
+
+  memmove(&_usbh_match_index[pos+1], &_usbh_match_index[pos], (_usbh_match_count - pos) * sizeof(usbh_match_index_t));
+  _usbh_match_index[pos] = entry;
+  _usbh_match_count++;
+
+  return true;
+}
+
+static void match_index_build(void)
+{
+  _usbh_match_class_count = 0;
+  _usbh_match_count = 0;
+  _usbh_match_overflow = false;
+
+  for (uint8_t drv_id = 0; drv_id < TOTAL_DRIVER_COUNT; drv_id++)
+  {
+    usbh_class_driver_t const * driver = get_driver(drv_id);
+    if ( !driver ) continue;
+
+    usbh_class_match_t const* match = driver->match_table;
+    bool added = true;
+
+    if ( match == NULL )
+    {
+      added = match_index_add(NULL, drv_id);
+    }else
+    {
+      for ( ; added && match->flags; match++ ) added = match_index_add(match, drv_id);
+    }
+
+    if ( !added )
+    {
+      TU_LOG1("USBH: driver match index is full, increase CFG_TUH_MATCH_INDEX_MAX\r\n");
+      _usbh_match_overflow = true;
+      return;
+    }
+  }
+}
+
+// Iterate drivers matching an interface in driver order
+typedef struct {
+  uint8_t cls_idx;  // next entry of interface class
+  uint8_t cls_end;
+  uint8_t any_idx;  // next entry without class
+  uint8_t last_drv; // last returned driver
+} usbh_match_iter_t;
+
+static void match_iter_init(usbh_match_iter_t* it, uint8_t itf_class)
+{
+  // binary search first entry of class
+  uint8_t lo = 0, hi = _usbh_match_class_count;
+  while ( lo < hi )
+  {
+    uint8_t const mid = (uint8_t) ((lo + hi) / 2);
+    if ( _usbh_match_index[mid].itf_class < itf_class ) lo = (uint8_t) (mid + 1);
+    else hi = mid;
+  }
+
+  it->cls_idx = lo;
+  it->cls_end = lo;
+  while ( it->cls_end < _usbh_match_class_count && _usbh_match_index[it->cls_end].itf_class == itf_class ) it->cls_end++;
+
+  it->any_idx  = _usbh_match_class_count;
+  it->last_drv = TUSB_INDEX_INVALID_8;
+}
+
+// Return next driver matching the interface, TUSB_INDEX_INVALID_8 if none left
+static uint8_t match_iter_next(usbh_match_iter_t* it, usbh_device_t const* dev, tusb_desc_interface_t const* desc_itf)
+{
+  if ( _usbh_match_overflow )
+  {
+    // index not complete, probe drivers one after another
+    uint8_t drv_id = (it->last_drv == TUSB_INDEX_INVALID_8) ? 0 : (uint8_t) (it->last_drv + 1);
+    for ( ; drv_id < TOTAL_DRIVER_COUNT; drv_id++ )
+    {
+      usbh_class_driver_t const * driver = get_driver(drv_id);
+      if ( driver && driver_match_interface(driver, dev, desc_itf) ) break;
+    }
+
+    if ( drv_id >= TOTAL_DRIVER_COUNT ) return TUSB_INDEX_INVALID_8;
+    it->last_drv = drv_id;
+    return drv_id;
+  }
+
+  while ( it->cls_idx < it->cls_end || it->any_idx < _usbh_match_count )
+  {
+    // merge both lists by driver id to keep driver priority
+    usbh_match_index_t const* entry;
+    if ( it->any_idx >= _usbh_match_count ||
+         (it->cls_idx < it->cls_end && _usbh_match_index[it->cls_idx].drv_id <= _usbh_match_index[it->any_idx].drv_id) )
+    {
+      entry = &_usbh_match_index[it->cls_idx++];
+    }else
+    {
+      entry = &_usbh_match_index[it->any_idx++];
+    }
+
+    // entries of a driver are consecutive, skip driver already returned
+    if ( entry->drv_id == it->last_drv ) continue;
+
+    if ( entry->match == NULL || match_entry(entry->match, dev, desc_itf) )
+    {
+      it->last_drv = entry->drv_id;
+      return entry->drv_id;
+    }
+  }
+
+  return TUSB_INDEX_INVALID_8;
+}
+
 static bool _parse_configuration_descriptor(uint8_t dev_addr, tusb_desc_configuration_t const* desc_cfg)
 {
   usbh_device_t* dev = get_device(dev_addr);
@@ -1682,12 +2297,16 @@ static bool _parse_configuration_descriptor(uint8_t dev_addr, tusb_desc_configur
     uint16_t const drv_len = tu_desc_get_interface_total_len(desc_itf, assoc_itf_count, (uint16_t) (desc_end-p_desc));
     TU_ASSERT(drv_len >= sizeof(tusb_desc_interface_t));
 
-    // Find driver for this interface
-    for (uint8_t drv_id = 0; drv_id < TOTAL_DRIVER_COUNT; drv_id++)
+    // Find driver for this interface: only drivers whose match table contains the interface are opened
+    usbh_match_iter_t match_iter;
+    match_iter_init(&match_iter, desc_itf->bInterfaceClass);
+
+    uint8_t drv_id;
+    while ( (drv_id = match_iter_next(&match_iter, dev, desc_itf)) != TUSB_INDEX_INVALID_8 )
     {
       usbh_class_driver_t const * driver = get_driver(drv_id);
 
-      if (driver && driver->open(dev->rhport, dev_addr, desc_itf, drv_len) )
+      if ( driver->open(dev->rhport, dev_addr, desc_itf, drv_len) )
       {
         // open successfully
         TU_LOG_USBH("  %s opened\r\n", driver->name);
@@ -1697,8 +2316,8 @@ static bool _parse_configuration_descriptor(uint8_t dev_addr, tusb_desc_configur
         {
           uint8_t const itf_num = desc_itf->bInterfaceNumber+i;
 
-          // Interface number must not be used already
-          TU_ASSERT( TUSB_INDEX_INVALID_8 == dev->itf2drv[itf_num] );
+          // Interface number must be in range and not be used already
+          TU_ASSERT( itf_num < CFG_TUH_INTERFACE_MAX && TUSB_INDEX_INVALID_8 == dev->itf2drv[itf_num] );
           dev->itf2drv[itf_num] = drv_id;
         }
 
@@ -1707,12 +2326,12 @@ static bool _parse_configuration_descriptor(uint8_t dev_addr, tusb_desc_configur
 
         break; // exit driver find loop
       }
+    }
 
-      if ( drv_id == TOTAL_DRIVER_COUNT - 1 )
-      {
-        TU_LOG(CFG_TUH_LOG_LEVEL, "[%u:%u] Interface %u: class = %u subclass = %u protocol = %u is not supported\r\n",
-               dev->rhport, dev_addr, desc_itf->bInterfaceNumber, desc_itf->bInterfaceClass, desc_itf->bInterfaceSubClass, desc_itf->bInterfaceProtocol);
-      }
+    if ( drv_id == TUSB_INDEX_INVALID_8 )
+    {
+      TU_LOG(CFG_TUH_LOG_LEVEL, "[%u:%u] Interface %u: class = %u subclass = %u protocol = %u is not supported\r\n",
+             dev->rhport, dev_addr, desc_itf->bInterfaceNumber, desc_itf->bInterfaceClass, desc_itf->bInterfaceSubClass, desc_itf->bInterfaceProtocol);
     }
 
     // next Interface or IAD descriptor
@@ -1757,6 +2376,27 @@ void usbh_driver_set_config_complete(uint8_t dev_addr, uint8_t itf_num)
   }
 }
 
+// Device is removed while being enumerated
+static void enum_abort(void)
+{
+  TU_LOG_USBH("Enumeration aborted\r\n");
+
+  usbh_timer_cancel(enum_retry_xfer, NULL);
+  usbh_timer_cancel(enum_roothub_reset_end, NULL);
+  usbh_timer_cancel(enum_roothub_debounced, NULL);
+#if CFG_TUH_HUB
+  usbh_timer_cancel(enum_hub_debounced, NULL);
+  usbh_timer_cancel(enum_hub_get_status_2, NULL);
+#endif
+
+  // abort on-going control xfer of address 0 if any
+  if (_ctrl_xfer.daddr == 0) _set_control_xfer_stage(CONTROL_STAGE_IDLE);
+  hcd_device_close(_dev0.rhport, 0);
+
+  // hub status is queued again by removal event handler
+  _dev0.enumerating = 0;
+}
+
 static void enum_full_complete(void)
 {
   // mark enumeration as complete
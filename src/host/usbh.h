@@ -93,6 +93,12 @@ TU_ATTR_WEAK void tuh_mount_cb (uint8_t daddr);
 /// Invoked when a device is unmounted (detached)
 TU_ATTR_WEAK void tuh_umount_cb(uint8_t daddr);
 
+// Invoked when an event is queued for tuh_task(), may be called in ISR context. Bare-metal application
+// can use it to pend a low priority software interrupt whose handler calls tuh_task_ext(0, true).
+// Since enumeration delays are timer based, application should also run the task when
+// tuh_task_event_ready() e.g from a periodic tick interrupt.
+TU_ATTR_WEAK void tuh_event_hook_cb(uint8_t rhport, uint32_t eventid, bool in_isr);
+
 //--------------------------------------------------------------------+
 // APPLICATION API
 //--------------------------------------------------------------------+
@@ -111,7 +117,8 @@ bool tuh_inited(void);
 
 // Task function should be called in main/rtos loop, extended version of tuh_task()
 // - timeout_ms: millisecond to wait, zero = no wait, 0xFFFFFFFF = wait forever
-// - in_isr: if function is called in ISR
+// - in_isr: if function is called in ISR e.g a low priority software interrupt pended by tuh_event_hook_cb(),
+//   in which case timeout_ms is ignored and the function never blocks
 void tuh_task_ext(uint32_t timeout_ms, bool in_isr);
 
 // Task function should be called in main/rtos loop
@@ -120,7 +127,7 @@ void tuh_task(void) {
   tuh_task_ext(UINT32_MAX, false);
 }
 
-// Check if there is pending events need processing by tuh_task()
+// Check if there is pending events or expired timers need processing by tuh_task()
 bool tuh_task_event_ready(void);
 
 #ifndef _TUSB_HCD_H_
@@ -136,6 +143,11 @@ bool tuh_rhport_is_active(uint8_t rhport);
 // Assert/de-assert Bus Reset signal to roothub port. USB specs: it should last 10-50ms
 bool tuh_rhport_reset_bus(uint8_t rhport, bool active);
 
+// Current time in milliseconds, used by host stack for non-blocking delays e.g during enumeration.
+// Default implementation (weak) extends the 11-bit frame number of host controller. Application can
+// override it with a system tick e.g if controller does not generate SOF while bus is in reset.
+uint32_t tuh_time_millis(void);
+
 //--------------------------------------------------------------------+
 // Device API
 //--------------------------------------------------------------------+
@@ -180,10 +192,20 @@ bool tuh_edpt_xfer(tuh_xfer_t* xfer);
 // Open a non-control endpoint
 bool tuh_edpt_open(uint8_t daddr, tusb_desc_endpoint_t const * desc_ep);
 
+// Close a non-control endpoint e.g before opening endpoints of another alternate setting, queued transfer
+// is aborted without callback. Return false if not supported by host controller driver
+bool tuh_edpt_close(uint8_t daddr, uint8_t ep_addr);
+
 // Abort a queued transfer. Note: it can only abort transfer that has not been started
 // Return true if a queued transfer is aborted, false if there is no transfer to abort
 bool tuh_edpt_abort_xfer(uint8_t daddr, uint8_t ep_addr);
 
+// Clear Feature ENDPOINT_HALT (control transfer) and reset host side data toggle of a non-control endpoint
+// true on success, false if there is on-going control transfer or incorrect parameters
+// if complete_cb == NULL i.e blocking, user_data should be pointed to xfer_reuslt_t*
+bool tuh_edpt_clear_stall(uint8_t daddr, uint8_t ep_addr,
+                          tuh_xfer_cb_t complete_cb, uintptr_t user_data);
+
 // Set Configuration (control transfer)
 // config_num = 0 will un-configure device. Note: config_num = config_descriptor_index + 1
 // true on success, false if there is on-going control transfer or incorrect parameters
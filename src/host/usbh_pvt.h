@@ -30,6 +30,7 @@
 #include "osal/osal.h"
 #include "common/tusb_fifo.h"
 #include "common/tusb_private.h"
+#include "host/usbh.h"
 
 #ifdef __cplusplus
  extern "C" {
@@ -50,6 +51,44 @@ enum {
 // Class Driver API
 //--------------------------------------------------------------------+
 
+// Match flags of usbh_class_match_t, only fields with flag set are compared
+enum {
+  USBH_MATCH_VID          = TU_BIT(0),
+  USBH_MATCH_PID          = TU_BIT(1),
+  USBH_MATCH_ITF_CLASS    = TU_BIT(2),
+  USBH_MATCH_ITF_SUBCLASS = TU_BIT(3),
+  USBH_MATCH_ITF_PROTOCOL = TU_BIT(4),
+};
+
+// Declarative match entry used to bind an interface to a driver without probing its open().
+// Match table is terminated by an entry with flags = 0
+typedef struct {
+  uint8_t  flags;
+  uint8_t  itf_class;
+  uint8_t  itf_subclass;
+  uint8_t  itf_protocol;
+  uint16_t vid;
+  uint16_t pid;
+} usbh_class_match_t;
+
+#define USBH_CLASS_MATCH_ITF(_class) \
+  { .flags = USBH_MATCH_ITF_CLASS, .itf_class = _class }
+
+#define USBH_CLASS_MATCH_ITF_SUBCLASS(_class, _subclass) \
+  { .flags = USBH_MATCH_ITF_CLASS | USBH_MATCH_ITF_SUBCLASS, .itf_class = _class, .itf_subclass = _subclass }
+
+#define USBH_CLASS_MATCH_ITF_INFO(_class, _subclass, _protocol) \
+  { .flags = USBH_MATCH_ITF_CLASS | USBH_MATCH_ITF_SUBCLASS | USBH_MATCH_ITF_PROTOCOL, \
+    .itf_class = _class, .itf_subclass = _subclass, .itf_protocol = _protocol }
+
+#define USBH_CLASS_MATCH_VID_ITF(_vid, _class) \
+  { .flags = USBH_MATCH_VID | USBH_MATCH_ITF_CLASS, .vid = _vid, .itf_class = _class }
+
+#define USBH_CLASS_MATCH_VID_PID(_vid, _pid) \
+  { .flags = USBH_MATCH_VID | USBH_MATCH_PID, .vid = _vid, .pid = _pid }
+
+#define USBH_CLASS_MATCH_END  { .flags = 0 }
+
 typedef struct {
   #if CFG_TUSB_DEBUG >= 2
   char const* name;
@@ -60,6 +99,10 @@ typedef struct {
   bool (* const set_config )(uint8_t dev_addr, uint8_t itf_num);
   bool (* const xfer_cb    )(uint8_t dev_addr, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes);
   void (* const close      )(uint8_t dev_addr);
+
+  // Optional match table, open() is only invoked for interfaces that match one of its entries.
+  // Driver without match table (NULL) is probed with open() for every interface
+  usbh_class_match_t const* match_table;
 } usbh_class_driver_t;
 
 // Invoked when initializing host stack to get additional class drivers.
@@ -76,6 +119,11 @@ uint8_t* usbh_get_enum_buf(void);
 
 void usbh_int_set(bool enabled);
 
+// Invoke func(param) in usbh task after delay_ms without blocking the task, must be called in usbh task.
+// Return false if all CFG_TUH_TIMER_MAX timers are in use. Timers with the device address as param are
+// cancelled when the device is removed
+bool usbh_defer_func_ms(osal_task_func_t func, void* param, uint32_t delay_ms);
+
 //--------------------------------------------------------------------+
 // USBH Endpoint API
 //--------------------------------------------------------------------+
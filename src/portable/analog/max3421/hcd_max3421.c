@@ -0,0 +1,725 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#include "tusb_option.h"
+
+#if CFG_TUH_ENABLED && CFG_TUH_MAX3421
+
+#include "host/hcd.h"
+#include "max3421.h"
+
+/* SPI traffic is the bottleneck of this controller, the driver tries to keep it minimal:
+ * - FIFO data is moved in a single CS burst (command + payload)
+ * - HIRQ is clocked out as status byte of every command, interrupt handler reads HRSL
+ *   and gets HIRQ for free. All edge interrupts are acked with one HIRQ write
+ * - MODE, PERADDR and SIE data toggles are shadowed, register is only written when changed
+ * - SNDFIFO is double-buffered: next OUT packet is loaded while SIE is sending the current
+ *   one so that consecutive packets are launched back-to-back on HXFRDN
+ * - NAK'ed transfer is retried in a later frame (interval for interrupt endpoint) instead of
+ *   re-launching immediately, other endpoints can use the SIE meanwhile
+ * - FRAME interrupt (every 1 ms) is only enabled while a transfer waits for a later frame or
+ *   frame number is in use, idle bus costs no SPI traffic
+ */
+
+//--------------------------------------------------------------------+
+// MACRO CONSTANT TYPEDEF
+//--------------------------------------------------------------------+
+
+// Number of endpoints (control endpoint of each device included) that can be opened
+#ifndef CFG_TUH_MAX3421_ENDPOINT_TOTAL
+  #define CFG_TUH_MAX3421_ENDPOINT_TOTAL  (8 + 4*(CFG_TUH_DEVICE_MAX-1))
+#endif
+
+// Unused address to flush orphan SNDFIFO packets to, transaction simply times out
+#define DRAIN_ADDR    0x7Fu
+
+// Frames FRAME interrupt is kept enabled after hcd_frame_number(), usbh reads it at least every second
+// while timers are armed
+#define FRAME_KEEPALIVE   2048u
+
+typedef struct {
+  uint8_t daddr;
+  uint8_t ep_num;
+
+  struct TU_ATTR_PACKED {
+    uint8_t ep_dir       : 1;
+    uint8_t xfer_type    : 2;
+    uint8_t low_speed    : 1;
+    uint8_t is_setup     : 1;
+    uint8_t data_toggle  : 1;
+    uint8_t xfer_pending : 1;
+  };
+
+  uint8_t interval;      // frames between polls of a NAK'ed interrupt endpoint
+  uint16_t packet_size;  // 0 if slot is free
+
+  uint8_t* buf;
+  uint16_t total_len;
+  uint16_t xferred_len;  // bytes acknowledged
+  uint16_t queued_len;   // bytes committed to SNDFIFO (OUT only), ahead of xferred_len
+
+  uint32_t retry_frame;  // transfer is not (re)started before this frame
+} max3421_ep_t;
+
+typedef struct {
+  volatile uint32_t frame_count;
+  volatile uint32_t frame_keepalive; // frame count is needed until this frame
+  volatile bool connected;
+  uint8_t speed;
+  bool int_enabled;
+
+  uint8_t hirq;     // clocked out with every SPI command byte
+  uint8_t hien;
+  uint8_t mode;     // shadow registers
+  uint8_t peraddr;
+  uint8_t sie_tog;  // SIE data toggles as in HRSL (HRSL_RCVTOGRD | HRSL_SNDTOGRD)
+
+  max3421_ep_t* xfer_ep;      // endpoint currently transferred by SIE
+  bool xfer_active;           // SIE is busy (xfer_ep may be NULL if closed or draining)
+  bool xfer_sndfifo;          // current transfer consumes SNDFIFO head
+
+  max3421_ep_t* sndfifo_ep;   // owner of committed SNDFIFO packets, NULL if orphan
+  uint8_t sndfifo_count;      // committed SNDFIFO packets (0-2)
+
+  uint8_t sched_idx;
+
+  max3421_ep_t ep[CFG_TUH_MAX3421_ENDPOINT_TOTAL];
+} max3421_data_t;
+
+static max3421_data_t _hcd_data;
+
+//--------------------------------------------------------------------+
+// SPI
+//--------------------------------------------------------------------+
+
+// Serialize SPI access of API called in task context with interrupt handler
+static void api_lock(uint8_t rhport) {
+  tuh_max3421_int_api(rhport, false);
+}
+
+static void api_unlock(uint8_t rhport) {
+  if (_hcd_data.int_enabled) tuh_max3421_int_api(rhport, true);
+}
+
+static void reg_write(uint8_t rhport, uint8_t reg, uint8_t data) {
+  uint8_t const tx_buf[2] = { MAX3421_CMD(reg, true), data };
+  uint8_t rx_buf[2];
+
+  tuh_max3421_spi_cs_api(rhport, true);
+  tuh_max3421_spi_xfer_api(rhport, tx_buf, rx_buf, 2);
+  tuh_max3421_spi_cs_api(rhport, false);
+
+  _hcd_data.hirq = rx_buf[0];
+}
+
+static uint8_t reg_read(uint8_t rhport, uint8_t reg) {
+  uint8_t const tx_buf[2] = { MAX3421_CMD(reg, false), 0 };
+  uint8_t rx_buf[2];
+
+  tuh_max3421_spi_cs_api(rhport, true);
+  tuh_max3421_spi_xfer_api(rhport, tx_buf, rx_buf, 2);
+  tuh_max3421_spi_cs_api(rhport, false);
+
+  _hcd_data.hirq = rx_buf[0];
+  return rx_buf[1];
+}
+
+// command byte and whole payload in one CS burst
+static void fifo_write(uint8_t rhport, uint8_t reg, uint8_t const* buffer, uint16_t len) {
+  uint8_t const cmd = MAX3421_CMD(reg, true);
+
+  tuh_max3421_spi_cs_api(rhport, true);
+  tuh_max3421_spi_xfer_api(rhport, &cmd, &_hcd_data.hirq, 1);
+  tuh_max3421_spi_xfer_api(rhport, buffer, NULL, len);
+  tuh_max3421_spi_cs_api(rhport, false);
+}
+
+static void fifo_read(uint8_t rhport, uint8_t* buffer, uint16_t len) {
+  uint8_t const cmd = MAX3421_CMD(RCVFIFO_ADDR, false);
+
+  tuh_max3421_spi_cs_api(rhport, true);
+  tuh_max3421_spi_xfer_api(rhport, &cmd, &_hcd_data.hirq, 1);
+  tuh_max3421_spi_xfer_api(rhport, NULL, buffer, len);
+  tuh_max3421_spi_cs_api(rhport, false);
+}
+
+static void mode_write(uint8_t rhport, uint8_t mode) {
+  if (mode != _hcd_data.mode) {
+    reg_write(rhport, MODE_ADDR, mode);
+    _hcd_data.mode = mode;
+  }
+}
+
+static void peraddr_write(uint8_t rhport, uint8_t daddr) {
+  if (daddr != _hcd_data.peraddr) {
+    reg_write(rhport, PERADDR_ADDR, daddr);
+    _hcd_data.peraddr = daddr;
+  }
+}
+
+static void hien_write(uint8_t rhport, uint8_t hien) {
+  if (hien != _hcd_data.hien) {
+    reg_write(rhport, HIEN_ADDR, hien);
+    _hcd_data.hien = hien;
+  }
+}
+
+// Count frames from now on, drop FRAME irq latched while it was disabled
+static void frame_irq_enable(uint8_t rhport) {
+  if (!(_hcd_data.hien & HIRQ_FRAME_IRQ)) {
+    reg_write(rhport, HIRQ_ADDR, HIRQ_FRAME_IRQ);
+    hien_write(rhport, _hcd_data.hien | HIRQ_FRAME_IRQ);
+  }
+}
+
+// Stop FRAME irq when no transfer waits for a later frame and frame number is not in use
+static void frame_irq_update(uint8_t rhport) {
+  uint32_t const frame = _hcd_data.frame_count;
+  if ((int32_t) (_hcd_data.frame_keepalive - frame) > 0) return;
+
+  for (uint8_t i = 0; i < CFG_TUH_MAX3421_ENDPOINT_TOTAL; i++) {
+    max3421_ep_t const* ep = &_hcd_data.ep[i];
+    if (ep->xfer_pending && (int32_t) (ep->retry_frame - frame) > 0) return;
+  }
+
+  hien_write(rhport, _hcd_data.hien & (uint8_t) ~HIRQ_FRAME_IRQ);
+}
+
+//--------------------------------------------------------------------+
+// Endpoint helper
+//--------------------------------------------------------------------+
+
+// control endpoint is bi-directional and has a single slot
+static max3421_ep_t* find_opened_ep(uint8_t daddr, uint8_t ep_num, uint8_t ep_dir) {
+  for (uint8_t i = 0; i < CFG_TUH_MAX3421_ENDPOINT_TOTAL; i++) {
+    max3421_ep_t* ep = &_hcd_data.ep[i];
+    if (ep->packet_size && ep->daddr == daddr && ep->ep_num == ep_num &&
+        (ep_num == 0 || ep->ep_dir == ep_dir)) {
+      return ep;
+    }
+  }
+  return NULL;
+}
+
+static max3421_ep_t* allocate_ep(void) {
+  for (uint8_t i = 0; i < CFG_TUH_MAX3421_ENDPOINT_TOTAL; i++) {
+    max3421_ep_t* ep = &_hcd_data.ep[i];
+    if (ep->packet_size == 0) return ep;
+  }
+  return NULL;
+}
+
+// handshake (status stage) of control transfer
+TU_ATTR_ALWAYS_INLINE static inline bool is_status_stage(max3421_ep_t const* ep) {
+  return ep->ep_num == 0 && !ep->is_setup && ep->total_len == 0;
+}
+
+// transfer consumes SNDFIFO data
+TU_ATTR_ALWAYS_INLINE static inline bool is_sndfifo_xfer(max3421_ep_t const* ep) {
+  return ep->ep_dir == TUSB_DIR_OUT && !ep->is_setup && !is_status_stage(ep);
+}
+
+//--------------------------------------------------------------------+
+// Transfer
+//--------------------------------------------------------------------+
+
+// Commit next packet of endpoint to SNDFIFO
+static void sndfifo_load(uint8_t rhport, max3421_ep_t* ep) {
+  uint16_t const len = tu_min16((uint16_t) (ep->total_len - ep->queued_len), ep->packet_size);
+
+  if (len) fifo_write(rhport, SNDFIFO_ADDR, ep->buf + ep->queued_len, len);
+  reg_write(rhport, SNDBC_ADDR, (uint8_t) len);
+
+  ep->queued_len += len;
+  _hcd_data.sndfifo_ep = ep;
+  _hcd_data.sndfifo_count++;
+}
+
+// Send orphan SNDFIFO packet (left by a failed/closed OUT endpoint) to an unused address
+static void sndfifo_drain(uint8_t rhport) {
+  peraddr_write(rhport, DRAIN_ADDR);
+  reg_write(rhport, HXFR_ADDR, HXFR_OUT_NIN);
+
+  _hcd_data.xfer_ep = NULL;
+  _hcd_data.xfer_active = true;
+  _hcd_data.xfer_sndfifo = true;
+}
+
+static void data_toggle_sync(uint8_t rhport, max3421_ep_t const* ep) {
+  uint8_t const mask = (ep->ep_dir == TUSB_DIR_IN) ? HRSL_RCVTOGRD : HRSL_SNDTOGRD;
+  uint8_t const sie_toggle = (_hcd_data.sie_tog & mask) ? 1 : 0;
+
+  if (sie_toggle != ep->data_toggle) {
+    uint8_t hctl;
+    if (ep->ep_dir == TUSB_DIR_IN) {
+      hctl = ep->data_toggle ? HCTL_RCVTOG1 : HCTL_RCVTOG0;
+    } else {
+      hctl = ep->data_toggle ? HCTL_SNDTOG1 : HCTL_SNDTOG0;
+    }
+    reg_write(rhport, HCTL_ADDR, hctl);
+
+    _hcd_data.sie_tog = (uint8_t) ((_hcd_data.sie_tog & ~mask) | (ep->data_toggle ? mask : 0));
+  }
+}
+
+// Launch a transaction of endpoint on SIE
+static void xfer_start(uint8_t rhport, max3421_ep_t* ep) {
+  _hcd_data.xfer_ep = ep;
+  _hcd_data.xfer_active = true;
+  _hcd_data.xfer_sndfifo = false;
+
+  peraddr_write(rhport, ep->daddr);
+
+  // low speed device behind a full speed hub needs PRE packet
+  uint8_t mode = _hcd_data.mode & (uint8_t) ~(MODE_LOWSPEED | MODE_HUBPRE);
+  if (ep->low_speed) {
+    mode |= MODE_LOWSPEED;
+    if (_hcd_data.speed != TUSB_SPEED_LOW) mode |= MODE_HUBPRE;
+  } else if (_hcd_data.speed == TUSB_SPEED_LOW) {
+    mode |= MODE_LOWSPEED;
+  }
+  mode_write(rhport, mode);
+
+  uint8_t hxfr = ep->ep_num;
+
+  if (ep->is_setup) {
+    // SUDFIFO is loaded by hcd_setup_send()
+    hxfr |= HXFR_SETUP;
+  } else if (is_status_stage(ep)) {
+    hxfr |= HXFR_HS | (ep->ep_dir == TUSB_DIR_OUT ? HXFR_OUT_NIN : 0);
+  } else {
+    if (ep->xfer_type == TUSB_XFER_ISOCHRONOUS) {
+      hxfr |= HXFR_ISO;
+    } else {
+      data_toggle_sync(rhport, ep);
+    }
+
+    if (ep->ep_dir == TUSB_DIR_OUT) {
+      hxfr |= HXFR_OUT_NIN;
+      _hcd_data.xfer_sndfifo = true;
+
+      // packet may already be in SNDFIFO: pre-loaded or retained after NAK
+      if (_hcd_data.sndfifo_count == 0) sndfifo_load(rhport, ep);
+    }
+  }
+
+  reg_write(rhport, HXFR_ADDR, hxfr);
+
+  // SIE is sending current packet, fill the other SNDFIFO buffer meanwhile
+  if (_hcd_data.xfer_sndfifo && _hcd_data.sndfifo_count < 2 && ep->queued_len < ep->total_len) {
+    sndfifo_load(rhport, ep);
+  }
+}
+
+// Pick next endpoint with pending transfer, round-robin
+static max3421_ep_t* xfer_next(void) {
+  uint32_t const frame = _hcd_data.frame_count;
+
+  for (uint8_t i = 1; i <= CFG_TUH_MAX3421_ENDPOINT_TOTAL; i++) {
+    uint8_t const idx = (uint8_t) ((_hcd_data.sched_idx + i) % CFG_TUH_MAX3421_ENDPOINT_TOTAL);
+    max3421_ep_t* ep = &_hcd_data.ep[idx];
+
+    if (!ep->xfer_pending) continue;
+
+    // NAK'ed: wait for its frame
+    if ((int32_t) (ep->retry_frame - frame) > 0) continue;
+
+    // SNDFIFO holds packet of another endpoint
+    if (is_sndfifo_xfer(ep) && _hcd_data.sndfifo_count && _hcd_data.sndfifo_ep != ep) continue;
+
+    _hcd_data.sched_idx = idx;
+    return ep;
+  }
+
+  return NULL;
+}
+
+static void xfer_schedule(uint8_t rhport) {
+  if (_hcd_data.xfer_active) return;
+
+  if (_hcd_data.sndfifo_count && _hcd_data.sndfifo_ep == NULL) {
+    sndfifo_drain(rhport);
+    return;
+  }
+
+  if (!_hcd_data.connected) return;
+
+  max3421_ep_t* ep = xfer_next();
+  if (ep) xfer_start(rhport, ep);
+}
+
+static void xfer_complete(max3421_ep_t* ep, xfer_result_t result, bool in_isr) {
+  uint32_t const len = ep->is_setup ? 8 : ep->xferred_len;
+
+  ep->xfer_pending = 0;
+  ep->is_setup = 0;
+
+  hcd_event_xfer_complete(ep->daddr, tu_edpt_addr(ep->ep_num, ep->ep_dir), len, result, in_isr);
+}
+
+static void xfer_done_isr(uint8_t rhport, uint8_t hrsl) {
+  max3421_ep_t* ep = _hcd_data.xfer_ep;
+  uint8_t const result = hrsl & HRSL_RESULT_MASK;
+
+  _hcd_data.xfer_ep = NULL;
+  _hcd_data.xfer_active = false;
+  _hcd_data.sie_tog = hrsl & (HRSL_RCVTOGRD | HRSL_SNDTOGRD);
+
+  // SIE releases SNDFIFO head unless NAK'ed, packet is then retained for retry
+  if (_hcd_data.xfer_sndfifo && result != HRSL_NAK) {
+    _hcd_data.sndfifo_count--;
+    if (_hcd_data.sndfifo_count == 0) _hcd_data.sndfifo_ep = NULL;
+  }
+  _hcd_data.xfer_sndfifo = false;
+
+  // drained or endpoint closed while transferring
+  if (ep == NULL) return;
+
+  switch (result) {
+    case HRSL_NAK:
+      ep->retry_frame = _hcd_data.frame_count + (ep->xfer_type == TUSB_XFER_INTERRUPT ? ep->interval : 1);
+      frame_irq_enable(rhport);
+      break;
+
+    case HRSL_SUCCESS:
+      if (ep->is_setup) {
+        ep->data_toggle = 1;
+        xfer_complete(ep, XFER_RESULT_SUCCESS, true);
+      } else if (is_status_stage(ep)) {
+        xfer_complete(ep, XFER_RESULT_SUCCESS, true);
+      } else if (ep->ep_dir == TUSB_DIR_OUT) {
+        ep->xferred_len += tu_min16((uint16_t) (ep->total_len - ep->xferred_len), ep->packet_size);
+        ep->data_toggle = (hrsl & HRSL_SNDTOGRD) ? 1 : 0;
+
+        if (ep->xferred_len < ep->total_len) {
+          // next packet is already in SNDFIFO: launch it right away
+          xfer_start(rhport, ep);
+        } else {
+          xfer_complete(ep, XFER_RESULT_SUCCESS, true);
+        }
+      } else {
+        uint8_t const rcvbc = reg_read(rhport, RCVBC_ADDR);
+        uint16_t const len = tu_min16(rcvbc, (uint16_t) (ep->total_len - ep->xferred_len));
+
+        if (len) fifo_read(rhport, ep->buf + ep->xferred_len, len);
+        reg_write(rhport, HIRQ_ADDR, HIRQ_RCVDAV_IRQ); // free RCVFIFO
+
+        ep->xferred_len += len;
+        ep->data_toggle = (hrsl & HRSL_RCVTOGRD) ? 1 : 0;
+
+        if (rcvbc < ep->packet_size || ep->xferred_len >= ep->total_len) {
+          xfer_complete(ep, XFER_RESULT_SUCCESS, true);
+        } else {
+          xfer_start(rhport, ep);
+        }
+      }
+      break;
+
+    case HRSL_STALL:
+      xfer_complete(ep, XFER_RESULT_STALLED, true);
+      break;
+
+    default:
+      TU_LOG1("MAX3421 xfer failed: hrsl = %u\r\n", result);
+      xfer_complete(ep, XFER_RESULT_FAILED, true);
+      break;
+  }
+
+  // pre-loaded packet of a failed transfer is orphan
+  if (_hcd_data.sndfifo_ep == ep && !ep->xfer_pending) {
+    _hcd_data.sndfifo_ep = NULL;
+  }
+}
+
+//--------------------------------------------------------------------+
+// Port
+//--------------------------------------------------------------------+
+
+static void connect_detect(uint8_t rhport, bool in_isr) {
+  reg_write(rhport, HCTL_ADDR, HCTL_SAMPLEBUS);
+  uint8_t const jk = reg_read(rhport, HRSL_ADDR) & (HRSL_JSTATUS | HRSL_KSTATUS);
+
+  uint8_t mode = _hcd_data.mode & (uint8_t) ~(MODE_LOWSPEED | MODE_HUBPRE | MODE_SOFKAENAB);
+
+  if (jk == 0) {
+    // SE0: disconnected
+    mode_write(rhport, mode);
+    _hcd_data.connected = false;
+    hcd_event_device_remove(rhport, in_isr);
+  } else if (jk != (HRSL_JSTATUS | HRSL_KSTATUS)) {
+    // J/K meaning depends on current LOWSPEED mode
+    bool const ls_mode = _hcd_data.mode & MODE_LOWSPEED;
+    bool const low_speed = (jk == HRSL_KSTATUS) ? !ls_mode : ls_mode;
+
+    _hcd_data.speed = low_speed ? TUSB_SPEED_LOW : TUSB_SPEED_FULL;
+    mode_write(rhport, mode | MODE_SOFKAENAB | (low_speed ? MODE_LOWSPEED : 0));
+    _hcd_data.connected = true;
+    hcd_event_device_attach(rhport, in_isr);
+  }
+}
+
+//--------------------------------------------------------------------+
+// Controller API
+//--------------------------------------------------------------------+
+
+bool hcd_init(uint8_t rhport) {
+  tuh_max3421_int_api(rhport, false);
+  tu_memclr(&_hcd_data, sizeof(_hcd_data));
+
+  // full duplex SPI, active low level interrupt. Chip powers up in half duplex, this write works in both modes
+  reg_write(rhport, PINCTL_ADDR, PINCTL_FDUPSPI | PINCTL_INTLEVEL);
+
+  // reset and wait for oscillator to stabilize
+  reg_write(rhport, USBCTL_ADDR, USBCTL_CHIPRES);
+  reg_write(rhport, USBCTL_ADDR, 0);
+
+  uint32_t timeout = 100000;
+  while (!(reg_read(rhport, USBIRQ_ADDR) & USBIRQ_OSCOK_IRQ) && --timeout) {}
+  TU_ASSERT(timeout);
+
+  // chip reset clears PERADDR and data toggles
+  _hcd_data.peraddr = 0;
+  _hcd_data.sie_tog = 0;
+
+  _hcd_data.mode = MODE_DPPULLDN | MODE_DMPULLDN | MODE_HOST;
+  reg_write(rhport, MODE_ADDR, _hcd_data.mode);
+
+  // FRAME irq is enabled on demand
+  _hcd_data.hien = HIRQ_CONDET_IRQ | HIRQ_HXFRDN_IRQ;
+  reg_write(rhport, HIEN_ADDR, _hcd_data.hien);
+
+  reg_write(rhport, HIRQ_ADDR, 0xff);
+
+  // device may be already attached
+  connect_detect(rhport, false);
+
+  reg_write(rhport, CPUCTL_ADDR, CPUCTL_IE);
+
+  return true;
+}
+
+void hcd_int_handler(uint8_t rhport) {
+  // HRSL read also clocks out HIRQ: result and interrupt status in one transaction
+  uint8_t const hrsl = reg_read(rhport, HRSL_ADDR);
+  uint8_t const hirq = _hcd_data.hirq & _hcd_data.hien;
+
+  // ack all edge interrupts at once, before a new transfer could raise HXFRDN again
+  if (hirq) reg_write(rhport, HIRQ_ADDR, hirq);
+
+  if (hirq & HIRQ_CONDET_IRQ) {
+    connect_detect(rhport, true);
+  }
+
+  if (hirq & HIRQ_FRAME_IRQ) {
+    _hcd_data.frame_count++;
+  }
+
+  if (hirq & HIRQ_HXFRDN_IRQ) {
+    xfer_done_isr(rhport, hrsl);
+  }
+
+  // after transfer result since NAK could need next frame
+  if (hirq & HIRQ_FRAME_IRQ) {
+    frame_irq_update(rhport);
+  }
+
+  xfer_schedule(rhport);
+}
+
+void hcd_int_enable(uint8_t rhport) {
+  _hcd_data.int_enabled = true;
+  tuh_max3421_int_api(rhport, true);
+}
+
+void hcd_int_disable(uint8_t rhport) {
+  _hcd_data.int_enabled = false;
+  tuh_max3421_int_api(rhport, false);
+}
+
+// Frame is counted with FRAME interrupt, only running while device is connected. Reading it keeps
+// the interrupt enabled for FRAME_KEEPALIVE frames.
+uint32_t hcd_frame_number(uint8_t rhport) {
+  _hcd_data.frame_keepalive = _hcd_data.frame_count + FRAME_KEEPALIVE;
+
+  if (!(_hcd_data.hien & HIRQ_FRAME_IRQ)) {
+    api_lock(rhport);
+    frame_irq_enable(rhport);
+    api_unlock(rhport);
+  }
+
+  return _hcd_data.frame_count;
+}
+
+//--------------------------------------------------------------------+
+// Port API
+//--------------------------------------------------------------------+
+
+bool hcd_port_connect_status(uint8_t rhport) {
+  (void) rhport;
+  return _hcd_data.connected;
+}
+
+// Chip ends the reset by itself, SOFs resume afterwards
+void hcd_port_reset(uint8_t rhport) {
+  api_lock(rhport);
+  reg_write(rhport, HCTL_ADDR, HCTL_BUSRST);
+  api_unlock(rhport);
+}
+
+void hcd_port_reset_end(uint8_t rhport) {
+  (void) rhport;
+}
+
+tusb_speed_t hcd_port_speed_get(uint8_t rhport) {
+  (void) rhport;
+  return (tusb_speed_t) _hcd_data.speed;
+}
+
+void hcd_device_close(uint8_t rhport, uint8_t dev_addr) {
+  api_lock(rhport);
+
+  for (uint8_t i = 0; i < CFG_TUH_MAX3421_ENDPOINT_TOTAL; i++) {
+    max3421_ep_t* ep = &_hcd_data.ep[i];
+    if (ep->packet_size && ep->daddr == dev_addr) {
+      if (_hcd_data.xfer_ep == ep) _hcd_data.xfer_ep = NULL;
+      if (_hcd_data.sndfifo_ep == ep) _hcd_data.sndfifo_ep = NULL;
+      tu_memclr(ep, sizeof(max3421_ep_t));
+    }
+  }
+
+  xfer_schedule(rhport);
+  api_unlock(rhport);
+}
+
+//--------------------------------------------------------------------+
+// Endpoints API
+//--------------------------------------------------------------------+
+
+bool hcd_edpt_open(uint8_t rhport, uint8_t dev_addr, tusb_desc_endpoint_t const * ep_desc) {
+  uint8_t const ep_num = tu_edpt_number(ep_desc->bEndpointAddress);
+  uint8_t const ep_dir = tu_edpt_dir(ep_desc->bEndpointAddress);
+
+  api_lock(rhport);
+
+  // control endpoint of dev0 is re-opened with actual packet size
+  max3421_ep_t* ep = find_opened_ep(dev_addr, ep_num, ep_dir);
+  if (ep == NULL) ep = allocate_ep();
+
+  if (ep) {
+    hcd_devtree_info_t devtree_info;
+    hcd_devtree_get_info(dev_addr, &devtree_info);
+
+    tu_memclr(ep, sizeof(max3421_ep_t));
+    ep->daddr       = dev_addr;
+    ep->ep_num      = ep_num;
+    ep->ep_dir      = ep_dir;
+    ep->xfer_type   = ep_desc->bmAttributes.xfer;
+    ep->low_speed   = (devtree_info.speed == TUSB_SPEED_LOW) ? 1 : 0;
+    ep->interval    = tu_max8(ep_desc->bInterval, 1);
+    ep->packet_size = tu_edpt_packet_size(ep_desc);
+  }
+
+  api_unlock(rhport);
+
+  TU_ASSERT(ep);
+  return true;
+}
+
+bool hcd_setup_send(uint8_t rhport, uint8_t dev_addr, uint8_t const setup_packet[8]) {
+  max3421_ep_t* ep = find_opened_ep(dev_addr, 0, 0);
+  TU_ASSERT(ep);
+
+  api_lock(rhport);
+
+  fifo_write(rhport, SUDFIFO_ADDR, setup_packet, 8);
+
+  ep->ep_dir       = TUSB_DIR_OUT;
+  ep->is_setup     = 1;
+  ep->buf          = NULL;
+  ep->total_len    = 8;
+  ep->xferred_len  = 0;
+  ep->queued_len   = 0;
+  ep->retry_frame  = _hcd_data.frame_count;
+  ep->xfer_pending = 1;
+
+  xfer_schedule(rhport);
+  api_unlock(rhport);
+
+  return true;
+}
+
+bool hcd_edpt_xfer(uint8_t rhport, uint8_t dev_addr, uint8_t ep_addr, uint8_t * buffer, uint16_t buflen) {
+  uint8_t const ep_num = tu_edpt_number(ep_addr);
+  uint8_t const ep_dir = tu_edpt_dir(ep_addr);
+
+  max3421_ep_t* ep = find_opened_ep(dev_addr, ep_num, ep_dir);
+  TU_ASSERT(ep && !ep->xfer_pending);
+
+  api_lock(rhport);
+
+  ep->ep_dir       = ep_dir; // control endpoint direction of data/status stage
+  ep->is_setup     = 0;
+  ep->buf          = buffer;
+  ep->total_len    = buflen;
+  ep->xferred_len  = 0;
+  ep->queued_len   = 0;
+  ep->retry_frame  = _hcd_data.frame_count;
+  ep->xfer_pending = 1;
+
+  xfer_schedule(rhport);
+  api_unlock(rhport);
+
+  return true;
+}
+
+// Transfer is started once its first packet is on the SIE or in SNDFIFO
+bool hcd_edpt_abort_xfer(uint8_t rhport, uint8_t dev_addr, uint8_t ep_addr) {
+  max3421_ep_t* ep = find_opened_ep(dev_addr, tu_edpt_number(ep_addr), tu_edpt_dir(ep_addr));
+  TU_VERIFY(ep);
+
+  api_lock(rhport);
+
+  bool const started = (_hcd_data.xfer_ep == ep) || (_hcd_data.sndfifo_ep == ep) || ep->xferred_len;
+  bool const aborted = ep->xfer_pending && !started;
+  if (aborted) ep->xfer_pending = 0;
+
+  api_unlock(rhport);
+
+  return aborted;
+}
+
+bool hcd_edpt_clear_stall(uint8_t rhport, uint8_t dev_addr, uint8_t ep_addr) {
+  (void) rhport;
+
+  max3421_ep_t* ep = find_opened_ep(dev_addr, tu_edpt_number(ep_addr), tu_edpt_dir(ep_addr));
+  TU_ASSERT(ep);
+
+  ep->data_toggle = 0;
+
+  return true;
+}
+
+#endif
@@ -319,12 +319,20 @@ void dcd_sof_enable(uint8_t rhport, bool en)
 // HELPER
 //--------------------------------------------------------------------+
 
-static void qtd_init(dcd_qtd_t* p_qtd, void * data_ptr, uint16_t total_bytes)
+// Force the CPU to flush the buffer. We increase the size by 31 because the call aligns the
+// address to 32-byte boundaries. Buffer must be word aligned.
+// Cache of transfer buffer is already maintained by usbd when CFG_TUD_MEM_DCACHE_ENABLE is set
+static inline void buffer_dcache_clean_invalidate(void * data_ptr, uint16_t total_bytes)
 {
-  // Force the CPU to flush the buffer. We increase the size by 31 because the call aligns the
-  // address to 32-byte boundaries. Buffer must be word aligned
+#if CFG_TUD_MEM_DCACHE_ENABLE
+  (void) data_ptr; (void) total_bytes;
+#else
   dcd_dcache_clean_invalidate((uint32_t*) tu_align((uint32_t) data_ptr, 4), total_bytes + 31);
+#endif
+}
 
+static void qtd_init(dcd_qtd_t* p_qtd, void * data_ptr, uint16_t total_bytes)
+{
   tu_memclr(p_qtd, sizeof(dcd_qtd_t));
 
   p_qtd->next            = QTD_NEXT_INVALID;
@@ -393,7 +401,8 @@ bool dcd_edpt_open(uint8_t rhport, tusb_desc_endpoint_t const * p_endpoint_desc)
   p_qhd->max_packet_size         = tu_edpt_packet_size(p_endpoint_desc);
   if (p_endpoint_desc->bmAttributes.xfer == TUSB_XFER_ISOCHRONOUS)
   {
-    p_qhd->iso_mult = 1;
+    // number of transactions per microframe, more than 1 for high-bandwidth endpoint
+    p_qhd->iso_mult = tu_edpt_mult(p_endpoint_desc);
   }
 
   p_qhd->qtd_overlay.next        = QTD_NEXT_INVALID;
@@ -479,6 +488,8 @@ bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, uint16_t t
   dcd_qhd_t* p_qhd = &_dcd_data.qhd[epnum][dir];
   dcd_qtd_t* p_qtd = &_dcd_data.qtd[epnum][dir];
 
+  buffer_dcache_clean_invalidate(buffer, total_bytes);
+
   // Prepare qtd
   qtd_init(p_qtd, buffer, total_bytes);
 
@@ -511,6 +522,7 @@ bool dcd_edpt_xfer_fifo (uint8_t rhport, uint8_t ep_addr, tu_fifo_t * ff, uint16
   if ( fifo_info.len_lin >= total_bytes )
   {
     // Linear length is enough for this transfer
+    buffer_dcache_clean_invalidate(fifo_info.ptr_lin, total_bytes);
     qtd_init(p_qtd, fifo_info.ptr_lin, total_bytes);
   }
   else
@@ -518,6 +530,7 @@ bool dcd_edpt_xfer_fifo (uint8_t rhport, uint8_t ep_addr, tu_fifo_t * ff, uint16
     // linear part is not enough
 
     // prepare TD up to linear length
+    buffer_dcache_clean_invalidate(fifo_info.ptr_lin, fifo_info.len_lin);
     qtd_init(p_qtd, fifo_info.ptr_lin, fifo_info.len_lin);
 
     if ( !tu_offset4k((uint32_t) fifo_info.ptr_wrap) && !tu_offset4k(tu_fifo_depth(ff)) )
@@ -536,7 +549,7 @@ bool dcd_edpt_xfer_fifo (uint8_t rhport, uint8_t ep_addr, tu_fifo_t * ff, uint16
         }
       }
 
-      dcd_dcache_clean_invalidate((uint32_t*) tu_align((uint32_t) fifo_info.ptr_wrap, 4), total_bytes - fifo_info.len_wrap + 31);
+      buffer_dcache_clean_invalidate(fifo_info.ptr_wrap, total_bytes - fifo_info.len_wrap);
     }
     else
     {
@@ -28,7 +28,7 @@
 
 // Chipidea Highspeed USB IP implement EHCI for host functionality
 
-#if CFG_TUH_ENABLED && defined(TUP_USBIP_EHCI)
+#if CFG_TUH_ENABLED && defined(TUP_USBIP_EHCI) && !CFG_TUH_MAX3421
 
 //--------------------------------------------------------------------+
 // INCLUDE
@@ -26,7 +26,7 @@
 
 #include "tusb_option.h"
 
-#if CFG_TUH_ENABLED && defined(TUP_USBIP_EHCI)
+#if CFG_TUH_ENABLED && defined(TUP_USBIP_EHCI) && !CFG_TUH_MAX3421
 
 //--------------------------------------------------------------------+
 // INCLUDE
@@ -148,7 +148,7 @@ TU_ATTR_ALWAYS_INLINE static inline ehci_link_t* list_get_period_head(uint8_t rh
 TU_ATTR_ALWAYS_INLINE static inline ehci_qhd_t* list_get_async_head(uint8_t rhport);
 TU_ATTR_ALWAYS_INLINE static inline void list_insert (ehci_link_t *current, ehci_link_t *new, uint8_t new_type);
 TU_ATTR_ALWAYS_INLINE static inline ehci_link_t* list_next (ehci_link_t const *p_link);
-static void list_remove_qhd_by_daddr(ehci_link_t* list_head, uint8_t dev_addr);
+static void list_remove_qhd_by_daddr(ehci_link_t* list_head, uint8_t dev_addr, ehci_qhd_t const* qhd_only);
 
 static void ehci_disable_schedule(ehci_registers_t* regs, bool is_period) {
   // maybe have a timeout for status
@@ -242,11 +242,11 @@ void hcd_device_close(uint8_t rhport, uint8_t daddr)
   }
 
   // Remove from async list
-  list_remove_qhd_by_daddr((ehci_link_t *) list_get_async_head(rhport), daddr);
+  list_remove_qhd_by_daddr((ehci_link_t *) list_get_async_head(rhport), daddr, NULL);
 
   // Remove from all interval period list
   for(uint8_t i = 0; i < TU_ARRAY_SIZE(ehci_data.period_head_arr); i++) {
-    list_remove_qhd_by_daddr((ehci_link_t *) &ehci_data.period_head_arr[i], daddr);
+    list_remove_qhd_by_daddr((ehci_link_t *) &ehci_data.period_head_arr[i], daddr, NULL);
   }
 
   // Async doorbell (EHCI 4.8.2 for operational details)
@@ -452,6 +452,7 @@ bool hcd_edpt_xfer(uint8_t rhport, uint8_t dev_addr, uint8_t ep_addr, uint8_t *
   uint8_t const dir   = tu_edpt_dir(ep_addr);
 
   ehci_qhd_t* qhd = qhd_get_from_addr(dev_addr, ep_addr);
+  TU_VERIFY(qhd);
   ehci_qtd_t* qtd;
 
   if (epnum == 0) {
@@ -478,11 +479,14 @@ bool hcd_edpt_xfer(uint8_t rhport, uint8_t dev_addr, uint8_t ep_addr, uint8_t *
   }
 
   // IN transfer: invalidate buffer, OUT transfer: clean buffer
+  // Transfer buffer is already maintained by usbh when CFG_TUH_MEM_DCACHE_ENABLE is set
+#if !CFG_TUH_MEM_DCACHE_ENABLE
   if (dir) {
     hcd_dcache_invalidate(buffer, buflen);
   }else {
     hcd_dcache_clean(buffer, buflen);
   }
+#endif
 
   // attach TD to QHD -> start transferring
   qhd_attach_qtd(qhd, qtd);
@@ -495,6 +499,7 @@ bool hcd_edpt_abort_xfer(uint8_t rhport, uint8_t dev_addr, uint8_t ep_addr) {
 
   // TODO ISO not supported yet
   ehci_qhd_t* qhd = qhd_get_from_addr(dev_addr, ep_addr);
+  TU_VERIFY(qhd);
   ehci_qtd_t * volatile qtd = qhd->attached_qtd;
   TU_VERIFY(qtd != NULL); // no queued transfer
 
@@ -522,9 +527,33 @@ bool hcd_edpt_abort_xfer(uint8_t rhport, uint8_t dev_addr, uint8_t ep_addr) {
   return still_active; // true if removed an active transfer
 }
 
+bool hcd_edpt_close(uint8_t rhport, uint8_t dev_addr, uint8_t ep_addr) {
+  // control endpoint is only closed with its device
+  TU_VERIFY(dev_addr && tu_edpt_number(ep_addr));
+
+  ehci_qhd_t* qhd = qhd_get_from_addr(dev_addr, ep_addr);
+  TU_VERIFY(qhd);
+
+  // free TD of queued transfer
+  if (qhd->attached_qtd) {
+    (void) hcd_edpt_abort_xfer(rhport, dev_addr, ep_addr);
+  }
+
+  bool const is_period = (qhd->int_smask != 0);
+  ehci_link_t* list_head = is_period ? list_get_period_head(rhport, qhd->interval_ms)
+                                     : (ehci_link_t*) list_get_async_head(rhport);
+  list_remove_qhd_by_daddr(list_head, dev_addr, qhd);
+
+  // Async doorbell (EHCI 4.8.2 for operational details), also frees removed period queue head
+  ehci_data.regs->command_bm.async_adv_doorbell = 1;
+
+  return true;
+}
+
 bool hcd_edpt_clear_stall(uint8_t rhport, uint8_t daddr, uint8_t ep_addr) {
   (void) rhport;
   ehci_qhd_t *qhd = qhd_get_from_addr(daddr, ep_addr);
+  TU_VERIFY(qhd);
   qhd->qtd_overlay.halted = 0;
   qhd->qtd_overlay.data_toggle = 0;
   hcd_dcache_clean_invalidate(qhd, sizeof(ehci_qhd_t));
@@ -538,7 +567,8 @@ bool hcd_edpt_clear_stall(uint8_t rhport, uint8_t daddr, uint8_t ep_addr) {
 
 // async_advance is handshake between usb stack & ehci controller.
 // This isr mean it is safe to modify previously removed queue head from async list.
-// In tinyusb, queue head is only removed when device is unplugged.
+// Queue head is removed when device is unplugged or endpoint is closed, both ring the doorbell. Queue head
+// removed from period list is freed here as well, controller may still reference it until the end of frame.
 TU_ATTR_ALWAYS_INLINE static inline
 void async_advance_isr(uint8_t rhport)
 {
@@ -598,9 +628,11 @@ void qhd_xfer_complete_isr(ehci_qhd_t * qhd) {
     uint32_t const xferred_bytes = qtd->expected_bytes - qtd->total_bytes;
 
     // invalidate dcache if IN transfer with data
+#if !CFG_TUH_MEM_DCACHE_ENABLE
     if (dir == 1 && qhd->attached_buffer != 0 && xferred_bytes > 0) {
       hcd_dcache_invalidate((void*) qhd->attached_buffer, xferred_bytes);
     }
+#endif
 
     // remove and free TD before invoking callback
     qhd_remove_qtd(qhd);
@@ -732,8 +764,8 @@ TU_ATTR_ALWAYS_INLINE static inline void list_insert(ehci_link_t *current, ehci_
   current->address = ((uint32_t) new) | (new_type << 1);
 }
 
-// Remove all queue head belong to this device address
-static void list_remove_qhd_by_daddr(ehci_link_t* list_head, uint8_t dev_addr) {
+// Remove all queue head belong to this device address, or only qhd_only if not NULL
+static void list_remove_qhd_by_daddr(ehci_link_t* list_head, uint8_t dev_addr, ehci_qhd_t const* qhd_only) {
   ehci_link_t* prev = list_head;
 
   while (prev && !prev->terminate) {
@@ -744,23 +776,16 @@ static void list_remove_qhd_by_daddr(ehci_link_t* list_head, uint8_t dev_addr) {
       break;
     }
 
-    if ( qhd->dev_addr == dev_addr ) {
+    if ( qhd->dev_addr == dev_addr && (qhd_only == NULL || qhd == qhd_only) ) {
       // TODO deactivate all TD, wait for QHD to inactive before removal
       prev->address = qhd->next.address;
 
       // EHCI 4.8.2 link the removed qhd's next to async head (which always reachable by Host Controller)
       qhd->next.address = ((uint32_t) list_head) | (EHCI_QTYPE_QHD << 1);
 
-      if ( qhd->int_smask )
-      {
-        // period list queue element is guarantee to be free in the next frame (1 ms)
-        qhd->used = 0;
-      }else
-      {
-        // async list use async advance handshake
-        // mark as removing, will completely re-usable when async advance isr occurs
-        qhd->removing = 1;
-      }
+      // mark as removing, will completely re-usable when async advance isr occurs. Period list queue element
+      // is only free in the next frame (1 ms) and could be re-used right away by endpoint open otherwise
+      qhd->removing = 1;
 
       hcd_dcache_clean(qhd, sizeof(ehci_qhd_t));
       hcd_dcache_clean(prev, sizeof(ehci_qhd_t));
@@ -801,8 +826,9 @@ static ehci_qhd_t *qhd_get_from_addr(uint8_t dev_addr, uint8_t ep_addr) {
 
   ehci_qhd_t *qhd_pool = ehci_data.qhd_pool;
 
+  // skip queue head closed by hcd_edpt_close(), endpoint may be re-opened with another one
   for ( uint32_t i = 0; i < QHD_MAX; i++ ) {
-    if ( (qhd_pool[i].dev_addr == dev_addr) &&
+    if ( qhd_pool[i].used && !qhd_pool[i].removing && (qhd_pool[i].dev_addr == dev_addr) &&
          ep_addr == tu_edpt_addr(qhd_pool[i].ep_number, qhd_pool[i].pid) ) {
       return &qhd_pool[i];
     }
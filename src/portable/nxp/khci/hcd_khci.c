@@ -26,7 +26,7 @@
 
 #include "tusb_option.h"
 
-#if CFG_TUH_ENABLED && defined(TUP_USBIP_CHIPIDEA_FS)
+#if CFG_TUH_ENABLED && defined(TUP_USBIP_CHIPIDEA_FS) && !CFG_TUH_MAX3421
 
 #ifdef TUP_USBIP_CHIPIDEA_FS_KINETIS
   #include "fsl_device_registers.h"
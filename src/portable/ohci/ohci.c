@@ -26,7 +26,7 @@
 
 #include "tusb_option.h"
 
-#if CFG_TUH_ENABLED && defined(TUP_USBIP_OHCI)
+#if CFG_TUH_ENABLED && defined(TUP_USBIP_OHCI) && !CFG_TUH_MAX3421
 
 #ifndef TUP_OHCI_RHPORTS
 #error  OHCI is enabled, but TUP_OHCI_RHPORTS is not defined.
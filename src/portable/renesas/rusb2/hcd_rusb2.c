@@ -27,7 +27,7 @@
 
 #include "tusb_option.h"
 
-#if CFG_TUH_ENABLED && defined(TUP_USBIP_RUSB2)
+#if CFG_TUH_ENABLED && defined(TUP_USBIP_RUSB2) && !CFG_TUH_MAX3421
 
 #include "host/hcd.h"
 #include "rusb2_type.h"
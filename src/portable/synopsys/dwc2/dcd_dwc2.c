@@ -67,16 +67,19 @@
 // Debug level for DWC2
 #define DWC2_DEBUG    2
 
-#ifndef dcache_clean
-#define dcache_clean(_addr, _size)
-#endif
+// Data cache maintenance of transfer buffers is done by usbd with CFG_TUD_MEM_DCACHE_ENABLE
+#if TU_CHECK_MCU(OPT_MCU_BCM2711, OPT_MCU_BCM2835, OPT_MCU_BCM2837)
+void dcd_dcache_clean(void const* addr, uint32_t data_size) {
+  data_clean((void*) (uintptr_t) addr, data_size);
+}
 
-#ifndef dcache_invalidate
-#define dcache_invalidate(_addr, _size)
-#endif
+void dcd_dcache_invalidate(void const* addr, uint32_t data_size) {
+  data_invalidate((void*) (uintptr_t) addr, data_size);
+}
 
-#ifndef dcache_clean_invalidate
-#define dcache_clean_invalidate(_addr, _size)
+void dcd_dcache_clean_invalidate(void const* addr, uint32_t data_size) {
+  data_clean_and_invalidate((void*) (uintptr_t) addr, data_size);
+}
 #endif
 
 static TU_ATTR_ALIGNED(4) uint32_t _setup_packet[2];
@@ -6,14 +6,19 @@ TINYUSB_SRC_C += \
 	src/device/usbd_control.c \
 	src/typec/usbc.c \
 	src/class/audio/audio_device.c \
+	src/class/bridge/bridge.c \
 	src/class/cdc/cdc_device.c \
 	src/class/dfu/dfu_device.c \
 	src/class/dfu/dfu_rt_device.c \
 	src/class/hid/hid_device.c \
 	src/class/midi/midi_device.c \
 	src/class/msc/msc_device.c \
+	src/class/msc/msc_image.c \
 	src/class/net/ecm_rndis_device.c \
 	src/class/net/ncm_device.c \
+	src/class/net/net_csum.c \
 	src/class/usbtmc/usbtmc_device.c \
 	src/class/video/video_device.c \
 	src/class/vendor/vendor_device.c \
+	src/class/vendor/vendor_mux.c \
+	src/class/zero/zero_device.c \
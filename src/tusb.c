@@ -73,6 +73,52 @@ bool tusb_inited(void)
   return ret;
 }
 
+//--------------------------------------------------------------------+
+// Checksum helper
+//--------------------------------------------------------------------+
+
+// Word at a time, 32-bit words are summed with end-around carry which folds to the same 16-bit sum
+uint32_t tu_csum_copy(void* dst, void const* src, uint32_t len, uint32_t sum)
+{
+  uint8_t* d = (uint8_t*) dst;
+  uint8_t const* s = (uint8_t const*) src;
+
+  while ( len >= 4 )
+  {
+    uint32_t const w = tu_unaligned_read32(s);
+    tu_unaligned_write32(d, w);
+    sum += w;
+    if ( sum < w ) sum++; // carry
+
+    d += 4; s += 4; len -= 4;
+  }
+
+  if ( len >= 2 )
+  {
+    uint16_t const w = tu_unaligned_read16(s);
+    tu_unaligned_write16(d, w);
+    sum += w;
+    if ( sum < w ) sum++;
+
+    d += 2; s += 2; len -= 2;
+  }
+
+  if ( len )
+  {
+    // odd byte is the first byte of a zero padded 16-bit word
+    *d = *s;
+#if TU_BYTE_ORDER == TU_LITTLE_ENDIAN
+    uint32_t const w = *s;
+#else
+    uint32_t const w = ((uint32_t) *s) << 8;
+#endif
+    sum += w;
+    if ( sum < w ) sum++;
+  }
+
+  return sum;
+}
+
 //--------------------------------------------------------------------+
 // Descriptor helper
 //--------------------------------------------------------------------+
@@ -82,6 +128,7 @@ uint8_t const * tu_desc_find(uint8_t const* desc, uint8_t const* end, uint8_t by
   while(desc+1 < end)
   {
     if ( desc[1] == byte1 ) return desc;
+    if ( 0 == desc[DESC_OFFSET_LEN] ) break; // malformed descriptor, would never advance
     desc += desc[DESC_OFFSET_LEN];
   }
   return NULL;
@@ -92,6 +139,7 @@ uint8_t const * tu_desc_find2(uint8_t const* desc, uint8_t const* end, uint8_t b
   while(desc+2 < end)
   {
     if ( desc[1] == byte1 && desc[2] == byte2) return desc;
+    if ( 0 == desc[DESC_OFFSET_LEN] ) break; // malformed descriptor, would never advance
     desc += desc[DESC_OFFSET_LEN];
   }
   return NULL;
@@ -102,6 +150,7 @@ uint8_t const * tu_desc_find3(uint8_t const* desc, uint8_t const* end, uint8_t b
   while(desc+3 < end)
   {
     if (desc[1] == byte1 && desc[2] == byte2 && desc[3] == byte3) return desc;
+    if ( 0 == desc[DESC_OFFSET_LEN] ) break; // malformed descriptor, would never advance
     desc += desc[DESC_OFFSET_LEN];
   }
   return NULL;
@@ -112,6 +161,52 @@ uint8_t const * tu_desc_find3(uint8_t const* desc, uint8_t const* end, uint8_t b
 // Endpoint Helper for both Host and Device stack
 //--------------------------------------------------------------------+
 
+// Claim/release is done with compare-and-swap on the whole endpoint state when the core has
+// lock-free byte atomics (e.g Cortex-M3 and above), otherwise fall back to provided mutex.
+#if defined(__GNUC__) && defined(__GCC_ATOMIC_CHAR_LOCK_FREE) && (__GCC_ATOMIC_CHAR_LOCK_FREE == 2)
+  #define TU_EDPT_STATE_ATOMIC   1
+#else
+  #define TU_EDPT_STATE_ATOMIC   0
+#endif
+
+#if TU_EDPT_STATE_ATOMIC
+
+// Atomically update claimed bit from 'from' to 'to', only if endpoint is not busy
+static bool edpt_claimed_cas(tu_edpt_state_t* ep_state, uint8_t from, uint8_t to)
+{
+  tu_edpt_state_t expected;
+  expected.value = __atomic_load_n(&ep_state->value, __ATOMIC_RELAXED);
+
+  while (1)
+  {
+    // only retry when other state bits (e.g stalled) change concurrently
+    TU_VERIFY((expected.busy == 0) && (expected.claimed == from));
+
+    tu_edpt_state_t desired = expected;
+    desired.claimed = to;
+
+    if ( __atomic_compare_exchange_n(&ep_state->value, (uint8_t*) &expected.value, desired.value,
+                                     false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED) )
+    {
+      return true;
+    }
+  }
+}
+
+bool tu_edpt_claim(tu_edpt_state_t* ep_state, osal_mutex_t mutex)
+{
+  (void) mutex;
+  return edpt_claimed_cas(ep_state, 0, 1);
+}
+
+bool tu_edpt_release(tu_edpt_state_t* ep_state, osal_mutex_t mutex)
+{
+  (void) mutex;
+  return edpt_claimed_cas(ep_state, 1, 0);
+}
+
+#else
+
 bool tu_edpt_claim(tu_edpt_state_t* ep_state, osal_mutex_t mutex)
 {
   (void) mutex;
@@ -150,10 +245,20 @@ bool tu_edpt_release(tu_edpt_state_t* ep_state, osal_mutex_t mutex)
   return ret;
 }
 
+#endif
+
 bool tu_edpt_validate(tusb_desc_endpoint_t const * desc_ep, tusb_speed_t speed)
 {
   uint16_t const max_packet_size = tu_edpt_packet_size(desc_ep);
-  TU_LOG2("  Open EP %02X with Size = %u\r\n", desc_ep->bEndpointAddress, max_packet_size);
+  uint8_t const mult = tu_edpt_mult(desc_ep);
+  TU_LOG2("  Open EP %02X with Size = %u x %u\r\n", desc_ep->bEndpointAddress, max_packet_size, mult);
+
+  // Additional transactions per microframe is only allowed for highspeed periodic endpoint
+  if ( mult > 1 )
+  {
+    TU_ASSERT(speed == TUSB_SPEED_HIGH && mult <= TUSB_EDPT_HIGH_BANDWIDTH_MULT_MAX &&
+              (desc_ep->bmAttributes.xfer == TUSB_XFER_ISOCHRONOUS || desc_ep->bmAttributes.xfer == TUSB_XFER_INTERRUPT));
+  }
 
   switch (desc_ep->bmAttributes.xfer)
   {
@@ -213,14 +318,17 @@ uint16_t tu_desc_get_interface_total_len(tusb_desc_interface_t const* desc_itf,
   uint8_t const* p_desc = (uint8_t const*) desc_itf;
   uint16_t len = 0;
 
-  while (itf_count--)
+  while (itf_count-- && len < max_len)
   {
     // Next on interface desc
-    len += tu_desc_len(desc_itf);
+    len += tu_desc_len(p_desc);
     p_desc = tu_desc_next(p_desc);
 
     while (len < max_len)
     {
+      // malformed zero length descriptor would never advance
+      if ( 0 == tu_desc_len(p_desc) ) return len;
+
       // return on IAD regardless of itf count
       if ( tu_desc_type(p_desc) == TUSB_DESC_INTERFACE_ASSOCIATION ) return len;
 
@@ -65,6 +65,14 @@
     #include "class/vendor/vendor_host.h"
   #endif
 
+  #if CFG_TUH_VENDOR_MUX
+    #include "class/vendor/vendor_mux_host.h"
+  #endif
+
+  #if CFG_TUH_ZERO
+    #include "class/zero/zero_host.h"
+  #endif
+
 #endif
 
 //------------- DEVICE -------------//
@@ -83,6 +91,10 @@
     #include "class/msc/msc_device.h"
   #endif
 
+  #if CFG_TUD_MSC && CFG_TUD_MSC_IMAGE
+    #include "class/msc/msc_image.h"
+  #endif
+
   #if CFG_TUD_AUDIO
     #include "class/audio/audio_device.h"
   #endif
@@ -99,6 +111,10 @@
     #include "class/vendor/vendor_device.h"
   #endif
 
+  #if CFG_TUD_ZERO
+    #include "class/zero/zero_device.h"
+  #endif
+
   #if CFG_TUD_USBTMC
     #include "class/usbtmc/usbtmc_device.h"
   #endif
@@ -120,6 +136,11 @@
   #endif
 #endif
 
+//------------- DUAL ROLE -------------//
+#if CFG_TUD_ENABLED && CFG_TUH_ENABLED && CFG_TUSB_BRIDGE
+  #include "class/bridge/bridge.h"
+#endif
+
 
 //--------------------------------------------------------------------+
 // APPLICATION API
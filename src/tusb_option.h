@@ -310,6 +310,12 @@
   #define CFG_TUSB_MEM_ALIGN      TU_ATTR_ALIGNED(4)
 #endif
 
+// D-Cache line size. When cache maintenance is enabled (CFG_TUD_MEM_DCACHE_ENABLE/CFG_TUH_MEM_DCACHE_ENABLE)
+// transfer buffers are aligned to it and should be sized in multiple of it e.g with TUD_EPBUF_DEF()/TUD_EPBUF_SIZE()
+#ifndef CFG_TUSB_MEM_DCACHE_LINE_SIZE
+  #define CFG_TUSB_MEM_DCACHE_LINE_SIZE   32
+#endif
+
 // OS selection
 #ifndef CFG_TUSB_OS
   #define CFG_TUSB_OS             OPT_OS_NONE
@@ -319,6 +325,17 @@
   #define CFG_TUSB_OS_INC_PATH
 #endif
 
+// Multi-core: tud_task() runs on one core while class read/write API is called from another core.
+// Class fifos become lock-free single producer/consumer and endpoints are only touched by the stack
+// core, application requests (e.g flush) are passed to it. Requires GCC compatible atomic builtins.
+#ifndef CFG_TUSB_MULTICORE
+  #define CFG_TUSB_MULTICORE      0
+#endif
+
+#if CFG_TUSB_MULTICORE && !defined(__GNUC__)
+  #error "CFG_TUSB_MULTICORE requires GCC compatible atomic builtins"
+#endif
+
 //--------------------------------------------------------------------
 // Device Options (Default)
 //--------------------------------------------------------------------
@@ -328,9 +345,19 @@
   #define CFG_TUD_MEM_SECTION     CFG_TUSB_MEM_SECTION
 #endif
 
-// Attribute to align memory for device controller (default: CFG_TUSB_MEM_ALIGN)
+// Enable D-Cache maintenance of transfer buffers: usbd cleans buffer before IN and invalidates it before/after
+// OUT transfer so that buffers can be placed in cacheable RAM. DCD must implement dcd_dcache_clean/invalidate()
+#ifndef CFG_TUD_MEM_DCACHE_ENABLE
+  #define CFG_TUD_MEM_DCACHE_ENABLE   0
+#endif
+
+// Attribute to align memory for device controller (default: CFG_TUSB_MEM_ALIGN, or cache line if cache maintenance is enabled)
 #ifndef CFG_TUD_MEM_ALIGN
-  #define CFG_TUD_MEM_ALIGN       CFG_TUSB_MEM_ALIGN
+  #if CFG_TUD_MEM_DCACHE_ENABLE
+    #define CFG_TUD_MEM_ALIGN     TU_ATTR_ALIGNED(CFG_TUSB_MEM_DCACHE_LINE_SIZE)
+  #else
+    #define CFG_TUD_MEM_ALIGN     CFG_TUSB_MEM_ALIGN
+  #endif
 #endif
 
 #ifndef CFG_TUD_ENDPOINT0_SIZE
@@ -341,6 +368,17 @@
   #define CFG_TUD_INTERFACE_MAX   16
 #endif
 
+// Timestamp transfer completion with SOF count (SOF interrupt is kept enabled), used by audio and video
+// for per packet timestamps and latency statistics
+#ifndef CFG_TUD_XFER_TIMESTAMP
+  #define CFG_TUD_XFER_TIMESTAMP  0
+#endif
+
+// Number of outstanding application writes/reads tracked for latency statistics per stream
+#ifndef CFG_TUD_XFER_TIMESTAMP_MARKS
+  #define CFG_TUD_XFER_TIMESTAMP_MARKS  8
+#endif
+
 #ifndef CFG_TUD_CDC
   #define CFG_TUD_CDC             0
 #endif
@@ -349,6 +387,11 @@
   #define CFG_TUD_MSC             0
 #endif
 
+// Read-only LUN backend serving a block compressed disk image
+#ifndef CFG_TUD_MSC_IMAGE
+  #define CFG_TUD_MSC_IMAGE       0
+#endif
+
 #ifndef CFG_TUD_HID
   #define CFG_TUD_HID             0
 #endif
@@ -369,6 +412,16 @@
   #define CFG_TUD_VENDOR          0
 #endif
 
+// Virtual channel multiplexer on vendor interface with VENDOR_MUX subclass/protocol
+#ifndef CFG_TUD_VENDOR_MUX
+  #define CFG_TUD_VENDOR_MUX      0
+#endif
+
+// Source/sink and loopback test function (gadget zero)
+#ifndef CFG_TUD_ZERO
+  #define CFG_TUD_ZERO            0
+#endif
+
 #ifndef CFG_TUD_USBTMC
   #define CFG_TUD_USBTMC          0
 #endif
@@ -411,14 +464,34 @@
   #endif
 #endif // CFG_TUH_ENABLED
 
+// Use MAX3421E SPI host controller (portable/analog/max3421) instead of MCU built-in controller.
+// Native host controller drivers compile to nothing when enabled, build with MAX3421_HOST=1 to add the driver
+#ifndef CFG_TUH_MAX3421
+  #define CFG_TUH_MAX3421  0
+#endif
+
+#if CFG_TUH_MAX3421 && defined(CFG_TUH_RPI_PIO_USB) && CFG_TUH_RPI_PIO_USB
+  #error "CFG_TUH_MAX3421 and CFG_TUH_RPI_PIO_USB are both host controller drivers, only one can be enabled"
+#endif
+
 // Attribute to place data in accessible RAM for host controller (default: CFG_TUSB_MEM_SECTION)
 #ifndef CFG_TUH_MEM_SECTION
   #define CFG_TUH_MEM_SECTION   CFG_TUSB_MEM_SECTION
 #endif
 
-// Attribute to align memory for host controller
+// Enable D-Cache maintenance for host: class buffers are aligned to cache line and usbh cleans/invalidates every
+// transfer buffer with hcd_dcache_clean/invalidate() which must be implemented for cacheable RAM
+#ifndef CFG_TUH_MEM_DCACHE_ENABLE
+  #define CFG_TUH_MEM_DCACHE_ENABLE   0
+#endif
+
+// Attribute to align memory for host controller (default: CFG_TUSB_MEM_ALIGN, or cache line if cache maintenance is enabled)
 #ifndef CFG_TUH_MEM_ALIGN
-  #define CFG_TUH_MEM_ALIGN     CFG_TUSB_MEM_ALIGN
+  #if CFG_TUH_MEM_DCACHE_ENABLE
+    #define CFG_TUH_MEM_ALIGN   TU_ATTR_ALIGNED(CFG_TUSB_MEM_DCACHE_LINE_SIZE)
+  #else
+    #define CFG_TUH_MEM_ALIGN   CFG_TUSB_MEM_ALIGN
+  #endif
 #endif
 
 //------------- CLASS -------------//
@@ -457,6 +530,16 @@
 #define CFG_TUH_VENDOR 0
 #endif
 
+// Virtual channel multiplexer on vendor interface with VENDOR_MUX subclass/protocol
+#ifndef CFG_TUH_VENDOR_MUX
+#define CFG_TUH_VENDOR_MUX 0
+#endif
+
+// Source/sink and loopback test driver (usbtest), number of interfaces
+#ifndef CFG_TUH_ZERO
+#define CFG_TUH_ZERO 0
+#endif
+
 #ifndef CFG_TUH_API_EDPT_XFER
 #define CFG_TUH_API_EDPT_XFER 0
 #endif
@@ -470,6 +553,15 @@
 #define CFG_TUD_RPI_PIO_USB 0
 #endif
 
+//--------------------------------------------------------------------+
+// Dual Role Options (Default)
+//--------------------------------------------------------------------+
+
+// Host <-> Device endpoint bridge: number of channels, requires CFG_TUH_API_EDPT_XFER
+#ifndef CFG_TUSB_BRIDGE
+#define CFG_TUSB_BRIDGE 0
+#endif
+
 
 //--------------------------------------------------------------------+
 // TypeC Options (Default)
@@ -0,0 +1,52 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include "tusb.h"
+
+#define BENCH_MSC_BLOCK_SIZE    512
+#define BENCH_MSC_BLOCK_COUNT   2048
+#define BENCH_HID_REPORT_SIZE   64
+
+// usb_descriptors.c
+void bench_desc_set_hid_interval(uint8_t interval);
+void bench_desc_set_msc_uas(bool enabled);
+
+// device_app.c
+void bench_device_task(void);
+void bench_device_hid_stream(bool enabled);
+uint8_t* bench_device_msc_block(uint32_t lba);
+
+// device_app.c: vendor source/sink, application class driver registered with UAS one (uas_device.c)
+void     bench_vendor_init(void);
+void     bench_vendor_reset(uint8_t rhport);
+uint16_t bench_vendor_open(uint8_t rhport, tusb_desc_interface_t const* itf_desc, uint16_t max_len);
+bool     bench_vendor_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t const* request);
+bool     bench_vendor_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes);
+
+#endif
@@ -0,0 +1,195 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#include <string.h>
+#include "bench.h"
+#include "sim_bus.h"
+#include "device/usbd_pvt.h"
+
+// Device side of the benchmark: MSC RAM disk, CDC echo, HID report stream and vendor source/sink
+
+static uint8_t _msc_disk[BENCH_MSC_BLOCK_COUNT][BENCH_MSC_BLOCK_SIZE];
+static bool _hid_stream;
+
+static struct {
+  uint8_t ep_in;
+  uint8_t ep_out;
+} _vendor;
+
+// IN always sends zeros, OUT data is dropped
+static uint8_t _vendor_buf[2][512];
+
+//--------------------------------------------------------------------+
+// MSC RAM disk
+//--------------------------------------------------------------------+
+
+// also served by UAS device (uas_device.c)
+uint8_t* bench_device_msc_block(uint32_t lba) {
+  return _msc_disk[lba];
+}
+
+void tud_msc_inquiry_cb(uint8_t lun, uint8_t vendor_id[8], uint8_t product_id[16], uint8_t product_rev[4]) {
+  (void) lun;
+  memcpy(vendor_id, "TinyUSB ", 8);
+  memcpy(product_id, "Benchmark Disk  ", 16);
+  memcpy(product_rev, "1.0 ", 4);
+}
+
+bool tud_msc_test_unit_ready_cb(uint8_t lun) {
+  (void) lun;
+  return true;
+}
+
+void tud_msc_capacity_cb(uint8_t lun, uint32_t* block_count, uint16_t* block_size) {
+  (void) lun;
+  *block_count = BENCH_MSC_BLOCK_COUNT;
+  *block_size = BENCH_MSC_BLOCK_SIZE;
+}
+
+int32_t tud_msc_read10_cb(uint8_t lun, uint32_t lba, uint32_t offset, void* buffer, uint32_t bufsize) {
+  (void) lun;
+  if (lba >= BENCH_MSC_BLOCK_COUNT) return -1;
+  memcpy(buffer, _msc_disk[lba] + offset, bufsize);
+  return (int32_t) bufsize;
+}
+
+int32_t tud_msc_write10_cb(uint8_t lun, uint32_t lba, uint32_t offset, uint8_t* buffer, uint32_t bufsize) {
+  (void) lun;
+  if (lba >= BENCH_MSC_BLOCK_COUNT) return -1;
+  memcpy(_msc_disk[lba] + offset, buffer, bufsize);
+  return (int32_t) bufsize;
+}
+
+int32_t tud_msc_scsi_cb(uint8_t lun, uint8_t const scsi_cmd[16], void* buffer, uint16_t bufsize) {
+  (void) buffer;
+  (void) bufsize;
+  (void) scsi_cmd;
+  tud_msc_set_sense(lun, SCSI_SENSE_ILLEGAL_REQUEST, 0x20, 0x00);
+  return -1;
+}
+
+//--------------------------------------------------------------------+
+// HID report stream
+//--------------------------------------------------------------------+
+
+// Report carries bus time when it was queued, host uses it to compute latency
+static void hid_send_report(void) {
+  uint8_t report[BENCH_HID_REPORT_SIZE] = { 0 };
+  uint64_t const now = sim_bus_time_ns();
+  memcpy(report, &now, sizeof(now));
+  tud_hid_report(0, report, sizeof(report));
+}
+
+void bench_device_hid_stream(bool enabled) {
+  _hid_stream = enabled;
+}
+
+void tud_hid_report_complete_cb(uint8_t instance, uint8_t const* report, uint16_t len) {
+  (void) instance;
+  (void) report;
+  (void) len;
+  if (_hid_stream) hid_send_report();
+}
+
+uint16_t tud_hid_get_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_t report_type, uint8_t* buffer,
+                               uint16_t reqlen) {
+  (void) instance;
+  (void) report_id;
+  (void) report_type;
+  (void) buffer;
+  (void) reqlen;
+  return 0;
+}
+
+void tud_hid_set_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_t report_type, uint8_t const* buffer,
+                           uint16_t bufsize) {
+  (void) instance;
+  (void) report_id;
+  (void) report_type;
+  (void) buffer;
+  (void) bufsize;
+}
+
+//--------------------------------------------------------------------+
+// Vendor source/sink
+//--------------------------------------------------------------------+
+
+// Like Linux g_zero: interface has no class code nor class request, host binds it with tuh_zero_match_cb()
+void bench_vendor_init(void) {
+  tu_varclr(&_vendor);
+}
+
+void bench_vendor_reset(uint8_t rhport) {
+  (void) rhport;
+  tu_varclr(&_vendor);
+}
+
+uint16_t bench_vendor_open(uint8_t rhport, tusb_desc_interface_t const* itf_desc, uint16_t max_len) {
+  uint16_t const drv_len = sizeof(tusb_desc_interface_t) + 2 * sizeof(tusb_desc_endpoint_t);
+  TU_VERIFY(TUSB_CLASS_VENDOR_SPECIFIC == itf_desc->bInterfaceClass && 0 == itf_desc->bInterfaceSubClass &&
+            2 == itf_desc->bNumEndpoints && drv_len <= max_len, 0);
+
+  TU_ASSERT(usbd_open_edpt_pair(rhport, tu_desc_next(itf_desc), 2, TUSB_XFER_BULK, &_vendor.ep_out, &_vendor.ep_in), 0);
+  TU_ASSERT(usbd_edpt_xfer(rhport, _vendor.ep_in, _vendor_buf[0], sizeof(_vendor_buf[0])), 0);
+  TU_ASSERT(usbd_edpt_xfer(rhport, _vendor.ep_out, _vendor_buf[1], sizeof(_vendor_buf[1])), 0);
+
+  return drv_len;
+}
+
+bool bench_vendor_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t const* request) {
+  (void) rhport;
+  (void) stage;
+  (void) request;
+  return false;
+}
+
+bool bench_vendor_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes) {
+  (void) result;
+  (void) xferred_bytes;
+
+  if (ep_addr == _vendor.ep_in) return usbd_edpt_xfer(rhport, ep_addr, _vendor_buf[0], sizeof(_vendor_buf[0]));
+  if (ep_addr == _vendor.ep_out) return usbd_edpt_xfer(rhport, ep_addr, _vendor_buf[1], sizeof(_vendor_buf[1]));
+  return false;
+}
+
+//--------------------------------------------------------------------+
+// Task
+//--------------------------------------------------------------------+
+
+void bench_device_task(void) {
+  // CDC echo
+  uint8_t buf[512];
+  while (tud_cdc_available() && tud_cdc_write_available()) {
+    uint32_t const count = tud_cdc_read(buf, tu_min32(sizeof(buf), tud_cdc_write_available()));
+    tud_cdc_write(buf, count);
+  }
+  tud_cdc_write_flush();
+
+  // start HID stream, continued by report complete callback
+  if (_hid_stream && tud_hid_ready()) {
+    hid_send_report();
+  }
+}
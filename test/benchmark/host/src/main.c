@@ -0,0 +1,634 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+/* Host class driver benchmark
+ *
+ * Runs msc_host (sequential/random READ10 over Bulk-Only and UAS), cdc_host (bulk loopback), hid_host (interrupt polling) and
+ * zero_host (source/sink and loopback with bulk, interrupt and isochronous endpoints, and a vendor interface
+ * without class code bound by tuh_zero_match_cb()) against
+ * tinyusb's own device stack over a simulated bus (sim_bus.c). For each configuration it reports:
+ * - throughput and per-transfer latency in bus time, derived from the wire time of every packet
+ * - task CPU cost: thread cpu time spent in tuh_task() and tud_task() per transfer
+ *
+ * Usage: host_benchmark [-q]    -q: quick run with less data, used by CI
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bench.h"
+#include "sim_bus.h"
+
+//--------------------------------------------------------------------+
+// MACRO CONSTANT TYPEDEF PROTYPES
+//--------------------------------------------------------------------+
+
+#define TIMEOUT_NS   (60ull * 1000000000ull) // bus time
+
+// outstanding READ10 commands, more than one with UAS only
+#define MSC_QUEUE_MAX  CFG_TUH_MSC_UAS_QUEUE_DEPTH
+
+typedef struct {
+  char     name[16];
+  char     config[16];
+  uint32_t count;      // transfers
+  uint64_t bytes;
+  uint64_t time_ns;    // bus time
+  uint64_t lat_sum_ns;
+  uint64_t lat_max_ns;
+  uint64_t host_cpu_ns;
+  uint64_t dev_cpu_ns;
+} bench_result_t;
+
+static struct {
+  uint8_t msc_daddr;
+  uint8_t hid_daddr;
+  uint8_t hid_idx;
+  uint8_t cdc_idx;
+  uint8_t zero_idx;
+  uint8_t zero_loop_idx;
+  uint8_t vendor_idx;
+  uint8_t vendor_daddr;
+  uint8_t vendor_itf_num;
+  bool    msc_mounted;
+  bool    hid_mounted;
+  bool    cdc_mounted;
+  bool    zero_mounted;
+  bool    zero_loop_mounted;
+  bool    vendor_mounted;
+
+  uint64_t host_cpu_ns;
+  uint64_t dev_cpu_ns;
+} _app;
+
+// state of the running test
+static struct {
+  bench_result_t* result;
+  uint32_t target;    // transfer count
+  bool     done;
+  bool     failed;
+  uint64_t xfer_start;
+
+  // msc
+  bool     random;
+  uint16_t block_count;
+  uint32_t lba;
+  uint32_t seed;
+  uint32_t issued;
+  uint64_t cmd_start[MSC_QUEUE_MAX];
+
+  // cdc
+  uint32_t chunk;
+  uint32_t rx_count;
+
+  // zero
+  tuh_zero_result_t zero;
+} _test;
+
+static uint8_t _buf[MSC_QUEUE_MAX][64 * BENCH_MSC_BLOCK_SIZE];
+static uint8_t _cdc_tx[CFG_TUH_CDC_TX_BUFSIZE];
+static uint8_t _cdc_rx[CFG_TUH_CDC_RX_BUFSIZE];
+
+static uint64_t cpu_time_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+//--------------------------------------------------------------------+
+// Runner
+//--------------------------------------------------------------------+
+
+static void run_once(void) {
+  uint64_t const t0 = cpu_time_ns();
+  tud_task();
+  bench_device_task();
+  uint64_t const t1 = cpu_time_ns();
+  tuh_task();
+  uint64_t const t2 = cpu_time_ns();
+
+  _app.dev_cpu_ns += t1 - t0;
+  _app.host_cpu_ns += t2 - t1;
+
+  // nothing moved on the bus: both stacks are idle or waiting for next frame
+  if (!sim_bus_step()) {
+    sim_bus_idle();
+  }
+}
+
+static bool run_until(bool const* flag, bool value) {
+  uint64_t const timeout = sim_bus_time_ns() + TIMEOUT_NS;
+  while (*flag != value) {
+    if (sim_bus_time_ns() > timeout || _test.failed) return false;
+    run_once();
+  }
+  return true;
+}
+
+static bool all_mounted(void) {
+  return _app.msc_mounted && _app.cdc_mounted && _app.hid_mounted && _app.zero_mounted && _app.zero_loop_mounted &&
+         _app.vendor_mounted;
+}
+
+static bool enumerate(tusb_speed_t speed, uint8_t hid_interval, bool msc_uas) {
+  bench_desc_set_hid_interval(hid_interval);
+  bench_desc_set_msc_uas(msc_uas);
+  sim_bus_connect(speed);
+
+  uint64_t const timeout = sim_bus_time_ns() + TIMEOUT_NS;
+  while (!all_mounted()) {
+    if (sim_bus_time_ns() > timeout) return false;
+    run_once();
+  }
+  return true;
+}
+
+static bool unplug(void) {
+  sim_bus_disconnect();
+  uint64_t const timeout = sim_bus_time_ns() + TIMEOUT_NS;
+  while (_app.msc_mounted || _app.cdc_mounted || _app.hid_mounted || _app.zero_mounted || _app.zero_loop_mounted ||
+         _app.vendor_mounted) {
+    if (sim_bus_time_ns() > timeout) return false;
+    run_once();
+  }
+  return true;
+}
+
+static void test_begin(bench_result_t* result, char const* name, uint32_t target) {
+  tu_memclr(result, sizeof(bench_result_t));
+  snprintf(result->name, sizeof(result->name), "%s", name);
+  tu_memclr(&_test, sizeof(_test));
+  _test.result = result;
+  _test.target = target;
+  _app.host_cpu_ns = _app.dev_cpu_ns = 0;
+  result->time_ns = sim_bus_time_ns();
+}
+
+static bool test_end(void) {
+  bool const ok = run_until(&_test.done, true);
+  bench_result_t* result = _test.result;
+  result->time_ns = sim_bus_time_ns() - result->time_ns;
+  result->host_cpu_ns = _app.host_cpu_ns;
+  result->dev_cpu_ns = _app.dev_cpu_ns;
+  return ok && !_test.failed;
+}
+
+// record one completed transfer, return true if test should continue
+static bool test_xfer_complete(uint32_t bytes, uint64_t latency_ns) {
+  bench_result_t* result = _test.result;
+  result->count++;
+  result->bytes += bytes;
+  result->lat_sum_ns += latency_ns;
+  if (latency_ns > result->lat_max_ns) result->lat_max_ns = latency_ns;
+
+  if (result->count >= _test.target) {
+    _test.done = true;
+  }
+  return !_test.done;
+}
+
+static void print_header(void) {
+  printf("%-5s %-10s %-12s %7s %10s %10s %9s %9s %9s %9s\n", "speed", "test", "config", "xfers", "KB/s",
+         "time ms", "lat us", "max us", "host us", "dev us");
+}
+
+static void print_result(tusb_speed_t speed, bench_result_t const* r) {
+  double const time_s = (double) r->time_ns / 1e9;
+  double const count = r->count ? (double) r->count : 1.0;
+  printf("%-5s %-10s %-12s %7u %10.1f %10.2f %9.1f %9.1f %9.2f %9.2f\n",
+         speed == TUSB_SPEED_HIGH ? "HS" : "FS", r->name, r->config, (unsigned) r->count,
+         (double) r->bytes / 1024.0 / time_s, (double) r->time_ns / 1e6,
+         (double) r->lat_sum_ns / count / 1e3, (double) r->lat_max_ns / 1e3,
+         (double) r->host_cpu_ns / count / 1e3, (double) r->dev_cpu_ns / count / 1e3);
+}
+
+//--------------------------------------------------------------------+
+// MSC: READ10
+//--------------------------------------------------------------------+
+
+static bool msc_read_complete(uint8_t dev_addr, tuh_msc_complete_data_t const* cb_data);
+
+// each block of the disk starts with its lba, checked on completion
+static void msc_disk_init(void) {
+  for (uint32_t lba = 0; lba < BENCH_MSC_BLOCK_COUNT; lba++) {
+    memcpy(bench_device_msc_block(lba), &lba, sizeof(lba));
+  }
+}
+
+static void msc_read_next(uint8_t slot) {
+  if (_test.issued >= _test.target) return;
+
+  uint32_t const max_lba = BENCH_MSC_BLOCK_COUNT - _test.block_count;
+  if (_test.random) {
+    _test.seed = _test.seed * 1103515245u + 12345u;
+    _test.lba = (_test.seed >> 8) % (max_lba + 1);
+  } else if (_test.lba > max_lba) {
+    _test.lba = 0;
+  }
+
+  _test.issued++;
+  _test.cmd_start[slot] = sim_bus_time_ns();
+  if (!tuh_msc_read10(_app.msc_daddr, 0, _buf[slot], _test.lba, _test.block_count, msc_read_complete, slot)) {
+    _test.failed = true;
+  }
+  if (!_test.random) _test.lba += _test.block_count;
+}
+
+static bool msc_read_complete(uint8_t dev_addr, tuh_msc_complete_data_t const* cb_data) {
+  (void) dev_addr;
+  uint8_t const slot = (uint8_t) cb_data->user_arg;
+  if (cb_data->csw->status != MSC_CSW_STATUS_PASSED || cb_data->csw->data_residue) {
+    _test.failed = true;
+    return false;
+  }
+
+  scsi_read10_t const* read10 = (scsi_read10_t const*) cb_data->cbw->command;
+  uint32_t const lba = tu_ntohl(read10->lba);
+  for (uint16_t i = 0; i < _test.block_count; i++) {
+    uint32_t block_lba;
+    memcpy(&block_lba, _buf[slot] + i * BENCH_MSC_BLOCK_SIZE, sizeof(block_lba));
+    if (block_lba != lba + i) {
+      _test.failed = true;
+      return false;
+    }
+  }
+
+  uint32_t const bytes = (uint32_t) _test.block_count * BENCH_MSC_BLOCK_SIZE;
+  if (test_xfer_complete(bytes, sim_bus_time_ns() - _test.cmd_start[slot])) {
+    msc_read_next(slot);
+  }
+  return true;
+}
+
+static bool bench_msc(bench_result_t* result, bool random, uint16_t block_count, uint8_t queue_depth,
+                      uint32_t total_bytes) {
+  bool const uas = tuh_msc_is_uas(_app.msc_daddr);
+  test_begin(result, uas ? (random ? "uas_rand" : "uas_seq") : (random ? "msc_rand" : "msc_seq"),
+             total_bytes / (block_count * BENCH_MSC_BLOCK_SIZE));
+  snprintf(result->config, sizeof(result->config), "%u blk q%u", block_count, queue_depth);
+  _test.random = random;
+  _test.block_count = block_count;
+  _test.seed = 1;
+
+  for (uint8_t slot = 0; slot < queue_depth; slot++) {
+    msc_read_next(slot);
+  }
+  return test_end();
+}
+
+// Read past the end of disk fails (UAS device stalls data pipe), the next read right after must pass
+static bool msc_recover_complete(uint8_t dev_addr, tuh_msc_complete_data_t const* cb_data) {
+  bool const bad_read = (cb_data->user_arg != 0);
+  if ((cb_data->csw->status == MSC_CSW_STATUS_PASSED) == bad_read) {
+    _test.failed = true;
+    return false;
+  }
+
+  if (bad_read) {
+    if (!tuh_msc_read10(dev_addr, 0, _buf[0], 1, 1, msc_recover_complete, 0)) _test.failed = true;
+  } else {
+    uint32_t block_lba;
+    memcpy(&block_lba, _buf[0], sizeof(block_lba));
+    if (block_lba != 1) _test.failed = true;
+    _test.done = true;
+  }
+  return true;
+}
+
+static bool check_msc_recovery(void) {
+  _test.done = false;
+  _test.failed = false;
+  return tuh_msc_read10(_app.msc_daddr, 0, _buf[0], BENCH_MSC_BLOCK_COUNT, 1, msc_recover_complete, 1) &&
+         run_until(&_test.done, true) && !_test.failed;
+}
+
+//--------------------------------------------------------------------+
+// CDC: bulk loopback
+//--------------------------------------------------------------------+
+
+static void cdc_write_next(void) {
+  for (uint32_t i = 0; i < _test.chunk; i++) {
+    _cdc_tx[i] = (uint8_t) (_test.result->count + i);
+  }
+  _test.rx_count = 0;
+  _test.xfer_start = sim_bus_time_ns();
+
+  if (tuh_cdc_write(_app.cdc_idx, _cdc_tx, _test.chunk) != _test.chunk) {
+    _test.failed = true;
+  }
+  tuh_cdc_write_flush(_app.cdc_idx);
+}
+
+void tuh_cdc_rx_cb(uint8_t idx) {
+  if (!_test.chunk) {
+    // not running cdc test
+    tuh_cdc_read(idx, _cdc_rx, sizeof(_cdc_rx));
+    return;
+  }
+
+  uint32_t const count = tuh_cdc_read(idx, _cdc_rx + _test.rx_count, _test.chunk - _test.rx_count);
+  _test.rx_count += count;
+
+  if (_test.rx_count >= _test.chunk) {
+    if (memcmp(_cdc_rx, _cdc_tx, _test.chunk)) {
+      _test.failed = true;
+      return;
+    }
+    if (test_xfer_complete(_test.chunk, sim_bus_time_ns() - _test.xfer_start)) {
+      cdc_write_next();
+    }
+  }
+}
+
+static bool bench_cdc(bench_result_t* result, uint32_t chunk, uint32_t total_bytes) {
+  test_begin(result, "cdc_loop", total_bytes / chunk);
+  snprintf(result->config, sizeof(result->config), "%u B", (unsigned) chunk);
+  _test.chunk = chunk;
+
+  cdc_write_next();
+  bool const ok = test_end();
+  _test.chunk = 0;
+  return ok;
+}
+
+//--------------------------------------------------------------------+
+// HID: interrupt polling
+//--------------------------------------------------------------------+
+
+void tuh_hid_report_received_cb(uint8_t dev_addr, uint8_t idx, uint8_t const* report, uint16_t len) {
+  if (!_test.result || _test.done) return;
+
+  // latency from device queuing the report until host received it
+  uint64_t queued;
+  memcpy(&queued, report, sizeof(queued));
+  if (test_xfer_complete(len, sim_bus_time_ns() - queued)) {
+    tuh_hid_receive_report(dev_addr, idx);
+  }
+}
+
+static bool bench_hid(bench_result_t* result, uint8_t interval, uint32_t count) {
+  test_begin(result, "hid_poll", count);
+  snprintf(result->config, sizeof(result->config), "bInterval %u", interval);
+
+  bench_device_hid_stream(true);
+  tuh_hid_receive_report(_app.hid_daddr, _app.hid_idx);
+  bool const ok = test_end();
+  bench_device_hid_stream(false);
+  return ok;
+}
+
+//--------------------------------------------------------------------+
+// ZERO: source/sink and loopback
+//--------------------------------------------------------------------+
+
+uint32_t tuh_zero_time_us_cb(void) {
+  return (uint32_t) (sim_bus_time_ns() / 1000);
+}
+
+void tuh_zero_test_complete_cb(uint8_t idx, tuh_zero_result_t const* result) {
+  (void) idx;
+  _test.zero = *result;
+  _test.done = true;
+}
+
+// Vendor source/sink sends zeros only (device_app.c)
+static bool bench_zero(bench_result_t* result, bool vendor, uint8_t type, uint8_t alt, uint16_t xfer_len,
+                       uint8_t queue_depth, uint32_t total_bytes) {
+  static char const* const type_names[] = { "zero_src", "zero_sink", "zero_loop" };
+  static char const* const alt_names[] = { "bulk", "int", "iso" };
+
+  test_begin(result, type_names[type], 0);
+  snprintf(result->config, sizeof(result->config), "%s %u q%u", vendor ? "vnd" : alt_names[alt], xfer_len,
+           queue_depth);
+
+  tuh_zero_test_t const test = {
+      .type = type,
+      .alt = alt,
+      .pattern = vendor ? ZERO_PATTERN_ZERO : ZERO_PATTERN_MOD63,
+      .queue_depth = queue_depth,
+      .xfer_len = xfer_len,
+      .count = total_bytes / xfer_len
+  };
+
+  uint8_t idx = (type == TUH_ZERO_TEST_LOOPBACK) ? _app.zero_loop_idx : _app.zero_idx;
+  if (vendor) idx = _app.vendor_idx;
+  bool const ok = tuh_zero_test_start(idx, &test) && test_end();
+
+  // driver measures from first transfer, excluding setup requests
+  tuh_zero_result_t const* r = &_test.zero;
+  result->count = r->count;
+  result->bytes = r->bytes;
+  result->time_ns = (uint64_t) r->elapsed_us * 1000u;
+  result->lat_sum_ns = (uint64_t) r->lat_avg_us * r->count * 1000u;
+  result->lat_max_ns = (uint64_t) r->lat_max_us * 1000u;
+
+  return ok && r->status == XFER_RESULT_SUCCESS && !r->errors && !r->dev_errors && r->count == test.count;
+}
+
+static void print_zero_latency(void) {
+  tuh_zero_result_t const* r = &_test.zero;
+  printf("%-30s latency us: min %u, p50 %u, p90 %u, p99 %u, max %u\n", "", (unsigned) r->lat_min_us,
+         (unsigned) r->lat_p50_us, (unsigned) r->lat_p90_us, (unsigned) r->lat_p99_us, (unsigned) r->lat_max_us);
+}
+
+//--------------------------------------------------------------------+
+// Mount callbacks
+//--------------------------------------------------------------------+
+
+void tuh_msc_mount_cb(uint8_t dev_addr) {
+  _app.msc_daddr = dev_addr;
+  _app.msc_mounted = true;
+}
+
+void tuh_msc_umount_cb(uint8_t dev_addr) {
+  (void) dev_addr;
+  _app.msc_mounted = false;
+}
+
+void tuh_cdc_mount_cb(uint8_t idx) {
+  _app.cdc_idx = idx;
+  _app.cdc_mounted = true;
+}
+
+void tuh_cdc_umount_cb(uint8_t idx) {
+  (void) idx;
+  _app.cdc_mounted = false;
+}
+
+// Bind vendor interface without subclass (device_app.c), as application would do for Linux g_zero
+uint8_t tuh_zero_match_cb(uint8_t daddr, tusb_desc_interface_t const* desc_itf) {
+  if (desc_itf->bInterfaceClass != TUSB_CLASS_VENDOR_SPECIFIC || desc_itf->bInterfaceSubClass != 0) return 0;
+  _app.vendor_daddr = daddr;
+  _app.vendor_itf_num = desc_itf->bInterfaceNumber;
+  return ZERO_PROTOCOL_SRC_SINK;
+}
+
+void tuh_zero_mount_cb(uint8_t idx) {
+  if (idx == tuh_zero_itf_get_index(_app.vendor_daddr, _app.vendor_itf_num)) {
+    _app.vendor_idx = idx;
+    _app.vendor_mounted = true;
+  } else if (tuh_zero_protocol(idx) == ZERO_PROTOCOL_LOOPBACK) {
+    _app.zero_loop_idx = idx;
+    _app.zero_loop_mounted = true;
+  } else {
+    _app.zero_idx = idx;
+    _app.zero_mounted = true;
+  }
+}
+
+void tuh_zero_umount_cb(uint8_t idx) {
+  if (idx == _app.zero_loop_idx) _app.zero_loop_mounted = false;
+  if (idx == _app.zero_idx) _app.zero_mounted = false;
+  if (idx == _app.vendor_idx) _app.vendor_mounted = false;
+}
+
+void tuh_hid_mount_cb(uint8_t dev_addr, uint8_t idx, uint8_t const* report_desc, uint16_t desc_len) {
+  (void) report_desc;
+  (void) desc_len;
+  _app.hid_daddr = dev_addr;
+  _app.hid_idx = idx;
+  _app.hid_mounted = true;
+}
+
+void tuh_hid_umount_cb(uint8_t dev_addr, uint8_t idx) {
+  (void) dev_addr;
+  (void) idx;
+  _app.hid_mounted = false;
+}
+
+//--------------------------------------------------------------------+
+// Main
+//--------------------------------------------------------------------+
+
+static bool check(bool ok, char const* what) {
+  if (!ok) printf("FAILED: %s\n", what);
+  return ok;
+}
+
+int main(int argc, char* argv[]) {
+  bool const quick = (argc > 1 && !strcmp(argv[1], "-q"));
+  uint32_t const msc_bytes = quick ? 64 * 1024 : 1024 * 1024;
+  uint32_t const cdc_bytes = quick ? 16 * 1024 : 256 * 1024;
+  uint32_t const hid_count = quick ? 100 : 1000;
+  uint32_t const zero_bytes = quick ? 64 * 1024 : 1024 * 1024;
+
+  static uint16_t const msc_blocks[] = { 1, 8, 64 };
+  static uint32_t const cdc_chunks[] = { 64, 512, 2048 };
+  static uint8_t const hid_intervals[] = { 1, 4 };
+
+  // type, alternate (bulk, interrupt, isochronous), transfer length, queue depth. Periodic ones with less data,
+  // single packet transfers fitting both speeds
+  static struct {
+    uint8_t type;
+    uint8_t alt;
+    uint16_t xfer_len;
+    uint8_t queue_depth;
+  } const zero_tests[] = {
+      { TUH_ZERO_TEST_SOURCE,   0, 512,  1 },
+      { TUH_ZERO_TEST_SOURCE,   0, 4096, 1 },
+      { TUH_ZERO_TEST_SOURCE,   0, 4096, 4 },
+      { TUH_ZERO_TEST_SINK,     0, 512,  1 },
+      { TUH_ZERO_TEST_SINK,     0, 4096, 4 },
+      { TUH_ZERO_TEST_LOOPBACK, 0, 512,  1 },
+      { TUH_ZERO_TEST_LOOPBACK, 0, 4096, 1 },
+      { TUH_ZERO_TEST_LOOPBACK, 0, 4096, 4 },
+      { TUH_ZERO_TEST_SOURCE,   1, 64  , 2 },
+      { TUH_ZERO_TEST_SINK,     1, 64  , 2 },
+      { TUH_ZERO_TEST_SOURCE,   2, 64  , 2 },
+      { TUH_ZERO_TEST_SINK,     2, 64  , 2 },
+  };
+  static tusb_speed_t const speeds[] = { TUSB_SPEED_FULL, TUSB_SPEED_HIGH };
+
+  sim_bus_init();
+  tusb_init();
+  msc_disk_init();
+
+  print_header();
+
+  bool ok = true;
+  bench_result_t result;
+
+  for (size_t s = 0; s < TU_ARRAY_SIZE(speeds) && ok; s++) {
+    tusb_speed_t const speed = speeds[s];
+
+    // HID interval is part of configuration descriptor, re-enumerate for each one.
+    // First run has Bulk-Only MSC, second one UAS
+    for (size_t h = 0; h < TU_ARRAY_SIZE(hid_intervals) && ok; h++) {
+      bool const uas = (h == 1);
+      ok = check(enumerate(speed, hid_intervals[h], uas), "enumeration");
+      ok = ok && check(tuh_msc_is_uas(_app.msc_daddr) == uas, "msc transport");
+
+      for (size_t i = 0; i < TU_ARRAY_SIZE(msc_blocks) && ok; i++) {
+        ok = check(bench_msc(&result, false, msc_blocks[i], 1, msc_bytes), "msc sequential read");
+        print_result(speed, &result);
+      }
+      for (size_t i = 0; i < TU_ARRAY_SIZE(msc_blocks) && ok; i++) {
+        ok = check(bench_msc(&result, true, msc_blocks[i], 1, msc_bytes), "msc random read");
+        print_result(speed, &result);
+      }
+
+      if (ok && uas) {
+        ok = check(tuh_msc_get_maxlun(_app.msc_daddr) == 1, "uas report luns");
+        ok = ok && check(check_msc_recovery(), "uas stall recovery");
+        for (size_t i = 0; i < TU_ARRAY_SIZE(msc_blocks) && ok; i++) {
+          ok = check(bench_msc(&result, true, msc_blocks[i], MSC_QUEUE_MAX, msc_bytes), "uas queued read");
+          print_result(speed, &result);
+        }
+      }
+
+      if (ok && h == 0) {
+        for (size_t i = 0; i < TU_ARRAY_SIZE(cdc_chunks) && ok; i++) {
+          ok = check(bench_cdc(&result, cdc_chunks[i], cdc_bytes), "cdc loopback");
+          print_result(speed, &result);
+        }
+
+        for (size_t i = 0; i < TU_ARRAY_SIZE(zero_tests) && ok; i++) {
+          uint32_t const bytes = zero_tests[i].alt ? zero_bytes / 8 : zero_bytes;
+          ok = check(bench_zero(&result, false, zero_tests[i].type, zero_tests[i].alt, zero_tests[i].xfer_len,
+                                zero_tests[i].queue_depth, bytes), "zero source/sink/loopback");
+          print_result(speed, &result);
+          print_zero_latency();
+        }
+
+        for (uint8_t type = TUH_ZERO_TEST_SOURCE; type <= TUH_ZERO_TEST_SINK && ok; type++) {
+          ok = check(bench_zero(&result, true, type, 0, 512, 1, zero_bytes), "zero vendor interface");
+          print_result(speed, &result);
+        }
+      }
+
+      if (ok) {
+        ok = check(bench_hid(&result, hid_intervals[h], hid_count), "hid polling");
+        print_result(speed, &result);
+      }
+
+      ok = ok && check(unplug(), "unplug");
+    }
+  }
+
+  return ok ? 0 : 1;
+}
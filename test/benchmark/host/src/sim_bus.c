@@ -0,0 +1,456 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#include <string.h>
+
+#include "sim_bus.h"
+#include "device/dcd.h"
+#include "host/hcd.h"
+
+//--------------------------------------------------------------------+
+// MACRO CONSTANT TYPEDEF PROTYPES
+//--------------------------------------------------------------------+
+
+#define RHPORT_DEVICE  0
+#define RHPORT_HOST    1
+
+// Per transaction protocol overhead in bytes: token, data pid + crc, handshake, sync/eop and inter-packet delays.
+// This gives 19 x 64 byte bulk packets per frame at full speed and 13 x 512 per micro-frame at high speed,
+// which matches the maximum bulk bandwidth in the USB 2.0 specs.
+#define FS_OVERHEAD    13
+#define HS_OVERHEAD    55
+
+typedef struct {
+  uint8_t* buf;
+  uint16_t total;
+  uint16_t actual;
+  bool     active;
+} sim_xfer_t;
+
+typedef struct {
+  sim_xfer_t xfer;
+  uint8_t  daddr;
+  uint8_t  type;
+  bool     opened;
+  uint32_t interval_ns; // polling interval for interrupt endpoint
+  uint64_t next_poll;
+} sim_host_ep_t;
+
+typedef struct {
+  sim_xfer_t xfer;
+  uint16_t mps;
+  uint8_t  type;
+  bool     stalled;
+} sim_dev_ep_t;
+
+static struct {
+  tusb_speed_t speed;
+  bool connected;
+  uint64_t now;
+
+  bool setup_pending;
+  uint8_t setup_daddr;
+  uint8_t setup[8];
+
+  sim_host_ep_t host_ep[TUP_DCD_ENDPOINT_MAX][2];
+  sim_dev_ep_t  dev_ep[TUP_DCD_ENDPOINT_MAX][2];
+
+  sim_bus_stats_t stats;
+} _sim;
+
+static uint64_t packet_time_ns(uint16_t len) {
+  if (_sim.speed == TUSB_SPEED_HIGH) {
+    return ((uint64_t) (len + HS_OVERHEAD) * 8 * 1000) / 480;
+  } else {
+    return ((uint64_t) (len + FS_OVERHEAD) * 8 * 1000) / 12;
+  }
+}
+
+static uint64_t frame_ns(void) {
+  return (_sim.speed == TUSB_SPEED_HIGH) ? 125000 : 1000000;
+}
+
+//--------------------------------------------------------------------+
+// Bus
+//--------------------------------------------------------------------+
+
+void sim_bus_init(void) {
+  tu_memclr(&_sim, sizeof(_sim));
+}
+
+void sim_bus_connect(tusb_speed_t speed) {
+  _sim.speed = speed;
+  _sim.connected = true;
+  _sim.dev_ep[0][0].mps = _sim.dev_ep[0][1].mps = CFG_TUD_ENDPOINT0_SIZE;
+  hcd_event_device_attach(RHPORT_HOST, false);
+}
+
+void sim_bus_disconnect(void) {
+  _sim.connected = false;
+  tu_memclr(_sim.host_ep, sizeof(_sim.host_ep));
+  _sim.setup_pending = false;
+  dcd_event_bus_signal(RHPORT_DEVICE, DCD_EVENT_UNPLUGGED, false);
+  hcd_event_device_remove(RHPORT_HOST, false);
+}
+
+uint64_t sim_bus_time_ns(void) {
+  return _sim.now;
+}
+
+void sim_bus_get_stats(sim_bus_stats_t* stats) {
+  *stats = _sim.stats;
+}
+
+void sim_bus_idle(void) {
+  _sim.now = (_sim.now / frame_ns() + 1) * frame_ns();
+}
+
+// Move one packet, return true if transfer on both sides are still active
+static bool move_packet(uint8_t epnum, uint8_t dir) {
+  sim_host_ep_t* hep = &_sim.host_ep[epnum][dir];
+  sim_dev_ep_t*  dep = &_sim.dev_ep[epnum][dir];
+  sim_xfer_t* hx = &hep->xfer;
+  sim_xfer_t* dx = &dep->xfer;
+  uint8_t const ep_addr = tu_edpt_addr(epnum, dir);
+
+  // packet is sized by the sender, truncated (babble) if receiver has less room
+  sim_xfer_t* tx = (dir == TUSB_DIR_IN) ? dx : hx;
+  sim_xfer_t* rx = (dir == TUSB_DIR_IN) ? hx : dx;
+
+  uint16_t const pkt_len = tu_min16(dep->mps, (uint16_t) (tx->total - tx->actual));
+  uint16_t const len = tu_min16(pkt_len, (uint16_t) (rx->total - rx->actual));
+  if (len) {
+    memcpy(rx->buf + rx->actual, tx->buf + tx->actual, len);
+  }
+  tx->actual += pkt_len;
+  rx->actual += len;
+
+  _sim.now += packet_time_ns(pkt_len);
+  _sim.stats.packets++;
+  _sim.stats.bytes += pkt_len;
+
+  // sender completes when all bytes are sent, receiver on short packet or full buffer
+  bool const short_pkt = pkt_len < dep->mps;
+  bool const tx_done = (tx->actual == tx->total);
+  bool const rx_done = short_pkt || (rx->actual == rx->total);
+
+  bool const dev_done  = (dir == TUSB_DIR_IN) ? tx_done : rx_done;
+  bool const host_done = (dir == TUSB_DIR_IN) ? rx_done : tx_done;
+
+  if (dev_done) {
+    dx->active = false;
+    dcd_event_xfer_complete(RHPORT_DEVICE, ep_addr, dx->actual, XFER_RESULT_SUCCESS, false);
+  }
+
+  if (host_done) {
+    hx->active = false;
+    hcd_event_xfer_complete(hep->daddr, ep_addr, hx->actual, XFER_RESULT_SUCCESS, false);
+  }
+
+  return !dev_done && !host_done;
+}
+
+bool sim_bus_step(void) {
+  if (!_sim.connected) return false;
+
+  bool progress = false;
+
+  if (_sim.setup_pending) {
+    // setup is always accepted by device and cancels pending control transfer
+    _sim.setup_pending = false;
+    for (uint8_t dir = 0; dir < 2; dir++) {
+      _sim.dev_ep[0][dir].xfer.active = false;
+      _sim.dev_ep[0][dir].stalled = false;
+      _sim.host_ep[0][dir].xfer.active = false;
+    }
+
+    _sim.now += packet_time_ns(8);
+    _sim.stats.packets++;
+
+    dcd_event_setup_received(RHPORT_DEVICE, _sim.setup, false);
+    hcd_event_xfer_complete(_sim.setup_daddr, 0, 8, XFER_RESULT_SUCCESS, false);
+    return true;
+  }
+
+  for (uint8_t epnum = 0; epnum < TUP_DCD_ENDPOINT_MAX; epnum++) {
+    for (uint8_t dir = 0; dir < 2; dir++) {
+      sim_host_ep_t* hep = &_sim.host_ep[epnum][dir];
+      sim_dev_ep_t*  dep = &_sim.dev_ep[epnum][dir];
+
+      if (!hep->xfer.active) continue;
+
+      if (dep->stalled) {
+        hep->xfer.active = false;
+        hcd_event_xfer_complete(hep->daddr, tu_edpt_addr(epnum, dir), hep->xfer.actual, XFER_RESULT_STALLED, false);
+        progress = true;
+        continue;
+      }
+
+      if (!dep->xfer.active) continue; // NAK
+
+      if (hep->type == TUSB_XFER_INTERRUPT) {
+        // one packet per polling interval
+        if (_sim.now < hep->next_poll) continue;
+        hep->next_poll = (_sim.now / frame_ns()) * frame_ns() + hep->interval_ns;
+        move_packet(epnum, dir);
+      } else {
+        while (move_packet(epnum, dir)) {}
+      }
+
+      progress = true;
+    }
+  }
+
+  return progress;
+}
+
+// Time is virtual, delay advances bus time
+void osal_task_delay(uint32_t msec) {
+  _sim.now += (uint64_t) msec * 1000000;
+}
+
+//--------------------------------------------------------------------+
+// Device Controller Driver
+//--------------------------------------------------------------------+
+
+void dcd_init(uint8_t rhport) {
+  (void) rhport;
+}
+
+void dcd_int_handler(uint8_t rhport) {
+  (void) rhport;
+}
+
+void dcd_int_enable(uint8_t rhport) {
+  (void) rhport;
+}
+
+void dcd_int_disable(uint8_t rhport) {
+  (void) rhport;
+}
+
+void dcd_set_address(uint8_t rhport, uint8_t dev_addr) {
+  (void) dev_addr;
+  // Response with status after changing device address
+  dcd_edpt_xfer(rhport, tu_edpt_addr(0, TUSB_DIR_IN), NULL, 0);
+}
+
+void dcd_remote_wakeup(uint8_t rhport) {
+  (void) rhport;
+}
+
+void dcd_connect(uint8_t rhport) {
+  (void) rhport;
+}
+
+void dcd_disconnect(uint8_t rhport) {
+  (void) rhport;
+}
+
+void dcd_sof_enable(uint8_t rhport, bool en) {
+  (void) rhport;
+  (void) en;
+}
+
+bool dcd_edpt_open(uint8_t rhport, tusb_desc_endpoint_t const* desc_ep) {
+  (void) rhport;
+  uint8_t const epnum = tu_edpt_number(desc_ep->bEndpointAddress);
+  uint8_t const dir = tu_edpt_dir(desc_ep->bEndpointAddress);
+  TU_ASSERT(epnum < TUP_DCD_ENDPOINT_MAX);
+
+  sim_dev_ep_t* dep = &_sim.dev_ep[epnum][dir];
+  tu_memclr(dep, sizeof(sim_dev_ep_t));
+  dep->mps = tu_edpt_packet_size(desc_ep);
+  dep->type = desc_ep->bmAttributes.xfer;
+  return true;
+}
+
+void dcd_edpt_close_all(uint8_t rhport) {
+  (void) rhport;
+  for (uint8_t epnum = 1; epnum < TUP_DCD_ENDPOINT_MAX; epnum++) {
+    tu_memclr(_sim.dev_ep[epnum], sizeof(_sim.dev_ep[epnum]));
+  }
+}
+
+void dcd_edpt_close(uint8_t rhport, uint8_t ep_addr) {
+  (void) rhport;
+  tu_memclr(&_sim.dev_ep[tu_edpt_number(ep_addr)][tu_edpt_dir(ep_addr)], sizeof(sim_dev_ep_t));
+}
+
+bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t* buffer, uint16_t total_bytes) {
+  (void) rhport;
+  sim_xfer_t* dx = &_sim.dev_ep[tu_edpt_number(ep_addr)][tu_edpt_dir(ep_addr)].xfer;
+  TU_ASSERT(!dx->active);
+
+  dx->buf = buffer;
+  dx->total = total_bytes;
+  dx->actual = 0;
+  dx->active = true;
+  return true;
+}
+
+void dcd_edpt_stall(uint8_t rhport, uint8_t ep_addr) {
+  (void) rhport;
+  uint8_t const epnum = tu_edpt_number(ep_addr);
+  if (epnum == 0) {
+    // control endpoint stalls both direction until next setup
+    _sim.dev_ep[0][0].stalled = _sim.dev_ep[0][1].stalled = true;
+  } else {
+    _sim.dev_ep[epnum][tu_edpt_dir(ep_addr)].stalled = true;
+  }
+}
+
+void dcd_edpt_clear_stall(uint8_t rhport, uint8_t ep_addr) {
+  (void) rhport;
+  _sim.dev_ep[tu_edpt_number(ep_addr)][tu_edpt_dir(ep_addr)].stalled = false;
+}
+
+//--------------------------------------------------------------------+
+// Host Controller Driver
+//--------------------------------------------------------------------+
+
+bool hcd_init(uint8_t rhport) {
+  (void) rhport;
+  return true;
+}
+
+void hcd_int_handler(uint8_t rhport) {
+  (void) rhport;
+}
+
+void hcd_int_enable(uint8_t rhport) {
+  (void) rhport;
+}
+
+void hcd_int_disable(uint8_t rhport) {
+  (void) rhport;
+}
+
+uint32_t hcd_frame_number(uint8_t rhport) {
+  (void) rhport;
+  return (uint32_t) (_sim.now / 1000000);
+}
+
+bool hcd_port_connect_status(uint8_t rhport) {
+  (void) rhport;
+  return _sim.connected;
+}
+
+void hcd_port_reset(uint8_t rhport) {
+  (void) rhport;
+  dcd_event_bus_reset(RHPORT_DEVICE, _sim.speed, false);
+}
+
+void hcd_port_reset_end(uint8_t rhport) {
+  (void) rhport;
+}
+
+tusb_speed_t hcd_port_speed_get(uint8_t rhport) {
+  (void) rhport;
+  return _sim.speed;
+}
+
+void hcd_device_close(uint8_t rhport, uint8_t dev_addr) {
+  (void) rhport;
+  for (uint8_t epnum = 0; epnum < TUP_DCD_ENDPOINT_MAX; epnum++) {
+    for (uint8_t dir = 0; dir < 2; dir++) {
+      if (_sim.host_ep[epnum][dir].daddr == dev_addr) {
+        tu_memclr(&_sim.host_ep[epnum][dir], sizeof(sim_host_ep_t));
+      }
+    }
+  }
+}
+
+bool hcd_edpt_open(uint8_t rhport, uint8_t dev_addr, tusb_desc_endpoint_t const* ep_desc) {
+  (void) rhport;
+  uint8_t const epnum = tu_edpt_number(ep_desc->bEndpointAddress);
+  TU_ASSERT(epnum < TUP_DCD_ENDPOINT_MAX);
+
+  // control endpoint is opened for both direction
+  for (uint8_t dir = 0; dir < 2; dir++) {
+    if (epnum != 0 && dir != tu_edpt_dir(ep_desc->bEndpointAddress)) continue;
+
+    sim_host_ep_t* hep = &_sim.host_ep[epnum][dir];
+    // like queue heads of a real controller, an endpoint must be closed before it is opened again
+    TU_ASSERT(epnum == 0 || !hep->opened);
+    tu_memclr(hep, sizeof(sim_host_ep_t));
+    hep->daddr = dev_addr;
+    hep->type = ep_desc->bmAttributes.xfer;
+    hep->opened = true;
+
+    if (hep->type == TUSB_XFER_INTERRUPT) {
+      uint8_t const interval = tu_max8(ep_desc->bInterval, 1);
+      // high speed interval is 2^(bInterval-1) micro-frames, full speed is bInterval frames
+      hep->interval_ns = (_sim.speed == TUSB_SPEED_HIGH) ? (125000u << (tu_min8(interval, 16) - 1))
+                                                         : (uint32_t) interval * 1000000u;
+    }
+  }
+
+  return true;
+}
+
+bool hcd_edpt_xfer(uint8_t rhport, uint8_t dev_addr, uint8_t ep_addr, uint8_t* buffer, uint16_t buflen) {
+  (void) rhport;
+  sim_host_ep_t* hep = &_sim.host_ep[tu_edpt_number(ep_addr)][tu_edpt_dir(ep_addr)];
+  TU_ASSERT(!hep->xfer.active);
+
+  hep->daddr = dev_addr;
+  hep->xfer.buf = buffer;
+  hep->xfer.total = buflen;
+  hep->xfer.actual = 0;
+  hep->xfer.active = true;
+  return true;
+}
+
+bool hcd_edpt_abort_xfer(uint8_t rhport, uint8_t dev_addr, uint8_t ep_addr) {
+  (void) rhport;
+  (void) dev_addr;
+  _sim.host_ep[tu_edpt_number(ep_addr)][tu_edpt_dir(ep_addr)].xfer.active = false;
+  return true;
+}
+
+bool hcd_edpt_close(uint8_t rhport, uint8_t dev_addr, uint8_t ep_addr) {
+  (void) rhport;
+  sim_host_ep_t* hep = &_sim.host_ep[tu_edpt_number(ep_addr)][tu_edpt_dir(ep_addr)];
+  TU_VERIFY(tu_edpt_number(ep_addr) && hep->daddr == dev_addr);
+  tu_memclr(hep, sizeof(sim_host_ep_t));
+  return true;
+}
+
+bool hcd_setup_send(uint8_t rhport, uint8_t dev_addr, uint8_t const setup_packet[8]) {
+  (void) rhport;
+  memcpy(_sim.setup, setup_packet, 8);
+  _sim.setup_daddr = dev_addr;
+  _sim.setup_pending = true;
+  return true;
+}
+
+bool hcd_edpt_clear_stall(uint8_t rhport, uint8_t dev_addr, uint8_t ep_addr) {
+  (void) rhport;
+  (void) dev_addr;
+  (void) ep_addr;
+  return true;
+}
@@ -0,0 +1,67 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#ifndef _SIM_BUS_H_
+#define _SIM_BUS_H_
+
+#include "tusb.h"
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+// Simulated USB bus between tinyusb device stack (rhport 0) and host stack (rhport 1) in the same process.
+// Implements both dcd_* and hcd_* API. Transfers queued on both sides are moved packet by packet by
+// sim_bus_step(), bus time advances by the wire time of each packet (payload + protocol overhead) so that
+// throughput and latency are reported in bus time, independent of the machine running the benchmark.
+// Interrupt endpoints are polled by host once per bInterval.
+
+typedef struct {
+  uint64_t packets;
+  uint64_t bytes;
+} sim_bus_stats_t;
+
+// Must be called before tusb_init()
+void     sim_bus_init(void);
+
+// Plug device, speed is negotiated by host port reset
+void     sim_bus_connect(tusb_speed_t speed);
+void     sim_bus_disconnect(void);
+
+// Move packets between transfers queued on both sides, return false if nothing could move
+bool     sim_bus_step(void);
+
+// Advance bus time to next (micro)frame, used when both stacks are idle
+void     sim_bus_idle(void);
+
+uint64_t sim_bus_time_ns(void);
+void     sim_bus_get_stats(sim_bus_stats_t* stats);
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif
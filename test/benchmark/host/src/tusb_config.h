@@ -0,0 +1,104 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#ifndef _TUSB_CONFIG_H_
+#define _TUSB_CONFIG_H_
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+//--------------------------------------------------------------------
+// Common Configuration
+//--------------------------------------------------------------------
+
+// Both stacks run in the same process and talk over the simulated bus (sim_bus.c):
+// device on rhport 0, host on rhport 1
+#define CFG_TUSB_MCU              OPT_MCU_NONE
+#define CFG_TUSB_OS               OPT_OS_NONE
+#define CFG_TUSB_RHPORT0_MODE     (OPT_MODE_DEVICE | OPT_MODE_HIGH_SPEED)
+#define CFG_TUSB_RHPORT1_MODE     (OPT_MODE_HOST | OPT_MODE_HIGH_SPEED)
+
+// no MCU port, endpoint count of the simulated controller
+#define TUP_DCD_ENDPOINT_MAX      16
+
+#ifndef CFG_TUSB_DEBUG
+#define CFG_TUSB_DEBUG            0
+#endif
+
+#define CFG_TUSB_MEM_SECTION
+#define CFG_TUSB_MEM_ALIGN        __attribute__ ((aligned(4)))
+
+//--------------------------------------------------------------------
+// Device Configuration
+//--------------------------------------------------------------------
+
+#define CFG_TUD_ENDPOINT0_SIZE    64
+
+#define CFG_TUD_CDC               1
+#define CFG_TUD_MSC               1
+#define CFG_TUD_HID               1
+#define CFG_TUD_ZERO              2 // source/sink and loopback
+
+#define CFG_TUD_CDC_RX_BUFSIZE    2048
+#define CFG_TUD_CDC_TX_BUFSIZE    2048
+#define CFG_TUD_CDC_EP_BUFSIZE    512
+
+#define CFG_TUD_MSC_EP_BUFSIZE    4096
+
+#define CFG_TUD_HID_EP_BUFSIZE    64
+
+#define CFG_TUD_ZERO_BUFSIZE      4096
+
+//--------------------------------------------------------------------
+// Host Configuration
+//--------------------------------------------------------------------
+
+#define CFG_TUH_ENUMERATION_BUFSIZE 512
+#define CFG_TUH_DEVICE_MAX        1
+
+#define CFG_TUH_CDC               1
+#define CFG_TUH_MSC               1
+#define CFG_TUH_HID               1
+#define CFG_TUH_ZERO              3 // source/sink, loopback and vendor source/sink
+
+#define CFG_TUH_MSC_UAS           1
+#define CFG_TUH_MSC_UAS_QUEUE_DEPTH 4
+
+#define CFG_TUH_CDC_RX_BUFSIZE    2048
+#define CFG_TUH_CDC_TX_BUFSIZE    2048
+
+#define CFG_TUH_HID_EPIN_BUFSIZE  64
+#define CFG_TUH_HID_EPOUT_BUFSIZE 64
+
+#define CFG_TUH_ZERO_BUFSIZE      4096
+#define CFG_TUH_ZERO_QUEUE_DEPTH  4
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif /* _TUSB_CONFIG_H_ */
@@ -0,0 +1,361 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#include <string.h>
+#include "bench.h"
+#include "device/usbd_pvt.h"
+
+// Minimal USB Attached SCSI device (USB 2.0, no streams) serving the MSC RAM disk, registered as application
+// class driver so that it takes the MSC interface before the built-in Bulk-Only driver when the configuration
+// has an UAS alternate (see bench_desc_set_msc_uas()). Alternate 0 is a Bulk-Only placeholder.
+// Commands are queued in arrival order and executed one at a time: Read/Write Ready IU, data, Sense IU.
+// READ10 past the end of disk stalls the data-in pipe after Read Ready IU to exercise host error recovery.
+
+#define UAS_QUEUE_DEPTH   8
+#define UAS_ALT           1
+
+enum {
+  STAGE_IDLE = 0,
+  STAGE_READY, // Read/Write Ready IU is being sent
+  STAGE_DATA,
+  STAGE_SENSE  // Sense IU is being sent
+};
+
+typedef struct {
+  uint16_t tag; // as received, big endian
+  uint8_t  cdb[16];
+} uas_cmd_t;
+
+static struct {
+  uint8_t itf_num;
+  uint8_t alt;
+  tusb_desc_endpoint_t const* ep_desc[4]; // index is pipe id - 1
+  uint8_t ep_cmd, ep_status, ep_in, ep_out;
+
+  uas_cmd_t queue[UAS_QUEUE_DEPTH];
+  uint8_t head;
+  uint8_t count;
+  bool cmd_armed;
+
+  uint8_t stage;
+  uas_cmd_t cur;
+  uint8_t* data;
+  uint16_t data_len;
+  bool data_in;
+
+  CFG_TUSB_MEM_ALIGN msc_uas_cmd_iu_t cmd_iu;
+  CFG_TUSB_MEM_ALIGN msc_uas_sense_iu_t status_iu;
+  CFG_TUSB_MEM_ALIGN uint8_t resp[36];
+} _uas;
+
+//--------------------------------------------------------------------+
+// Command execution
+//--------------------------------------------------------------------+
+
+static void cmd_arm(uint8_t rhport) {
+  _uas.cmd_armed = usbd_edpt_xfer(rhport, _uas.ep_cmd, (uint8_t*) &_uas.cmd_iu, sizeof(msc_uas_cmd_iu_t));
+}
+
+static void send_ready(uint8_t rhport, uint8_t iu_id) {
+  msc_uas_ready_iu_t* iu = (msc_uas_ready_iu_t*) &_uas.status_iu;
+  tu_memclr(iu, sizeof(msc_uas_ready_iu_t));
+  iu->iu_id = iu_id;
+  iu->tag = _uas.cur.tag;
+
+  _uas.stage = STAGE_READY;
+  usbd_edpt_xfer(rhport, _uas.ep_status, (uint8_t*) iu, sizeof(msc_uas_ready_iu_t));
+}
+
+static void send_sense(uint8_t rhport, uint8_t sense_key, uint8_t asc) {
+  msc_uas_sense_iu_t* iu = &_uas.status_iu;
+  tu_memclr(iu, sizeof(msc_uas_sense_iu_t));
+  iu->iu_id = MSC_UAS_IU_SENSE;
+  iu->tag = _uas.cur.tag;
+
+  uint16_t len = (uint16_t) offsetof(msc_uas_sense_iu_t, sense_data);
+  if (sense_key != SCSI_SENSE_NONE) {
+    scsi_sense_fixed_resp_t* sense = (scsi_sense_fixed_resp_t*) iu->sense_data;
+    sense->response_code = 0x70;
+    sense->sense_key = sense_key & 0x0F;
+    sense->add_sense_len = sizeof(scsi_sense_fixed_resp_t) - 8;
+    sense->add_sense_code = asc;
+
+    iu->status = MSC_UAS_STATUS_CHECK_CONDITION;
+    iu->sense_len = tu_htons(sizeof(scsi_sense_fixed_resp_t));
+    len += sizeof(scsi_sense_fixed_resp_t);
+  }
+
+  _uas.stage = STAGE_SENSE;
+  usbd_edpt_xfer(rhport, _uas.ep_status, (uint8_t*) iu, len);
+}
+
+static void cmd_execute(uint8_t rhport) {
+  uint8_t const* cdb = _uas.cur.cdb;
+  _uas.data_in = true;
+
+  switch (cdb[0]) {
+    case SCSI_CMD_READ_10:
+    case SCSI_CMD_WRITE_10: {
+      scsi_read10_t const* rw = (scsi_read10_t const*) cdb;
+      uint32_t const lba = tu_ntohl(rw->lba);
+      uint16_t const blocks = tu_ntohs(rw->block_count);
+      _uas.data_in = (cdb[0] == SCSI_CMD_READ_10);
+      if (lba + blocks > BENCH_MSC_BLOCK_COUNT || blocks * BENCH_MSC_BLOCK_SIZE > UINT16_MAX) {
+        if (!_uas.data_in) {
+          send_sense(rhport, SCSI_SENSE_ILLEGAL_REQUEST, 0x21); // LBA out of range
+          return;
+        }
+        _uas.data = NULL; // stall data phase
+        break;
+      }
+      _uas.data = bench_device_msc_block(lba);
+      _uas.data_len = (uint16_t) (blocks * BENCH_MSC_BLOCK_SIZE);
+      break;
+    }
+
+    case SCSI_CMD_INQUIRY: {
+      scsi_inquiry_resp_t* resp = (scsi_inquiry_resp_t*) _uas.resp;
+      tu_memclr(resp, sizeof(scsi_inquiry_resp_t));
+      resp->version = 6; // SPC-4
+      resp->response_data_format = 2;
+      resp->additional_length = sizeof(scsi_inquiry_resp_t) - 5;
+      resp->cmd_que = 1;
+      memcpy(resp->vendor_id, "TinyUSB ", 8);
+      memcpy(resp->product_id, "Benchmark UAS   ", 16);
+      memcpy(resp->product_rev, "1.0 ", 4);
+      _uas.data = _uas.resp;
+      _uas.data_len = tu_min16(sizeof(scsi_inquiry_resp_t), cdb[4]);
+      break;
+    }
+
+    case SCSI_CMD_READ_CAPACITY_10: {
+      scsi_read_capacity10_resp_t* resp = (scsi_read_capacity10_resp_t*) _uas.resp;
+      resp->last_lba = tu_htonl(BENCH_MSC_BLOCK_COUNT - 1);
+      resp->block_size = tu_htonl(BENCH_MSC_BLOCK_SIZE);
+      _uas.data = _uas.resp;
+      _uas.data_len = sizeof(scsi_read_capacity10_resp_t);
+      break;
+    }
+
+    case SCSI_CMD_REQUEST_SENSE: {
+      scsi_sense_fixed_resp_t* resp = (scsi_sense_fixed_resp_t*) _uas.resp;
+      tu_memclr(resp, sizeof(scsi_sense_fixed_resp_t));
+      resp->response_code = 0x70;
+      resp->add_sense_len = sizeof(scsi_sense_fixed_resp_t) - 8;
+      _uas.data = _uas.resp;
+      _uas.data_len = tu_min16(sizeof(scsi_sense_fixed_resp_t), cdb[4]);
+      break;
+    }
+
+    case SCSI_CMD_REPORT_LUNS: {
+      scsi_report_luns_resp_t* resp = (scsi_report_luns_resp_t*) _uas.resp;
+      tu_memclr(resp, sizeof(scsi_report_luns_resp_t));
+      resp->list_length = tu_htonl(8); // LUN 0 only
+      _uas.data = _uas.resp;
+      _uas.data_len = (uint16_t) tu_min32(sizeof(scsi_report_luns_resp_t), tu_ntohl(((scsi_report_luns_t const*) cdb)->alloc_length));
+      break;
+    }
+
+    case SCSI_CMD_TEST_UNIT_READY:
+      send_sense(rhport, SCSI_SENSE_NONE, 0);
+      return;
+
+    default:
+      send_sense(rhport, SCSI_SENSE_ILLEGAL_REQUEST, 0x20); // invalid command operation code
+      return;
+  }
+
+  send_ready(rhport, _uas.data_in ? MSC_UAS_IU_READ_READY : MSC_UAS_IU_WRITE_READY);
+}
+
+static void cmd_next(uint8_t rhport) {
+  if (_uas.stage != STAGE_IDLE || _uas.count == 0) return;
+
+  _uas.cur = _uas.queue[_uas.head];
+  _uas.head = (uint8_t) ((_uas.head + 1) % UAS_QUEUE_DEPTH);
+  _uas.count--;
+
+  // room for another command
+  if (!_uas.cmd_armed) cmd_arm(rhport);
+
+  cmd_execute(rhport);
+}
+
+//--------------------------------------------------------------------+
+// Class driver
+//--------------------------------------------------------------------+
+
+static void uas_init(void) {
+  tu_memclr(&_uas, sizeof(_uas));
+}
+
+static void uas_reset(uint8_t rhport) {
+  (void) rhport;
+  uas_init();
+}
+
+// Claim Bulk-Only interface only if followed by an UAS alternate
+static uint16_t uas_open(uint8_t rhport, tusb_desc_interface_t const* desc_itf, uint16_t max_len) {
+  TU_VERIFY(desc_itf->bInterfaceClass == TUSB_CLASS_MSC && desc_itf->bInterfaceSubClass == MSC_SUBCLASS_SCSI &&
+            desc_itf->bInterfaceProtocol == MSC_PROTOCOL_BOT && desc_itf->bAlternateSetting == 0, 0);
+
+  uint8_t const* p_desc = (uint8_t const*) desc_itf;
+  uint8_t const* desc_end = p_desc + max_len;
+  tusb_desc_endpoint_t const* desc_ep = NULL;
+  tusb_desc_endpoint_t const* ep_desc[4] = { NULL };
+  bool in_uas = false;
+  uint8_t found = 0;
+
+  p_desc = tu_desc_next(p_desc);
+  while (p_desc < desc_end) {
+    uint8_t const type = tu_desc_type(p_desc);
+    if (type == TUSB_DESC_INTERFACE) {
+      tusb_desc_interface_t const* itf = (tusb_desc_interface_t const*) p_desc;
+      if (itf->bInterfaceNumber != desc_itf->bInterfaceNumber) break;
+      in_uas = (itf->bAlternateSetting == UAS_ALT && itf->bInterfaceProtocol == MSC_PROTOCOL_UAS);
+    } else if (type == TUSB_DESC_ENDPOINT) {
+      desc_ep = (tusb_desc_endpoint_t const*) p_desc;
+    } else if (type == MSC_UAS_DESC_PIPE_USAGE && in_uas && desc_ep) {
+      uint8_t const pipe_id = ((msc_uas_desc_pipe_usage_t const*) p_desc)->bPipeID;
+      if (pipe_id >= MSC_UAS_PIPE_COMMAND && pipe_id <= MSC_UAS_PIPE_DATA_OUT) {
+        ep_desc[pipe_id - 1] = desc_ep;
+        found |= (uint8_t) TU_BIT(pipe_id - 1);
+      }
+    }
+    p_desc = tu_desc_next(p_desc);
+  }
+
+  TU_VERIFY(found == 0x0F, 0);
+
+  for (uint8_t i = 0; i < 4; i++) {
+    TU_ASSERT(usbd_edpt_open(rhport, ep_desc[i]), 0);
+  }
+
+  _uas.itf_num = desc_itf->bInterfaceNumber;
+  _uas.ep_cmd = ep_desc[MSC_UAS_PIPE_COMMAND - 1]->bEndpointAddress;
+  _uas.ep_status = ep_desc[MSC_UAS_PIPE_STATUS - 1]->bEndpointAddress;
+  _uas.ep_in = ep_desc[MSC_UAS_PIPE_DATA_IN - 1]->bEndpointAddress;
+  _uas.ep_out = ep_desc[MSC_UAS_PIPE_DATA_OUT - 1]->bEndpointAddress;
+
+  return (uint16_t) (p_desc - (uint8_t const*) desc_itf);
+}
+
+static bool uas_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t const* request) {
+  if (stage != CONTROL_STAGE_SETUP) return true;
+  TU_VERIFY(request->bmRequestType_bit.type == TUSB_REQ_TYPE_STANDARD &&
+            request->bmRequestType_bit.recipient == TUSB_REQ_RCPT_INTERFACE);
+
+  switch (request->bRequest) {
+    case TUSB_REQ_SET_INTERFACE: {
+      uint8_t const itf_num = _uas.itf_num;
+      uint8_t const ep_cmd = _uas.ep_cmd, ep_status = _uas.ep_status, ep_in = _uas.ep_in, ep_out = _uas.ep_out;
+      TU_VERIFY(request->wValue <= UAS_ALT);
+
+      // drop all commands, endpoints stay opened
+      uas_init();
+      _uas.itf_num = itf_num;
+      _uas.ep_cmd = ep_cmd;
+      _uas.ep_status = ep_status;
+      _uas.ep_in = ep_in;
+      _uas.ep_out = ep_out;
+      _uas.alt = (uint8_t) request->wValue;
+
+      if (_uas.alt == UAS_ALT) cmd_arm(rhport);
+      return tud_control_status(rhport, request);
+    }
+
+    case TUSB_REQ_GET_INTERFACE:
+      return tud_control_xfer(rhport, request, &_uas.alt, 1);
+
+    default: return false;
+  }
+}
+
+static bool uas_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes) {
+  (void) xferred_bytes;
+  TU_ASSERT(result == XFER_RESULT_SUCCESS);
+
+  if (ep_addr == _uas.ep_cmd) {
+    _uas.cmd_armed = false;
+    TU_VERIFY(_uas.cmd_iu.iu_id == MSC_UAS_IU_COMMAND && _uas.count < UAS_QUEUE_DEPTH);
+
+    uas_cmd_t* cmd = &_uas.queue[(_uas.head + _uas.count) % UAS_QUEUE_DEPTH];
+    cmd->tag = _uas.cmd_iu.tag;
+    memcpy(cmd->cdb, _uas.cmd_iu.cdb, sizeof(cmd->cdb));
+    _uas.count++;
+
+    if (_uas.count < UAS_QUEUE_DEPTH) cmd_arm(rhport);
+  } else if (ep_addr == _uas.ep_status) {
+    if (_uas.stage == STAGE_READY) {
+      if (_uas.data == NULL) {
+        // host clears the halt with Clear Feature, handled by usbd
+        usbd_edpt_stall(rhport, _uas.ep_in);
+        send_sense(rhport, SCSI_SENSE_ILLEGAL_REQUEST, 0x21); // LBA out of range
+        return true;
+      }
+      _uas.stage = STAGE_DATA;
+      usbd_edpt_xfer(rhport, _uas.data_in ? _uas.ep_in : _uas.ep_out, _uas.data, _uas.data_len);
+      return true;
+    }
+    _uas.stage = STAGE_IDLE;
+  } else if (ep_addr == _uas.ep_in || ep_addr == _uas.ep_out) {
+    send_sense(rhport, SCSI_SENSE_NONE, 0);
+    return true;
+  }
+
+  cmd_next(rhport);
+  return true;
+}
+
+static usbd_class_driver_t const _app_drivers[] = {
+  {
+#if CFG_TUSB_DEBUG >= CFG_TUD_LOG_LEVEL
+    .name = "UAS",
+#endif
+    .init = uas_init,
+    .reset = uas_reset,
+    .open = uas_open,
+    .control_xfer_cb = uas_control_xfer_cb,
+    .xfer_cb = uas_xfer_cb,
+    .sof = NULL
+  },
+  {
+#if CFG_TUSB_DEBUG >= CFG_TUD_LOG_LEVEL
+    .name = "VENDOR",
+#endif
+    .init = bench_vendor_init,
+    .reset = bench_vendor_reset,
+    .open = bench_vendor_open,
+    .control_xfer_cb = bench_vendor_control_xfer_cb,
+    .xfer_cb = bench_vendor_xfer_cb,
+    .sof = NULL
+  }
+};
+
+usbd_class_driver_t const* usbd_app_driver_get_cb(uint8_t* driver_count) {
+  *driver_count = TU_ARRAY_SIZE(_app_drivers);
+  return _app_drivers;
+}
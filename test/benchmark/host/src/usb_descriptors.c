@@ -0,0 +1,261 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#include <string.h>
+#include "bench.h"
+
+#define USB_VID   0xCafe
+#define USB_PID   0x4007
+#define USB_BCD   0x0200
+
+//--------------------------------------------------------------------+
+// Device Descriptors
+//--------------------------------------------------------------------+
+static tusb_desc_device_t const desc_device = {
+    .bLength            = sizeof(tusb_desc_device_t),
+    .bDescriptorType    = TUSB_DESC_DEVICE,
+    .bcdUSB             = USB_BCD,
+
+    // Use Interface Association Descriptor (IAD) for CDC
+    .bDeviceClass       = TUSB_CLASS_MISC,
+    .bDeviceSubClass    = MISC_SUBCLASS_COMMON,
+    .bDeviceProtocol    = MISC_PROTOCOL_IAD,
+
+    .bMaxPacketSize0    = CFG_TUD_ENDPOINT0_SIZE,
+
+    .idVendor           = USB_VID,
+    .idProduct          = USB_PID,
+    .bcdDevice          = 0x0100,
+
+    .iManufacturer      = 0x01,
+    .iProduct           = 0x02,
+    .iSerialNumber      = 0x03,
+
+    .bNumConfigurations = 0x01
+};
+
+uint8_t const *tud_descriptor_device_cb(void) {
+  return (uint8_t const *) &desc_device;
+}
+
+//--------------------------------------------------------------------+
+// HID Report Descriptor
+//--------------------------------------------------------------------+
+
+static uint8_t const desc_hid_report[] = {
+    TUD_HID_REPORT_DESC_GENERIC_INOUT(BENCH_HID_REPORT_SIZE)
+};
+
+uint8_t const *tud_hid_descriptor_report_cb(uint8_t instance) {
+  (void) instance;
+  return desc_hid_report;
+}
+
+//--------------------------------------------------------------------+
+// Configuration Descriptor
+//--------------------------------------------------------------------+
+
+enum {
+  ITF_NUM_CDC = 0,
+  ITF_NUM_CDC_DATA,
+  ITF_NUM_MSC,
+  ITF_NUM_ZERO,
+  ITF_NUM_ZERO_LOOP,
+  ITF_NUM_VENDOR,
+  ITF_NUM_HID,
+  ITF_NUM_TOTAL
+};
+
+#define EPNUM_CDC_NOTIF   0x81
+#define EPNUM_CDC_OUT     0x02
+#define EPNUM_CDC_IN      0x82
+#define EPNUM_MSC_OUT     0x03
+#define EPNUM_MSC_IN      0x83
+#define EPNUM_HID         0x84
+
+#define EPNUM_UAS_DATA_OUT 0x05
+#define EPNUM_UAS_DATA_IN  0x85
+
+#define EPNUM_ZERO_OUT      0x06
+#define EPNUM_ZERO_IN       0x86
+#define EPNUM_ZERO_LOOP_OUT 0x07
+#define EPNUM_ZERO_LOOP_IN  0x87
+
+#define EPNUM_VENDOR_OUT    0x08
+#define EPNUM_VENDOR_IN     0x88
+
+// MSC interface with Bulk-Only alternate 0 and UAS alternate 1 (uas_device.c). Command and status pipe
+// share endpoints with Bulk-Only OUT and IN
+#define TUD_UAS_DESC_LEN  (9 + 7 + 7 + 9 + 4 * (7 + 4))
+
+#define TUD_UAS_PIPE_DESCRIPTOR(_epaddr, _epsize, _pipe_id) \
+  7, TUSB_DESC_ENDPOINT, _epaddr, TUSB_XFER_BULK, U16_TO_U8S_LE(_epsize), 0, \
+  4, MSC_UAS_DESC_PIPE_USAGE, _pipe_id, 0
+
+#define TUD_UAS_DESCRIPTOR(_itfnum, _epcmd, _epstatus, _epdin, _epdout, _epsize) \
+  /* Alternate 0: Bulk-Only */ \
+  9, TUSB_DESC_INTERFACE, _itfnum, 0, 2, TUSB_CLASS_MSC, MSC_SUBCLASS_SCSI, MSC_PROTOCOL_BOT, 0, \
+  7, TUSB_DESC_ENDPOINT, _epcmd, TUSB_XFER_BULK, U16_TO_U8S_LE(_epsize), 0, \
+  7, TUSB_DESC_ENDPOINT, _epstatus, TUSB_XFER_BULK, U16_TO_U8S_LE(_epsize), 0, \
+  /* Alternate 1: UAS */ \
+  9, TUSB_DESC_INTERFACE, _itfnum, 1, 4, TUSB_CLASS_MSC, MSC_SUBCLASS_SCSI, MSC_PROTOCOL_UAS, 0, \
+  TUD_UAS_PIPE_DESCRIPTOR(_epcmd, _epsize, MSC_UAS_PIPE_COMMAND), \
+  TUD_UAS_PIPE_DESCRIPTOR(_epstatus, _epsize, MSC_UAS_PIPE_STATUS), \
+  TUD_UAS_PIPE_DESCRIPTOR(_epdin, _epsize, MSC_UAS_PIPE_DATA_IN), \
+  TUD_UAS_PIPE_DESCRIPTOR(_epdout, _epsize, MSC_UAS_PIPE_DATA_OUT)
+
+#define ZERO_DESC_LEN  (TUD_ZERO_SRC_SINK_DESC_LEN + TUD_ZERO_LOOPBACK_DESC_LEN)
+
+// Source/sink with bulk, interrupt and isochronous alternates, and bulk loopback (zero_host.c)
+#define ZERO_DESCRIPTOR(_epsize, _periodic_size) \
+  TUD_ZERO_SRC_SINK_DESCRIPTOR(ITF_NUM_ZERO, 0, EPNUM_ZERO_OUT, EPNUM_ZERO_IN, _epsize, _periodic_size, 1, \
+                               _periodic_size, 1), \
+  TUD_ZERO_LOOPBACK_DESCRIPTOR(ITF_NUM_ZERO_LOOP, 0, EPNUM_ZERO_LOOP_OUT, EPNUM_ZERO_LOOP_IN, _epsize)
+
+// Source/sink like Linux g_zero: vendor interface without subclass (device_app.c), bound by tuh_zero_match_cb()
+#define VENDOR_DESC_LEN  (9 + 7 + 7)
+
+#define VENDOR_DESCRIPTOR(_epsize) \
+  9, TUSB_DESC_INTERFACE, ITF_NUM_VENDOR, 0, 2, TUSB_CLASS_VENDOR_SPECIFIC, 0, 0, 0, \
+  7, TUSB_DESC_ENDPOINT, EPNUM_VENDOR_IN, TUSB_XFER_BULK, U16_TO_U8S_LE(_epsize), 0, \
+  7, TUSB_DESC_ENDPOINT, EPNUM_VENDOR_OUT, TUSB_XFER_BULK, U16_TO_U8S_LE(_epsize), 0
+
+#define CONFIG_BOT_TOTAL_LEN  (TUD_CONFIG_DESC_LEN + TUD_CDC_DESC_LEN + TUD_MSC_DESC_LEN + ZERO_DESC_LEN + \
+                               VENDOR_DESC_LEN + TUD_HID_DESC_LEN)
+#define CONFIG_UAS_TOTAL_LEN  (TUD_CONFIG_DESC_LEN + TUD_CDC_DESC_LEN + TUD_UAS_DESC_LEN + ZERO_DESC_LEN + \
+                               VENDOR_DESC_LEN + TUD_HID_DESC_LEN)
+
+#define CONFIG_DESCRIPTOR(_total_len, _msc_desc, _epsize) \
+  TUD_CONFIG_DESCRIPTOR(1, ITF_NUM_TOTAL, 0, _total_len, 0x00, 100), \
+  TUD_CDC_DESCRIPTOR(ITF_NUM_CDC, 0, EPNUM_CDC_NOTIF, 8, EPNUM_CDC_OUT, EPNUM_CDC_IN, _epsize), \
+  _msc_desc, \
+  ZERO_DESCRIPTOR(_epsize, (_epsize == 512) ? 1024 : 64), \
+  VENDOR_DESCRIPTOR(_epsize), \
+  TUD_HID_DESCRIPTOR(ITF_NUM_HID, 0, HID_ITF_PROTOCOL_NONE, sizeof(desc_hid_report), EPNUM_HID, \
+                     BENCH_HID_REPORT_SIZE, 1)
+
+// HID is the last interface, its endpoint bInterval is the last byte. Not const since interval is changed per run
+static uint8_t desc_fs_bot_configuration[] = {
+    CONFIG_DESCRIPTOR(CONFIG_BOT_TOTAL_LEN, TUD_MSC_DESCRIPTOR(ITF_NUM_MSC, 0, EPNUM_MSC_OUT, EPNUM_MSC_IN, 64), 64)
+};
+
+static uint8_t desc_hs_bot_configuration[] = {
+    CONFIG_DESCRIPTOR(CONFIG_BOT_TOTAL_LEN, TUD_MSC_DESCRIPTOR(ITF_NUM_MSC, 0, EPNUM_MSC_OUT, EPNUM_MSC_IN, 512), 512)
+};
+
+static uint8_t desc_fs_uas_configuration[] = {
+    CONFIG_DESCRIPTOR(CONFIG_UAS_TOTAL_LEN,
+                      TUD_UAS_DESCRIPTOR(ITF_NUM_MSC, EPNUM_MSC_OUT, EPNUM_MSC_IN, EPNUM_UAS_DATA_IN,
+                                         EPNUM_UAS_DATA_OUT, 64), 64)
+};
+
+static uint8_t desc_hs_uas_configuration[] = {
+    CONFIG_DESCRIPTOR(CONFIG_UAS_TOTAL_LEN,
+                      TUD_UAS_DESCRIPTOR(ITF_NUM_MSC, EPNUM_MSC_OUT, EPNUM_MSC_IN, EPNUM_UAS_DATA_IN,
+                                         EPNUM_UAS_DATA_OUT, 512), 512)
+};
+
+TU_VERIFY_STATIC(sizeof(desc_fs_bot_configuration) == CONFIG_BOT_TOTAL_LEN, "Incorrect size");
+TU_VERIFY_STATIC(sizeof(desc_hs_bot_configuration) == CONFIG_BOT_TOTAL_LEN, "Incorrect size");
+TU_VERIFY_STATIC(sizeof(desc_fs_uas_configuration) == CONFIG_UAS_TOTAL_LEN, "Incorrect size");
+TU_VERIFY_STATIC(sizeof(desc_hs_uas_configuration) == CONFIG_UAS_TOTAL_LEN, "Incorrect size");
+
+static bool _msc_uas;
+
+// Set HID endpoint bInterval, must be called before the device is enumerated
+void bench_desc_set_hid_interval(uint8_t interval) {
+  desc_fs_bot_configuration[CONFIG_BOT_TOTAL_LEN - 1] = interval;
+  desc_hs_bot_configuration[CONFIG_BOT_TOTAL_LEN - 1] = interval;
+  desc_fs_uas_configuration[CONFIG_UAS_TOTAL_LEN - 1] = interval;
+  desc_hs_uas_configuration[CONFIG_UAS_TOTAL_LEN - 1] = interval;
+}
+
+// Select MSC interface with UAS alternate or Bulk-Only only, must be called before the device is enumerated
+void bench_desc_set_msc_uas(bool enabled) {
+  _msc_uas = enabled;
+}
+
+uint8_t const *tud_descriptor_configuration_cb(uint8_t index) {
+  (void) index;
+  if (tud_speed_get() == TUSB_SPEED_HIGH) {
+    return _msc_uas ? desc_hs_uas_configuration : desc_hs_bot_configuration;
+  }
+  return _msc_uas ? desc_fs_uas_configuration : desc_fs_bot_configuration;
+}
+
+static tusb_desc_device_qualifier_t const desc_device_qualifier = {
+    .bLength            = sizeof(tusb_desc_device_qualifier_t),
+    .bDescriptorType    = TUSB_DESC_DEVICE_QUALIFIER,
+    .bcdUSB             = USB_BCD,
+
+    .bDeviceClass       = TUSB_CLASS_MISC,
+    .bDeviceSubClass    = MISC_SUBCLASS_COMMON,
+    .bDeviceProtocol    = MISC_PROTOCOL_IAD,
+
+    .bMaxPacketSize0    = CFG_TUD_ENDPOINT0_SIZE,
+    .bNumConfigurations = 0x01,
+    .bReserved          = 0x00
+};
+
+uint8_t const *tud_descriptor_device_qualifier_cb(void) {
+  return (uint8_t const *) &desc_device_qualifier;
+}
+
+//--------------------------------------------------------------------+
+// String Descriptors
+//--------------------------------------------------------------------+
+
+static char const *string_desc_arr[] = {
+    (const char[]) { 0x09, 0x04 }, // 0: is supported language is English (0x0409)
+    "TinyUSB",                     // 1: Manufacturer
+    "TinyUSB Benchmark",           // 2: Product
+    "123456",                      // 3: Serial
+};
+
+static uint16_t _desc_str[32 + 1];
+
+uint16_t const *tud_descriptor_string_cb(uint8_t index, uint16_t langid) {
+  (void) langid;
+  size_t chr_count;
+
+  if (index == 0) {
+    memcpy(&_desc_str[1], string_desc_arr[0], 2);
+    chr_count = 1;
+  } else {
+    if (!(index < sizeof(string_desc_arr) / sizeof(string_desc_arr[0]))) return NULL;
+
+    const char *str = string_desc_arr[index];
+    chr_count = strlen(str);
+    for (size_t i = 0; i < chr_count; i++) {
+      _desc_str[1 + i] = str[i];
+    }
+  }
+
+  // first byte is length (including header), second byte is string type
+  _desc_str[0] = (uint16_t) ((TUSB_DESC_STRING << 8) | (2 * chr_count + 2));
+
+  return _desc_str;
+}
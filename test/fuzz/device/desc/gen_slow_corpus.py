@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+# Generate regression corpus of slow inputs for the descriptor parser harness.
+#
+# Input layout follows FuzzedDataProvider: byte arrays are taken from the front,
+# integers from the back of the input. See LLVMFuzzerTestOneInput() in src/fuzz.cc
+#   [callback data][descriptor chain] ... [target args reversed][target][callback len]
+
+import os
+import struct
+
+TARGET_DESC_FIND = 0
+TARGET_AUDIO = 1
+TARGET_VIDEO = 2
+
+# every controller call (e.g endpoint open) succeeds
+CALLBACK = bytes([1] * 64)
+
+
+def fuzz_input(target, args, chain):
+    return CALLBACK + chain + bytes(reversed(args)) + bytes([target, len(CALLBACK)])
+
+
+def desc(dtype, *payload):
+    body = bytes(payload)
+    return bytes([len(body) + 2, dtype]) + body
+
+
+def cs_itf(*payload):
+    return desc(0x24, *payload)
+
+
+def itf(num, alt, n_ep, cls, subclass, protocol):
+    return desc(0x04, num, alt, n_ep, cls, subclass, protocol, 0)
+
+
+def ep(addr, attr, size, interval):
+    return desc(0x05, addr, attr, size & 0xff, size >> 8, interval)
+
+
+#--------------------------------------------------------------------+
+# tu_desc_find()
+#--------------------------------------------------------------------+
+
+# zero length descriptor never advanced the walk
+def desc_find_zero_length():
+    chain = desc(0x04, *([0] * 7)) + bytes([0, 0x05]) + desc(0x05, *([0] * 5))
+    return fuzz_input(TARGET_DESC_FIND, [0x24, 0x01, 0x02], chain)
+
+
+# one step per byte, search never matches
+def desc_find_one_byte_step():
+    return fuzz_input(TARGET_DESC_FIND, [0x24, 0x01, 0x02], bytes([1] * 4096))
+
+
+#--------------------------------------------------------------------+
+# Audio
+#--------------------------------------------------------------------+
+
+# many entities, AS interface lookup and format parsing walk past all of them
+def audio_many_entities():
+    entities = b''.join(cs_itf(0x0A, eid, 0x01, 0x07, 0, 0) for eid in range(1, 41))
+    ac_total = 9 + len(entities)
+    chain = itf(0, 0, 0, 0x01, 0x01, 0x20)
+    chain += cs_itf(0x01, 0x00, 0x02, 0x03, ac_total & 0xff, ac_total >> 8, 0)
+    chain += entities
+    chain += itf(1, 0, 0, 0x01, 0x02, 0x20)
+    chain += itf(1, 1, 1, 0x01, 0x02, 0x20)
+    chain += cs_itf(0x01, 2, 0, 0x01, 0x01, 0, 0, 0, 4, 0, 0, 0, 0, 0)
+    chain += cs_itf(0x02, 0x01, 2, 16)
+    chain += ep(0x81, 0x05, 392, 1)
+    chain += desc(0x25, 0x01, 0, 0, 0, 0, 0)
+    return fuzz_input(TARGET_AUDIO, [1, 1], chain)
+
+
+#--------------------------------------------------------------------+
+# Video
+#--------------------------------------------------------------------+
+
+# more formats and frames than indexed, probe falls back to descriptor walk
+def video_many_formats():
+    n_fmt = 8
+    n_frm = 8
+
+    fmts = b''
+    for f in range(1, n_fmt + 1):
+        fmts += cs_itf(0x06, f, n_frm, 0, 1, 0, 0, 0, 0)
+        for i in range(1, n_frm + 1):
+            w, h = 16 * i, 16 * i
+            frm = struct.pack('<BBHHIIIIBIII', i, 0, w, h, w * h * 16 * 10, w * h * 16 * 30, w * h * 2,
+                              333333, 0, 333333, 1000000, 333333)
+            fmts += cs_itf(0x07, *frm)
+
+    vs_total = 13 + n_fmt + len(fmts)
+    vs_hdr = cs_itf(0x01, n_fmt, vs_total & 0xff, vs_total >> 8, 0x81, 0, 2, 0, 0, 0, 1, *([0] * n_fmt))
+
+    terms = cs_itf(0x02, 1, 0x01, 0x02, 0, 0, 0, 0, 0, 0, 0, 0, 3, 0, 0, 0)
+    terms += cs_itf(0x03, 2, 0x01, 0x01, 0, 1, 0)
+    vc_total = 13 + len(terms)
+    vc_hdr = cs_itf(0x01, 0x50, 0x01, vc_total & 0xff, vc_total >> 8, 0x80, 0x8d, 0x5b, 0x00, 1, 1)
+
+    chain = itf(0, 0, 0, 0x0E, 0x01, 0x01) + vc_hdr + terms
+    chain += itf(1, 0, 0, 0x0E, 0x02, 0x01) + vs_hdr + fmts
+    chain += itf(1, 1, 1, 0x0E, 0x02, 0x01) + ep(0x81, 0x05, 256, 1)
+    return fuzz_input(TARGET_VIDEO, [1, 1], chain)
+
+
+if __name__ == '__main__':
+    out = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'slow_corpus')
+    os.makedirs(out, exist_ok=True)
+    for gen in (desc_find_zero_length, desc_find_one_byte_step, audio_many_entities, video_many_formats):
+        with open(os.path.join(out, gen.__name__), 'wb') as f:
+            f.write(gen())
@@ -0,0 +1,208 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2022 Nathaniel Brough
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <fuzzer/FuzzedDataProvider.h>
+#include <string.h>
+#include <vector>
+
+#include "fuzz/fuzz.h"
+#include "fuzz/fuzz_cost.h"
+#include "tusb.h"
+
+//--------------------------------------------------------------------+
+// MACRO CONSTANT TYPEDEF PROTYPES
+//--------------------------------------------------------------------+
+
+// Descriptor parsers of the device stack, measured for worst-case cost.
+// Input layout: target (1 byte), target arguments, then the descriptor chain.
+enum {
+  TARGET_DESC_FIND = 0, // tu_desc_find(), tu_desc_find2(), tu_desc_find3()
+  TARGET_AUDIO,         // audiod_open() + SET_INTERFACE (audiod_parse_for_AS_params())
+  TARGET_VIDEO,         // videod_open() + SET_INTERFACE + probe/commit
+  TARGET_COUNT
+};
+
+// Parsers may peek a few bytes into a descriptor before checking its length
+#define DESC_SLACK 8
+
+// Device descriptors are provided by the application, therefore only well-formed
+// chains are fed to the class drivers: each bLength is non-zero and the chain
+// exactly covers the buffer.
+static bool desc_chain_valid(std::vector<uint8_t> const &desc) {
+  size_t ofs = 0;
+  while (ofs < desc.size()) {
+    if (desc[ofs] == 0 || desc[ofs] > desc.size() - ofs) {
+      return false;
+    }
+    ofs += desc[ofs];
+  }
+  return true;
+}
+
+// Pad chain with filler descriptors up to len, keep DESC_SLACK zeroes after it
+static void desc_chain_pad(std::vector<uint8_t> &desc, size_t len) {
+  while (desc.size() < len) {
+    size_t const remain = len - desc.size();
+    uint8_t const n = (uint8_t)(remain > 255 ? 128 : remain);
+    desc.push_back(n);
+    desc.insert(desc.end(), n - 1, 0xFF);
+  }
+  desc.insert(desc.end(), DESC_SLACK, 0);
+}
+
+static void control_request(uint8_t stage, uint8_t type, uint8_t request, uint16_t value,
+                            uint16_t index, uint16_t length,
+                            bool (*cb)(uint8_t, uint8_t, tusb_control_request_t const *)) {
+  tusb_control_request_t req;
+  memset(&req, 0, sizeof(req));
+  req.bmRequestType_bit.recipient = TUSB_REQ_RCPT_INTERFACE;
+  req.bmRequestType_bit.type = type;
+  req.bmRequestType_bit.direction = (request & 0x80) ? TUSB_DIR_IN : TUSB_DIR_OUT;
+  req.bRequest = request;
+  req.wValue = value;
+  req.wIndex = index;
+  req.wLength = length;
+  cb(0, stage, &req);
+}
+
+//--------------------------------------------------------------------+
+// Targets
+//--------------------------------------------------------------------+
+
+static void fuzz_desc_find(FuzzedDataProvider &provider) {
+  uint8_t const byte1 = provider.ConsumeIntegral<uint8_t>();
+  uint8_t const byte2 = provider.ConsumeIntegral<uint8_t>();
+  uint8_t const byte3 = provider.ConsumeIntegral<uint8_t>();
+
+  // Any bytes: this is also used by the host stack on untrusted descriptors
+  std::vector<uint8_t> desc = provider.ConsumeRemainingBytes<uint8_t>();
+  size_t const len = desc.size();
+  desc.insert(desc.end(), DESC_SLACK, 0);
+
+  uint8_t const *beg = desc.data();
+  uint8_t const *end = beg + len;
+
+  fuzz_cost_begin();
+  for (uint8_t const *p = beg; p && p < end; p = tu_desc_find(p + 1, end, byte1)) {}
+  for (uint8_t const *p = beg; p && p < end; p = tu_desc_find2(p + 1, end, byte1, byte2)) {}
+  for (uint8_t const *p = beg; p && p < end; p = tu_desc_find3(p + 1, end, byte1, byte2, byte3)) {}
+  fuzz_cost_end(len);
+}
+
+static void fuzz_audio(FuzzedDataProvider &provider) {
+  uint8_t const itf = provider.ConsumeIntegral<uint8_t>();
+  uint8_t const alt = provider.ConsumeIntegral<uint8_t>();
+
+  // Audio function length is fixed by CFG_TUD_AUDIO_FUNC_1_DESC_LEN, counted from IAD
+  size_t const max_len = CFG_TUD_AUDIO_FUNC_1_DESC_LEN - TUD_AUDIO_DESC_IAD_LEN;
+  std::vector<uint8_t> desc = provider.ConsumeBytes<uint8_t>(max_len);
+  if (desc.size() < sizeof(tusb_desc_interface_t) || !desc_chain_valid(desc)) {
+    return;
+  }
+  size_t const len = desc.size();
+  desc_chain_pad(desc, max_len);
+
+  fuzz_cost_begin();
+  audiod_reset(0);
+  if (audiod_open(0, (tusb_desc_interface_t const *)desc.data(), (uint16_t)max_len)) {
+    control_request(CONTROL_STAGE_SETUP, TUSB_REQ_TYPE_STANDARD, TUSB_REQ_SET_INTERFACE, alt, itf, 0,
+                    audiod_control_xfer_cb);
+  }
+  audiod_reset(0);
+  fuzz_cost_end(len);
+}
+
+static void fuzz_video(FuzzedDataProvider &provider) {
+  uint8_t const itf = provider.ConsumeIntegral<uint8_t>();
+  uint8_t const alt = provider.ConsumeIntegral<uint8_t>();
+
+  std::vector<uint8_t> desc = provider.ConsumeRemainingBytes<uint8_t>();
+  if (desc.size() < sizeof(tusb_desc_interface_t) || desc.size() > UINT16_MAX ||
+      !desc_chain_valid(desc)) {
+    return;
+  }
+  size_t const len = desc.size();
+  desc.insert(desc.end(), DESC_SLACK, 0);
+
+  uint16_t const probe = VIDEO_VS_CTL_PROBE << 8;
+  uint16_t const commit = VIDEO_VS_CTL_COMMIT << 8;
+  uint16_t const probe_len = sizeof(video_probe_and_commit_control_t);
+
+  fuzz_cost_begin();
+  videod_reset(0);
+  if (videod_open(0, (tusb_desc_interface_t const *)desc.data(), (uint16_t)len)) {
+    control_request(CONTROL_STAGE_SETUP, TUSB_REQ_TYPE_STANDARD, TUSB_REQ_SET_INTERFACE, alt, itf, 0,
+                    videod_control_xfer_cb);
+
+    static uint8_t const get_req[] = {VIDEO_REQUEST_GET_MIN, VIDEO_REQUEST_GET_MAX,
+                                      VIDEO_REQUEST_GET_DEF, VIDEO_REQUEST_GET_CUR};
+    for (uint8_t req : get_req) {
+      control_request(CONTROL_STAGE_SETUP, TUSB_REQ_TYPE_CLASS, req, probe, itf, probe_len,
+                      videod_control_xfer_cb);
+    }
+
+    // SET_CUR is evaluated on data stage, with whatever probe data is in the buffer
+    control_request(CONTROL_STAGE_SETUP, TUSB_REQ_TYPE_CLASS, VIDEO_REQUEST_SET_CUR, probe, itf,
+                    probe_len, videod_control_xfer_cb);
+    control_request(CONTROL_STAGE_DATA, TUSB_REQ_TYPE_CLASS, VIDEO_REQUEST_SET_CUR, probe, itf,
+                    probe_len, videod_control_xfer_cb);
+    control_request(CONTROL_STAGE_SETUP, TUSB_REQ_TYPE_CLASS, VIDEO_REQUEST_SET_CUR, commit, itf,
+                    probe_len, videod_control_xfer_cb);
+    control_request(CONTROL_STAGE_DATA, TUSB_REQ_TYPE_CLASS, VIDEO_REQUEST_SET_CUR, commit, itf,
+                    probe_len, videod_control_xfer_cb);
+  }
+  videod_reset(0);
+  fuzz_cost_end(len);
+}
+
+//--------------------------------------------------------------------+
+// Fuzz entry
+//--------------------------------------------------------------------+
+
+extern "C" int LLVMFuzzerInitialize(int *argc, char ***argv) {
+  (void)argc;
+  (void)argv;
+  audiod_init();
+  videod_init();
+  return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *Data, size_t Size) {
+  FuzzedDataProvider provider(Data, Size);
+
+  // Controller responses (e.g endpoint open) are taken from the input
+  std::vector<uint8_t> callback_data = provider.ConsumeBytes<uint8_t>(
+      provider.ConsumeIntegralInRange<size_t>(0, 64));
+  fuzz_init(callback_data.data(), callback_data.size());
+
+  switch (provider.ConsumeIntegralInRange<uint8_t>(0, TARGET_COUNT - 1)) {
+    case TARGET_DESC_FIND: fuzz_desc_find(provider); break;
+    case TARGET_AUDIO:     fuzz_audio(provider);     break;
+    case TARGET_VIDEO:     fuzz_video(provider);     break;
+    default: break;
+  }
+
+  return 0;
+}
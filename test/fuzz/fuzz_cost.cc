@@ -0,0 +1,146 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include "fuzz/fuzz_cost.h"
+#include <linux/perf_event.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+//--------------------------------------------------------------------+
+// MACRO CONSTANT TYPEDEF PROTYPES
+//--------------------------------------------------------------------+
+
+// 4 buckets per power of two of cost per byte
+#define COST_BUCKET_PER_LOG2 4
+#define COST_BUCKET_COUNT (64 * COST_BUCKET_PER_LOG2)
+
+// Every byte in this section is an extra coverage counter for libFuzzer,
+// cleared before each run.
+__attribute__((used, section("__libfuzzer_extra_counters")))
+static uint8_t _cost_counters[COST_BUCKET_COUNT];
+
+static struct {
+  bool initialized;
+  int perf_fd; // -1 if instruction counter is not available
+  uint64_t limit_base;
+  uint64_t limit_per_byte;
+  uint64_t start;
+} _cost = {false, -1, 0, 0, 0};
+
+//--------------------------------------------------------------------+
+// Counter
+//--------------------------------------------------------------------+
+
+static uint64_t env_u64(const char *name) {
+  const char *str = getenv(name);
+  return str ? strtoull(str, NULL, 0) : 0;
+}
+
+static void cost_init(void) {
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.size = sizeof(attr);
+  attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+
+  _cost.limit_base = env_u64("FUZZ_COST_BASE");
+  _cost.limit_per_byte = env_u64("FUZZ_COST_PER_BYTE");
+
+  _cost.perf_fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+  if (_cost.perf_fd < 0) {
+    // limits are instruction counts, comparing them with nanoseconds would silently
+    // pass or fail depending on the machine
+    if (_cost.limit_base || _cost.limit_per_byte) {
+      perror("fuzz_cost: instruction counter required by FUZZ_COST_BASE/FUZZ_COST_PER_BYTE is not available "
+             "(check /proc/sys/kernel/perf_event_paranoid)");
+      abort();
+    }
+    fprintf(stderr, "fuzz_cost: instruction counter not available, cost feedback uses cpu time (ns)\n");
+  }
+
+  _cost.initialized = true;
+}
+
+static uint64_t cost_read(void) {
+  if (_cost.perf_fd >= 0) {
+    uint64_t count = 0;
+    if (read(_cost.perf_fd, &count, sizeof(count)) != sizeof(count)) {
+      // never mix units within a run
+      perror("fuzz_cost: failed to read instruction counter");
+      abort();
+    }
+    return count;
+  }
+
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// bucket index of cost per byte, log2 with COST_BUCKET_PER_LOG2 sub-steps
+static unsigned cost_bucket(uint64_t cost, size_t size) {
+  uint64_t const per_byte = cost / (size + 1);
+  if (per_byte == 0) return 0;
+
+  unsigned const log2 = 63u - (unsigned)__builtin_clzll(per_byte);
+  unsigned const frac = (log2 >= 2) ? (unsigned)(per_byte >> (log2 - 2)) & 0x3u
+                                    : (unsigned)(per_byte << (2 - log2)) & 0x3u;
+  return log2 * COST_BUCKET_PER_LOG2 + frac;
+}
+
+//--------------------------------------------------------------------+
+// API
+//--------------------------------------------------------------------+
+
+extern "C" void fuzz_cost_begin(void) {
+  if (!_cost.initialized) {
+    cost_init();
+  }
+  _cost.start = cost_read();
+}
+
+extern "C" uint64_t fuzz_cost_end(size_t size) {
+  uint64_t const cost = cost_read() - _cost.start;
+
+  _cost_counters[cost_bucket(cost, size)] = 1;
+
+  if (_cost.limit_base || _cost.limit_per_byte) {
+    uint64_t const limit = _cost.limit_base + _cost.limit_per_byte * size;
+    if (cost > limit) {
+      fprintf(stderr, "fuzz_cost: input of %zu bytes cost %llu, limit is %llu\n",
+              size, (unsigned long long)cost, (unsigned long long)limit);
+      abort();
+    }
+  }
+
+  return cost;
+}
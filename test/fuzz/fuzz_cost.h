@@ -0,0 +1,53 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Worst-case cost feedback for fuzz harnesses.
+//
+// The cost of running one input is measured as retired user-space instructions
+// (perf counter), or as thread cpu time in nanoseconds when perf is not available.
+// Cost per input byte is reported to libFuzzer as extra coverage counters so that
+// inputs reaching a higher cost bucket are kept, steering the fuzzer towards slow inputs.
+//
+// Environment variables (both 0/unset = no limit), in instructions:
+//   FUZZ_COST_BASE     : cost allowed for any input
+//   FUZZ_COST_PER_BYTE : additional cost allowed per input byte
+// Setting a limit requires the perf instruction counter, the harness aborts at start otherwise.
+// An input exceeding FUZZ_COST_BASE + FUZZ_COST_PER_BYTE * size aborts, so that slow
+// inputs are reported as crashes and the regression corpus fails on algorithmic blowups.
+
+void fuzz_cost_begin(void);
+uint64_t fuzz_cost_end(size_t size);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,88 @@
+#!/usr/bin/env python3
+# Generate regression corpus of slow inputs for the host descriptor parser harness.
+#
+# Input is the image of the enumerated device, see LLVMFuzzerTestOneInput() in src/fuzz.cc
+#   [device descriptor][configuration descriptor][HID report descriptor]
+
+import os
+import struct
+
+DEVICE = struct.pack('<BBHBBBBHHHBBBB', 18, 0x01, 0x0200, 0, 0, 0, 64, 0xCAFE, 0x4000, 0x0100, 0, 0, 0, 1)
+
+
+def desc(dtype, *payload):
+    body = bytes(payload)
+    return bytes([len(body) + 2, dtype]) + body
+
+
+def config(body, total=None):
+    total = (9 + len(body)) if total is None else total
+    return desc(0x02, total & 0xff, total >> 8, 1, 1, 0, 0x80, 50) + body
+
+
+def itf(num, alt, n_ep, cls, subclass, protocol):
+    return desc(0x04, num, alt, n_ep, cls, subclass, protocol, 0)
+
+
+def ep(addr, attr, size, interval):
+    return desc(0x05, addr, attr, size & 0xff, size >> 8, interval)
+
+
+def hid(report_len):
+    return desc(0x21, 0x11, 0x01, 0, 1, 0x22, report_len & 0xff, report_len >> 8)
+
+
+def hid_interface(num, report_len):
+    return itf(num, 0, 1, 0x03, 0, 0) + hid(report_len) + ep(0x81, 0x03, 8, 10)
+
+
+#--------------------------------------------------------------------+
+# Configuration descriptor
+#--------------------------------------------------------------------+
+
+# zero length descriptor never advanced interface length calculation
+def config_zero_length():
+    body = itf(0, 0, 1, 0x03, 0, 0) + bytes([0, 0x21]) + ep(0x81, 0x03, 8, 10)
+    return DEVICE + config(body)
+
+
+# interface number beyond interface table, bound to driver once opened
+def config_itf_number_out_of_range():
+    return DEVICE + config(hid_interface(200, 0))
+
+
+# interface followed by many minimal descriptors, walked by usbh and driver
+def config_many_descriptors():
+    body = itf(0, 0, 1, 0x03, 0, 0) + hid(0) + bytes([2, 0xFF] * 100) + ep(0x81, 0x03, 8, 10)
+    return DEVICE + config(body)
+
+
+#--------------------------------------------------------------------+
+# HID report descriptor
+#--------------------------------------------------------------------+
+
+# many short items, each with a new report ID
+def hid_report_many_ids():
+    report = b''
+    for rid in range(1, 61):
+        report += bytes([0x85, rid])       # Report ID
+        report += bytes([0x09, 0x01])      # Usage
+    report = report[:248] + bytes([0xC0] * (248 - len(report[:248])))
+    return DEVICE + config(hid_interface(0, len(report))) + report
+
+
+# deeply nested collections
+def hid_report_nested_collections():
+    depth = 120
+    report = bytes([0x05, 0x01]) + bytes([0xA1, 0x01] * depth) + bytes([0xC0] * depth)
+    report = report[:256]
+    return DEVICE + config(hid_interface(0, len(report))) + report
+
+
+if __name__ == '__main__':
+    out = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'slow_corpus')
+    os.makedirs(out, exist_ok=True)
+    for gen in (config_zero_length, config_itf_number_out_of_range, config_many_descriptors,
+                hid_report_many_ids, hid_report_nested_collections):
+        with open(os.path.join(out, gen.__name__), 'wb') as f:
+            f.write(gen())
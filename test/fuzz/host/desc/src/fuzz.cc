@@ -0,0 +1,261 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2022 Nathaniel Brough
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <string.h>
+
+#include "fuzz/fuzz_cost.h"
+#include "host/hcd.h"
+#include "tusb.h"
+
+//--------------------------------------------------------------------+
+// MACRO CONSTANT TYPEDEF PROTYPES
+//--------------------------------------------------------------------+
+
+// Enumeration of a device whose descriptors are the fuzz input, measured for
+// worst-case cost of host parsers: _parse_configuration_descriptor(), class
+// driver open() and tuh_hid_parse_report_descriptor().
+//
+// Input is the device image:
+//   [device descriptor (18)][configuration descriptor (wTotalLength)][HID report descriptor]
+// Configuration and report descriptors are returned as is, i.e wTotalLength
+// and bLength are not fixed up to match the actual data.
+
+// Simulated time per task iteration, enough for debouncing, reset and retries
+#define TASK_ITERATION_MS 10
+#define TASK_ITERATIONS 300
+
+static struct {
+  uint8_t const *image;
+  size_t len;
+  bool connected;
+  uint32_t ms;
+  tusb_control_request_t request;
+} _dev;
+
+//--------------------------------------------------------------------+
+// Device model
+//--------------------------------------------------------------------+
+
+static size_t image_config_len(void) {
+  if (_dev.len < sizeof(tusb_desc_device_t) + 4) {
+    return 0;
+  }
+  size_t const total = tu_le16toh(tu_unaligned_read16(_dev.image + sizeof(tusb_desc_device_t) + 2));
+  return tu_min32((uint32_t)total, (uint32_t)(_dev.len - sizeof(tusb_desc_device_t)));
+}
+
+// Data stage of IN request, return number of bytes or -1 to stall
+static int device_control_in(uint8_t *buffer, uint16_t buflen) {
+  tusb_control_request_t const *req = &_dev.request;
+  uint8_t const *data = NULL;
+  size_t len = 0;
+
+  if (req->bRequest == TUSB_REQ_GET_DESCRIPTOR) {
+    size_t const cfg_len = image_config_len();
+    uint8_t const *cfg = _dev.image + sizeof(tusb_desc_device_t);
+
+    switch (tu_u16_high(req->wValue)) {
+      case TUSB_DESC_DEVICE:
+        data = _dev.image;
+        len = tu_min32((uint32_t)_dev.len, sizeof(tusb_desc_device_t));
+        break;
+
+      case TUSB_DESC_CONFIGURATION:
+        if (cfg_len == 0) return -1;
+        data = cfg;
+        len = _dev.len - sizeof(tusb_desc_device_t);
+        break;
+
+      case HID_DESC_TYPE_REPORT:
+        if (cfg_len == 0) return -1;
+        data = cfg + cfg_len;
+        len = _dev.len - sizeof(tusb_desc_device_t) - cfg_len;
+        break;
+
+      default:
+        return -1;
+    }
+  }
+
+  // Other IN requests (e.g class/vendor) return all zeroes
+  uint16_t const count = (uint16_t)tu_min32(buflen, data ? (uint32_t)len : req->wLength);
+  if (data) {
+    memcpy(buffer, data, count);
+  } else {
+    memset(buffer, 0, count);
+  }
+  return count;
+}
+
+//--------------------------------------------------------------------+
+// Controller API
+//--------------------------------------------------------------------+
+extern "C" {
+
+bool hcd_init(uint8_t rhport) {
+  (void)rhport;
+  return true;
+}
+
+void hcd_int_handler(uint8_t rhport) { (void)rhport; }
+void hcd_int_enable(uint8_t rhport) { (void)rhport; }
+void hcd_int_disable(uint8_t rhport) { (void)rhport; }
+
+uint32_t hcd_frame_number(uint8_t rhport) {
+  (void)rhport;
+  return _dev.ms;
+}
+
+bool hcd_port_connect_status(uint8_t rhport) {
+  (void)rhport;
+  return _dev.connected;
+}
+
+void hcd_port_reset(uint8_t rhport) { (void)rhport; }
+void hcd_port_reset_end(uint8_t rhport) { (void)rhport; }
+
+tusb_speed_t hcd_port_speed_get(uint8_t rhport) {
+  (void)rhport;
+  return TUSB_SPEED_FULL;
+}
+
+void hcd_device_close(uint8_t rhport, uint8_t dev_addr) {
+  (void)rhport;
+  (void)dev_addr;
+}
+
+bool hcd_edpt_open(uint8_t rhport, uint8_t dev_addr, tusb_desc_endpoint_t const *ep_desc) {
+  (void)rhport;
+  (void)dev_addr;
+  (void)ep_desc;
+  return true;
+}
+
+bool hcd_setup_send(uint8_t rhport, uint8_t dev_addr, uint8_t const setup_packet[8]) {
+  (void)rhport;
+  memcpy(&_dev.request, setup_packet, sizeof(tusb_control_request_t));
+  hcd_event_xfer_complete(dev_addr, 0, 8, XFER_RESULT_SUCCESS, false);
+  return true;
+}
+
+bool hcd_edpt_xfer(uint8_t rhport, uint8_t dev_addr, uint8_t ep_addr, uint8_t *buffer, uint16_t buflen) {
+  (void)rhport;
+
+  // Device never answers on non-control endpoints
+  if (tu_edpt_number(ep_addr) != 0) {
+    return true;
+  }
+
+  if (tu_edpt_dir(ep_addr) == TUSB_DIR_IN && buflen) {
+    int const count = device_control_in(buffer, buflen);
+    if (count < 0) {
+      hcd_event_xfer_complete(dev_addr, ep_addr, 0, XFER_RESULT_STALLED, false);
+    } else {
+      hcd_event_xfer_complete(dev_addr, ep_addr, (uint32_t)count, XFER_RESULT_SUCCESS, false);
+    }
+  } else {
+    hcd_event_xfer_complete(dev_addr, ep_addr, buflen, XFER_RESULT_SUCCESS, false);
+  }
+  return true;
+}
+
+bool hcd_edpt_abort_xfer(uint8_t rhport, uint8_t dev_addr, uint8_t ep_addr) {
+  (void)rhport;
+  (void)dev_addr;
+  (void)ep_addr;
+  return true;
+}
+
+bool hcd_edpt_clear_stall(uint8_t rhport, uint8_t dev_addr, uint8_t ep_addr) {
+  (void)rhport;
+  (void)dev_addr;
+  (void)ep_addr;
+  return true;
+}
+
+//--------------------------------------------------------------------+
+// Time, delays elapse immediately
+//--------------------------------------------------------------------+
+
+uint32_t tuh_time_millis(void) { return _dev.ms; }
+
+void osal_task_delay(uint32_t msec) { _dev.ms += msec; }
+
+//--------------------------------------------------------------------+
+// Application callbacks
+//--------------------------------------------------------------------+
+
+void tuh_hid_mount_cb(uint8_t dev_addr, uint8_t idx, uint8_t const *report_desc, uint16_t desc_len) {
+  (void)dev_addr;
+  (void)idx;
+  tuh_hid_report_info_t info[8];
+  tuh_hid_parse_report_descriptor(info, TU_ARRAY_SIZE(info), report_desc, desc_len);
+}
+
+void tuh_hid_report_received_cb(uint8_t dev_addr, uint8_t idx, uint8_t const *report, uint16_t len) {
+  (void)dev_addr;
+  (void)idx;
+  (void)report;
+  (void)len;
+}
+}
+
+//--------------------------------------------------------------------+
+// Fuzz entry
+//--------------------------------------------------------------------+
+
+extern "C" int LLVMFuzzerInitialize(int *argc, char ***argv) {
+  (void)argc;
+  (void)argv;
+  tuh_init(BOARD_TUH_RHPORT);
+  return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *Data, size_t Size) {
+  _dev.image = Data;
+  _dev.len = Size;
+
+  fuzz_cost_begin();
+
+  _dev.connected = true;
+  hcd_event_device_attach(BOARD_TUH_RHPORT, false);
+  for (int i = 0; i < TASK_ITERATIONS; i++) {
+    _dev.ms += TASK_ITERATION_MS;
+    tuh_task();
+  }
+
+  _dev.connected = false;
+  hcd_event_device_remove(BOARD_TUH_RHPORT, false);
+  for (int i = 0; i < TASK_ITERATIONS; i++) {
+    _dev.ms += TASK_ITERATION_MS;
+    tuh_task();
+  }
+
+  fuzz_cost_end(Size);
+
+  _dev.image = NULL;
+  _dev.len = 0;
+  return 0;
+}
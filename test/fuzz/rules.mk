@@ -21,7 +21,21 @@ endif
 # TinyUSB Stack source
 SRC_C += \
 	src/tusb.c \
-	src/common/tusb_fifo.c \
+	src/common/tusb_fifo.c
+
+ifeq ($(FUZZ_HOST),1)
+# Host stack, harness provides its own controller model
+SRC_C += \
+	src/host/usbh.c \
+	src/host/hub.c \
+	src/class/cdc/cdc_host.c \
+	src/class/hid/hid_host.c \
+	src/class/msc/msc_host.c
+
+SRC_CXX += \
+	test/fuzz/fuzz.cc
+else
+SRC_C += \
 	src/device/usbd.c \
 	src/device/usbd_control.c \
 	src/class/audio/audio_device.c \
@@ -31,12 +45,14 @@ SRC_C += \
 	src/class/hid/hid_device.c \
 	src/class/midi/midi_device.c \
 	src/class/msc/msc_device.c \
+	src/class/msc/msc_image.c \
 	src/class/net/ecm_rndis_device.c \
 	src/class/net/ncm_device.c \
+	src/class/net/net_csum.c \
 	src/class/usbtmc/usbtmc_device.c \
 	src/class/video/video_device.c \
-	src/class/vendor/vendor_device.c
-
+	src/class/vendor/vendor_device.c \
+	src/class/zero/zero_device.c
 
 # Fuzzers are c++
 SRC_CXX += \
@@ -45,6 +61,7 @@ SRC_CXX += \
 	test/fuzz/msc_fuzz.cc \
 	test/fuzz/net_fuzz.cc \
 	test/fuzz/usbd_fuzz.cc
+endif
 
 # TinyUSB stack include
 INC += $(TOP)/src
@@ -144,6 +161,15 @@ endif
 get-deps:
 	$(PYTHON) $(TOP)/tools/get_deps.py $(DEPS_SUBMODULES)
 
+# Run inputs of the regression corpus (if any) once, slow inputs fail with the cost limit
+# set by FUZZ_COST_BASE/FUZZ_COST_PER_BYTE (see test/fuzz/fuzz_cost.h)
+REGRESSION_CORPUS ?= slow_corpus
+regression: $(BUILD)/$(PROJECT)
+ifneq ($(wildcard $(REGRESSION_CORPUS)/*),)
+	FUZZ_COST_BASE=$(FUZZ_COST_BASE) FUZZ_COST_PER_BYTE=$(FUZZ_COST_PER_BYTE) \
+	$(BUILD)/$(PROJECT) -timeout=5 $(wildcard $(REGRESSION_CORPUS)/*)
+endif
+
 size: $(BUILD)/$(PROJECT)
 	-@echo ''
 	@$(SIZE) $<
@@ -0,0 +1,351 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#include "unity.h"
+
+// Files to test
+#include "osal/osal.h"
+#include "tusb_fifo.h"
+#include "tusb.h"
+#include "usbd.h"
+TEST_FILE("usbd_control.c")
+TEST_FILE("audio_device.c")
+
+// Mock File
+#include "mock_dcd.h"
+
+//--------------------------------------------------------------------+
+// MACRO TYPEDEF CONSTANT ENUM DECLARATION
+//--------------------------------------------------------------------+
+
+enum
+{
+  EDPT_AUDIO_IN = 0x81,
+  AUDIO_EP_SIZE = CFG_TUD_AUDIO_FUNC_1_EP_IN_SZ_MAX,
+};
+
+enum
+{
+  ITF_NUM_AUDIO_CONTROL,
+  ITF_NUM_AUDIO_STREAMING,
+  ITF_NUM_TOTAL
+};
+
+uint8_t const rhport = 0;
+
+#define CONFIG_TOTAL_LEN    (TUD_CONFIG_DESC_LEN + TUD_AUDIO_MIC_ONE_CH_DESC_LEN)
+
+uint8_t const data_desc_configuration[] =
+{
+  TUD_CONFIG_DESCRIPTOR(1, ITF_NUM_TOTAL, 0, CONFIG_TOTAL_LEN, 0, 100),
+  TUD_AUDIO_MIC_ONE_CH_DESCRIPTOR(ITF_NUM_AUDIO_CONTROL, 0, 2, 16, EDPT_AUDIO_IN, AUDIO_EP_SIZE),
+};
+
+uint8_t const * tud_descriptor_device_cb(void)
+{
+  return NULL;
+}
+
+uint8_t const * tud_descriptor_configuration_cb(uint8_t index)
+{
+  (void) index;
+  return data_desc_configuration;
+}
+
+uint16_t const* tud_descriptor_string_cb(uint8_t index, uint16_t langid)
+{
+  (void) index;
+  (void) langid;
+  return NULL;
+}
+
+static tud_stream_stamp_t stamp_log[8];
+static uint8_t stamp_count;
+
+void tud_audio_tx_stamp_cb(uint8_t func_id, tud_stream_stamp_t const* stamp)
+{
+  (void) func_id;
+  TEST_ASSERT_LESS_THAN(TU_ARRAY_SIZE(stamp_log), stamp_count);
+  stamp_log[stamp_count++] = *stamp;
+}
+
+//--------------------------------------------------------------------+
+// DCD stubs
+//--------------------------------------------------------------------+
+typedef struct
+{
+  uint8_t  ep_addr;
+  uint8_t* buffer;
+  uint16_t len;
+} xfer_t;
+
+static xfer_t  xfer_log[16];
+static uint8_t xfer_count;
+
+static bool stub_edpt_open(uint8_t rhport_, tusb_desc_endpoint_t const * desc_ep, int num_calls)
+{
+  (void) rhport_; (void) desc_ep; (void) num_calls;
+  return true;
+}
+
+static void stub_edpt_close(uint8_t rhport_, uint8_t ep_addr, int num_calls)
+{
+  (void) rhport_; (void) ep_addr; (void) num_calls;
+}
+
+static bool stub_edpt_xfer(uint8_t rhport_, uint8_t ep_addr, uint8_t * buffer, uint16_t total_bytes, int num_calls)
+{
+  (void) rhport_; (void) num_calls;
+  TEST_ASSERT_LESS_THAN(TU_ARRAY_SIZE(xfer_log), xfer_count);
+  xfer_log[xfer_count++] = (xfer_t) { ep_addr, buffer, total_bytes };
+  return true;
+}
+
+// Return last transfer queued on endpoint
+static xfer_t* last_xfer(uint8_t ep_addr)
+{
+  for ( int i = xfer_count - 1; i >= 0; i-- )
+  {
+    if ( xfer_log[i].ep_addr == ep_addr ) return &xfer_log[i];
+  }
+  return NULL;
+}
+
+static void xfer_complete(uint8_t ep_addr, uint32_t len)
+{
+  dcd_event_xfer_complete(rhport, ep_addr, len, XFER_RESULT_SUCCESS, false);
+  tud_task();
+}
+
+static void setup_request(tusb_control_request_t const* request)
+{
+  dcd_event_setup_received(rhport, (uint8_t const*) request, false);
+  tud_task();
+}
+
+static void sof(uint32_t count)
+{
+  while ( count-- ) dcd_event_sof(rhport, 0, false);
+}
+
+static void set_interface(uint8_t alt)
+{
+  tusb_control_request_t const request_set_itf =
+  {
+    .bmRequestType = 0x01,
+    .bRequest      = TUSB_REQ_SET_INTERFACE,
+    .wValue        = alt,
+    .wIndex        = ITF_NUM_AUDIO_STREAMING,
+    .wLength       = 0
+  };
+  setup_request(&request_set_itf);
+}
+
+//--------------------------------------------------------------------+
+//
+//--------------------------------------------------------------------+
+void setUp(void)
+{
+  dcd_int_disable_Ignore();
+  dcd_int_enable_Ignore();
+  dcd_sof_enable_Ignore();
+  dcd_edpt_clear_stall_Ignore();
+
+  if ( !tud_inited() )
+  {
+    dcd_init_Expect(rhport);
+    tusb_init();
+  }
+
+  dcd_edpt_open_StubWithCallback(stub_edpt_open);
+  dcd_edpt_close_StubWithCallback(stub_edpt_close);
+  dcd_edpt_xfer_StubWithCallback(stub_edpt_xfer);
+
+  dcd_event_bus_reset(rhport, TUSB_SPEED_HIGH, false);
+  tud_task();
+
+  tusb_control_request_t const request_set_configuration =
+  {
+    .bmRequestType = 0x00,
+    .bRequest      = TUSB_REQ_SET_CONFIGURATION,
+    .wValue        = 1,
+    .wIndex        = 0,
+    .wLength       = 0
+  };
+  setup_request(&request_set_configuration);
+
+  // streaming starts with ZLP
+  set_interface(1);
+  TEST_ASSERT_EQUAL(0, last_xfer(EDPT_AUDIO_IN)->len);
+}
+
+void tearDown(void)
+{
+  tud_audio_implicit_fb_set(0);
+  xfer_count  = 0;
+  stamp_count = 0;
+}
+
+//--------------------------------------------------------------------+
+//
+//--------------------------------------------------------------------+
+void test_tx_stamp(void)
+{
+  uint8_t data[2*AUDIO_EP_SIZE] = { 0 };
+  uint32_t const t0 = tud_sof_clock();
+
+  TEST_ASSERT_EQUAL(sizeof(data), tud_audio_write(data, sizeof(data)));
+  TEST_ASSERT_EQUAL(sizeof(data), tud_audio_n_tx_offset(0));
+
+  // ZLP completes, no stamp reported, first packet is loaded
+  sof(1);
+  xfer_complete(EDPT_AUDIO_IN, 0);
+  TEST_ASSERT_EQUAL(0, stamp_count);
+  TEST_ASSERT_EQUAL(AUDIO_EP_SIZE, last_xfer(EDPT_AUDIO_IN)->len);
+
+  sof(1);
+  xfer_complete(EDPT_AUDIO_IN, AUDIO_EP_SIZE);
+  sof(2);
+  xfer_complete(EDPT_AUDIO_IN, AUDIO_EP_SIZE);
+
+  TEST_ASSERT_EQUAL(2, stamp_count);
+  TEST_ASSERT_EQUAL(0            , stamp_log[0].offset);
+  TEST_ASSERT_EQUAL(AUDIO_EP_SIZE, stamp_log[0].len);
+  TEST_ASSERT_EQUAL(t0 + 2       , stamp_log[0].sof);
+  TEST_ASSERT_EQUAL(AUDIO_EP_SIZE, stamp_log[1].offset);
+  TEST_ASSERT_EQUAL(t0 + 4       , stamp_log[1].sof);
+
+  // latency sampled once the write is fully transmitted
+  tud_latency_stat_t stat;
+  TEST_ASSERT_TRUE(tud_audio_tx_latency(&stat, true));
+  TEST_ASSERT_EQUAL(1, stat.count);
+  TEST_ASSERT_EQUAL(4, stat.last);
+
+  TEST_ASSERT_TRUE(tud_audio_tx_latency(&stat, false));
+  TEST_ASSERT_EQUAL(0, stat.count);
+}
+
+void test_close_clears_stamps(void)
+{
+  uint8_t data[AUDIO_EP_SIZE] = { 0 };
+  tud_audio_write(data, sizeof(data));
+  xfer_complete(EDPT_AUDIO_IN, 0);
+  xfer_complete(EDPT_AUDIO_IN, AUDIO_EP_SIZE);
+
+  tud_latency_stat_t stat;
+  TEST_ASSERT_TRUE(tud_audio_tx_latency(&stat, false));
+  TEST_ASSERT_EQUAL(1, stat.count);
+
+  set_interface(0);
+  TEST_ASSERT_TRUE(tud_audio_tx_latency(&stat, false));
+  TEST_ASSERT_EQUAL(0, stat.count);
+  TEST_ASSERT_EQUAL(0, tud_audio_n_tx_offset(0));
+}
+
+//--------------------------------------------------------------------+
+// Implicit feedback
+//--------------------------------------------------------------------+
+
+// 10.25 audio frames (mono 16-bit) per packet, rate is given per (micro)frame of 2^(bInterval-1) per packet
+#define IMPLICIT_FB_RATE    (671744u >> (TUD_OPT_HIGH_SPEED ? 3 : 0))
+
+// Complete current packet and return size of the next one
+static uint16_t next_packet(void)
+{
+  xfer_complete(EDPT_AUDIO_IN, last_xfer(EDPT_AUDIO_IN)->len);
+  return last_xfer(EDPT_AUDIO_IN)->len;
+}
+
+void test_implicit_fb_packet_sizes(void)
+{
+  uint8_t data[200] = { 0 };
+  TEST_ASSERT_TRUE(tud_audio_implicit_fb_set(IMPLICIT_FB_RATE));
+  TEST_ASSERT_EQUAL(sizeof(data), tud_audio_write(data, sizeof(data)));
+
+  // fraction accumulates: three packets of 10 frames then one of 11
+  uint16_t const expected[] = { 20, 20, 20, 22, 20, 20, 20, 22 };
+  for ( size_t i = 0; i < TU_ARRAY_SIZE(expected); i++ )
+  {
+    TEST_ASSERT_EQUAL(expected[i], next_packet());
+  }
+}
+
+void test_implicit_fb_underrun(void)
+{
+  uint8_t data[100] = { 0 };
+  TEST_ASSERT_TRUE(tud_audio_implicit_fb_set(IMPLICIT_FB_RATE));
+
+  // only 3 frames available: sent as is, missing frames are not caught up later
+  tud_audio_write(data, 6);
+  TEST_ASSERT_EQUAL(6, next_packet());
+
+  tud_audio_write(data, sizeof(data));
+  uint16_t const expected[] = { 20, 20, 22, 20 };
+  for ( size_t i = 0; i < TU_ARRAY_SIZE(expected); i++ )
+  {
+    TEST_ASSERT_EQUAL(expected[i], next_packet());
+  }
+
+  // rate of zero sends whatever is available
+  tud_audio_implicit_fb_set(0);
+  TEST_ASSERT_EQUAL(sizeof(data) - 82, next_packet());
+}
+
+//--------------------------------------------------------------------+
+// Gain
+//--------------------------------------------------------------------+
+
+// Q1.15 gain of volume in 1/256 dB, conversion error is below 0.4%
+static void check_gain_db(double db, double expected)
+{
+  uint16_t const gain = tud_audio_gain_from_db((int16_t) (db * 256));
+  TEST_ASSERT_UINT32_WITHIN((uint32_t) (expected * 0.004) + 1, (uint32_t) expected, gain);
+}
+
+void test_gain_from_db(void)
+{
+  TEST_ASSERT_EQUAL_HEX16(0, tud_audio_gain_from_db(INT16_MIN));
+  TEST_ASSERT_EQUAL_HEX16(TUD_AUDIO_GAIN_UNITY, tud_audio_gain_from_db(0));
+
+  check_gain_db(-6.0206, 16384);
+  check_gain_db(-20, 3276.8);
+  check_gain_db(-40, 327.68);
+  check_gain_db(3, 46286);
+
+  // above +6 dB saturates, far below is silence
+  TEST_ASSERT_EQUAL_HEX16(UINT16_MAX, tud_audio_gain_from_db(6*256 + 100));
+  TEST_ASSERT_EQUAL_HEX16(UINT16_MAX, tud_audio_gain_from_db(INT16_MAX));
+  TEST_ASSERT_EQUAL_HEX16(0, tud_audio_gain_from_db(-120*256));
+
+  // monotonic
+  uint16_t prev = 0;
+  for ( int32_t v = -100*256; v <= 6*256; v += 64 )
+  {
+    uint16_t const gain = tud_audio_gain_from_db((int16_t) v);
+    TEST_ASSERT_GREATER_OR_EQUAL(prev, gain);
+    prev = gain;
+  }
+}
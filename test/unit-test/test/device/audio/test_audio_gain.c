@@ -0,0 +1,242 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#include "unity.h"
+
+// Files to test
+#include "osal/osal.h"
+#include "tusb_fifo.h"
+#include "tusb.h"
+#include "usbd.h"
+TEST_FILE("usbd_control.c")
+TEST_FILE("audio_device.c")
+
+// Mock File
+#include "mock_dcd.h"
+
+//--------------------------------------------------------------------+
+// MACRO TYPEDEF CONSTANT ENUM DECLARATION
+//--------------------------------------------------------------------+
+
+enum
+{
+  EDPT_AUDIO_IN = 0x81,
+  AUDIO_EP_SIZE = CFG_TUD_AUDIO_FUNC_1_EP_IN_SZ_MAX,
+};
+
+enum
+{
+  ITF_NUM_AUDIO_CONTROL,
+  ITF_NUM_AUDIO_STREAMING,
+  ITF_NUM_TOTAL
+};
+
+uint8_t const rhport = 0;
+
+#define CONFIG_TOTAL_LEN    (TUD_CONFIG_DESC_LEN + TUD_AUDIO_MIC_ONE_CH_DESC_LEN)
+
+uint8_t const data_desc_configuration[] =
+{
+  TUD_CONFIG_DESCRIPTOR(1, ITF_NUM_TOTAL, 0, CONFIG_TOTAL_LEN, 0, 100),
+  TUD_AUDIO_MIC_ONE_CH_DESCRIPTOR(ITF_NUM_AUDIO_CONTROL, 0, 2, 16, EDPT_AUDIO_IN, AUDIO_EP_SIZE),
+};
+
+uint8_t const * tud_descriptor_device_cb(void)
+{
+  return NULL;
+}
+
+uint8_t const * tud_descriptor_configuration_cb(uint8_t index)
+{
+  (void) index;
+  return data_desc_configuration;
+}
+
+uint16_t const* tud_descriptor_string_cb(uint8_t index, uint16_t langid)
+{
+  (void) index;
+  (void) langid;
+  return NULL;
+}
+
+//--------------------------------------------------------------------+
+// DCD stubs
+//--------------------------------------------------------------------+
+static uint8_t* xfer_buf;
+static uint16_t xfer_len;
+
+static bool stub_edpt_open(uint8_t rhport_, tusb_desc_endpoint_t const * desc_ep, int num_calls)
+{
+  (void) rhport_; (void) desc_ep; (void) num_calls;
+  return true;
+}
+
+static void stub_edpt_close(uint8_t rhport_, uint8_t ep_addr, int num_calls)
+{
+  (void) rhport_; (void) ep_addr; (void) num_calls;
+}
+
+static bool stub_edpt_xfer(uint8_t rhport_, uint8_t ep_addr, uint8_t * buffer, uint16_t total_bytes, int num_calls)
+{
+  (void) rhport_; (void) num_calls;
+  if ( ep_addr == EDPT_AUDIO_IN )
+  {
+    xfer_buf = buffer;
+    xfer_len = total_bytes;
+  }
+  return true;
+}
+
+static void setup_request(tusb_control_request_t const* request)
+{
+  dcd_event_setup_received(rhport, (uint8_t const*) request, false);
+  tud_task();
+}
+
+// Queue mono 16-bit samples, complete current packet and return encoded samples of the next one
+static int16_t const* encode(int16_t const* samples, uint16_t count)
+{
+  TEST_ASSERT_EQUAL(2*count, tud_audio_write_support_ff(0, samples, 2*count));
+
+  dcd_event_xfer_complete(rhport, EDPT_AUDIO_IN, xfer_len, XFER_RESULT_SUCCESS, false);
+  tud_task();
+
+  TEST_ASSERT_EQUAL(2*count, xfer_len);
+  return (int16_t const*) xfer_buf;
+}
+
+//--------------------------------------------------------------------+
+//
+//--------------------------------------------------------------------+
+void setUp(void)
+{
+  dcd_int_disable_Ignore();
+  dcd_int_enable_Ignore();
+  dcd_sof_enable_Ignore();
+  dcd_edpt_clear_stall_Ignore();
+
+  if ( !tud_inited() )
+  {
+    dcd_init_Expect(rhport);
+    tusb_init();
+  }
+
+  dcd_edpt_open_StubWithCallback(stub_edpt_open);
+  dcd_edpt_close_StubWithCallback(stub_edpt_close);
+  dcd_edpt_xfer_StubWithCallback(stub_edpt_xfer);
+
+  dcd_event_bus_reset(rhport, TUSB_SPEED_HIGH, false);
+  tud_task();
+
+  tusb_control_request_t const request_set_configuration =
+  {
+    .bmRequestType = 0x00,
+    .bRequest      = TUSB_REQ_SET_CONFIGURATION,
+    .wValue        = 1,
+    .wIndex        = 0,
+    .wLength       = 0
+  };
+  setup_request(&request_set_configuration);
+
+  tusb_control_request_t const request_set_itf =
+  {
+    .bmRequestType = 0x01,
+    .bRequest      = TUSB_REQ_SET_INTERFACE,
+    .wValue        = 1,
+    .wIndex        = ITF_NUM_AUDIO_STREAMING,
+    .wLength       = 0
+  };
+  setup_request(&request_set_itf);
+
+  // streaming starts with ZLP
+  TEST_ASSERT_EQUAL(0, xfer_len);
+}
+
+void tearDown(void)
+{
+  // back to unity, ramp settles within two samples
+  tud_audio_set_tx_mute(false);
+  tud_audio_set_tx_gain(TUD_AUDIO_GAIN_UNITY);
+
+  int16_t const zero[2] = { 0 };
+  encode(zero, 2);
+}
+
+//--------------------------------------------------------------------+
+// CFG_TUD_AUDIO_GAIN_RAMP_STEP is a half of unity: gain reaches its target within two samples
+//--------------------------------------------------------------------+
+void test_gain_unity_passthrough(void)
+{
+  int16_t const samples[] = { 0, 1, -1, INT16_MAX, INT16_MIN, 0x1234 };
+  int16_t const* out = encode(samples, TU_ARRAY_SIZE(samples));
+  TEST_ASSERT_EQUAL_INT16_ARRAY(samples, out, TU_ARRAY_SIZE(samples));
+}
+
+void test_gain_saturation(void)
+{
+  TEST_ASSERT_TRUE(tud_audio_set_tx_gain(UINT16_MAX));
+
+  // first sample is ramped to 1.5, then full ~2.0 gain
+  int16_t const samples[] = { 0x1000, 0x1000, 0x7000, -0x7000, 0x3FFF, -0x4000, -0x1000 };
+  int16_t const expected[] = { 0x1800, 0x1FFF, INT16_MAX, INT16_MIN, 0x7FFD, INT16_MIN, -0x2000 };
+  int16_t const* out = encode(samples, TU_ARRAY_SIZE(samples));
+  TEST_ASSERT_EQUAL_INT16_ARRAY(expected, out, TU_ARRAY_SIZE(expected));
+}
+
+void test_gain_attenuation(void)
+{
+  TEST_ASSERT_TRUE(tud_audio_set_tx_gain(tud_audio_gain_from_db(-6*256 - 5)));
+
+  int16_t const samples[] = { 0x4000, 0x4000, 0x4000, -0x4000 };
+  int16_t const* out = encode(samples, TU_ARRAY_SIZE(samples));
+
+  // half of unity is one ramp step away
+  TEST_ASSERT_INT16_WITHIN(0x40, 0x2000, out[0]);
+  TEST_ASSERT_INT16_WITHIN(0x40, 0x2000, out[1]);
+  TEST_ASSERT_INT16_WITHIN(0x40, 0x2000, out[2]);
+  TEST_ASSERT_INT16_WITHIN(0x40, -0x2000, out[3]);
+}
+
+void test_gain_mute(void)
+{
+  TEST_ASSERT_TRUE(tud_audio_set_tx_mute(true));
+
+  // ramps down to silence without click
+  int16_t const samples[] = { 0x2000, 0x2000, 0x2000, -0x2000 };
+  int16_t const expected[] = { 0x1000, 0, 0, 0 };
+  int16_t const* out = encode(samples, TU_ARRAY_SIZE(samples));
+  TEST_ASSERT_EQUAL_INT16_ARRAY(expected, out, TU_ARRAY_SIZE(expected));
+
+  // gain set while muted applies once unmuted
+  TEST_ASSERT_TRUE(tud_audio_set_tx_gain(UINT16_MAX));
+  out = encode(samples, 2);
+  TEST_ASSERT_EQUAL_INT16(0, out[0]);
+
+  TEST_ASSERT_TRUE(tud_audio_set_tx_mute(false));
+  int16_t const expected_unmute[] = { 0x1000, 0x2000, 0x3000, -0x4000 };
+  out = encode(samples, TU_ARRAY_SIZE(samples));
+  TEST_ASSERT_EQUAL_INT16_ARRAY(expected_unmute, out, TU_ARRAY_SIZE(expected_unmute));
+}
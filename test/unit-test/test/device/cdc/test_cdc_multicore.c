@@ -0,0 +1,347 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+// Stress test of CDC class with CFG_TUSB_MULTICORE: application thread uses read/write API while stack thread
+// runs usbd task with an emulated controller, including bus reset and control requests. Both data streams
+// are sequence numbers which must arrive in order, data is only allowed to be dropped by write_clear() or
+// bus reset.
+
+#include <pthread.h>
+#include <sched.h>
+#include "unity.h"
+
+// Files to test
+#include "osal/osal.h"
+#include "tusb_fifo.h"
+#include "tusb.h"
+#include "usbd.h"
+TEST_FILE("usbd_control.c")
+TEST_FILE("cdc_device.c")
+
+// Mock File
+#include "mock_dcd.h"
+
+//--------------------------------------------------------------------+
+// MACRO TYPEDEF CONSTANT ENUM DECLARATION
+//--------------------------------------------------------------------+
+
+enum
+{
+  EDPT_NOTIF = 0x81,
+  EDPT_OUT   = 0x02,
+  EDPT_IN    = 0x82,
+  EDPT_SIZE  = 64,
+};
+
+#define STACK_LOOPS       200000u
+#define RESET_INTERVAL    5000u
+
+uint8_t const rhport = 0;
+
+#define CONFIG_TOTAL_LEN    (TUD_CONFIG_DESC_LEN + TUD_CDC_DESC_LEN)
+
+uint8_t const data_desc_configuration[] =
+{
+  TUD_CONFIG_DESCRIPTOR(1, 2, 0, CONFIG_TOTAL_LEN, 0, 100),
+  TUD_CDC_DESCRIPTOR(0, 0, EDPT_NOTIF, 8, EDPT_OUT, EDPT_IN, EDPT_SIZE),
+};
+
+uint8_t const * tud_descriptor_device_cb(void)
+{
+  return NULL;
+}
+
+uint8_t const * tud_descriptor_configuration_cb(uint8_t index)
+{
+  (void) index;
+  return data_desc_configuration;
+}
+
+uint16_t const* tud_descriptor_string_cb(uint8_t index, uint16_t langid)
+{
+  (void) index;
+  (void) langid;
+  return NULL;
+}
+
+// errors detected by threads, only reported by main thread
+static volatile uint32_t err_count;
+static volatile bool stack_done;
+
+static uint32_t xorshift32(uint32_t* state)
+{
+  uint32_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return *state = x;
+}
+
+//--------------------------------------------------------------------+
+// Emulated controller, only used by stack thread
+//--------------------------------------------------------------------+
+static uint8_t* in_buf;
+static uint16_t in_len;
+static bool     in_busy;
+
+static uint8_t* out_buf;
+static uint16_t out_len;
+static bool     out_busy;
+
+static bool stub_edpt_open(uint8_t rhport_, tusb_desc_endpoint_t const * desc_ep, int num_calls)
+{
+  (void) rhport_; (void) desc_ep; (void) num_calls;
+  return true;
+}
+
+static void stub_edpt_close_all(uint8_t rhport_, int num_calls)
+{
+  (void) rhport_; (void) num_calls;
+  in_busy  = false;
+  out_busy = false;
+}
+
+static bool stub_edpt_xfer(uint8_t rhport_, uint8_t ep_addr, uint8_t * buffer, uint16_t total_bytes, int num_calls)
+{
+  (void) rhport_; (void) num_calls;
+
+  if ( ep_addr == EDPT_IN )
+  {
+    if ( in_busy ) err_count++;
+    in_buf  = buffer;
+    in_len  = total_bytes;
+    in_busy = true;
+  }
+  else if ( ep_addr == EDPT_OUT )
+  {
+    if ( out_busy ) err_count++;
+    out_buf  = buffer;
+    out_len  = total_bytes;
+    out_busy = true;
+  }
+
+  return true;
+}
+
+static void setup_request(uint8_t bmRequestType, uint8_t bRequest, uint16_t wValue)
+{
+  tusb_control_request_t const request =
+  {
+    .bmRequestType = bmRequestType,
+    .bRequest      = bRequest,
+    .wValue        = wValue,
+    .wIndex        = 0,
+    .wLength       = 0
+  };
+  dcd_event_setup_received(rhport, (uint8_t const*) &request, false);
+  tud_task();
+}
+
+// Bus reset then enumerate and open terminal (DTR)
+static void bus_reset(void)
+{
+  dcd_event_bus_reset(rhport, TUSB_SPEED_FULL, false);
+  tud_task();
+
+  // endpoints are closed by reset
+  in_busy  = false;
+  out_busy = false;
+
+  setup_request(0x00, TUSB_REQ_SET_CONFIGURATION, 1);
+  setup_request(0x21, CDC_REQUEST_SET_CONTROL_LINE_STATE, 0x01);
+
+  // status stage
+  dcd_event_xfer_complete(rhport, 0x80, 0, XFER_RESULT_SUCCESS, false);
+  tud_task();
+}
+
+//--------------------------------------------------------------------+
+// Threads
+//--------------------------------------------------------------------+
+static uint32_t tx_received; // records sent by application arrived at host
+static uint32_t rx_sent;     // records sent by host
+static uint32_t rx_received; // records received by application
+
+static void* stack_thread(void* arg)
+{
+  (void) arg;
+  uint32_t seed = 0x12345678;
+  uint32_t tx_next = 0; // lowest valid sequence of next record from application
+  uint32_t rx_seq  = 0;
+
+  for ( uint32_t loop = 0; loop < STACK_LOOPS; loop++ )
+  {
+    tud_task();
+
+    uint32_t const rnd = xorshift32(&seed);
+
+    if ( in_busy && (rnd & 1) )
+    {
+      // records are only dropped as a whole, in order
+      if ( in_len % 4 ) err_count++;
+      for ( uint16_t i = 0; i + 4 <= in_len; i += 4 )
+      {
+        uint32_t seq;
+        memcpy(&seq, in_buf + i, 4);
+        if ( seq < tx_next ) err_count++;
+        tx_next = seq + 1;
+        tx_received++;
+      }
+
+      in_busy = false;
+      dcd_event_xfer_complete(rhport, EDPT_IN, in_len, XFER_RESULT_SUCCESS, false);
+    }
+
+    if ( out_busy && (rnd & 2) )
+    {
+      // short packet of random length
+      uint16_t const len = (uint16_t) (4 * (1 + (rnd >> 8) % (out_len / 4)));
+      for ( uint16_t i = 0; i < len; i += 4 )
+      {
+        memcpy(out_buf + i, &rx_seq, 4);
+        rx_seq++;
+        rx_sent++;
+      }
+
+      out_busy = false;
+      dcd_event_xfer_complete(rhport, EDPT_OUT, len, XFER_RESULT_SUCCESS, false);
+    }
+
+    if ( (loop % RESET_INTERVAL) == RESET_INTERVAL - 1 ) bus_reset();
+
+    // let application run on single core host
+    if ( rnd & 0x100 ) sched_yield();
+  }
+
+  stack_done = true;
+  return NULL;
+}
+
+static void* app_thread(void* arg)
+{
+  (void) arg;
+  uint32_t seed = 0x87654321;
+  uint32_t tx_seq  = 0;
+  uint32_t rx_next = 0;
+  uint32_t buf[32];
+
+  while ( !stack_done )
+  {
+    uint32_t const rnd = xorshift32(&seed);
+    uint16_t const count = (uint16_t) (1 + (rnd >> 8) % TU_ARRAY_SIZE(buf));
+
+    switch ( rnd % 16 )
+    {
+      case 0:
+        tud_cdc_write_clear();
+      break;
+
+      case 1:
+        tud_cdc_read_flush();
+      break;
+
+      case 2:
+      case 3:
+      case 4:
+      case 5:
+      case 6:
+      case 7:
+      {
+        for ( uint16_t i = 0; i < count; i++ ) buf[i] = tx_seq + i;
+        uint32_t const n = tud_cdc_write(buf, 4u*count);
+        if ( n % 4 ) err_count++;
+        tx_seq += n / 4;
+        tud_cdc_write_flush();
+      }
+      break;
+
+      default:
+      {
+        if ( tud_cdc_available() % 4 ) err_count++;
+
+        uint32_t const n = tud_cdc_read(buf, 4u*count);
+        if ( n % 4 ) err_count++;
+        for ( uint32_t i = 0; i < n / 4; i++ )
+        {
+          if ( buf[i] < rx_next ) err_count++;
+          rx_next = buf[i] + 1;
+          rx_received++;
+        }
+      }
+      break;
+    }
+
+    if ( rnd & 0x100 ) sched_yield();
+  }
+
+  return NULL;
+}
+
+//--------------------------------------------------------------------+
+//
+//--------------------------------------------------------------------+
+void setUp(void)
+{
+  dcd_int_disable_Ignore();
+  dcd_int_enable_Ignore();
+  dcd_edpt_stall_Ignore();
+  dcd_edpt_clear_stall_Ignore();
+  dcd_edpt0_status_complete_Ignore();
+
+  if ( !tud_inited() )
+  {
+    dcd_init_Expect(rhport);
+    tusb_init();
+  }
+
+  dcd_edpt_open_StubWithCallback(stub_edpt_open);
+  dcd_edpt_close_all_StubWithCallback(stub_edpt_close_all);
+  dcd_edpt_xfer_StubWithCallback(stub_edpt_xfer);
+
+  err_count  = 0;
+  stack_done = false;
+
+  bus_reset();
+}
+
+void tearDown(void)
+{
+}
+
+void test_cdc_multicore_stress(void)
+{
+  pthread_t st, at;
+  TEST_ASSERT_EQUAL(0, pthread_create(&st, NULL, stack_thread, NULL));
+  TEST_ASSERT_EQUAL(0, pthread_create(&at, NULL, app_thread, NULL));
+  TEST_ASSERT_EQUAL(0, pthread_join(st, NULL));
+  TEST_ASSERT_EQUAL(0, pthread_join(at, NULL));
+
+  TEST_ASSERT_EQUAL(0, err_count);
+
+  // data moved in both directions, and most of it was not dropped
+  TEST_ASSERT_GREATER_THAN(STACK_LOOPS / 4, tx_received);
+  TEST_ASSERT_GREATER_THAN(rx_sent / 2, rx_received);
+}
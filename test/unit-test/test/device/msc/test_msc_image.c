@@ -0,0 +1,150 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019, hathach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#include <string.h>
+#include "unity.h"
+
+// Files to test
+#include "tusb_option.h"
+#include "msc_image.h"
+
+//--------------------------------------------------------------------+
+// MACRO TYPEDEF CONSTANT ENUM DECLARATION
+//--------------------------------------------------------------------+
+
+// 3 blocks of 16 bytes, 2 blocks per chunk
+//  - chunk 0: "ab" repeated, LZ4 compressed
+//  - chunk 1: last block, stored uncompressed
+static uint8_t image[] =
+{
+  // header: signature, block size, chunk blocks, block count, chunk count
+  0x54, 0x55, 0x5A, 0x49, 16, 0, 2, 0, 3, 0, 0, 0, 2, 0, 0, 0,
+
+  // chunk offsets
+  28, 0, 0, 0, 40, 0, 0, 0, 56, 0, 0, 0,
+
+  // chunk 0: 2 literals + match of 25 at offset 2, then 5 literals
+  0x2F, 'a', 'b', 0x02, 0x00, 0x06,
+  0x50, 'b', 'a', 'b', 'a', 'b',
+
+  // chunk 1
+  '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'
+};
+
+static uint8_t disk[48];
+static tud_msc_image_t img;
+
+//------------- IMPLEMENTATION -------------//
+
+void setUp(void)
+{
+  for(uint8_t i=0; i<32; i++) disk[i] = (i & 1) ? 'b' : 'a';
+  memcpy(disk+32, "0123456789ABCDEF", 16);
+
+  TEST_ASSERT_TRUE(tud_msc_image_init(&img, image, sizeof(image)));
+}
+
+void tearDown(void)
+{
+}
+
+void test_msc_image_geometry(void)
+{
+  TEST_ASSERT_EQUAL(3, tud_msc_image_block_count(&img));
+  TEST_ASSERT_EQUAL(16, tud_msc_image_block_size(&img));
+}
+
+void test_msc_image_read_block(void)
+{
+  uint8_t buf[16];
+
+  TEST_ASSERT_EQUAL(16, tud_msc_image_read(&img, 1, 0, buf, sizeof(buf)));
+  TEST_ASSERT_EQUAL_MEMORY(disk+16, buf, 16);
+
+  TEST_ASSERT_EQUAL(16, tud_msc_image_read(&img, 2, 0, buf, sizeof(buf)));
+  TEST_ASSERT_EQUAL_MEMORY(disk+32, buf, 16);
+}
+
+void test_msc_image_read_across_chunks(void)
+{
+  uint8_t buf[48];
+
+  // request is clipped to end of image
+  TEST_ASSERT_EQUAL(44, tud_msc_image_read(&img, 0, 4, buf, sizeof(buf)));
+  TEST_ASSERT_EQUAL_MEMORY(disk+4, buf, 44);
+}
+
+void test_msc_image_read_out_of_range(void)
+{
+  uint8_t buf[16];
+  TEST_ASSERT_EQUAL(-1, tud_msc_image_read(&img, 3, 0, buf, sizeof(buf)));
+}
+
+void test_msc_image_bad_index(void)
+{
+  tud_msc_image_t bad;
+  uint8_t copy[sizeof(image)];
+  memcpy(copy, image, sizeof(image));
+
+  // chunk 1 beyond end of image
+  copy[24] = sizeof(image) + 1;
+  TEST_ASSERT_FALSE(tud_msc_image_init(&bad, copy, sizeof(copy)));
+}
+
+void test_msc_image_bad_count(void)
+{
+  tud_msc_image_t bad;
+  uint8_t copy[sizeof(image)];
+  memcpy(copy, image, sizeof(image));
+
+  // 1 byte blocks and chunks: 4*(chunk_count+1) wraps around to 4
+  copy[4] = 1;
+  copy[6] = 1;
+  memcpy(copy+8,  "\x00\x00\x00\x40", 4);
+  memcpy(copy+12, "\x00\x00\x00\x40", 4);
+  copy[16] = 20;
+  TEST_ASSERT_FALSE(tud_msc_image_init(&bad, copy, sizeof(copy)));
+
+  // chunk count of 2 blocks per chunk wraps around to 0
+  copy[6] = 2;
+  memcpy(copy+8,  "\xff\xff\xff\xff", 4);
+  memcpy(copy+12, "\x00\x00\x00\x00", 4);
+  TEST_ASSERT_FALSE(tud_msc_image_init(&bad, copy, sizeof(copy)));
+}
+
+void test_msc_image_corrupted_chunk(void)
+{
+  tud_msc_image_t bad;
+  uint8_t copy[sizeof(image)];
+  memcpy(copy, image, sizeof(image));
+
+  // match offset 0 is invalid
+  copy[31] = 0;
+  TEST_ASSERT_TRUE(tud_msc_image_init(&bad, copy, sizeof(copy)));
+
+  uint8_t buf[16];
+  TEST_ASSERT_EQUAL(-1, tud_msc_image_read(&bad, 0, 0, buf, sizeof(buf)));
+}
@@ -29,6 +29,8 @@
 #include "tusb_fifo.h"
 #include "tusb.h"
 #include "usbd.h"
+#include "usbd_pvt.h"
+#include "common/tusb_private.h"
 TEST_FILE("usbd_control.c")
 
 // Mock File
@@ -119,6 +121,24 @@ uint16_t const* tud_descriptor_string_cb(uint8_t index, uint16_t langid)
   return NULL;
 }
 
+// Emulate a low priority software interrupt pended by event hook
+static uint32_t swi_pend_count;
+static bool swi_pend_in_isr;
+
+void tud_event_hook_cb(uint8_t rhport_, uint32_t eventid, bool in_isr)
+{
+  (void) rhport_;
+  (void) eventid;
+  swi_pend_count++;
+  swi_pend_in_isr = in_isr;
+}
+
+static void swi_handler(void)
+{
+  swi_pend_count = 0;
+  tud_task_ext(0, true);
+}
+
 void setUp(void)
 {
   dcd_int_disable_Ignore();
@@ -242,3 +262,225 @@ void test_usbd_control_in_zlp(void)
 
   tud_task();
 }
+
+//--------------------------------------------------------------------+
+// Endpoint claim/release
+//--------------------------------------------------------------------+
+
+void test_usbd_edpt_claim_release(void)
+{
+  uint8_t const ep_addr = 0x81;
+
+  // claim only once
+  TEST_ASSERT_TRUE( usbd_edpt_claim(rhport, ep_addr) );
+  TEST_ASSERT_FALSE( usbd_edpt_claim(rhport, ep_addr) );
+
+  // release only once
+  TEST_ASSERT_TRUE( usbd_edpt_release(rhport, ep_addr) );
+  TEST_ASSERT_FALSE( usbd_edpt_release(rhport, ep_addr) );
+
+  // can be claimed again after released
+  TEST_ASSERT_TRUE( usbd_edpt_claim(rhport, ep_addr) );
+  TEST_ASSERT_TRUE( usbd_edpt_release(rhport, ep_addr) );
+}
+
+void test_usbd_edpt_claim_busy(void)
+{
+  uint8_t const ep_addr = 0x82;
+  uint8_t buf[8];
+
+  TEST_ASSERT_TRUE( usbd_edpt_claim(rhport, ep_addr) );
+
+  // busy endpoint can neither be released nor claimed
+  dcd_edpt_xfer_ExpectAndReturn(rhport, ep_addr, buf, sizeof(buf), true);
+  TEST_ASSERT_TRUE( usbd_edpt_xfer(rhport, ep_addr, buf, sizeof(buf)) );
+  TEST_ASSERT_FALSE( usbd_edpt_release(rhport, ep_addr) );
+  TEST_ASSERT_FALSE( usbd_edpt_claim(rhport, ep_addr) );
+}
+
+//--------------------------------------------------------------------+
+// Deferred task in software interrupt
+//--------------------------------------------------------------------+
+
+void test_usbd_task_deferred_isr(void)
+{
+  desc_device = (uint8_t const *) &data_desc_device;
+  swi_pend_count = 0;
+
+  // setup received in ISR pends the software interrupt
+  dcd_event_setup_received(rhport, (uint8_t*) &req_get_desc_device, true);
+  TEST_ASSERT_EQUAL(1, swi_pend_count);
+  TEST_ASSERT_TRUE(swi_pend_in_isr);
+
+  // data stage is started within software interrupt
+  dcd_edpt_xfer_ExpectWithArrayAndReturn(rhport, 0x80, (uint8_t*)&data_desc_device, sizeof(tusb_desc_device_t), sizeof(tusb_desc_device_t), true);
+  swi_handler();
+  TEST_ASSERT_FALSE(tud_task_event_ready());
+
+  // status stage
+  dcd_event_xfer_complete(rhport, EDPT_CTRL_IN, sizeof(tusb_desc_device_t), 0, true);
+  TEST_ASSERT_EQUAL(1, swi_pend_count);
+  dcd_edpt_xfer_ExpectAndReturn(rhport, EDPT_CTRL_OUT, NULL, 0, true);
+  swi_handler();
+
+  dcd_event_xfer_complete(rhport, EDPT_CTRL_OUT, 0, 0, true);
+  TEST_ASSERT_EQUAL(1, swi_pend_count);
+  dcd_edpt0_status_complete_ExpectWithArray(rhport, &req_get_desc_device, 1);
+  swi_handler();
+
+  // nothing else to do
+  TEST_ASSERT_FALSE(tud_task_event_ready());
+}
+
+//--------------------------------------------------------------------+
+// SOF Scheduler
+//--------------------------------------------------------------------+
+
+static void sof_sched_cb(uint8_t rhport_, uint32_t frame_count, void* param)
+{
+  (void) rhport_;
+  (void) frame_count;
+  (*((uint32_t*) param))++;
+}
+
+void test_usbd_sof_sched(void)
+{
+  uint32_t count_a = 0, count_b = 0;
+
+  // SOF interrupt is enabled with the first callback only
+  dcd_sof_enable_Expect(rhport, true);
+  TEST_ASSERT_TRUE( tud_sof_sched_add(sof_sched_cb, &count_a, 1, 0) );
+  TEST_ASSERT_TRUE( tud_sof_sched_add(sof_sched_cb, &count_b, 4, 2) );
+  TEST_ASSERT_FALSE( tud_sof_sched_add(sof_sched_cb, &count_b, 4, 4) ); // offset must be less than interval
+
+  for(uint32_t i=0; i<12; i++)
+  {
+    dcd_event_sof(rhport, i, true);
+  }
+
+  TEST_ASSERT_EQUAL(12, count_a);
+  TEST_ASSERT_EQUAL(3, count_b); // 3rd, 7th and 11th SOF
+
+  // SOF interrupt is disabled with the last callback removed
+  TEST_ASSERT_TRUE( tud_sof_sched_remove(sof_sched_cb, &count_a) );
+  dcd_sof_enable_Expect(rhport, false);
+  TEST_ASSERT_TRUE( tud_sof_sched_remove(sof_sched_cb, &count_b) );
+  TEST_ASSERT_FALSE( tud_sof_sched_remove(sof_sched_cb, &count_b) );
+
+  dcd_event_sof(rhport, 12, true);
+  TEST_ASSERT_EQUAL(12, count_a);
+}
+
+void test_usbd_sof_sched_frame_aligned(void)
+{
+  uint32_t count_a = 0, count_b = 0;
+
+  dcd_sof_enable_Expect(rhport, true);
+  TEST_ASSERT_TRUE( tud_sof_sched_add(sof_sched_cb, &count_a, 4, 1) );
+
+  // frame 100..102: first invocation on frame 101
+  for(uint32_t i=100; i<103; i++) dcd_event_sof(rhport, i, true);
+  TEST_ASSERT_EQUAL(1, count_a);
+
+  // added later, runs on the same frames as the first one
+  TEST_ASSERT_TRUE( tud_sof_sched_add(sof_sched_cb, &count_b, 4, 1) );
+  for(uint32_t i=103; i<106; i++) dcd_event_sof(rhport, i, true);
+  TEST_ASSERT_EQUAL(2, count_a);
+  TEST_ASSERT_EQUAL(1, count_b);
+
+  // phase is kept when 11-bit frame number wraps: invoked on frame 2045 and 1
+  count_a = count_b = 0;
+  for(uint32_t i=2044; i<2048; i++) dcd_event_sof(rhport, i, true);
+  for(uint32_t i=0; i<4; i++) dcd_event_sof(rhport, i, true);
+  TEST_ASSERT_EQUAL(2, count_a);
+  TEST_ASSERT_EQUAL(2, count_b);
+
+  TEST_ASSERT_TRUE( tud_sof_sched_remove(sof_sched_cb, &count_a) );
+  dcd_sof_enable_Expect(rhport, false);
+  TEST_ASSERT_TRUE( tud_sof_sched_remove(sof_sched_cb, &count_b) );
+}
+
+void test_usbd_sof_enabled_again_after_bus_reset(void)
+{
+  uint32_t count = 0;
+
+  dcd_sof_enable_Expect(rhport, true);
+  TEST_ASSERT_TRUE( tud_sof_sched_add(sof_sched_cb, &count, 1, 0) );
+
+  // DCD may disable SOF interrupt on bus reset, usbd must enable it again
+  dcd_event_bus_reset(rhport, TUSB_SPEED_HIGH, false);
+  mscd_reset_Expect(rhport);
+  dcd_sof_enable_Expect(rhport, true);
+  tud_task();
+
+  dcd_sof_enable_Expect(rhport, false);
+  TEST_ASSERT_TRUE( tud_sof_sched_remove(sof_sched_cb, &count) );
+}
+
+//--------------------------------------------------------------------+
+// High-bandwidth endpoint
+//--------------------------------------------------------------------+
+
+void test_usbd_edpt_high_bandwidth_validate(void)
+{
+  tusb_desc_endpoint_t desc_ep =
+  {
+    .bLength          = sizeof(tusb_desc_endpoint_t),
+    .bDescriptorType  = TUSB_DESC_ENDPOINT,
+    .bEndpointAddress = 0x81,
+    .bmAttributes     = { .xfer = TUSB_XFER_ISOCHRONOUS },
+    .wMaxPacketSize   = TUSB_EDPT_HIGH_BANDWIDTH_SIZE(1024, 3),
+    .bInterval        = 1
+  };
+
+  TEST_ASSERT_EQUAL(1024, tu_edpt_packet_size(&desc_ep));
+  TEST_ASSERT_EQUAL(3, tu_edpt_mult(&desc_ep));
+  TEST_ASSERT_EQUAL(3072, tu_edpt_bytes_per_interval(&desc_ep));
+
+  // only valid for highspeed
+  TEST_ASSERT_TRUE( tu_edpt_validate(&desc_ep, TUSB_SPEED_HIGH) );
+  TEST_ASSERT_FALSE( tu_edpt_validate(&desc_ep, TUSB_SPEED_FULL) );
+
+  // valid per specs, but DCD only supports high-bandwidth for ISO
+  desc_ep.bmAttributes.xfer = TUSB_XFER_INTERRUPT;
+  TEST_ASSERT_TRUE( tu_edpt_validate(&desc_ep, TUSB_SPEED_HIGH) );
+
+  // bulk does not support additional transactions
+  desc_ep.bmAttributes.xfer = TUSB_XFER_BULK;
+  desc_ep.wMaxPacketSize    = TUSB_EDPT_HIGH_BANDWIDTH_SIZE(512, 2);
+  TEST_ASSERT_FALSE( tu_edpt_validate(&desc_ep, TUSB_SPEED_HIGH) );
+
+  // 4 transactions is reserved
+  desc_ep.bmAttributes.xfer = TUSB_XFER_ISOCHRONOUS;
+  desc_ep.wMaxPacketSize    = TUSB_EDPT_HIGH_BANDWIDTH_SIZE(1024, 4);
+  TEST_ASSERT_FALSE( tu_edpt_validate(&desc_ep, TUSB_SPEED_HIGH) );
+}
+
+void test_usbd_edpt_high_bandwidth_open(void)
+{
+  tusb_desc_endpoint_t desc_ep =
+  {
+    .bLength          = sizeof(tusb_desc_endpoint_t),
+    .bDescriptorType  = TUSB_DESC_ENDPOINT,
+    .bEndpointAddress = 0x81,
+    .bmAttributes     = { .xfer = TUSB_XFER_ISOCHRONOUS },
+    .wMaxPacketSize   = TUSB_EDPT_HIGH_BANDWIDTH_SIZE(1024, 3),
+    .bInterval        = 1
+  };
+
+  dcd_event_bus_reset(rhport, TUSB_SPEED_HIGH, false);
+  mscd_reset_Expect(rhport);
+  tud_task();
+
+  // DCD programs additional transactions for ISO
+  dcd_edpt_open_ExpectAndReturn(rhport, &desc_ep, true);
+  TEST_ASSERT_TRUE( usbd_edpt_open(rhport, &desc_ep) );
+
+  // but not for interrupt endpoint
+  desc_ep.bmAttributes.xfer = TUSB_XFER_INTERRUPT;
+  TEST_ASSERT_FALSE( usbd_edpt_open(rhport, &desc_ep) );
+
+  desc_ep.wMaxPacketSize = 1024;
+  dcd_edpt_open_ExpectAndReturn(rhport, &desc_ep, true);
+  TEST_ASSERT_TRUE( usbd_edpt_open(rhport, &desc_ep) );
+}
@@ -0,0 +1,154 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019, Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "unity.h"
+
+// Files to test
+#include "osal/osal.h"
+#include "tusb_fifo.h"
+#include "tusb.h"
+#include "usbd.h"
+#include "usbd_pvt.h"
+TEST_FILE("usbd_control.c")
+
+// Mock File
+#include "mock_dcd.h"
+#include "mock_msc_device.h"
+
+//--------------------------------------------------------------------+
+// Descriptor callbacks, not used
+//--------------------------------------------------------------------+
+uint8_t const * tud_descriptor_device_cb(void)
+{
+  return NULL;
+}
+
+uint8_t const * tud_descriptor_configuration_cb(uint8_t index)
+{
+  (void) index;
+  return NULL;
+}
+
+uint16_t const* tud_descriptor_string_cb(uint8_t index, uint16_t langid)
+{
+  (void) index;
+  (void) langid;
+  return NULL;
+}
+
+//--------------------------------------------------------------------+
+//
+//--------------------------------------------------------------------+
+static usbd_stream_ts_t ts;
+
+void setUp(void)
+{
+  tu_varclr(&ts);
+}
+
+void tearDown(void)
+{
+}
+
+void test_offset(void)
+{
+  TEST_ASSERT_EQUAL(0  , usbd_stream_ts_mark(&ts, 10, 1));
+  TEST_ASSERT_EQUAL(10 , usbd_stream_ts_mark(&ts, 20, 1));
+
+  TEST_ASSERT_EQUAL(0  , usbd_stream_ts_consume(&ts, 5, 2));
+  TEST_ASSERT_EQUAL(5  , usbd_stream_ts_consume(&ts, 25, 2));
+  TEST_ASSERT_EQUAL(30 , ts.rd_offset);
+}
+
+void test_latency_sampled_when_fully_consumed(void)
+{
+  usbd_stream_ts_mark(&ts, 100, 10);
+  usbd_stream_ts_mark(&ts, 100, 12);
+
+  // first chunk partially consumed
+  usbd_stream_ts_consume(&ts, 64, 11);
+  TEST_ASSERT_EQUAL(0, ts.stat.count);
+
+  // first chunk complete
+  usbd_stream_ts_consume(&ts, 64, 13);
+  TEST_ASSERT_EQUAL(1, ts.stat.count);
+  TEST_ASSERT_EQUAL(3, ts.stat.last);
+
+  // second chunk complete
+  usbd_stream_ts_consume(&ts, 72, 20);
+  TEST_ASSERT_EQUAL(2 , ts.stat.count);
+  TEST_ASSERT_EQUAL(8 , ts.stat.last);
+  TEST_ASSERT_EQUAL(3 , ts.stat.min);
+  TEST_ASSERT_EQUAL(8 , ts.stat.max);
+  TEST_ASSERT_EQUAL(11, ts.stat.sum);
+}
+
+void test_sof_wrap(void)
+{
+  usbd_stream_ts_mark(&ts, 8, UINT32_MAX - 1);
+  usbd_stream_ts_consume(&ts, 8, 2);
+  TEST_ASSERT_EQUAL(1, ts.stat.count);
+  TEST_ASSERT_EQUAL(4, ts.stat.last);
+}
+
+void test_mark_ring_full(void)
+{
+  // marks beyond capacity are dropped, offsets are still counted
+  uint32_t const n = CFG_TUD_XFER_TIMESTAMP_MARKS + 2;
+  for (uint32_t i = 0; i < n; i++)
+  {
+    usbd_stream_ts_mark(&ts, 1, i);
+  }
+  TEST_ASSERT_EQUAL(n, ts.wr_offset);
+
+  usbd_stream_ts_consume(&ts, n, 100);
+  TEST_ASSERT_EQUAL(CFG_TUD_XFER_TIMESTAMP_MARKS - 1, ts.stat.count);
+  TEST_ASSERT_EQUAL(100, ts.stat.max);
+  TEST_ASSERT_EQUAL(100 - (CFG_TUD_XFER_TIMESTAMP_MARKS - 2), ts.stat.min);
+  TEST_ASSERT_EQUAL(n, ts.rd_offset);
+}
+
+void test_stat_snapshot_clear(void)
+{
+  usbd_stream_ts_mark(&ts, 10, 5);
+  usbd_stream_ts_consume(&ts, 10, 9);
+
+  tud_latency_stat_t stat;
+  usbd_stream_ts_stat(&ts, &stat, false);
+  TEST_ASSERT_EQUAL(1, stat.count);
+  TEST_ASSERT_EQUAL(4, stat.last);
+  TEST_ASSERT_EQUAL(1, ts.stat.count);
+
+  // snapshot is taken before clearing
+  usbd_stream_ts_stat(&ts, &stat, true);
+  TEST_ASSERT_EQUAL(1, stat.count);
+  TEST_ASSERT_EQUAL(0, ts.stat.count);
+
+  // clear only, offsets are kept
+  usbd_stream_ts_mark(&ts, 10, 10);
+  usbd_stream_ts_consume(&ts, 10, 12);
+  usbd_stream_ts_stat(&ts, NULL, true);
+  TEST_ASSERT_EQUAL(0, ts.stat.count);
+  TEST_ASSERT_EQUAL(20, ts.rd_offset);
+}
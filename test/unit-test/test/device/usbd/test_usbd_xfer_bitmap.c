@@ -0,0 +1,229 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019, Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "unity.h"
+
+// Files to test
+#include "osal/osal.h"
+#include "tusb_fifo.h"
+#include "tusb.h"
+#include "usbd.h"
+TEST_FILE("usbd_control.c")
+TEST_FILE("zero_device.c")
+
+// Mock File
+#include "mock_dcd.h"
+
+//--------------------------------------------------------------------+
+// MACRO TYPEDEF CONSTANT ENUM DECLARATION
+//--------------------------------------------------------------------+
+
+enum
+{
+  EDPT_SS_OUT   = 0x01,
+  EDPT_SS_IN    = 0x81,
+  EDPT_LB_OUT   = 0x02,
+  EDPT_LB_IN    = 0x82,
+  BULK_SIZE     = 512,
+};
+
+enum
+{
+  ITF_NUM_SRC_SINK,
+  ITF_NUM_LOOPBACK,
+  ITF_NUM_TOTAL
+};
+
+uint8_t const rhport = 0;
+
+#define CONFIG_TOTAL_LEN    (TUD_CONFIG_DESC_LEN + TUD_ZERO_SRC_SINK_DESC_LEN + TUD_ZERO_LOOPBACK_DESC_LEN)
+
+uint8_t const data_desc_configuration[] =
+{
+  TUD_CONFIG_DESCRIPTOR(1, ITF_NUM_TOTAL, 0, CONFIG_TOTAL_LEN, 0, 100),
+  TUD_ZERO_SRC_SINK_DESCRIPTOR(ITF_NUM_SRC_SINK, 0, EDPT_SS_OUT, EDPT_SS_IN, BULK_SIZE, 64, 1, 256, 1),
+  TUD_ZERO_LOOPBACK_DESCRIPTOR(ITF_NUM_LOOPBACK, 0, EDPT_LB_OUT, EDPT_LB_IN, BULK_SIZE),
+};
+
+uint8_t const * tud_descriptor_device_cb(void)
+{
+  return NULL;
+}
+
+uint8_t const * tud_descriptor_configuration_cb(uint8_t index)
+{
+  (void) index;
+  return data_desc_configuration;
+}
+
+uint16_t const* tud_descriptor_string_cb(uint8_t index, uint16_t langid)
+{
+  (void) index;
+  (void) langid;
+  return NULL;
+}
+
+//--------------------------------------------------------------------+
+// DCD stubs
+//--------------------------------------------------------------------+
+static bool stub_edpt_open(uint8_t rhport_, tusb_desc_endpoint_t const * desc_ep, int num_calls)
+{
+  (void) rhport_; (void) desc_ep; (void) num_calls;
+  return true;
+}
+
+static bool stub_edpt_xfer(uint8_t rhport_, uint8_t ep_addr, uint8_t * buffer, uint16_t total_bytes, int num_calls)
+{
+  (void) rhport_; (void) ep_addr; (void) buffer; (void) total_bytes; (void) num_calls;
+  return true;
+}
+
+static void setup_request(tusb_control_request_t const* request)
+{
+  dcd_event_setup_received(rhport, (uint8_t const*) request, false);
+  tud_task();
+}
+
+static zero_stat_t get_stat(uint8_t idx)
+{
+  zero_stat_t stat;
+  tud_zero_n_stat(idx, &stat, false);
+  return stat;
+}
+
+//--------------------------------------------------------------------+
+//
+//--------------------------------------------------------------------+
+void setUp(void)
+{
+  dcd_int_disable_Ignore();
+  dcd_int_enable_Ignore();
+
+  if ( !tud_inited() )
+  {
+    dcd_init_Expect(rhport);
+    tusb_init();
+  }
+
+  dcd_edpt_open_StubWithCallback(stub_edpt_open);
+  dcd_edpt_xfer_StubWithCallback(stub_edpt_xfer);
+
+  dcd_event_bus_reset(rhport, TUSB_SPEED_HIGH, false);
+  tud_task();
+
+  tusb_control_request_t const request_set_configuration =
+  {
+    .bmRequestType = 0x00,
+    .bRequest      = TUSB_REQ_SET_CONFIGURATION,
+    .wValue        = 1,
+    .wIndex        = 0,
+    .wLength       = 0
+  };
+  setup_request(&request_set_configuration);
+
+  tud_zero_n_stat(0, NULL, true);
+  tud_zero_n_stat(1, NULL, true);
+}
+
+void tearDown(void)
+{
+}
+
+//--------------------------------------------------------------------+
+//
+//--------------------------------------------------------------------+
+void test_completions_of_all_endpoints_processed_by_one_task_run(void)
+{
+  dcd_event_xfer_complete(rhport, EDPT_SS_IN , BULK_SIZE, XFER_RESULT_SUCCESS, false);
+  dcd_event_xfer_complete(rhport, EDPT_SS_OUT, 0        , XFER_RESULT_SUCCESS, false);
+  dcd_event_xfer_complete(rhport, EDPT_LB_OUT, 100      , XFER_RESULT_SUCCESS, false);
+  TEST_ASSERT_TRUE(tud_task_event_ready());
+
+  tud_task();
+  TEST_ASSERT_FALSE(tud_task_event_ready());
+
+  TEST_ASSERT_EQUAL(1, get_stat(0).in_xfers);
+  TEST_ASSERT_EQUAL(BULK_SIZE, get_stat(0).in_bytes);
+  TEST_ASSERT_EQUAL(1, get_stat(0).out_xfers);
+  TEST_ASSERT_EQUAL(1, get_stat(1).out_xfers);
+  TEST_ASSERT_EQUAL(100, get_stat(1).out_bytes);
+}
+
+void test_completion_not_lost_when_queue_full(void)
+{
+  // fill up event queue
+  for ( uint32_t i = 0; i < CFG_TUD_TASK_QUEUE_SZ + 4; i++ )
+  {
+    dcd_event_bus_signal(rhport, DCD_EVENT_SUSPEND, false);
+  }
+
+  dcd_event_xfer_complete(rhport, EDPT_SS_IN , BULK_SIZE, XFER_RESULT_SUCCESS, false);
+  dcd_event_xfer_complete(rhport, EDPT_LB_OUT, 100      , XFER_RESULT_SUCCESS, false);
+  tud_task();
+
+  TEST_ASSERT_EQUAL(1, get_stat(0).in_xfers);
+  TEST_ASSERT_EQUAL(1, get_stat(1).out_xfers);
+}
+
+void test_result_kept_per_endpoint_and_direction(void)
+{
+  dcd_event_xfer_complete(rhport, EDPT_LB_OUT, 10, XFER_RESULT_SUCCESS, false);
+  tud_task();
+
+  // loopback echoes received length, then both directions complete before task runs
+  dcd_event_xfer_complete(rhport, EDPT_LB_IN , 10, XFER_RESULT_SUCCESS, false);
+  dcd_event_xfer_complete(rhport, EDPT_LB_OUT, 20, XFER_RESULT_SUCCESS, false);
+  tud_task();
+
+  zero_stat_t const stat = get_stat(1);
+  TEST_ASSERT_EQUAL(1 , stat.in_xfers);
+  TEST_ASSERT_EQUAL(10, stat.in_bytes);
+  TEST_ASSERT_EQUAL(2 , stat.out_xfers);
+  TEST_ASSERT_EQUAL(30, stat.out_bytes);
+}
+
+void test_completion_processed_after_queued_setup(void)
+{
+  // SETUP is queued first: statistics are cleared before the later transfer is counted
+  tusb_control_request_t const request_get_stat =
+  {
+    .bmRequestType = 0xA1,
+    .bRequest      = ZERO_REQ_GET_STAT,
+    .wValue        = 1,
+    .wIndex        = ITF_NUM_LOOPBACK,
+    .wLength       = sizeof(zero_stat_t)
+  };
+
+  dcd_event_xfer_complete(rhport, EDPT_LB_OUT, 10, XFER_RESULT_SUCCESS, false);
+  tud_task();
+  TEST_ASSERT_EQUAL(1, get_stat(1).out_xfers);
+
+  dcd_event_setup_received(rhport, (uint8_t const*) &request_get_stat, false);
+  dcd_event_xfer_complete(rhport, EDPT_LB_OUT, 20, XFER_RESULT_SUCCESS, false);
+  tud_task();
+
+  zero_stat_t const stat = get_stat(1);
+  TEST_ASSERT_EQUAL(1 , stat.out_xfers);
+  TEST_ASSERT_EQUAL(20, stat.out_bytes);
+}
@@ -0,0 +1,300 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#include "unity.h"
+
+// Files to test
+#include "osal/osal.h"
+#include "tusb_fifo.h"
+#include "tusb.h"
+#include "usbd.h"
+TEST_FILE("usbd_control.c")
+TEST_FILE("video_device.c")
+
+// Mock File
+#include "mock_dcd.h"
+
+//--------------------------------------------------------------------+
+// MACRO TYPEDEF CONSTANT ENUM DECLARATION
+//--------------------------------------------------------------------+
+
+enum
+{
+  EDPT_CTRL_OUT  = 0x00,
+  EDPT_VIDEO_IN  = 0x81,
+  VIDEO_EP_SIZE  = 256,
+  FRAME_WIDTH    = 16,
+  FRAME_HEIGHT   = 8,
+  FRAME_INTERVAL = 10000, // 1 ms in 100 ns unit
+};
+
+enum
+{
+  ITF_NUM_VIDEO_CONTROL,
+  ITF_NUM_VIDEO_STREAMING,
+  ITF_NUM_TOTAL
+};
+
+uint8_t const rhport = 0;
+
+#define VIDEO_DESC_LEN (\
+    TUD_VIDEO_DESC_IAD_LEN\
+    + TUD_VIDEO_DESC_STD_VC_LEN\
+    + (TUD_VIDEO_DESC_CS_VC_LEN + 1)\
+    + TUD_VIDEO_DESC_CAMERA_TERM_LEN\
+    + TUD_VIDEO_DESC_OUTPUT_TERM_LEN\
+    + TUD_VIDEO_DESC_STD_VS_LEN\
+    + (TUD_VIDEO_DESC_CS_VS_IN_LEN + 1)\
+    + TUD_VIDEO_DESC_CS_VS_FMT_UNCOMPR_LEN\
+    + TUD_VIDEO_DESC_CS_VS_FRM_UNCOMPR_CONT_LEN\
+    + TUD_VIDEO_DESC_STD_VS_LEN\
+    + 7)
+
+#define CONFIG_TOTAL_LEN    (TUD_CONFIG_DESC_LEN + VIDEO_DESC_LEN)
+
+uint8_t const data_desc_configuration[] =
+{
+  TUD_CONFIG_DESCRIPTOR(1, ITF_NUM_TOTAL, 0, CONFIG_TOTAL_LEN, 0, 100),
+  TUD_VIDEO_DESC_IAD(ITF_NUM_VIDEO_CONTROL, 0x02, 0),
+  TUD_VIDEO_DESC_STD_VC(ITF_NUM_VIDEO_CONTROL, 0, 0),
+    TUD_VIDEO_DESC_CS_VC(0x0150, TUD_VIDEO_DESC_CAMERA_TERM_LEN + TUD_VIDEO_DESC_OUTPUT_TERM_LEN, 27000000, ITF_NUM_VIDEO_STREAMING),
+      TUD_VIDEO_DESC_CAMERA_TERM(1, 0, 0, 0, 0, 0, 0),
+      TUD_VIDEO_DESC_OUTPUT_TERM(2, VIDEO_TT_STREAMING, 0, 1, 0),
+  TUD_VIDEO_DESC_STD_VS(ITF_NUM_VIDEO_STREAMING, 0, 0, 0),
+    TUD_VIDEO_DESC_CS_VS_INPUT(1, TUD_VIDEO_DESC_CS_VS_FMT_UNCOMPR_LEN + TUD_VIDEO_DESC_CS_VS_FRM_UNCOMPR_CONT_LEN,
+                               EDPT_VIDEO_IN, 0, 2, 0, 0, 0, 0),
+      TUD_VIDEO_DESC_CS_VS_FMT_UNCOMPR(1, 1, TUD_VIDEO_GUID_YUY2, 16, 1, 0, 0, 0, 0),
+        TUD_VIDEO_DESC_CS_VS_FRM_UNCOMPR_CONT(1, 0, FRAME_WIDTH, FRAME_HEIGHT,
+                                              FRAME_WIDTH * FRAME_HEIGHT * 16, FRAME_WIDTH * FRAME_HEIGHT * 16,
+                                              FRAME_WIDTH * FRAME_HEIGHT * 2,
+                                              FRAME_INTERVAL, FRAME_INTERVAL, FRAME_INTERVAL, FRAME_INTERVAL),
+  TUD_VIDEO_DESC_STD_VS(ITF_NUM_VIDEO_STREAMING, 1, 1, 0),
+    TUD_VIDEO_DESC_EP_ISO(EDPT_VIDEO_IN, VIDEO_EP_SIZE, 1),
+};
+
+uint8_t const * tud_descriptor_device_cb(void)
+{
+  return NULL;
+}
+
+uint8_t const * tud_descriptor_configuration_cb(uint8_t index)
+{
+  (void) index;
+  return data_desc_configuration;
+}
+
+uint16_t const* tud_descriptor_string_cb(uint8_t index, uint16_t langid)
+{
+  (void) index;
+  (void) langid;
+  return NULL;
+}
+
+static tud_stream_stamp_t stamp_log[8];
+static uint8_t stamp_count;
+
+void tud_video_stamp_cb(uint_fast8_t ctl_idx, uint_fast8_t stm_idx, tud_stream_stamp_t const *stamp)
+{
+  (void) ctl_idx; (void) stm_idx;
+  TEST_ASSERT_LESS_THAN(TU_ARRAY_SIZE(stamp_log), stamp_count);
+  stamp_log[stamp_count++] = *stamp;
+}
+
+//--------------------------------------------------------------------+
+// DCD stubs
+//--------------------------------------------------------------------+
+typedef struct
+{
+  uint8_t  ep_addr;
+  uint8_t* buffer;
+  uint16_t len;
+} xfer_t;
+
+static xfer_t  xfer_log[16];
+static uint8_t xfer_count;
+
+static bool stub_edpt_open(uint8_t rhport_, tusb_desc_endpoint_t const * desc_ep, int num_calls)
+{
+  (void) rhport_; (void) desc_ep; (void) num_calls;
+  return true;
+}
+
+static void stub_edpt_close(uint8_t rhport_, uint8_t ep_addr, int num_calls)
+{
+  (void) rhport_; (void) ep_addr; (void) num_calls;
+}
+
+static bool stub_edpt_xfer(uint8_t rhport_, uint8_t ep_addr, uint8_t * buffer, uint16_t total_bytes, int num_calls)
+{
+  (void) rhport_; (void) num_calls;
+  TEST_ASSERT_LESS_THAN(TU_ARRAY_SIZE(xfer_log), xfer_count);
+  xfer_log[xfer_count++] = (xfer_t) { ep_addr, buffer, total_bytes };
+  return true;
+}
+
+// Return last transfer queued on endpoint
+static xfer_t* last_xfer(uint8_t ep_addr)
+{
+  for ( int i = xfer_count - 1; i >= 0; i-- )
+  {
+    if ( xfer_log[i].ep_addr == ep_addr ) return &xfer_log[i];
+  }
+  return NULL;
+}
+
+static void xfer_complete(uint8_t ep_addr, uint32_t len)
+{
+  dcd_event_xfer_complete(rhport, ep_addr, len, XFER_RESULT_SUCCESS, false);
+  tud_task();
+}
+
+static void setup_request(tusb_control_request_t const* request)
+{
+  dcd_event_setup_received(rhport, (uint8_t const*) request, false);
+  tud_task();
+}
+
+static void sof(uint32_t count)
+{
+  while ( count-- ) dcd_event_sof(rhport, 0, false);
+}
+
+static void set_interface(uint8_t alt)
+{
+  tusb_control_request_t const request_set_itf =
+  {
+    .bmRequestType = 0x01,
+    .bRequest      = TUSB_REQ_SET_INTERFACE,
+    .wValue        = alt,
+    .wIndex        = ITF_NUM_VIDEO_STREAMING,
+    .wLength       = 0
+  };
+  setup_request(&request_set_itf);
+}
+
+//--------------------------------------------------------------------+
+//
+//--------------------------------------------------------------------+
+void setUp(void)
+{
+  dcd_int_disable_Ignore();
+  dcd_int_enable_Ignore();
+  dcd_sof_enable_Ignore();
+  dcd_edpt_clear_stall_Ignore();
+
+  if ( !tud_inited() )
+  {
+    dcd_init_Expect(rhport);
+    tusb_init();
+  }
+
+  dcd_edpt_open_StubWithCallback(stub_edpt_open);
+  dcd_edpt_close_StubWithCallback(stub_edpt_close);
+  dcd_edpt_xfer_StubWithCallback(stub_edpt_xfer);
+
+  dcd_event_bus_reset(rhport, TUSB_SPEED_HIGH, false);
+  tud_task();
+
+  tusb_control_request_t const request_set_configuration =
+  {
+    .bmRequestType = 0x00,
+    .bRequest      = TUSB_REQ_SET_CONFIGURATION,
+    .wValue        = 1,
+    .wIndex        = 0,
+    .wLength       = 0
+  };
+  setup_request(&request_set_configuration);
+
+  // commit default parameters, then start streaming
+  set_interface(0);
+  tusb_control_request_t const request_commit =
+  {
+    .bmRequestType = 0x21,
+    .bRequest      = VIDEO_REQUEST_SET_CUR,
+    .wValue        = VIDEO_VS_CTL_COMMIT << 8,
+    .wIndex        = ITF_NUM_VIDEO_STREAMING,
+    .wLength       = sizeof(video_probe_and_commit_control_t)
+  };
+  setup_request(&request_commit);
+  xfer_t* x = last_xfer(EDPT_CTRL_OUT);
+  TEST_ASSERT_NOT_NULL(x);
+  memset(x->buffer, 0, x->len);
+  xfer_complete(EDPT_CTRL_OUT, x->len);
+
+  set_interface(1);
+  TEST_ASSERT_TRUE(tud_video_n_streaming(0, 0));
+}
+
+void tearDown(void)
+{
+  xfer_count  = 0;
+  stamp_count = 0;
+}
+
+//--------------------------------------------------------------------+
+//
+//--------------------------------------------------------------------+
+void test_frame_stamp(void)
+{
+  static uint8_t frame[100];
+  uint32_t const t0 = tud_sof_clock();
+
+  TEST_ASSERT_TRUE(tud_video_n_frame_xfer(0, 0, frame, sizeof(frame)));
+
+  // payload header is excluded from stamped length
+  xfer_t* x = last_xfer(EDPT_VIDEO_IN);
+  uint16_t const hdr_len = x->buffer[0];
+  uint16_t const len0    = x->len;
+  TEST_ASSERT_LESS_THAN(sizeof(frame) + hdr_len, len0);
+
+  sof(1);
+  xfer_complete(EDPT_VIDEO_IN, len0);
+  TEST_ASSERT_EQUAL(1, stamp_count);
+  TEST_ASSERT_EQUAL(0             , stamp_log[0].offset);
+  TEST_ASSERT_EQUAL(len0 - hdr_len, stamp_log[0].len);
+  TEST_ASSERT_EQUAL(t0 + 1        , stamp_log[0].sof);
+
+  tud_latency_stat_t stat;
+  TEST_ASSERT_TRUE(tud_video_n_latency(0, 0, &stat, false));
+  TEST_ASSERT_EQUAL(0, stat.count);
+
+  // rest of the frame
+  uint16_t const len1 = last_xfer(EDPT_VIDEO_IN)->len;
+  TEST_ASSERT_EQUAL(sizeof(frame) - (len0 - hdr_len), len1 - hdr_len);
+  sof(2);
+  xfer_complete(EDPT_VIDEO_IN, len1);
+  TEST_ASSERT_EQUAL(2             , stamp_count);
+  TEST_ASSERT_EQUAL(len0 - hdr_len, stamp_log[1].offset);
+  TEST_ASSERT_EQUAL(t0 + 3        , stamp_log[1].sof);
+
+  // latency sampled once the frame is fully transmitted
+  TEST_ASSERT_TRUE(tud_video_n_latency(0, 0, &stat, true));
+  TEST_ASSERT_EQUAL(1, stat.count);
+  TEST_ASSERT_EQUAL(3, stat.last);
+
+  TEST_ASSERT_TRUE(tud_video_n_latency(0, 0, &stat, false));
+  TEST_ASSERT_EQUAL(0, stat.count);
+}
@@ -0,0 +1,438 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#include "unity.h"
+
+// Files to test
+#include "osal/osal.h"
+#include "tusb_fifo.h"
+#include "tusb.h"
+#include "usbd.h"
+TEST_FILE("usbd_control.c")
+TEST_FILE("zero_device.c")
+
+// Mock File
+#include "mock_dcd.h"
+
+//--------------------------------------------------------------------+
+// MACRO TYPEDEF CONSTANT ENUM DECLARATION
+//--------------------------------------------------------------------+
+
+enum
+{
+  EDPT_CTRL_OUT = 0x00,
+  EDPT_CTRL_IN  = 0x80,
+
+  EDPT_SS_OUT   = 0x01,
+  EDPT_SS_IN    = 0x81,
+  EDPT_LB_OUT   = 0x02,
+  EDPT_LB_IN    = 0x82,
+
+  BULK_SIZE     = 512,
+  INT_SIZE      = 64,
+  ISO_SIZE      = 256,
+};
+
+enum
+{
+  ITF_NUM_SRC_SINK,
+  ITF_NUM_LOOPBACK,
+  ITF_NUM_TOTAL
+};
+
+uint8_t const rhport = 0;
+
+#define CONFIG_TOTAL_LEN    (TUD_CONFIG_DESC_LEN + TUD_ZERO_SRC_SINK_DESC_LEN + TUD_ZERO_LOOPBACK_DESC_LEN)
+
+uint8_t const data_desc_configuration[] =
+{
+  TUD_CONFIG_DESCRIPTOR(1, ITF_NUM_TOTAL, 0, CONFIG_TOTAL_LEN, 0, 100),
+  TUD_ZERO_SRC_SINK_DESCRIPTOR(ITF_NUM_SRC_SINK, 0, EDPT_SS_OUT, EDPT_SS_IN, BULK_SIZE, INT_SIZE, 1, ISO_SIZE, 1),
+  TUD_ZERO_LOOPBACK_DESCRIPTOR(ITF_NUM_LOOPBACK, 0, EDPT_LB_OUT, EDPT_LB_IN, BULK_SIZE),
+};
+
+uint8_t const * tud_descriptor_device_cb(void)
+{
+  return NULL;
+}
+
+uint8_t const * tud_descriptor_configuration_cb(uint8_t index)
+{
+  (void) index;
+  return data_desc_configuration;
+}
+
+uint16_t const* tud_descriptor_string_cb(uint8_t index, uint16_t langid)
+{
+  (void) index;
+  (void) langid;
+  return NULL;
+}
+
+//--------------------------------------------------------------------+
+// DCD stubs
+//--------------------------------------------------------------------+
+typedef struct
+{
+  uint8_t  ep_addr;
+  uint8_t* buffer;
+  uint16_t len;
+} xfer_t;
+
+static xfer_t  xfer_log[16];
+static uint8_t xfer_count;
+static uint8_t open_count;
+static uint8_t close_count;
+
+static uint8_t  iso_alloc_addr[2];
+static uint16_t iso_alloc_size[2];
+static uint8_t  iso_activate_count;
+
+static bool stub_edpt_open(uint8_t rhport_, tusb_desc_endpoint_t const * desc_ep, int num_calls)
+{
+  (void) rhport_; (void) desc_ep; (void) num_calls;
+  open_count++;
+  return true;
+}
+
+static bool stub_edpt_iso_alloc(uint8_t rhport_, uint8_t ep_addr, uint16_t largest_packet_size, int num_calls)
+{
+  (void) rhport_; (void) num_calls;
+  uint8_t const dir = tu_edpt_dir(ep_addr);
+  TEST_ASSERT_EQUAL(0, iso_alloc_addr[dir]);
+  iso_alloc_addr[dir] = ep_addr;
+  iso_alloc_size[dir] = largest_packet_size;
+  return true;
+}
+
+static bool stub_edpt_iso_activate(uint8_t rhport_, tusb_desc_endpoint_t const * desc_ep, int num_calls)
+{
+  (void) rhport_; (void) num_calls;
+  TEST_ASSERT_EQUAL(TUSB_XFER_ISOCHRONOUS, desc_ep->bmAttributes.xfer);
+  TEST_ASSERT_EQUAL(desc_ep->bEndpointAddress, iso_alloc_addr[tu_edpt_dir(desc_ep->bEndpointAddress)]);
+  iso_activate_count++;
+  return true;
+}
+
+static void stub_edpt_close(uint8_t rhport_, uint8_t ep_addr, int num_calls)
+{
+  (void) rhport_; (void) ep_addr; (void) num_calls;
+  close_count++;
+}
+
+static bool stub_edpt_xfer(uint8_t rhport_, uint8_t ep_addr, uint8_t * buffer, uint16_t total_bytes, int num_calls)
+{
+  (void) rhport_; (void) num_calls;
+  TEST_ASSERT_LESS_THAN(TU_ARRAY_SIZE(xfer_log), xfer_count);
+  xfer_log[xfer_count++] = (xfer_t) { ep_addr, buffer, total_bytes };
+  return true;
+}
+
+// Return last transfer queued on endpoint
+static xfer_t* last_xfer(uint8_t ep_addr)
+{
+  for ( int i = xfer_count - 1; i >= 0; i-- )
+  {
+    if ( xfer_log[i].ep_addr == ep_addr ) return &xfer_log[i];
+  }
+  return NULL;
+}
+
+static void xfer_complete(uint8_t ep_addr, uint32_t len)
+{
+  dcd_event_xfer_complete(rhport, ep_addr, len, XFER_RESULT_SUCCESS, false);
+  tud_task();
+}
+
+static void setup_request(tusb_control_request_t const* request)
+{
+  dcd_event_setup_received(rhport, (uint8_t const*) request, false);
+  tud_task();
+}
+
+//--------------------------------------------------------------------+
+//
+//--------------------------------------------------------------------+
+void setUp(void)
+{
+  dcd_int_disable_Ignore();
+  dcd_int_enable_Ignore();
+
+  if ( !tud_inited() )
+  {
+    dcd_init_Expect(rhport);
+    tusb_init();
+  }
+
+  dcd_edpt_open_StubWithCallback(stub_edpt_open);
+  dcd_edpt_close_StubWithCallback(stub_edpt_close);
+  dcd_edpt_xfer_StubWithCallback(stub_edpt_xfer);
+  dcd_edpt_iso_alloc_StubWithCallback(stub_edpt_iso_alloc);
+  dcd_edpt_iso_activate_StubWithCallback(stub_edpt_iso_activate);
+
+  dcd_event_bus_reset(rhport, TUSB_SPEED_HIGH, false);
+  tud_task();
+
+  tusb_control_request_t const request_set_configuration =
+  {
+    .bmRequestType = 0x00,
+    .bRequest      = TUSB_REQ_SET_CONFIGURATION,
+    .wValue        = 1,
+    .wIndex        = 0,
+    .wLength       = 0
+  };
+  setup_request(&request_set_configuration);
+}
+
+void tearDown(void)
+{
+  xfer_count  = 0;
+  open_count  = 0;
+  close_count = 0;
+  iso_activate_count = 0;
+  tu_varclr(&iso_alloc_addr);
+  tu_varclr(&iso_alloc_size);
+}
+
+//--------------------------------------------------------------------+
+//
+//--------------------------------------------------------------------+
+void test_open(void)
+{
+  TEST_ASSERT_TRUE(tud_zero_n_mounted(0));
+  TEST_ASSERT_TRUE(tud_zero_n_mounted(1));
+  TEST_ASSERT_EQUAL(0, tud_zero_alt());
+
+  // ISO endpoints of source/sink are reserved but not activated
+  TEST_ASSERT_EQUAL(EDPT_SS_OUT, iso_alloc_addr[TUSB_DIR_OUT]);
+  TEST_ASSERT_EQUAL(EDPT_SS_IN, iso_alloc_addr[TUSB_DIR_IN]);
+  TEST_ASSERT_EQUAL(ISO_SIZE, iso_alloc_size[TUSB_DIR_OUT]);
+  TEST_ASSERT_EQUAL(ISO_SIZE, iso_alloc_size[TUSB_DIR_IN]);
+  TEST_ASSERT_EQUAL(0, iso_activate_count);
+
+  // source, sink, loopback receive, control status
+  TEST_ASSERT_EQUAL(4, xfer_count);
+  TEST_ASSERT_EQUAL(EDPT_SS_IN, xfer_log[0].ep_addr);
+  TEST_ASSERT_EQUAL(512, xfer_log[0].len);
+  TEST_ASSERT_TRUE(zero_pattern_check(ZERO_PATTERN_MOD63, xfer_log[0].buffer, 512, BULK_SIZE));
+  TEST_ASSERT_EQUAL(62, xfer_log[0].buffer[62]);
+  TEST_ASSERT_EQUAL(0, xfer_log[0].buffer[63]);
+
+  TEST_ASSERT_EQUAL(EDPT_SS_OUT, xfer_log[1].ep_addr);
+  TEST_ASSERT_EQUAL(512, xfer_log[1].len);
+  TEST_ASSERT_EQUAL(EDPT_LB_OUT, xfer_log[2].ep_addr);
+  TEST_ASSERT_EQUAL(EDPT_CTRL_IN, xfer_log[3].ep_addr);
+}
+
+void test_sink_verify(void)
+{
+  xfer_t* x = last_xfer(EDPT_SS_OUT);
+
+  zero_pattern_fill(ZERO_PATTERN_MOD63, x->buffer, 100, BULK_SIZE);
+  xfer_complete(EDPT_SS_OUT, 100);
+
+  x = last_xfer(EDPT_SS_OUT);
+  zero_pattern_fill(ZERO_PATTERN_MOD63, x->buffer, 100, BULK_SIZE);
+  x->buffer[70] ^= 0xff;
+  xfer_complete(EDPT_SS_OUT, 100);
+
+  zero_stat_t stat;
+  TEST_ASSERT_TRUE(tud_zero_stat(&stat, true));
+  TEST_ASSERT_EQUAL(2, stat.out_xfers);
+  TEST_ASSERT_EQUAL(200, stat.out_bytes);
+  TEST_ASSERT_EQUAL(1, stat.errors);
+
+  TEST_ASSERT_TRUE(tud_zero_stat(&stat, false));
+  TEST_ASSERT_EQUAL(0, stat.out_xfers);
+}
+
+void test_source_sweep_zlp(void)
+{
+  zero_param_t const param = { .pattern = ZERO_PATTERN_MOD63, .zlp = 1, .len_min = 448, .len_max = 576, .len_step = 64 };
+  TEST_ASSERT_FALSE(tud_zero_set_param(&param)); // larger than buffer
+
+  zero_param_t const param2 = { .pattern = ZERO_PATTERN_MOD63, .zlp = 1, .len_min = 448, .len_max = 512, .len_step = 64 };
+  TEST_ASSERT_TRUE(tud_zero_set_param(&param2));
+
+  uint16_t const expected[] = { 448, 512, 0, 448, 512, 0 };
+  for ( size_t i = 0; i < TU_ARRAY_SIZE(expected); i++ )
+  {
+    xfer_complete(EDPT_SS_IN, last_xfer(EDPT_SS_IN)->len);
+    TEST_ASSERT_EQUAL(expected[i], last_xfer(EDPT_SS_IN)->len);
+  }
+}
+
+void test_loopback(void)
+{
+  uint8_t* buf0 = last_xfer(EDPT_LB_OUT)->buffer;
+  memset(buf0, 0xA5, 100);
+  xfer_complete(EDPT_LB_OUT, 100);
+
+  // echo and receive into other buffer
+  xfer_t* tx = last_xfer(EDPT_LB_IN);
+  TEST_ASSERT_NOT_NULL(tx);
+  TEST_ASSERT_EQUAL_PTR(buf0, tx->buffer);
+  TEST_ASSERT_EQUAL(100, tx->len);
+  uint8_t* buf1 = last_xfer(EDPT_LB_OUT)->buffer;
+  TEST_ASSERT_TRUE(buf1 != buf0);
+
+  // both buffers in use, receive is paused until echo complete
+  uint8_t const count = xfer_count;
+  xfer_complete(EDPT_LB_OUT, 0);
+  TEST_ASSERT_EQUAL(count, xfer_count);
+
+  xfer_complete(EDPT_LB_IN, 100);
+  TEST_ASSERT_EQUAL(count + 2, xfer_count);
+  TEST_ASSERT_EQUAL_PTR(buf1, last_xfer(EDPT_LB_IN)->buffer);
+  TEST_ASSERT_EQUAL(0, last_xfer(EDPT_LB_IN)->len);
+  TEST_ASSERT_EQUAL_PTR(buf0, last_xfer(EDPT_LB_OUT)->buffer);
+}
+
+void test_set_interface(void)
+{
+  tusb_control_request_t const request_set_itf =
+  {
+    .bmRequestType = 0x01,
+    .bRequest      = TUSB_REQ_SET_INTERFACE,
+    .wValue        = 2,
+    .wIndex        = ITF_NUM_SRC_SINK,
+    .wLength       = 0
+  };
+  xfer_count = 0;
+  open_count = 0;
+  setup_request(&request_set_itf);
+
+  TEST_ASSERT_EQUAL(2, close_count);
+  TEST_ASSERT_EQUAL(2, tud_zero_alt());
+
+  // reserved ISO endpoints are activated instead of opened
+  TEST_ASSERT_EQUAL(0, open_count);
+  TEST_ASSERT_EQUAL(2, iso_activate_count);
+
+  // isochronous: single packet per transfer
+  TEST_ASSERT_EQUAL(ISO_SIZE, last_xfer(EDPT_SS_IN)->len);
+  TEST_ASSERT_EQUAL(ISO_SIZE, last_xfer(EDPT_SS_OUT)->len);
+  TEST_ASSERT_EQUAL(0, last_xfer(EDPT_CTRL_IN)->len);
+
+  // non-existing alternate setting is ignored, endpoints are kept
+  tusb_control_request_t const request_invalid = { .bmRequestType = 0x01, .bRequest = TUSB_REQ_SET_INTERFACE,
+                                                   .wValue = 3, .wIndex = ITF_NUM_SRC_SINK, .wLength = 0 };
+  setup_request(&request_invalid);
+  TEST_ASSERT_EQUAL(2, close_count);
+  TEST_ASSERT_EQUAL(2, tud_zero_alt());
+
+  // back to bulk: ISO endpoints are kept reserved, bulk endpoints are opened while ISO transfers are in flight
+  tusb_control_request_t const request_bulk = { .bmRequestType = 0x01, .bRequest = TUSB_REQ_SET_INTERFACE,
+                                                .wValue = 0, .wIndex = ITF_NUM_SRC_SINK, .wLength = 0 };
+  setup_request(&request_bulk);
+  TEST_ASSERT_EQUAL(2, close_count);
+  TEST_ASSERT_EQUAL(2, open_count);
+  TEST_ASSERT_EQUAL(0, tud_zero_alt());
+  zero_param_t param;
+  TEST_ASSERT_TRUE(tud_zero_get_param(&param));
+  TEST_ASSERT_EQUAL(param.len_min, last_xfer(EDPT_SS_IN)->len);
+  TEST_ASSERT_EQUAL(512, last_xfer(EDPT_SS_OUT)->len);
+}
+
+void test_get_stat_request(void)
+{
+  xfer_t* x = last_xfer(EDPT_SS_OUT);
+  zero_pattern_fill(ZERO_PATTERN_MOD63, x->buffer, 512, BULK_SIZE);
+  xfer_complete(EDPT_SS_OUT, 512);
+
+  tusb_control_request_t const request_get_stat =
+  {
+    .bmRequestType = 0xA1,
+    .bRequest      = ZERO_REQ_GET_STAT,
+    .wValue        = 1,
+    .wIndex        = ITF_NUM_SRC_SINK,
+    .wLength       = sizeof(zero_stat_t)
+  };
+  setup_request(&request_get_stat);
+
+  x = last_xfer(EDPT_CTRL_IN);
+  TEST_ASSERT_EQUAL(sizeof(zero_stat_t), x->len);
+
+  zero_stat_t stat;
+  memcpy(&stat, x->buffer, sizeof(stat));
+  TEST_ASSERT_EQUAL(1, stat.out_xfers);
+  TEST_ASSERT_EQUAL(512, stat.out_bytes);
+  TEST_ASSERT_EQUAL(0, stat.errors);
+
+  // cleared by request
+  TEST_ASSERT_TRUE(tud_zero_stat(&stat, false));
+  TEST_ASSERT_EQUAL(0, stat.out_xfers);
+}
+
+void test_pattern_change_deferred(void)
+{
+  zero_param_t const param = { .pattern = ZERO_PATTERN_ZERO, .len_min = 512, .len_max = 512 };
+  zero_param_t const param_default = { .pattern = ZERO_PATTERN_MOD63, .len_min = 512, .len_max = 512 };
+
+  // buffer of the in-flight transfer is not modified
+  xfer_t* x = last_xfer(EDPT_SS_IN);
+  TEST_ASSERT_TRUE(tud_zero_set_param(&param));
+  TEST_ASSERT_EQUAL(62, x->buffer[62]);
+
+  // applied to the next transfer
+  xfer_complete(EDPT_SS_IN, 512);
+  x = last_xfer(EDPT_SS_IN);
+  TEST_ASSERT_EQUAL(0, x->buffer[62]);
+  TEST_ASSERT_TRUE(zero_pattern_check(ZERO_PATTERN_ZERO, x->buffer, 512, BULK_SIZE));
+
+  TEST_ASSERT_TRUE(tud_zero_set_param(&param_default));
+  xfer_complete(EDPT_SS_IN, 512);
+  TEST_ASSERT_EQUAL(62, last_xfer(EDPT_SS_IN)->buffer[62]);
+}
+
+void test_set_param_request(void)
+{
+  tusb_control_request_t const request_set_param =
+  {
+    .bmRequestType = 0x21,
+    .bRequest      = ZERO_REQ_SET_PARAM,
+    .wValue        = 0,
+    .wIndex        = ITF_NUM_SRC_SINK,
+    .wLength       = sizeof(zero_param_t)
+  };
+  setup_request(&request_set_param);
+
+  // little endian on the wire: len_min = 64, len_max = 320, len_step = 256
+  uint8_t const data[] = { ZERO_PATTERN_MOD63, 0, 0x40, 0x00, 0x40, 0x01, 0x00, 0x01 };
+  xfer_t* x = last_xfer(EDPT_CTRL_OUT);
+  TEST_ASSERT_EQUAL(sizeof(data), x->len);
+  memcpy(x->buffer, data, sizeof(data));
+  xfer_complete(EDPT_CTRL_OUT, sizeof(data));
+
+  zero_param_t param;
+  TEST_ASSERT_TRUE(tud_zero_get_param(&param));
+  TEST_ASSERT_EQUAL(64 , param.len_min);
+  TEST_ASSERT_EQUAL(320, param.len_max);
+  TEST_ASSERT_EQUAL(256, param.len_step);
+
+  zero_param_t const param_default = { .pattern = ZERO_PATTERN_MOD63, .len_min = 512, .len_max = 512 };
+  TEST_ASSERT_TRUE(tud_zero_set_param(&param_default));
+}
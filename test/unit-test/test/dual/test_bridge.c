@@ -0,0 +1,270 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019, hathach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#include "unity.h"
+
+// Files to test
+#include "osal/osal.h"
+#include "tusb_fifo.h"
+#include "tusb_types.h"
+#include "bridge.h"
+
+// Mock File
+#include "mock_usbd_pvt.h"
+#include "mock_usbh.h"
+
+//--------------------------------------------------------------------+
+// MACRO TYPEDEF CONSTANT ENUM DECLARATION
+//--------------------------------------------------------------------+
+
+enum
+{
+  CH_OUT = 0,
+  CH_IN  = 1,
+
+  EDPT_DEV_OUT  = 0x01,
+  EDPT_DEV_IN   = 0x81,
+  EDPT_HOST_OUT = 0x02,
+  EDPT_HOST_IN  = 0x82,
+
+  DADDR = 1,
+};
+
+uint8_t const rhport = 0;
+
+// vendor interface carrying both bridged endpoints
+uint8_t const desc_itf[] =
+{
+  9, TUSB_DESC_INTERFACE, 0, 0, 2, TUSB_CLASS_VENDOR_SPECIFIC, 0x00, 0x00, 0,
+  7, TUSB_DESC_ENDPOINT, EDPT_DEV_OUT, TUSB_XFER_BULK, U16_TO_U8S_LE(512), 0,
+  7, TUSB_DESC_ENDPOINT, EDPT_DEV_IN, TUSB_XFER_BULK, U16_TO_U8S_LE(512), 0
+};
+
+tusb_desc_endpoint_t const desc_host_in =
+{
+  .bLength = sizeof(tusb_desc_endpoint_t), .bDescriptorType = TUSB_DESC_ENDPOINT,
+  .bEndpointAddress = EDPT_HOST_IN, .bmAttributes = { .xfer = TUSB_XFER_BULK }, .wMaxPacketSize = 64
+};
+
+tusb_desc_endpoint_t const desc_host_out =
+{
+  .bLength = sizeof(tusb_desc_endpoint_t), .bDescriptorType = TUSB_DESC_ENDPOINT,
+  .bEndpointAddress = EDPT_HOST_OUT, .bmAttributes = { .xfer = TUSB_XFER_BULK }, .wMaxPacketSize = 64
+};
+
+// transfers submitted to both stacks, in order
+typedef struct
+{
+  uint8_t  ep_addr; // host endpoints are logged with bit 6 set
+  uint8_t* buffer;
+  uint16_t len;
+} xfer_log_t;
+
+#define HOST_EP(_ep)   ((uint8_t) ((_ep) | 0x40))
+
+static xfer_log_t xfer_log[16];
+static uint8_t xfer_count;
+static tuh_xfer_cb_t host_cb;
+
+static bool stub_usbd_edpt_xfer(uint8_t port, uint8_t ep_addr, uint8_t* buffer, uint16_t total_bytes, int num_calls)
+{
+  (void) port; (void) num_calls;
+  TEST_ASSERT_LESS_THAN(TU_ARRAY_SIZE(xfer_log), xfer_count);
+  xfer_log[xfer_count++] = (xfer_log_t) { ep_addr, buffer, total_bytes };
+  return true;
+}
+
+static bool stub_tuh_edpt_xfer(tuh_xfer_t* xfer, int num_calls)
+{
+  (void) num_calls;
+  TEST_ASSERT_EQUAL(DADDR, xfer->daddr);
+  TEST_ASSERT_LESS_THAN(TU_ARRAY_SIZE(xfer_log), xfer_count);
+  xfer_log[xfer_count++] = (xfer_log_t) { HOST_EP(xfer->ep_addr), xfer->buffer, (uint16_t) xfer->buflen };
+  host_cb = xfer->complete_cb;
+  return true;
+}
+
+static void host_complete(uint8_t ep_addr, uint32_t len)
+{
+  tuh_xfer_t xfer =
+  {
+    .daddr = DADDR, .ep_addr = ep_addr, .result = XFER_RESULT_SUCCESS, .actual_len = len, .user_data = (ep_addr & 0x80) ? CH_IN : CH_OUT
+  };
+  host_cb(&xfer);
+}
+
+static void check_xfer(uint8_t idx, uint8_t ep_addr, uint16_t len)
+{
+  TEST_ASSERT_LESS_THAN(xfer_count, idx);
+  TEST_ASSERT_EQUAL_HEX8(ep_addr, xfer_log[idx].ep_addr);
+  TEST_ASSERT_EQUAL(len, xfer_log[idx].len);
+}
+
+// rx_cb behavior
+static bool hold_buffer;
+static uint8_t held_buf_id;
+
+void tu_bridge_rx_cb(uint8_t ch, uint8_t buf_id, uint8_t const* data, uint16_t len)
+{
+  (void) data; (void) len;
+  if (hold_buffer)
+  {
+    held_buf_id = buf_id;
+    tu_bridge_buf_ref(ch, buf_id);
+  }
+}
+
+void setUp(void)
+{
+  xfer_count = 0;
+  host_cb = NULL;
+  hold_buffer = false;
+
+  usbd_edpt_open_IgnoreAndReturn(true);
+  usbd_edpt_claim_IgnoreAndReturn(true);
+  usbd_edpt_release_IgnoreAndReturn(true);
+  tuh_edpt_open_IgnoreAndReturn(true);
+  tuh_edpt_abort_xfer_IgnoreAndReturn(true);
+  usbd_edpt_xfer_StubWithCallback(stub_usbd_edpt_xfer);
+  tuh_edpt_xfer_StubWithCallback(stub_tuh_edpt_xfer);
+
+  bridged_init();
+  TEST_ASSERT_TRUE(tu_bridge_device_bind(CH_OUT, EDPT_DEV_OUT));
+  TEST_ASSERT_TRUE(tu_bridge_device_bind(CH_IN, EDPT_DEV_IN));
+  TEST_ASSERT_EQUAL(sizeof(desc_itf), bridged_open(rhport, (tusb_desc_interface_t const*) desc_itf, sizeof(desc_itf)));
+}
+
+void tearDown(void)
+{
+}
+
+//--------------------------------------------------------------------+
+// Tests
+//--------------------------------------------------------------------+
+
+void test_bind_mismatched_direction(void)
+{
+  tu_bridge_host_close(CH_IN);
+  TEST_ASSERT_FALSE(tu_bridge_host_open(CH_IN, DADDR, &desc_host_out));
+}
+
+void test_open_device_only(void)
+{
+  // device OUT is receiving, IN waits for attached device
+  TEST_ASSERT_EQUAL(1, xfer_count);
+  check_xfer(0, EDPT_DEV_OUT, CFG_TUSB_BRIDGE_BUFSIZE);
+  TEST_ASSERT_FALSE(tu_bridge_connected(CH_OUT));
+  TEST_ASSERT_EQUAL(CFG_TUSB_BRIDGE_BUF_COUNT - 1, tu_bridge_credits(CH_OUT));
+}
+
+void test_in_forward_zero_copy(void)
+{
+  TEST_ASSERT_TRUE(tu_bridge_host_open(CH_IN, DADDR, &desc_host_in));
+  TEST_ASSERT_TRUE(tu_bridge_connected(CH_IN));
+  check_xfer(1, HOST_EP(EDPT_HOST_IN), CFG_TUSB_BRIDGE_BUFSIZE);
+
+  host_complete(EDPT_HOST_IN, 100);
+
+  // next receive is posted before forwarding, forwarded from the very same buffer
+  check_xfer(2, HOST_EP(EDPT_HOST_IN), CFG_TUSB_BRIDGE_BUFSIZE);
+  check_xfer(3, EDPT_DEV_IN, 100);
+  TEST_ASSERT_EQUAL_PTR(xfer_log[1].buffer, xfer_log[3].buffer);
+  TEST_ASSERT_NOT_EQUAL(xfer_log[1].buffer, xfer_log[2].buffer);
+}
+
+void test_in_credit_exhausted(void)
+{
+  TEST_ASSERT_TRUE(tu_bridge_host_open(CH_IN, DADDR, &desc_host_in));
+  host_complete(EDPT_HOST_IN, 100); // 2: rx, 3: tx
+  host_complete(EDPT_HOST_IN, 50);  // queued, no credit left to receive
+
+  TEST_ASSERT_EQUAL(4, xfer_count);
+  TEST_ASSERT_EQUAL(0, tu_bridge_credits(CH_IN));
+
+  // upstream host took first transfer: second one is sent, freed buffer is received into
+  TEST_ASSERT_TRUE(bridged_xfer_cb(rhport, EDPT_DEV_IN, XFER_RESULT_SUCCESS, 100));
+  check_xfer(4, HOST_EP(EDPT_HOST_IN), CFG_TUSB_BRIDGE_BUFSIZE);
+  check_xfer(5, EDPT_DEV_IN, 50);
+  TEST_ASSERT_EQUAL_PTR(xfer_log[2].buffer, xfer_log[5].buffer);
+  TEST_ASSERT_EQUAL_PTR(xfer_log[1].buffer, xfer_log[4].buffer);
+}
+
+void test_out_short_packet_zlp(void)
+{
+  TEST_ASSERT_TRUE(tu_bridge_host_open(CH_OUT, DADDR, &desc_host_out));
+
+  // 128 bytes ended with short packet on 512 byte device endpoint, is 2 full packets on 64 byte host endpoint
+  TEST_ASSERT_TRUE(bridged_xfer_cb(rhport, EDPT_DEV_OUT, XFER_RESULT_SUCCESS, 128));
+  check_xfer(1, EDPT_DEV_OUT, CFG_TUSB_BRIDGE_BUFSIZE);
+  check_xfer(2, HOST_EP(EDPT_HOST_OUT), 128);
+
+  host_complete(EDPT_HOST_OUT, 128);
+  check_xfer(3, HOST_EP(EDPT_HOST_OUT), 0);
+  TEST_ASSERT_EQUAL(0, tu_bridge_credits(CH_OUT));
+
+  host_complete(EDPT_HOST_OUT, 0);
+  TEST_ASSERT_EQUAL(4, xfer_count);
+  TEST_ASSERT_EQUAL(1, tu_bridge_credits(CH_OUT));
+}
+
+void test_buffer_held_by_application(void)
+{
+  TEST_ASSERT_TRUE(tu_bridge_host_open(CH_OUT, DADDR, &desc_host_out));
+  hold_buffer = true;
+
+  TEST_ASSERT_TRUE(bridged_xfer_cb(rhport, EDPT_DEV_OUT, XFER_RESULT_SUCCESS, 10));
+  host_complete(EDPT_HOST_OUT, 10);
+
+  // sent but still referenced, credit is not returned
+  TEST_ASSERT_EQUAL(0, tu_bridge_credits(CH_OUT));
+
+  tu_bridge_buf_unref(CH_OUT, held_buf_id);
+  TEST_ASSERT_EQUAL(1, tu_bridge_credits(CH_OUT));
+}
+
+void test_host_close_drops_queued(void)
+{
+  TEST_ASSERT_TRUE(tu_bridge_host_open(CH_OUT, DADDR, &desc_host_out));
+  TEST_ASSERT_TRUE(bridged_xfer_cb(rhport, EDPT_DEV_OUT, XFER_RESULT_SUCCESS, 10));
+  TEST_ASSERT_EQUAL(0, tu_bridge_credits(CH_OUT));
+
+  // attached device is gone: buffer being sent is returned, device OUT resumes receiving
+  tu_bridge_host_close(CH_OUT);
+  TEST_ASSERT_FALSE(tu_bridge_connected(CH_OUT));
+  TEST_ASSERT_EQUAL(1, tu_bridge_credits(CH_OUT));
+}
+
+void test_source_error_halts(void)
+{
+  TEST_ASSERT_TRUE(tu_bridge_host_open(CH_IN, DADDR, &desc_host_in));
+
+  tuh_xfer_t xfer = { .daddr = DADDR, .ep_addr = EDPT_HOST_IN, .result = XFER_RESULT_STALLED, .user_data = CH_IN };
+  host_cb(&xfer);
+
+  // no more receive until re-opened
+  TEST_ASSERT_EQUAL(2, xfer_count);
+  TEST_ASSERT_EQUAL(CFG_TUSB_BRIDGE_BUF_COUNT, tu_bridge_credits(CH_IN));
+}
@@ -0,0 +1,592 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023, Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "unity.h"
+
+// Files to test
+#include "tusb_option.h"
+#include "hcd.h"
+#include "max3421.h"
+TEST_FILE("hcd_max3421.c")
+
+/* SPI-level register model of MAX3421E with a simple attached device:
+ * - ep0 answers every IN data stage with an incrementing pattern
+ * - ep1 OUT (bulk) stores received data, NAK/STALL can be injected
+ * - ep2 IN (bulk) returns data from a buffer, NAK can be injected
+ * Transactions are executed synchronously on HXFR write, HXFRDN is raised right away.
+ * Model also counts SPI transactions/bytes for throughput checks.
+ */
+
+//--------------------------------------------------------------------+
+// MAX3421E Model
+//--------------------------------------------------------------------+
+enum {
+  DEV_ADDR = 1,
+  EP_BULK_OUT = 0x01,
+  EP_BULK_IN  = 0x82,
+  BULK_SIZE   = 64,
+};
+
+typedef struct {
+  uint8_t regs[32];
+  uint8_t hirq;
+
+  uint8_t snd_buf[2][MAX3421_FIFO_SIZE];
+  uint8_t snd_len[2];
+  uint8_t snd_head;
+  uint8_t snd_count;   // committed to SIE
+  uint8_t snd_wr_idx;  // CPU write index in non-committed buffer
+
+  uint8_t rcv_buf[MAX3421_FIFO_SIZE];
+  uint8_t rcv_len;
+  uint8_t rcv_rd_idx;
+  bool rcv_full;
+
+  uint8_t sud_buf[8];
+  uint8_t sud_idx;
+
+  uint8_t sndtog, rcvtog;
+
+  // SPI
+  bool cs;
+  bool cmd_done;
+  uint8_t cmd_reg;
+  bool cmd_write;
+  uint32_t spi_xact;   // CS assertions
+  uint32_t spi_bytes;
+  uint32_t hxfr_count;
+  uint8_t last_peraddr;
+
+  bool int_enabled;
+
+  // bus & device
+  uint8_t bus_jk;      // HRSL_JSTATUS/KSTATUS of attached device, 0 if detached
+  uint8_t out_buf[4096];
+  uint16_t out_len;
+  uint8_t out_toggle;
+  uint8_t out_nak;     // NAK next n OUT packets
+  bool out_stall;
+
+  uint8_t in_buf[4096];
+  uint16_t in_len;
+  uint16_t in_idx;
+  uint8_t in_toggle;
+  uint8_t in_nak;
+  uint16_t in_nak_total;
+
+  uint8_t setup[8];
+  uint32_t drain_count;
+} max3421_model_t;
+
+static max3421_model_t _model;
+
+static uint8_t model_hrsl(uint8_t result) {
+  return (uint8_t) (result | (_model.rcvtog ? HRSL_RCVTOGRD : 0) | (_model.sndtog ? HRSL_SNDTOGRD : 0) |
+                    (_model.regs[HRSL_ADDR] & (HRSL_JSTATUS | HRSL_KSTATUS)));
+}
+
+static uint8_t model_hirq(void) {
+  return (uint8_t) (_model.hirq | (_model.snd_count < 2 ? HIRQ_SNDBAV_IRQ : 0));
+}
+
+static void model_xfer_done(uint8_t result) {
+  _model.regs[HRSL_ADDR] = model_hrsl(result);
+  _model.hirq |= HIRQ_HXFRDN_IRQ;
+}
+
+static void model_hxfr(uint8_t hxfr) {
+  uint8_t const addr = _model.regs[PERADDR_ADDR];
+  uint8_t const ep_num = hxfr & HXFR_EPNUM_MASK;
+  bool const dev_present = (addr == DEV_ADDR) || (addr == 0 && ep_num == 0);
+
+  _model.hxfr_count++;
+  _model.last_peraddr = addr;
+
+  if (hxfr & HXFR_SETUP) {
+    memcpy(_model.setup, _model.sud_buf, 8);
+    model_xfer_done(HRSL_SUCCESS);
+    return;
+  }
+
+  if (hxfr & HXFR_HS) {
+    model_xfer_done(HRSL_SUCCESS);
+    return;
+  }
+
+  if (hxfr & HXFR_OUT_NIN) {
+    TEST_ASSERT_MESSAGE(_model.snd_count, "OUT launched with empty SNDFIFO");
+    uint8_t const head = _model.snd_head;
+    uint8_t result;
+
+    if (!dev_present) {
+      _model.drain_count++;
+      result = HRSL_TIMEOUT;
+    } else if (_model.out_stall) {
+      result = HRSL_STALL;
+    } else if (_model.out_nak) {
+      _model.out_nak--;
+      result = HRSL_NAK;
+    } else {
+      TEST_ASSERT_EQUAL_MESSAGE(_model.out_toggle, _model.sndtog, "OUT data toggle");
+      memcpy(_model.out_buf + _model.out_len, _model.snd_buf[head], _model.snd_len[head]);
+      _model.out_len += _model.snd_len[head];
+      _model.out_toggle ^= 1;
+      _model.sndtog ^= 1;
+      result = HRSL_SUCCESS;
+    }
+
+    // NAK'ed packet is retained for retry
+    if (result != HRSL_NAK) {
+      _model.snd_head ^= 1;
+      _model.snd_count--;
+    }
+
+    model_xfer_done(result);
+    return;
+  }
+
+  // IN
+  if (!dev_present) {
+    model_xfer_done(HRSL_TIMEOUT);
+    return;
+  }
+
+  if (ep_num == 2 && _model.in_nak) {
+    _model.in_nak--;
+    _model.in_nak_total++;
+    model_xfer_done(HRSL_NAK);
+    return;
+  }
+
+  TEST_ASSERT_FALSE_MESSAGE(_model.rcv_full, "IN launched with full RCVFIFO");
+
+  uint16_t len;
+  if (ep_num == 0) {
+    len = 64;
+    for (uint8_t i = 0; i < len; i++) _model.rcv_buf[i] = i;
+  } else {
+    TEST_ASSERT_EQUAL_MESSAGE(_model.in_toggle, _model.rcvtog, "IN data toggle");
+    len = tu_min16((uint16_t) (_model.in_len - _model.in_idx), BULK_SIZE);
+    memcpy(_model.rcv_buf, _model.in_buf + _model.in_idx, len);
+    _model.in_idx += len;
+    _model.in_toggle ^= 1;
+  }
+
+  _model.rcv_len = (uint8_t) len;
+  _model.rcv_rd_idx = 0;
+  _model.rcv_full = true;
+  _model.rcvtog ^= 1;
+  _model.hirq |= HIRQ_RCVDAV_IRQ;
+  model_xfer_done(HRSL_SUCCESS);
+}
+
+static void model_reg_write(uint8_t reg, uint8_t data) {
+  switch (reg) {
+    case SNDFIFO_ADDR: {
+      uint8_t const idx = (uint8_t) ((_model.snd_head + _model.snd_count) % 2);
+      TEST_ASSERT_LESS_THAN(2, _model.snd_count);
+      _model.snd_buf[idx][_model.snd_wr_idx++] = data;
+      break;
+    }
+
+    case SNDBC_ADDR: {
+      uint8_t const idx = (uint8_t) ((_model.snd_head + _model.snd_count) % 2);
+      TEST_ASSERT_LESS_THAN(2, _model.snd_count);
+      _model.snd_len[idx] = data;
+      _model.snd_count++;
+      _model.snd_wr_idx = 0;
+      break;
+    }
+
+    case SUDFIFO_ADDR:
+      _model.sud_buf[_model.sud_idx++ % 8] = data;
+      break;
+
+    case HIRQ_ADDR:
+      if (data & HIRQ_RCVDAV_IRQ) _model.rcv_full = false;
+      _model.hirq &= (uint8_t) ~data;
+      break;
+
+    case USBCTL_ADDR:
+      if (data & USBCTL_CHIPRES) {
+        // SPI configuration is kept
+        uint8_t const pinctl = _model.regs[PINCTL_ADDR];
+        tu_memclr(_model.regs, sizeof(_model.regs));
+        _model.regs[PINCTL_ADDR] = pinctl;
+        _model.sndtog = _model.rcvtog = 0;
+      } else {
+        _model.regs[USBIRQ_ADDR] |= USBIRQ_OSCOK_IRQ;
+      }
+      _model.regs[USBCTL_ADDR] = data;
+      break;
+
+    case HCTL_ADDR:
+      if (data & HCTL_SAMPLEBUS) {
+        _model.regs[HRSL_ADDR] = (uint8_t) ((_model.regs[HRSL_ADDR] & ~(HRSL_JSTATUS | HRSL_KSTATUS)) | _model.bus_jk);
+      }
+      if (data & HCTL_BUSRST) _model.hirq |= HIRQ_BUSEVENT_IRQ;
+      if (data & HCTL_RCVTOG0) _model.rcvtog = 0;
+      if (data & HCTL_RCVTOG1) _model.rcvtog = 1;
+      if (data & HCTL_SNDTOG0) _model.sndtog = 0;
+      if (data & HCTL_SNDTOG1) _model.sndtog = 1;
+      break;
+
+    case HXFR_ADDR:
+      model_hxfr(data);
+      break;
+
+    default:
+      _model.regs[reg] = data;
+      break;
+  }
+}
+
+static uint8_t model_reg_read(uint8_t reg) {
+  switch (reg) {
+    case RCVFIFO_ADDR: return _model.rcv_buf[_model.rcv_rd_idx++];
+    case RCVBC_ADDR:   return _model.rcv_len;
+    case HIRQ_ADDR:    return model_hirq();
+    default:           return _model.regs[reg];
+  }
+}
+
+// level interrupt: handler runs as long as an enabled irq is pending
+static void model_run(void) {
+  for (uint32_t i = 0; i < 1000; i++) {
+    if (!_model.int_enabled || !(_model.regs[CPUCTL_ADDR] & CPUCTL_IE)) return;
+    if (!(model_hirq() & _model.regs[HIEN_ADDR])) return;
+    hcd_int_handler(0);
+  }
+  TEST_FAIL_MESSAGE("interrupt storm");
+}
+
+static void model_frame(void) {
+  if (_model.regs[MODE_ADDR] & MODE_SOFKAENAB) _model.hirq |= HIRQ_FRAME_IRQ;
+  model_run();
+}
+
+//--------------------------------------------------------------------+
+// Board API & USBH stub
+//--------------------------------------------------------------------+
+
+void tuh_max3421_spi_cs_api(uint8_t rhport, bool active) {
+  (void) rhport;
+  if (active) {
+    TEST_ASSERT_FALSE(_model.cs);
+    _model.spi_xact++;
+    _model.cmd_done = false;
+  }
+  _model.cs = active;
+}
+
+bool tuh_max3421_spi_xfer_api(uint8_t rhport, uint8_t const* tx_buf, uint8_t* rx_buf, size_t xfer_bytes) {
+  (void) rhport;
+  TEST_ASSERT_TRUE(_model.cs);
+  _model.spi_bytes += xfer_bytes;
+
+  for (size_t i = 0; i < xfer_bytes; i++) {
+    uint8_t const tx = tx_buf ? tx_buf[i] : 0;
+    uint8_t rx;
+
+    if (!_model.cmd_done) {
+      _model.cmd_done = true;
+      _model.cmd_reg = tx >> 3;
+      _model.cmd_write = (tx & MAX3421_CMD_WRITE) ? true : false;
+      rx = model_hirq();
+    } else if (_model.cmd_write) {
+      model_reg_write(_model.cmd_reg, tx);
+      rx = 0;
+    } else {
+      rx = model_reg_read(_model.cmd_reg);
+    }
+
+    if (rx_buf) rx_buf[i] = rx;
+  }
+
+  return true;
+}
+
+void tuh_max3421_int_api(uint8_t rhport, bool enabled) {
+  (void) rhport;
+  _model.int_enabled = enabled;
+}
+
+enum { EVENT_MAX = 16 };
+static hcd_event_t _events[EVENT_MAX];
+static uint8_t _event_count;
+
+void hcd_event_handler(hcd_event_t const* event, bool in_isr) {
+  (void) in_isr;
+  TEST_ASSERT_LESS_THAN(EVENT_MAX, _event_count);
+  _events[_event_count++] = *event;
+}
+
+void hcd_devtree_get_info(uint8_t dev_addr, hcd_devtree_info_t* devtree_info) {
+  (void) dev_addr;
+  devtree_info->rhport = 0;
+  devtree_info->hub_addr = 0;
+  devtree_info->hub_port = 0;
+  devtree_info->speed = TUSB_SPEED_FULL;
+}
+
+//--------------------------------------------------------------------+
+// Helper
+//--------------------------------------------------------------------+
+
+static void open_edpt(uint8_t daddr, uint8_t ep_addr, uint8_t xfer_type, uint16_t size, uint8_t interval) {
+  tusb_desc_endpoint_t const desc = {
+    .bLength          = sizeof(tusb_desc_endpoint_t),
+    .bDescriptorType  = TUSB_DESC_ENDPOINT,
+    .bEndpointAddress = ep_addr,
+    .bmAttributes     = { .xfer = xfer_type },
+    .wMaxPacketSize   = size,
+    .bInterval        = interval
+  };
+  TEST_ASSERT_TRUE(hcd_edpt_open(0, daddr, &desc));
+}
+
+static hcd_event_t const* last_event(void) {
+  TEST_ASSERT_GREATER_THAN(0, _event_count);
+  return &_events[_event_count - 1];
+}
+
+static void check_xfer_event(uint8_t ep_addr, uint32_t len, xfer_result_t result) {
+  hcd_event_t const* event = last_event();
+  TEST_ASSERT_EQUAL(HCD_EVENT_XFER_COMPLETE, event->event_id);
+  TEST_ASSERT_EQUAL_HEX8(ep_addr, event->xfer_complete.ep_addr);
+  TEST_ASSERT_EQUAL(len, event->xfer_complete.len);
+  TEST_ASSERT_EQUAL(result, event->xfer_complete.result);
+}
+
+//--------------------------------------------------------------------+
+// Test
+//--------------------------------------------------------------------+
+
+static uint8_t _buf[4096];
+
+void setUp(void) {
+  tu_memclr(&_model, sizeof(_model));
+  tu_memclr(_events, sizeof(_events));
+  _event_count = 0;
+
+  _model.bus_jk = HRSL_JSTATUS; // full speed device attached
+
+  TEST_ASSERT_TRUE(hcd_init(0));
+  hcd_int_enable(0);
+  model_run();
+}
+
+void tearDown(void) {
+}
+
+void test_hcd_max3421_init_attach(void) {
+  TEST_ASSERT_EQUAL_HEX8(PINCTL_FDUPSPI | PINCTL_INTLEVEL, _model.regs[PINCTL_ADDR]);
+  TEST_ASSERT_BITS_HIGH(MODE_HOST | MODE_SOFKAENAB, _model.regs[MODE_ADDR]);
+  TEST_ASSERT_BITS_LOW(MODE_LOWSPEED, _model.regs[MODE_ADDR]);
+
+  TEST_ASSERT_EQUAL(HCD_EVENT_DEVICE_ATTACH, last_event()->event_id);
+  TEST_ASSERT_TRUE(hcd_port_connect_status(0));
+  TEST_ASSERT_EQUAL(TUSB_SPEED_FULL, hcd_port_speed_get(0));
+
+  // FRAME interrupt is off while idle, reading frame number starts counting
+  TEST_ASSERT_BITS_LOW(HIRQ_FRAME_IRQ, _model.regs[HIEN_ADDR]);
+  model_frame();
+  TEST_ASSERT_EQUAL(0, hcd_frame_number(0));
+  TEST_ASSERT_BITS_HIGH(HIRQ_FRAME_IRQ, _model.regs[HIEN_ADDR]);
+  model_frame();
+  model_frame();
+  TEST_ASSERT_EQUAL(2, hcd_frame_number(0));
+
+  // disconnect
+  _model.bus_jk = 0;
+  _model.hirq |= HIRQ_CONDET_IRQ;
+  model_run();
+  TEST_ASSERT_EQUAL(HCD_EVENT_DEVICE_REMOVE, last_event()->event_id);
+  TEST_ASSERT_FALSE(hcd_port_connect_status(0));
+  TEST_ASSERT_BITS_LOW(MODE_SOFKAENAB, _model.regs[MODE_ADDR]);
+}
+
+void test_hcd_max3421_control_in(void) {
+  uint8_t const setup[8] = { 0x80, TUSB_REQ_GET_DESCRIPTOR, 0x00, TUSB_DESC_DEVICE, 0, 0, 18, 0 };
+
+  open_edpt(0, 0x00, TUSB_XFER_CONTROL, 64, 0);
+
+  TEST_ASSERT_TRUE(hcd_setup_send(0, 0, setup));
+  model_run();
+  TEST_ASSERT_EQUAL_MEMORY(setup, _model.setup, 8);
+  check_xfer_event(0x00, 8, XFER_RESULT_SUCCESS);
+
+  // data stage starts with DATA1
+  TEST_ASSERT_TRUE(hcd_edpt_xfer(0, 0, 0x80, _buf, 18));
+  model_run();
+  check_xfer_event(0x80, 18, XFER_RESULT_SUCCESS);
+  for (uint8_t i = 0; i < 18; i++) TEST_ASSERT_EQUAL(i, _buf[i]);
+
+  // status stage
+  TEST_ASSERT_TRUE(hcd_edpt_xfer(0, 0, 0x00, NULL, 0));
+  model_run();
+  check_xfer_event(0x00, 0, XFER_RESULT_SUCCESS);
+}
+
+void test_hcd_max3421_bulk_out_back_to_back(void) {
+  enum { PKT_COUNT = 16 };
+  for (uint16_t i = 0; i < sizeof(_buf); i++) _buf[i] = (uint8_t) (i * 7);
+
+  open_edpt(DEV_ADDR, EP_BULK_OUT, TUSB_XFER_BULK, BULK_SIZE, 0);
+
+  uint32_t const spi_xact = _model.spi_xact;
+  TEST_ASSERT_TRUE(hcd_edpt_xfer(0, DEV_ADDR, EP_BULK_OUT, _buf, PKT_COUNT*BULK_SIZE));
+  model_run();
+
+  check_xfer_event(EP_BULK_OUT, PKT_COUNT*BULK_SIZE, XFER_RESULT_SUCCESS);
+  TEST_ASSERT_EQUAL(PKT_COUNT*BULK_SIZE, _model.out_len);
+  TEST_ASSERT_EQUAL_MEMORY(_buf, _model.out_buf, PKT_COUNT*BULK_SIZE);
+  TEST_ASSERT_EQUAL(PKT_COUNT, _model.hxfr_count);
+  TEST_ASSERT_EQUAL(0, _model.snd_count);
+
+  // steady state per packet: HRSL read, HIRQ ack, HXFR, SNDFIFO burst, SNDBC
+  TEST_ASSERT_LESS_OR_EQUAL(5*PKT_COUNT + 4, _model.spi_xact - spi_xact);
+
+  // next transfer continues data toggle without HCTL write
+  _model.out_len = 0;
+  TEST_ASSERT_TRUE(hcd_edpt_xfer(0, DEV_ADDR, EP_BULK_OUT, _buf, 10));
+  model_run();
+  check_xfer_event(EP_BULK_OUT, 10, XFER_RESULT_SUCCESS);
+  TEST_ASSERT_EQUAL_MEMORY(_buf, _model.out_buf, 10);
+}
+
+void test_hcd_max3421_bulk_out_nak_retry_per_frame(void) {
+  for (uint16_t i = 0; i < 128; i++) _buf[i] = (uint8_t) i;
+
+  open_edpt(DEV_ADDR, EP_BULK_OUT, TUSB_XFER_BULK, BULK_SIZE, 0);
+
+  _model.out_nak = 3;
+  TEST_ASSERT_TRUE(hcd_edpt_xfer(0, DEV_ADDR, EP_BULK_OUT, _buf, 128));
+  model_run();
+
+  // NAK'ed: no retry until next frame
+  TEST_ASSERT_EQUAL(1, _model.hxfr_count);
+  TEST_ASSERT_EQUAL(0, _event_count - 1);
+
+  model_frame();
+  TEST_ASSERT_EQUAL(2, _model.hxfr_count);
+  model_frame();
+  TEST_ASSERT_EQUAL(3, _model.hxfr_count);
+
+  // 4th attempt is ACK'ed, retained + preloaded packets complete the transfer
+  model_frame();
+  check_xfer_event(EP_BULK_OUT, 128, XFER_RESULT_SUCCESS);
+  TEST_ASSERT_EQUAL(5, _model.hxfr_count);
+  TEST_ASSERT_EQUAL(128, _model.out_len);
+  TEST_ASSERT_EQUAL_MEMORY(_buf, _model.out_buf, 128);
+}
+
+void test_hcd_max3421_frame_irq_on_demand(void) {
+  open_edpt(DEV_ADDR, EP_BULK_OUT, TUSB_XFER_BULK, BULK_SIZE, 0);
+  TEST_ASSERT_BITS_LOW(HIRQ_FRAME_IRQ, _model.regs[HIEN_ADDR]);
+
+  // ACK'ed right away: no frame needed
+  TEST_ASSERT_TRUE(hcd_edpt_xfer(0, DEV_ADDR, EP_BULK_OUT, _buf, 10));
+  model_run();
+  check_xfer_event(EP_BULK_OUT, 10, XFER_RESULT_SUCCESS);
+  TEST_ASSERT_BITS_LOW(HIRQ_FRAME_IRQ, _model.regs[HIEN_ADDR]);
+
+  // NAK'ed: retry waits for next frame
+  _model.out_nak = 1;
+  TEST_ASSERT_TRUE(hcd_edpt_xfer(0, DEV_ADDR, EP_BULK_OUT, _buf, 10));
+  model_run();
+  TEST_ASSERT_BITS_HIGH(HIRQ_FRAME_IRQ, _model.regs[HIEN_ADDR]);
+
+  // retried and completed, no more periodic work
+  model_frame();
+  check_xfer_event(EP_BULK_OUT, 10, XFER_RESULT_SUCCESS);
+  TEST_ASSERT_BITS_LOW(HIRQ_FRAME_IRQ, _model.regs[HIEN_ADDR]);
+
+  // idle frames cost no SPI traffic
+  uint32_t const spi_xact = _model.spi_xact;
+  for (uint8_t i = 0; i < 8; i++) model_frame();
+  TEST_ASSERT_EQUAL(spi_xact, _model.spi_xact);
+}
+
+void test_hcd_max3421_bulk_in_nak(void) {
+  for (uint16_t i = 0; i < 100; i++) _model.in_buf[i] = (uint8_t) (0xff - i);
+  _model.in_len = 100;
+  _model.in_nak = 2;
+
+  open_edpt(DEV_ADDR, EP_BULK_IN, TUSB_XFER_BULK, BULK_SIZE, 0);
+
+  TEST_ASSERT_TRUE(hcd_edpt_xfer(0, DEV_ADDR, EP_BULK_IN, _buf, 512));
+  model_run();
+  TEST_ASSERT_EQUAL(1, _model.hxfr_count);
+
+  model_frame();
+  model_frame();
+
+  // 64 + 36 (short packet)
+  check_xfer_event(EP_BULK_IN, 100, XFER_RESULT_SUCCESS);
+  TEST_ASSERT_EQUAL(4, _model.hxfr_count);
+  TEST_ASSERT_EQUAL_MEMORY(_model.in_buf, _buf, 100);
+}
+
+void test_hcd_max3421_interrupt_in_interval(void) {
+  _model.in_nak = 0xff;
+  open_edpt(DEV_ADDR, EP_BULK_IN, TUSB_XFER_INTERRUPT, 8, 4);
+
+  TEST_ASSERT_TRUE(hcd_edpt_xfer(0, DEV_ADDR, EP_BULK_IN, _buf, 8));
+  model_run();
+
+  for (uint8_t i = 0; i < 8; i++) model_frame();
+
+  // polled once per 4 frames
+  TEST_ASSERT_EQUAL(3, _model.in_nak_total);
+
+  // not started transfer can be aborted
+  TEST_ASSERT_TRUE(hcd_edpt_abort_xfer(0, DEV_ADDR, EP_BULK_IN));
+  for (uint8_t i = 0; i < 8; i++) model_frame();
+  TEST_ASSERT_EQUAL(3, _model.in_nak_total);
+}
+
+void test_hcd_max3421_out_stall_drain(void) {
+  for (uint16_t i = 0; i < 256; i++) _buf[i] = (uint8_t) i;
+
+  open_edpt(DEV_ADDR, EP_BULK_OUT, TUSB_XFER_BULK, BULK_SIZE, 0);
+
+  _model.out_stall = true;
+  TEST_ASSERT_TRUE(hcd_edpt_xfer(0, DEV_ADDR, EP_BULK_OUT, _buf, 256));
+  model_run();
+  check_xfer_event(EP_BULK_OUT, 0, XFER_RESULT_STALLED);
+
+  // pre-loaded packet is flushed to unused address
+  TEST_ASSERT_EQUAL(1, _model.drain_count);
+  TEST_ASSERT_EQUAL(0, _model.snd_count);
+
+  // clear stall: next transfer starts with DATA0 and fresh data
+  _model.out_stall = false;
+  _model.out_toggle = 0;
+  TEST_ASSERT_TRUE(hcd_edpt_clear_stall(0, DEV_ADDR, EP_BULK_OUT));
+  TEST_ASSERT_TRUE(hcd_edpt_xfer(0, DEV_ADDR, EP_BULK_OUT, _buf + 100, 64));
+  model_run();
+  check_xfer_event(EP_BULK_OUT, 64, XFER_RESULT_SUCCESS);
+  TEST_ASSERT_EQUAL_MEMORY(_buf + 100, _model.out_buf, 64);
+}
@@ -0,0 +1,362 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#include "unity.h"
+
+// Files to test
+#include "tusb_option.h"
+#include "zero_host.h"
+
+// Mock File
+#include "mock_usbh.h"
+#include "mock_usbh_pvt.h"
+
+//--------------------------------------------------------------------+
+// MACRO TYPEDEF CONSTANT ENUM DECLARATION
+//--------------------------------------------------------------------+
+
+enum
+{
+  DADDR     = 1,
+  EDPT_IN   = 0x81,
+  EDPT_OUT  = 0x01,
+  BULK_SIZE = 64,
+  INT_SIZE  = 16,
+  XFER_LEN  = 64,
+};
+
+// source/sink interface: alt 0 bulk, alt 1 interrupt
+uint8_t const desc_src_sink[] =
+{
+  9, TUSB_DESC_INTERFACE, 0, 0, 2, TUSB_CLASS_VENDOR_SPECIFIC, ZERO_SUBCLASS, ZERO_PROTOCOL_SRC_SINK, 0,
+  7, TUSB_DESC_ENDPOINT, EDPT_OUT, TUSB_XFER_BULK, U16_TO_U8S_LE(BULK_SIZE), 0,
+  7, TUSB_DESC_ENDPOINT, EDPT_IN , TUSB_XFER_BULK, U16_TO_U8S_LE(BULK_SIZE), 0,
+  9, TUSB_DESC_INTERFACE, 0, 1, 2, TUSB_CLASS_VENDOR_SPECIFIC, ZERO_SUBCLASS, ZERO_PROTOCOL_SRC_SINK, 0,
+  7, TUSB_DESC_ENDPOINT, EDPT_OUT, TUSB_XFER_INTERRUPT, U16_TO_U8S_LE(INT_SIZE), 1,
+  7, TUSB_DESC_ENDPOINT, EDPT_IN , TUSB_XFER_INTERRUPT, U16_TO_U8S_LE(INT_SIZE), 1,
+};
+
+// Linux g_zero source/sink: vendor interface without subclass
+uint8_t const desc_g_zero[] =
+{
+  9, TUSB_DESC_INTERFACE, 0, 0, 2, TUSB_CLASS_VENDOR_SPECIFIC, 0, 0, 0,
+  7, TUSB_DESC_ENDPOINT, EDPT_IN , TUSB_XFER_BULK, U16_TO_U8S_LE(BULK_SIZE), 0,
+  7, TUSB_DESC_ENDPOINT, EDPT_OUT, TUSB_XFER_BULK, U16_TO_U8S_LE(BULK_SIZE), 0,
+};
+
+//--------------------------------------------------------------------+
+// Application callbacks
+//--------------------------------------------------------------------+
+static uint32_t _now;
+static uint8_t  _complete_count;
+
+uint32_t tuh_zero_time_us_cb(void)
+{
+  return _now;
+}
+
+void tuh_zero_test_complete_cb(uint8_t idx, tuh_zero_result_t const* result)
+{
+  (void) idx; (void) result;
+  _complete_count++;
+}
+
+uint8_t tuh_zero_match_cb(uint8_t daddr, tusb_desc_interface_t const* desc_itf)
+{
+  uint16_t vid, pid;
+  TEST_ASSERT_TRUE(tuh_vid_pid_get(daddr, &vid, &pid));
+  if ( vid == 0x0525 && pid == 0xa4a0 && desc_itf->bInterfaceClass == TUSB_CLASS_VENDOR_SPECIFIC )
+  {
+    return ZERO_PROTOCOL_SRC_SINK;
+  }
+  return 0;
+}
+
+//--------------------------------------------------------------------+
+// USBH stubs
+//--------------------------------------------------------------------+
+static tuh_xfer_t             _ctrl_xfer;
+static tusb_control_request_t _ctrl_req;
+static uint8_t                _ctrl_count;
+
+static uint8_t* _in_buf;
+static uint8_t  _in_count;
+
+static bool stub_control_xfer(tuh_xfer_t* xfer, int num_calls)
+{
+  (void) num_calls;
+  _ctrl_xfer = *xfer;
+  _ctrl_req  = *xfer->setup;
+  _ctrl_xfer.setup = &_ctrl_req;
+  _ctrl_count++;
+  return true;
+}
+
+static bool stub_interface_set(uint8_t daddr, uint8_t itf_num, uint8_t itf_alt,
+                               tuh_xfer_cb_t complete_cb, uintptr_t user_data, int num_calls)
+{
+  (void) num_calls;
+  _ctrl_xfer = (tuh_xfer_t) { .daddr = daddr, .complete_cb = complete_cb, .user_data = user_data };
+  _ctrl_req  = (tusb_control_request_t) { .bRequest = TUSB_REQ_SET_INTERFACE, .wValue = itf_alt, .wIndex = itf_num };
+  _ctrl_xfer.setup = &_ctrl_req;
+  _ctrl_count++;
+  return true;
+}
+
+static bool stub_edpt_xfer(uint8_t dev_addr, uint8_t ep_addr, uint8_t * buffer, uint16_t total_bytes,
+                           tuh_xfer_cb_t complete_cb, uintptr_t user_data, int num_calls)
+{
+  (void) dev_addr; (void) total_bytes; (void) complete_cb; (void) user_data; (void) num_calls;
+  if ( ep_addr == EDPT_IN )
+  {
+    _in_buf = buffer;
+    _in_count++;
+  }
+  return true;
+}
+
+// Complete pending control request successfully
+static void control_complete(void)
+{
+  _ctrl_xfer.result     = XFER_RESULT_SUCCESS;
+  _ctrl_xfer.actual_len = _ctrl_req.wLength;
+  if ( _ctrl_xfer.buffer ) memset(_ctrl_xfer.buffer, 0, _ctrl_req.wLength);
+  _ctrl_xfer.complete_cb(&_ctrl_xfer);
+}
+
+static uint8_t mount(uint8_t const* desc, uint16_t len)
+{
+  tuh_edpt_open_IgnoreAndReturn(true);
+  usbh_driver_set_config_complete_Ignore();
+
+  TEST_ASSERT_TRUE(zeroh_open(0, DADDR, (tusb_desc_interface_t const*) desc, len));
+  TEST_ASSERT_TRUE(zeroh_set_config(DADDR, 0));
+
+  uint8_t const idx = tuh_zero_itf_get_index(DADDR, 0);
+  TEST_ASSERT_TRUE(tuh_zero_mounted(idx));
+  return idx;
+}
+
+// Run source test on native interface, transfer i completes lat[i] us after submitted
+static void run_source(uint8_t idx, uint32_t const* lat, uint32_t count)
+{
+  tuh_zero_test_t const test = { .type = TUH_ZERO_TEST_SOURCE, .alt = 0, .pattern = ZERO_PATTERN_MOD63,
+                                 .queue_depth = 1, .xfer_len = XFER_LEN, .count = count };
+  TEST_ASSERT_TRUE(tuh_zero_test_start(idx, &test));
+
+  // set param, clear stat
+  control_complete();
+  control_complete();
+
+  for ( uint32_t i = 0; i < count; i++ )
+  {
+    _now += lat[i];
+    zero_pattern_fill(ZERO_PATTERN_MOD63, _in_buf, XFER_LEN, BULK_SIZE);
+    TEST_ASSERT_TRUE(zeroh_xfer_cb(DADDR, EDPT_IN, XFER_RESULT_SUCCESS, XFER_LEN));
+  }
+
+  // get stat
+  TEST_ASSERT_EQUAL(ZERO_REQ_GET_STAT, _ctrl_req.bRequest);
+  control_complete();
+  TEST_ASSERT_FALSE(tuh_zero_busy(idx));
+}
+
+//--------------------------------------------------------------------+
+//
+//--------------------------------------------------------------------+
+void setUp(void)
+{
+  zeroh_init();
+
+  tuh_control_xfer_StubWithCallback(stub_control_xfer);
+  tuh_interface_set_StubWithCallback(stub_interface_set);
+  usbh_edpt_xfer_with_callback_StubWithCallback(stub_edpt_xfer);
+  usbh_edpt_claim_IgnoreAndReturn(true);
+
+  _now = 1000;
+  _complete_count = 0;
+  _ctrl_count = 0;
+  _in_count = 0;
+}
+
+void tearDown(void)
+{
+}
+
+//--------------------------------------------------------------------+
+// Latency histogram
+//--------------------------------------------------------------------+
+void test_latency_percentile(void)
+{
+  uint8_t const idx = mount(desc_src_sink, sizeof(desc_src_sink));
+
+  // 50 x 10 us, 40 x 100 us, 9 x 1000 us, 1 x 5000 us
+  static uint32_t lat[100];
+  for ( uint32_t i = 0; i < 100; i++ )
+  {
+    lat[i] = (i < 50) ? 10 : (i < 90) ? 100 : (i < 99) ? 1000 : 5000;
+  }
+  run_source(idx, lat, 100);
+
+  tuh_zero_result_t r;
+  TEST_ASSERT_TRUE(tuh_zero_result(idx, &r));
+  TEST_ASSERT_EQUAL(XFER_RESULT_SUCCESS, r.status);
+  TEST_ASSERT_EQUAL(100, r.count);
+  TEST_ASSERT_EQUAL(0, r.errors);
+  TEST_ASSERT_EQUAL(10, r.lat_min_us);
+  TEST_ASSERT_EQUAL(5000, r.lat_max_us);
+  TEST_ASSERT_EQUAL((500 + 4000 + 9000 + 5000) / 100, r.lat_avg_us);
+
+  // percentile is upper bound of its bucket: 4 buckets per power of 2
+  TEST_ASSERT_EQUAL(11  , r.lat_p50_us); // [10, 11]
+  TEST_ASSERT_EQUAL(111 , r.lat_p90_us); // [96, 111]
+  TEST_ASSERT_EQUAL(1023, r.lat_p99_us); // [896, 1023]
+
+  // capped by max
+  TEST_ASSERT_EQUAL(5000, tuh_zero_latency_percentile(idx, 100));
+  TEST_ASSERT_EQUAL(11  , tuh_zero_latency_percentile(idx, 0));
+}
+
+void test_latency_small_values(void)
+{
+  uint8_t const idx = mount(desc_src_sink, sizeof(desc_src_sink));
+
+  // below 8 us every value has its own bucket
+  uint32_t const lat[] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+  run_source(idx, lat, TU_ARRAY_SIZE(lat));
+
+  for ( uint8_t i = 0; i < TU_ARRAY_SIZE(lat); i++ )
+  {
+    TEST_ASSERT_EQUAL(lat[i], tuh_zero_latency_percentile(idx, (uint8_t) ((i + 1) * 100 / TU_ARRAY_SIZE(lat))));
+  }
+}
+
+void test_latency_bucket_boundary(void)
+{
+  uint8_t const idx = mount(desc_src_sink, sizeof(desc_src_sink));
+
+  // 95 and 96 are in different buckets: [80, 95] and [96, 111]
+  uint32_t const lat[] = { 95, 96 };
+  run_source(idx, lat, TU_ARRAY_SIZE(lat));
+
+  TEST_ASSERT_EQUAL(95, tuh_zero_latency_percentile(idx, 50));
+  TEST_ASSERT_EQUAL(96, tuh_zero_latency_percentile(idx, 100));
+}
+
+void test_latency_overflow(void)
+{
+  uint8_t const idx = mount(desc_src_sink, sizeof(desc_src_sink));
+
+  // beyond histogram range, last bucket is capped by max
+  uint32_t const lat[] = { 20000000 };
+  run_source(idx, lat, TU_ARRAY_SIZE(lat));
+
+  TEST_ASSERT_EQUAL(20000000, tuh_zero_latency_percentile(idx, 50));
+}
+
+//--------------------------------------------------------------------+
+// Alternate setting
+//--------------------------------------------------------------------+
+void test_alt_switch_closes_endpoints(void)
+{
+  uint8_t const idx = mount(desc_src_sink, sizeof(desc_src_sink));
+
+  tuh_edpt_close_ExpectAndReturn(DADDR, EDPT_IN , true);
+  tuh_edpt_close_ExpectAndReturn(DADDR, EDPT_OUT, true);
+
+  tuh_zero_test_t const test = { .type = TUH_ZERO_TEST_SOURCE, .alt = 1, .pattern = ZERO_PATTERN_MOD63,
+                                 .queue_depth = 1, .xfer_len = XFER_LEN, .count = 1 };
+  TEST_ASSERT_TRUE(tuh_zero_test_start(idx, &test));
+  TEST_ASSERT_EQUAL(TUSB_REQ_SET_INTERFACE, _ctrl_req.bRequest);
+  TEST_ASSERT_EQUAL(1, _ctrl_req.wValue);
+
+  // endpoints of new setting are opened, then parameters are set with length limited to packet size
+  control_complete();
+  TEST_ASSERT_EQUAL(ZERO_REQ_SET_PARAM, _ctrl_req.bRequest);
+}
+
+void test_alt_switch_rejected(void)
+{
+  uint8_t const idx = mount(desc_src_sink, sizeof(desc_src_sink));
+
+  // host controller can not close endpoints
+  tuh_edpt_close_ExpectAndReturn(DADDR, EDPT_IN, false);
+
+  tuh_zero_test_t const test = { .type = TUH_ZERO_TEST_SOURCE, .alt = 1, .pattern = ZERO_PATTERN_MOD63,
+                                 .queue_depth = 1, .xfer_len = XFER_LEN, .count = 1 };
+  TEST_ASSERT_FALSE(tuh_zero_test_start(idx, &test));
+  TEST_ASSERT_FALSE(tuh_zero_busy(idx));
+  TEST_ASSERT_EQUAL(0, _ctrl_count);
+}
+
+//--------------------------------------------------------------------+
+// Other devices
+//--------------------------------------------------------------------+
+void test_match_g_zero(void)
+{
+  uint16_t vid = 0x0525, pid = 0xa4a0;
+  tuh_vid_pid_get_ExpectAndReturn(DADDR, NULL, NULL, true);
+  tuh_vid_pid_get_IgnoreArg_vid();
+  tuh_vid_pid_get_IgnoreArg_pid();
+  tuh_vid_pid_get_ReturnThruPtr_vid(&vid);
+  tuh_vid_pid_get_ReturnThruPtr_pid(&pid);
+
+  uint8_t const idx = mount(desc_g_zero, sizeof(desc_g_zero));
+  TEST_ASSERT_EQUAL(ZERO_PROTOCOL_SRC_SINK, tuh_zero_protocol(idx));
+
+  // no class request, transfers start right away
+  tuh_zero_test_t const test = { .type = TUH_ZERO_TEST_SOURCE, .alt = 0, .pattern = ZERO_PATTERN_ZERO,
+                                 .queue_depth = 1, .xfer_len = XFER_LEN, .count = 2 };
+  TEST_ASSERT_TRUE(tuh_zero_test_start(idx, &test));
+  TEST_ASSERT_EQUAL(1, _in_count);
+
+  for ( uint8_t i = 0; i < 2; i++ )
+  {
+    memset(_in_buf, 0, XFER_LEN);
+    TEST_ASSERT_TRUE(zeroh_xfer_cb(DADDR, EDPT_IN, XFER_RESULT_SUCCESS, XFER_LEN));
+  }
+
+  TEST_ASSERT_EQUAL(0, _ctrl_count);
+  TEST_ASSERT_EQUAL(1, _complete_count);
+
+  tuh_zero_result_t r;
+  TEST_ASSERT_TRUE(tuh_zero_result(idx, &r));
+  TEST_ASSERT_EQUAL(XFER_RESULT_SUCCESS, r.status);
+  TEST_ASSERT_EQUAL(2, r.count);
+  TEST_ASSERT_EQUAL(0, r.errors);
+}
+
+void test_match_other_device_skipped(void)
+{
+  uint16_t vid = 0xcafe, pid = 0x4000;
+  tuh_vid_pid_get_ExpectAndReturn(DADDR, NULL, NULL, true);
+  tuh_vid_pid_get_IgnoreArg_vid();
+  tuh_vid_pid_get_IgnoreArg_pid();
+  tuh_vid_pid_get_ReturnThruPtr_vid(&vid);
+  tuh_vid_pid_get_ReturnThruPtr_pid(&pid);
+
+  TEST_ASSERT_FALSE(zeroh_open(0, DADDR, (tusb_desc_interface_t const*) desc_g_zero, sizeof(desc_g_zero)));
+}
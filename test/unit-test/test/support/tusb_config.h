@@ -78,7 +78,9 @@
 
 //------------- CLASS -------------//
 //#define CFG_TUD_CDC              0
+#ifndef CFG_TUD_MSC
 #define CFG_TUD_MSC              1
+#endif
 //#define CFG_TUD_HID              0
 //#define CFG_TUD_MIDI             0
 //#define CFG_TUD_VENDOR           0
@@ -28,12 +28,28 @@
 #include "unity.h"
 
 #include "tusb_common.h"
+#include "osal/osal.h"
+#include "tusb_fifo.h"
+
+// tu_csum_copy() is implemented in tusb.c
+TEST_FILE("tusb.c");
 
 //--------------------------------------------------------------------+
 // MACRO TYPEDEF CONSTANT ENUM DECLARATION
 //--------------------------------------------------------------------+
 
 
+// Stub out usbd functions referenced by tusb.c
+bool tud_init(uint8_t rhport) { (void) rhport; return true; }
+bool tud_inited(void) { return true; }
+bool usbd_edpt_claim(uint8_t rhport, uint8_t ep_addr) { (void) rhport; (void) ep_addr; return true; }
+bool usbd_edpt_release(uint8_t rhport, uint8_t ep_addr) { (void) rhport; (void) ep_addr; return true; }
+bool usbd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t * buffer, uint16_t total_bytes)
+{
+  (void) rhport; (void) ep_addr; (void) buffer; (void) total_bytes;
+  return true;
+}
+
 //------------- IMPLEMENTATION -------------//
 
 void setUp(void)
@@ -80,3 +96,92 @@ void test_TU_ARGS_NUM(void)
   TEST_ASSERT_EQUAL(31, TU_ARGS_NUM(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15, a16, a17, a18, a19, a20, a21, a22, a23, a24, a25, a26, a27, a28, a29, a30, a31));
   TEST_ASSERT_EQUAL(32, TU_ARGS_NUM(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15, a16, a17, a18, a19, a20, a21, a22, a23, a24, a25, a26, a27, a28, a29, a30, a31, a32));
 }
+
+void test_tu_ctz32(void)
+{
+  TEST_ASSERT_EQUAL( 0, tu_ctz32(1));
+  TEST_ASSERT_EQUAL( 0, tu_ctz32(0xFFFFFFFFu));
+  TEST_ASSERT_EQUAL( 3, tu_ctz32(0x08));
+  TEST_ASSERT_EQUAL( 4, tu_ctz32(0x30));
+  TEST_ASSERT_EQUAL(16, tu_ctz32(0x00010000u));
+  TEST_ASSERT_EQUAL(31, tu_ctz32(0x80000000u));
+}
+
+//--------------------------------------------------------------------+
+// Checksum
+//--------------------------------------------------------------------+
+
+// Reference: sum of 16-bit words in memory byte order, odd byte is the first byte of a zero padded word
+static uint16_t csum_ref(uint8_t const* buf, uint32_t len)
+{
+  uint32_t sum = 0;
+  for(uint32_t i=0; i<len; i+=2)
+  {
+    uint8_t pair[2] = { buf[i], (i+1 < len) ? buf[i+1] : 0 };
+    uint16_t w;
+    memcpy(&w, pair, 2);
+    sum += w;
+  }
+  return tu_csum_fold(sum);
+}
+
+void test_tu_csum_copy_odd_length_and_offset(void)
+{
+  uint8_t src[80];
+  uint8_t dst[80];
+
+  for(uint32_t i=0; i<sizeof(src); i++) src[i] = (uint8_t) (i*37 + 11);
+
+  for(uint32_t src_off=0; src_off<4; src_off++)
+  {
+    for(uint32_t dst_off=0; dst_off<4; dst_off++)
+    {
+      for(uint32_t len=0; len<=67; len++)
+      {
+        memset(dst, 0xA5, sizeof(dst));
+
+        uint32_t const sum = tu_csum_copy(dst + dst_off, src + src_off, len, 0);
+        TEST_ASSERT_EQUAL_HEX16(csum_ref(src + src_off, len), tu_csum_fold(sum));
+
+        // copied exactly len bytes
+        if ( len ) TEST_ASSERT_EQUAL_MEMORY(src + src_off, dst + dst_off, len);
+        for(uint32_t i=0; i<dst_off; i++) TEST_ASSERT_EQUAL_HEX8(0xA5, dst[i]);
+        TEST_ASSERT_EQUAL_HEX8(0xA5, dst[dst_off + len]);
+      }
+    }
+  }
+}
+
+void test_tu_csum_copy_chained(void)
+{
+  uint8_t src[61];
+  uint8_t dst[61];
+  for(uint32_t i=0; i<sizeof(src); i++) src[i] = (uint8_t) (255 - i*3);
+
+  // every segment but the last has even length
+  uint32_t sum = tu_csum_copy(dst, src, 6, 0);
+  sum = tu_csum_copy(dst + 6, src + 6, 18, sum);
+  sum = tu_csum_copy(dst + 24, src + 24, 37, sum);
+
+  TEST_ASSERT_EQUAL_HEX16(csum_ref(src, sizeof(src)), tu_csum_fold(sum));
+  TEST_ASSERT_EQUAL_MEMORY(src, dst, sizeof(src));
+}
+
+void test_tu_csum_copy_carry(void)
+{
+  uint8_t src[1025];
+  uint8_t dst[1025];
+  memset(src, 0xFF, sizeof(src));
+
+  // end-around carry on every word
+  uint32_t sum = tu_csum_copy(dst, src, sizeof(src), 0);
+  TEST_ASSERT_EQUAL_HEX16(csum_ref(src, sizeof(src)), tu_csum_fold(sum));
+
+  sum = tu_csum_copy(dst, src, sizeof(src) - 1, 0xFFFFFFFFu);
+  TEST_ASSERT_EQUAL_HEX16(0xFFFF, tu_csum_fold(sum));
+
+  src[0] = 0x01; src[1] = 0x00;
+  src[2] = 0xFF; src[3] = 0xFF;
+  sum = tu_csum_copy(dst, src, 4, 0);
+  TEST_ASSERT_EQUAL_HEX16(csum_ref(src, 4), tu_csum_fold(sum));
+}
@@ -376,3 +376,111 @@ void test_rd_idx_wrap()
   TEST_ASSERT_EQUAL(n, 2);
   TEST_ASSERT_EQUAL(ff10.rd_idx, 6);
 }
+
+//--------------------------------------------------------------------+
+// Asynchronous copy
+//--------------------------------------------------------------------+
+
+// Emulated copy engine: requests are queued and completed later by test
+typedef struct
+{
+  void* dst;
+  void const* src;
+  uint16_t len;
+  void* ctx;
+} copy_req_t;
+
+static copy_req_t copy_req[4];
+static uint8_t copy_req_count;
+static uint8_t async_complete_count;
+
+static void emu_copy(void* dst, void const* src, uint16_t len, void* ctx)
+{
+  TEST_ASSERT_LESS_THAN(TU_ARRAY_SIZE(copy_req), copy_req_count);
+  copy_req[copy_req_count++] = (copy_req_t) { .dst = dst, .src = src, .len = len, .ctx = ctx };
+}
+
+// complete oldest request
+static void emu_copy_complete_one(void)
+{
+  TEST_ASSERT_GREATER_THAN(0, copy_req_count);
+  copy_req_t req = copy_req[0];
+  memmove(copy_req, copy_req+1, (copy_req_count-1)*sizeof(copy_req_t));
+  copy_req_count--;
+
+  memcpy(req.dst, req.src, req.len);
+  tu_fifo_copy_done(req.ctx);
+}
+
+static tu_fifo_copy_engine_t const emu_engine = { .copy = emu_copy };
+
+static void async_complete_cb(tu_fifo_async_t* op)
+{
+  (void) op;
+  async_complete_count++;
+}
+
+void test_write_read_async_no_engine(void)
+{
+  tu_fifo_async_t op = { .complete_cb = async_complete_cb };
+  async_complete_count = 0;
+
+  // completed synchronously with memcpy
+  TEST_ASSERT_EQUAL(10, tu_fifo_write_n_async(ff, test_data, 10, &op));
+  TEST_ASSERT_EQUAL(1, async_complete_count);
+  TEST_ASSERT_EQUAL(10, tu_fifo_count(ff));
+
+  TEST_ASSERT_EQUAL(10, tu_fifo_read_n_async(ff, rd_buf, 20, &op));
+  TEST_ASSERT_EQUAL(2, async_complete_count);
+  TEST_ASSERT_EQUAL(0, tu_fifo_count(ff));
+  TEST_ASSERT_EQUAL_MEMORY(test_data, rd_buf, 10);
+}
+
+void test_write_read_async_engine(void)
+{
+  tu_fifo_async_t op = { .complete_cb = async_complete_cb };
+  async_complete_count = 0;
+  copy_req_count = 0;
+
+  tu_fifo_copy_engine_set(&emu_engine);
+
+  // move index so that async write is wrapped around
+  ff->wr_idx = ff->rd_idx = FIFO_SIZE - 5;
+
+  TEST_ASSERT_EQUAL(20, tu_fifo_write_n_async(ff, test_data, 20, &op));
+  TEST_ASSERT_EQUAL(2, copy_req_count);
+
+  // data is not visible until all segments are complete
+  emu_copy_complete_one();
+  TEST_ASSERT_EQUAL(0, async_complete_count);
+  TEST_ASSERT_EQUAL(0, tu_fifo_count(ff));
+
+  emu_copy_complete_one();
+  TEST_ASSERT_EQUAL(1, async_complete_count);
+  TEST_ASSERT_EQUAL(20, tu_fifo_count(ff));
+
+  // space is not released until read copy is complete
+  TEST_ASSERT_EQUAL(20, tu_fifo_read_n_async(ff, rd_buf, 20, &op));
+  TEST_ASSERT_EQUAL(2, copy_req_count);
+  TEST_ASSERT_EQUAL(20, tu_fifo_count(ff));
+
+  emu_copy_complete_one();
+  emu_copy_complete_one();
+  TEST_ASSERT_EQUAL(2, async_complete_count);
+  TEST_ASSERT_EQUAL(0, tu_fifo_count(ff));
+  TEST_ASSERT_EQUAL_MEMORY(test_data, rd_buf, 20);
+
+  tu_fifo_copy_engine_set(NULL);
+}
+
+void test_write_async_full(void)
+{
+  tu_fifo_async_t op = { .complete_cb = async_complete_cb };
+
+  tu_fifo_write_n(ff, test_data, FIFO_SIZE - 4);
+
+  // limited to remaining space
+  TEST_ASSERT_EQUAL(4, tu_fifo_write_n_async(ff, test_data, 10, &op));
+  TEST_ASSERT_EQUAL(0, tu_fifo_write_n_async(ff, test_data, 10, &op));
+  TEST_ASSERT_TRUE(tu_fifo_full(ff));
+}
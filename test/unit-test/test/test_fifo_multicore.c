@@ -0,0 +1,263 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+// Stress test of CFG_TUSB_MULTICORE fifo: producer and consumer run on different threads
+// (i.e cores) without any lock, data stream must arrive complete and in order.
+// Build with -fsanitize=thread to also have ThreadSanitizer check the index ordering.
+
+#include <pthread.h>
+#include <sched.h>
+#include "unity.h"
+
+#include "osal/osal.h"
+#include "tusb_fifo.h"
+
+#define FIFO_DEPTH    61   // not power of 2 to exercise index wrapping
+#define STREAM_LEN    (1u << 20)
+
+static tu_fifo_t ff;
+static uint8_t ff_buf[FIFO_DEPTH * sizeof(uint32_t)];
+
+// first error detected by a thread, only reported by main thread
+static volatile uint32_t err_count;
+
+static uint32_t xorshift32(uint32_t* state)
+{
+  uint32_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return *state = x;
+}
+
+// let the other thread run when there is no progress, in case of a single cpu
+static void no_progress(uint16_t n)
+{
+  if ( n == 0 ) sched_yield();
+}
+
+static void run_threads(void* (*producer)(void*), void* (*consumer)(void*))
+{
+  pthread_t pt, ct;
+  TEST_ASSERT_EQUAL(0, pthread_create(&pt, NULL, producer, NULL));
+  TEST_ASSERT_EQUAL(0, pthread_create(&ct, NULL, consumer, NULL));
+  TEST_ASSERT_EQUAL(0, pthread_join(pt, NULL));
+  TEST_ASSERT_EQUAL(0, pthread_join(ct, NULL));
+}
+
+void setUp(void)
+{
+  err_count = 0;
+}
+
+void tearDown(void)
+{
+}
+
+//--------------------------------------------------------------------+
+// Byte stream with write_n() / read_n() of random length
+//--------------------------------------------------------------------+
+static void* stream_producer(void* arg)
+{
+  (void) arg;
+  uint32_t seed = 0x12345678;
+  uint8_t buf[FIFO_DEPTH];
+  uint32_t sent = 0;
+
+  while ( sent < STREAM_LEN )
+  {
+    // TU_MIN() evaluates its arguments twice
+    uint32_t const len = xorshift32(&seed) % FIFO_DEPTH + 1;
+    uint16_t n = (uint16_t) TU_MIN(len, STREAM_LEN - sent);
+    for ( uint16_t i = 0; i < n; i++ ) buf[i] = (uint8_t) (sent + i);
+
+    n = tu_fifo_write_n(&ff, buf, n);
+    if ( tu_fifo_remaining(&ff) > FIFO_DEPTH ) err_count++;
+    no_progress(n);
+    sent += n;
+  }
+
+  return NULL;
+}
+
+static void* stream_consumer(void* arg)
+{
+  (void) arg;
+  uint32_t seed = 0x87654321;
+  uint8_t buf[FIFO_DEPTH];
+  uint32_t received = 0;
+
+  while ( received < STREAM_LEN )
+  {
+    uint32_t const len = xorshift32(&seed) % FIFO_DEPTH + 1;
+    uint16_t n = (uint16_t) TU_MIN(len, STREAM_LEN - received);
+
+    if ( tu_fifo_count(&ff) > FIFO_DEPTH ) err_count++;
+    n = tu_fifo_read_n(&ff, buf, n);
+    no_progress(n);
+
+    for ( uint16_t i = 0; i < n; i++ )
+    {
+      if ( buf[i] != (uint8_t) (received + i) ) err_count++;
+    }
+    received += n;
+  }
+
+  return NULL;
+}
+
+void test_spsc_stream(void)
+{
+  tu_fifo_config(&ff, ff_buf, FIFO_DEPTH, 1, false);
+
+  run_threads(stream_producer, stream_consumer);
+
+  TEST_ASSERT_EQUAL(0, err_count);
+  TEST_ASSERT_TRUE(tu_fifo_empty(&ff));
+}
+
+//--------------------------------------------------------------------+
+// Word items with write() / peek() / read(), items must never be torn
+//--------------------------------------------------------------------+
+static void* item_producer(void* arg)
+{
+  (void) arg;
+
+  for ( uint32_t i = 0; i < STREAM_LEN / 4; )
+  {
+    uint32_t const value = i * 0x01010101u;
+    if ( tu_fifo_write(&ff, &value) ) i++;
+    else no_progress(0);
+  }
+
+  return NULL;
+}
+
+static void* item_consumer(void* arg)
+{
+  (void) arg;
+
+  for ( uint32_t i = 0; i < STREAM_LEN / 4; )
+  {
+    uint32_t peeked, value;
+    if ( !tu_fifo_peek(&ff, &peeked) )
+    {
+      no_progress(0);
+      continue;
+    }
+
+    // only consumer removes items, peeked item must be the one read
+    if ( !tu_fifo_read(&ff, &value) ) err_count++;
+    if ( (value != peeked) || (value != i * 0x01010101u) ) err_count++;
+    i++;
+  }
+
+  return NULL;
+}
+
+void test_spsc_item(void)
+{
+  tu_fifo_config(&ff, ff_buf, FIFO_DEPTH, sizeof(uint32_t), false);
+
+  run_threads(item_producer, item_consumer);
+
+  TEST_ASSERT_EQUAL(0, err_count);
+  TEST_ASSERT_TRUE(tu_fifo_empty(&ff));
+}
+
+//--------------------------------------------------------------------+
+// DMA style access with buffer info and advance pointers
+//--------------------------------------------------------------------+
+static void* dma_producer(void* arg)
+{
+  (void) arg;
+  uint32_t sent = 0;
+
+  while ( sent < STREAM_LEN )
+  {
+    tu_fifo_buffer_info_t info;
+    tu_fifo_get_write_info(&ff, &info);
+
+    // don't write past end of stream
+    uint16_t const len_lin  = (uint16_t) TU_MIN(info.len_lin, STREAM_LEN - sent);
+    uint16_t const len_wrap = (uint16_t) TU_MIN(info.len_wrap, STREAM_LEN - sent - len_lin);
+
+    uint16_t n = 0;
+    uint8_t* p = (uint8_t*) info.ptr_lin;
+    for ( uint16_t i = 0; i < len_lin; i++ ) p[i] = (uint8_t) (sent + n++);
+    p = (uint8_t*) info.ptr_wrap;
+    for ( uint16_t i = 0; i < len_wrap; i++ ) p[i] = (uint8_t) (sent + n++);
+
+    tu_fifo_advance_write_pointer(&ff, n);
+    sent += n;
+    no_progress(n);
+  }
+
+  return NULL;
+}
+
+static void* dma_consumer(void* arg)
+{
+  (void) arg;
+  uint32_t received = 0;
+
+  while ( received < STREAM_LEN )
+  {
+    tu_fifo_buffer_info_t info;
+    tu_fifo_get_read_info(&ff, &info);
+
+    uint16_t const len_lin  = (uint16_t) TU_MIN(info.len_lin, STREAM_LEN - received);
+    uint16_t const len_wrap = (uint16_t) TU_MIN(info.len_wrap, STREAM_LEN - received - len_lin);
+
+    uint16_t n = 0;
+    uint8_t const* p = (uint8_t const*) info.ptr_lin;
+    for ( uint16_t i = 0; i < len_lin; i++ )
+    {
+      if ( p[i] != (uint8_t) (received + n++) ) err_count++;
+    }
+    p = (uint8_t const*) info.ptr_wrap;
+    for ( uint16_t i = 0; i < len_wrap; i++ )
+    {
+      if ( p[i] != (uint8_t) (received + n++) ) err_count++;
+    }
+
+    tu_fifo_advance_read_pointer(&ff, n);
+    received += n;
+    no_progress(n);
+  }
+
+  return NULL;
+}
+
+void test_spsc_dma(void)
+{
+  tu_fifo_config(&ff, ff_buf, FIFO_DEPTH, 1, false);
+
+  run_threads(dma_producer, dma_consumer);
+
+  TEST_ASSERT_EQUAL(0, err_count);
+  TEST_ASSERT_TRUE(tu_fifo_empty(&ff));
+}
@@ -0,0 +1,227 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2023 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * This file is part of the TinyUSB stack.
+ */
+
+#include <string.h>
+#include "unity.h"
+
+#include "osal/osal.h"
+#include "tusb_fifo.h"
+#include "vendor_mux.h"
+
+#define N_CH      2
+#define FF_DEPTH  64
+
+// two multiplexers connected back to back: a <-> b
+typedef struct {
+  tu_vmux_t mux;
+  tu_vmux_channel_t ch[N_CH];
+  uint8_t rx_ff_buf[N_CH][FF_DEPTH];
+  uint8_t tx_ff_buf[N_CH][FF_DEPTH];
+} test_mux_t;
+
+static test_mux_t a, b;
+static uint8_t link_buf[512];
+
+static void mux_init(test_mux_t* m)
+{
+  for(uint8_t i=0; i<N_CH; i++)
+  {
+    tu_fifo_config(&m->ch[i].rx_ff, m->rx_ff_buf[i], FF_DEPTH, 1, false);
+    tu_fifo_config(&m->ch[i].tx_ff, m->tx_ff_buf[i], FF_DEPTH, 1, false);
+  }
+  tu_vmux_init(&m->mux, m->ch, N_CH);
+}
+
+// send one link transfer of at most bufsize bytes from src to dst, return transferred bytes
+static uint16_t link_xfer(test_mux_t* src, test_mux_t* dst, uint16_t bufsize)
+{
+  uint16_t const count = tu_vmux_tx(&src->mux, link_buf, bufsize);
+  tu_vmux_rx(&dst->mux, link_buf, count);
+  return count;
+}
+
+void setUp(void)
+{
+  mux_init(&a);
+  mux_init(&b);
+}
+
+void tearDown(void)
+{
+}
+
+//--------------------------------------------------------------------+
+// Tests
+//--------------------------------------------------------------------+
+
+void test_reset_grants_whole_fifo(void)
+{
+  TEST_ASSERT_TRUE(tu_vmux_tx_pending(&a.mux));
+
+  uint8_t const expected[] =
+  {
+    0, VENDOR_MUX_FRAME_CREDIT, FF_DEPTH, 0,
+    1, VENDOR_MUX_FRAME_CREDIT, FF_DEPTH, 0,
+  };
+  TEST_ASSERT_EQUAL(sizeof(expected), tu_vmux_tx(&a.mux, link_buf, sizeof(link_buf)));
+  TEST_ASSERT_EQUAL_MEMORY(expected, link_buf, sizeof(expected));
+
+  // nothing left to send
+  TEST_ASSERT_FALSE(tu_vmux_tx_pending(&a.mux));
+  TEST_ASSERT_EQUAL(0, tu_vmux_tx(&a.mux, link_buf, sizeof(link_buf)));
+}
+
+void test_data_limited_by_credit(void)
+{
+  uint8_t data[40];
+  for(uint8_t i=0; i<sizeof(data); i++) data[i] = i;
+
+  // drop initial credits of b, a has no credit yet
+  TEST_ASSERT_EQUAL(8, tu_vmux_tx(&a.mux, link_buf, sizeof(link_buf)));
+  TEST_ASSERT_EQUAL(sizeof(data), tu_vmux_write(&a.mux, 0, data, sizeof(data)));
+  TEST_ASSERT_FALSE(tu_vmux_tx_pending(&a.mux));
+
+  // peer grants 10 bytes
+  uint8_t const credit[] = { 0, VENDOR_MUX_FRAME_CREDIT, 10, 0 };
+  tu_vmux_rx(&a.mux, credit, sizeof(credit));
+  TEST_ASSERT_TRUE(tu_vmux_tx_pending(&a.mux));
+
+  TEST_ASSERT_EQUAL(4 + 10, tu_vmux_tx(&a.mux, link_buf, sizeof(link_buf)));
+  uint8_t const hdr[] = { 0, VENDOR_MUX_FRAME_DATA, 10, 0 };
+  TEST_ASSERT_EQUAL_MEMORY(hdr, link_buf, 4);
+  TEST_ASSERT_EQUAL_MEMORY(data, link_buf + 4, 10);
+
+  // credit is used up
+  TEST_ASSERT_FALSE(tu_vmux_tx_pending(&a.mux));
+  TEST_ASSERT_EQUAL(30, tu_fifo_count(&a.ch[0].tx_ff));
+}
+
+void test_rx_header_split_across_packets(void)
+{
+  uint8_t const frames[] =
+  {
+    1, VENDOR_MUX_FRAME_DATA, 3, 0, 'a', 'b', 'c',
+    0, VENDOR_MUX_FRAME_DATA, 2, 0, 'x', 'y',
+    5, VENDOR_MUX_FRAME_DATA, 1, 0, 'z', // unknown channel is dropped
+    0, VENDOR_MUX_FRAME_CREDIT, 0x34, 0x12,
+  };
+
+  // feed byte by byte
+  for(uint8_t i=0; i<sizeof(frames); i++) tu_vmux_rx(&a.mux, &frames[i], 1);
+
+  uint8_t buf[8];
+  TEST_ASSERT_EQUAL(3, tu_vmux_available(&a.mux, 1));
+  TEST_ASSERT_EQUAL(3, tu_vmux_read(&a.mux, 1, buf, sizeof(buf)));
+  TEST_ASSERT_EQUAL_MEMORY("abc", buf, 3);
+
+  TEST_ASSERT_EQUAL(2, tu_vmux_read(&a.mux, 0, buf, sizeof(buf)));
+  TEST_ASSERT_EQUAL_MEMORY("xy", buf, 2);
+
+  TEST_ASSERT_EQUAL(0, tu_vmux_read(&a.mux, 5, buf, sizeof(buf)));
+  TEST_ASSERT_EQUAL(0x1234, a.ch[0].tx_credit - a.ch[0].tx_sent);
+}
+
+void test_read_grants_credit_in_chunks(void)
+{
+  // exchange initial credits
+  link_xfer(&a, &b, sizeof(link_buf));
+  link_xfer(&b, &a, sizeof(link_buf));
+
+  uint8_t data[FF_DEPTH];
+  memset(data, 0x55, sizeof(data));
+  TEST_ASSERT_EQUAL(FF_DEPTH, tu_vmux_write(&a.mux, 0, data, sizeof(data)));
+  TEST_ASSERT_EQUAL(4 + FF_DEPTH, link_xfer(&a, &b, sizeof(link_buf)));
+  TEST_ASSERT_EQUAL(FF_DEPTH, tu_vmux_available(&b.mux, 0));
+
+  // less than a quarter of FIFO is freed: no credit yet
+  uint8_t buf[FF_DEPTH];
+  tu_vmux_read(&b.mux, 0, buf, FF_DEPTH/4 - 1);
+  TEST_ASSERT_FALSE(tu_vmux_tx_pending(&b.mux));
+
+  tu_vmux_read(&b.mux, 0, buf, 1);
+  TEST_ASSERT_TRUE(tu_vmux_tx_pending(&b.mux));
+
+  uint8_t const expected[] = { 0, VENDOR_MUX_FRAME_CREDIT, FF_DEPTH/4, 0 };
+  TEST_ASSERT_EQUAL(sizeof(expected), link_xfer(&b, &a, sizeof(link_buf)));
+  TEST_ASSERT_EQUAL_MEMORY(expected, link_buf, sizeof(expected));
+  TEST_ASSERT_EQUAL(FF_DEPTH/4, a.ch[0].tx_credit - a.ch[0].tx_sent);
+}
+
+void test_round_robin_and_bufsize(void)
+{
+  link_xfer(&b, &a, sizeof(link_buf));
+  link_xfer(&a, &b, sizeof(link_buf));
+
+  tu_vmux_write(&a.mux, 0, "0000", 4);
+  tu_vmux_write(&a.mux, 1, "1111", 4);
+
+  // only room for one header + 2 bytes
+  TEST_ASSERT_EQUAL(6, tu_vmux_tx(&a.mux, link_buf, 6));
+  uint8_t const first = link_buf[0];
+
+  // next transfer starts with the other channel
+  TEST_ASSERT_EQUAL(6, tu_vmux_tx(&a.mux, link_buf, 6));
+  TEST_ASSERT_EQUAL(1 - first, link_buf[0]);
+  TEST_ASSERT_EQUAL(2, tu_fifo_count(&a.ch[0].tx_ff));
+  TEST_ASSERT_EQUAL(2, tu_fifo_count(&a.ch[1].tx_ff));
+
+  // header does not fit
+  TEST_ASSERT_EQUAL(0, tu_vmux_tx(&a.mux, link_buf, VENDOR_MUX_HEADER_LEN));
+}
+
+// stream data of both channels over a small link, flow control must never drop any byte
+void test_stream_no_loss(void)
+{
+  enum { STREAM_LEN = 1000 };
+  uint32_t sent[N_CH] = { 0 }, recv[N_CH] = { 0 };
+  uint8_t buf[FF_DEPTH];
+
+  for(uint32_t loop = 0; loop < 10000; loop++)
+  {
+    for(uint8_t i=0; i<N_CH; i++)
+    {
+      // writer
+      uint32_t n = tu_min32(tu_vmux_write_available(&a.mux, i), STREAM_LEN - sent[i]);
+      n = tu_min32(n, 7 + i);
+      for(uint32_t k=0; k<n; k++) buf[k] = (uint8_t) (sent[i] + k + i);
+      TEST_ASSERT_EQUAL(n, tu_vmux_write(&a.mux, i, buf, n));
+      sent[i] += n;
+
+      // reader is slower than writer
+      uint32_t const count = tu_vmux_read(&b.mux, i, buf, 5);
+      for(uint32_t k=0; k<count; k++) TEST_ASSERT_EQUAL_UINT8((uint8_t) (recv[i] + k + i), buf[k]);
+      recv[i] += count;
+    }
+
+    link_xfer(&a, &b, 64);
+    link_xfer(&b, &a, 64);
+
+    if ( recv[0] == STREAM_LEN && recv[1] == STREAM_LEN ) break;
+  }
+
+  TEST_ASSERT_EQUAL(STREAM_LEN, recv[0]);
+  TEST_ASSERT_EQUAL(STREAM_LEN, recv[1]);
+}
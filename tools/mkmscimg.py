@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+"""Build a block compressed read-only disk image for the MSC device, see src/class/msc/msc_image.h
+
+The disk image is split into chunks of --chunk-blocks blocks, each compressed independently with LZ4 (block
+format). Chunks that do not compress are stored as is. Output is a binary image, or a C array with --c-array.
+"""
+import argparse
+import struct
+import sys
+
+SIGNATURE = 0x495A5554  # "TUZI"
+MIN_MATCH = 4
+LAST_LITERALS = 5       # last 5 bytes of a block are always literals
+MFLIMIT = 12            # last match must start at least 12 bytes before end of block
+MAX_OFFSET = 0xFFFF
+
+
+def lz4_length(n):
+    out = bytearray()
+    while n >= 255:
+        out.append(255)
+        n -= 255
+    out.append(n)
+    return out
+
+
+def lz4_sequence(out, literals, match_len=None, offset=0):
+    lit_len = len(literals)
+    token = min(lit_len, 15) << 4
+    if match_len is not None:
+        token |= min(match_len - MIN_MATCH, 15)
+    out.append(token)
+    if lit_len >= 15:
+        out += lz4_length(lit_len - 15)
+    out += literals
+    if match_len is not None:
+        out += struct.pack('<H', offset)
+        if match_len - MIN_MATCH >= 15:
+            out += lz4_length(match_len - MIN_MATCH - 15)
+
+
+def lz4_compress(data):
+    """Greedy LZ4 block compressor, hash table of last position for each 4 byte sequence"""
+    out = bytearray()
+    table = {}
+    n = len(data)
+    anchor = 0
+    pos = 0
+    match_end_limit = n - LAST_LITERALS
+
+    while pos + MFLIMIT <= n:
+        key = data[pos:pos + MIN_MATCH]
+        ref = table.get(key)
+        table[key] = pos
+        if ref is None or pos - ref > MAX_OFFSET:
+            pos += 1
+            continue
+
+        length = MIN_MATCH
+        while pos + length < match_end_limit and data[ref + length] == data[pos + length]:
+            length += 1
+
+        lz4_sequence(out, data[anchor:pos], length, pos - ref)
+        pos += length
+        anchor = pos
+
+    lz4_sequence(out, data[anchor:])
+    return bytes(out)
+
+
+def build_image(disk, block_size, chunk_blocks):
+    if len(disk) % block_size:
+        disk += b'\0' * (block_size - len(disk) % block_size)
+
+    block_count = len(disk) // block_size
+    chunk_size = block_size * chunk_blocks
+    chunks = []
+    for start in range(0, len(disk), chunk_size):
+        raw = disk[start:start + chunk_size]
+        comp = lz4_compress(raw)
+        chunks.append(comp if len(comp) < len(raw) else raw)
+
+    offset = 16 + 4 * (len(chunks) + 1)
+    index = []
+    for c in chunks:
+        index.append(offset)
+        offset += len(c)
+    index.append(offset)
+
+    header = struct.pack('<IHHII', SIGNATURE, block_size, chunk_blocks, block_count, len(chunks))
+    return header + struct.pack('<%dI' % len(index), *index) + b''.join(chunks)
+
+
+def to_c_array(image, name):
+    lines = ['// Generated by tools/mkmscimg.py', '#include "tusb.h"', '',
+             'TU_ATTR_ALIGNED(4) uint8_t const %s[%d] =' % (name, len(image)), '{']
+    for i in range(0, len(image), 16):
+        lines.append('  ' + ' '.join('0x%02x,' % b for b in image[i:i + 16]))
+    lines.append('};')
+    return '\n'.join(lines) + '\n'
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('input', help='raw disk image e.g FAT or ISO9660')
+    parser.add_argument('output', help='compressed image')
+    parser.add_argument('-b', '--block-size', type=int, default=512, help='logical block size (default 512)')
+    parser.add_argument('-c', '--chunk-blocks', type=int, default=8, help='blocks per chunk (default 8)')
+    parser.add_argument('--c-array', metavar='NAME', help='output C array with this name instead of binary')
+    args = parser.parse_args()
+
+    with open(args.input, 'rb') as f:
+        disk = f.read()
+
+    image = build_image(disk, args.block_size, args.chunk_blocks)
+    print('%u bytes -> %u bytes (%.1f%%), chunk size %u: set CFG_TUD_MSC_IMAGE_CHUNK_SIZE >= %u' %
+          (len(disk), len(image), 100.0 * len(image) / max(len(disk), 1),
+           args.block_size * args.chunk_blocks, args.block_size * args.chunk_blocks))
+
+    if args.c_array:
+        with open(args.output, 'w') as f:
+            f.write(to_c_array(image, args.c_array))
+    else:
+        with open(args.output, 'wb') as f:
+            f.write(image)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())